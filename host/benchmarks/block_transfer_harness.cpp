@@ -0,0 +1,237 @@
+// Harness of block-wise transfers of large configuration documents through a local lossy proxy
+// "block2" fetches one block per round trip like RFC 7959, "qblock2" asks for up to kMaxPayloads missing blocks per
+// round trip and the server answers with a burst like RFC 9177. Both modes are a model of the block exchanges on plain
+// UDP datagrams, not of the CoAP encoding, and retransmit with the same doubling timeout
+// The harness measures this protocol model only. LoadConfigDocument, libcoap's block handling and the parsers are not
+// built on the host, so neither their overhead nor the idle timeout of the loader are part of the numbers
+#include "HostBench.h"
+#include "LossyProxy.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Number of blocks that are sent as a burst, the MAX_PAYLOADS default of RFC 9177
+constexpr uint32_t kMaxPayloads = 10;
+// Largest block size, SZX 6
+constexpr size_t kMaxBlockSize = 1024;
+// A transfer is abandoned after this many timeouts in a row
+constexpr uint32_t kMaxTimeouts = 8;
+
+struct Request
+{
+    uint32_t szx;
+    uint32_t count;
+    uint32_t blocks[kMaxPayloads];
+};
+
+struct Response
+{
+    uint32_t block;
+    uint32_t more;
+    // Size of the whole document like the Size2 option of RFC 7959
+    uint32_t size2;
+    uint32_t length;
+    uint8_t payload[kMaxBlockSize];
+};
+
+uint8_t DocumentByte(size_t offset)
+{
+    return static_cast<uint8_t>((offset * 31) ^ (offset >> 8));
+}
+
+size_t BlockSize(uint32_t szx)
+{
+    return size_t(16) << szx;
+}
+
+/**
+ * Local stand-in of a configuration server that serves a single document in blocks
+ */
+class BlockServer
+{
+public:
+    explicit BlockServer(size_t document_size) : mDocumentSize(document_size)
+    {
+        mFd     = LossyProxy::OpenLoopbackSocket(&mPort);
+        mThread = std::thread([this] { Run(); });
+    }
+
+    ~BlockServer()
+    {
+        mStopped = true;
+        mThread.join();
+        close(mFd);
+    }
+
+    uint16_t Port() const { return mPort; }
+
+private:
+    void Run()
+    {
+        while (!mStopped) {
+            pollfd fds = { mFd, POLLIN, 0 };
+            if (poll(&fds, 1, 10) <= 0) {
+                continue;
+            }
+            Request request;
+            sockaddr_in from;
+            socklen_t length = sizeof(from);
+            if (recvfrom(mFd, &request, sizeof(request), 0, reinterpret_cast<sockaddr *>(&from), &length) != sizeof(request)) {
+                continue;
+            }
+            size_t block_size = BlockSize(request.szx);
+            for (uint32_t i = 0; i < request.count && i < kMaxPayloads; i++) {
+                Response response;
+                size_t offset = static_cast<size_t>(request.blocks[i]) * block_size;
+                if (offset >= mDocumentSize) {
+                    continue;
+                }
+                response.block  = request.blocks[i];
+                response.length = static_cast<uint32_t>(std::min(block_size, mDocumentSize - offset));
+                response.more   = offset + response.length < mDocumentSize;
+                response.size2  = static_cast<uint32_t>(mDocumentSize);
+                for (size_t b = 0; b < response.length; b++) {
+                    response.payload[b] = DocumentByte(offset + b);
+                }
+                sendto(mFd, &response, offsetof(Response, payload) + response.length, 0, reinterpret_cast<sockaddr *>(&from),
+                       length);
+            }
+        }
+    }
+
+    size_t mDocumentSize;
+    int mFd;
+    uint16_t mPort = 0;
+    std::atomic<bool> mStopped{ false };
+    std::thread mThread;
+};
+
+struct Transfer
+{
+    bool complete      = false;
+    bool intact        = true;
+    uint32_t requests  = 0;
+    uint32_t timeouts  = 0;
+    int64_t durationUs = 0;
+};
+
+/**
+ * Function used to fetch the document, the number of blocks is learned from the Size2 of the first response
+ */
+void Fetch(int fd, const sockaddr_in & to, bool q_block, uint32_t szx, uint32_t rto_ms, Transfer & transfer)
+{
+    size_t block_size = BlockSize(szx);
+    std::vector<bool> received;
+    uint32_t total    = 1;
+    uint32_t missing  = 1;
+    uint32_t timeouts = 0;
+    int64_t start     = HostBenchNowNs();
+
+    while (missing > 0 && timeouts < kMaxTimeouts) {
+        // Block2 asks for the first missing block only, Q-Block2 for every missing block that fits into a burst
+        Request request{};
+        request.szx = szx;
+        for (uint32_t block = 0; block < total && request.count < (q_block ? kMaxPayloads : 1); block++) {
+            if (received.empty() || !received[block]) {
+                request.blocks[request.count++] = block;
+            }
+        }
+        sendto(fd, &request, sizeof(request), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+        transfer.requests++;
+
+        // Wait until every requested block arrived, the timeout doubles with every timeout in a row
+        uint32_t outstanding = request.count;
+        int64_t deadline     = HostBenchNowNs() + (static_cast<int64_t>(rto_ms) << timeouts) * 1000000;
+        while (outstanding > 0) {
+            int64_t now = HostBenchNowNs();
+            pollfd fds  = { fd, POLLIN, 0 };
+            if (now >= deadline || poll(&fds, 1, static_cast<int>((deadline - now + 999999) / 1000000)) <= 0) {
+                break;
+            }
+            Response response;
+            ssize_t size = recv(fd, &response, sizeof(response), 0);
+            if (size < static_cast<ssize_t>(offsetof(Response, payload))) {
+                continue;
+            }
+            if (received.empty()) {
+                total   = static_cast<uint32_t>((response.size2 + block_size - 1) / block_size);
+                missing = total;
+                received.resize(total, false);
+            }
+            if (response.block < total && !received[response.block]) {
+                missing--;
+                received[response.block] = true;
+                for (size_t b = 0; b < response.length; b++) {
+                    transfer.intact &= response.payload[b] == DocumentByte(response.block * block_size + b);
+                }
+            }
+            for (uint32_t i = 0; i < request.count; i++) {
+                if (request.blocks[i] == response.block) {
+                    outstanding--;
+                    request.blocks[i] = UINT32_MAX;
+                }
+            }
+        }
+        timeouts = outstanding == request.count ? timeouts + 1 : 0;
+        transfer.timeouts += outstanding > 0;
+    }
+    transfer.complete   = missing == 0;
+    transfer.durationUs = (HostBenchNowNs() - start) / 1000;
+}
+
+std::vector<double> ParseList(int argc, char ** argv, const char * name, const char * default_value)
+{
+    const char * value = default_value;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            value = argv[i + 1];
+        }
+    }
+    std::vector<double> list;
+    for (char * end = nullptr; *value != '\0'; value = *end == ',' ? end + 1 : end) {
+        list.push_back(strtod(value, &end));
+    }
+    return list;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    size_t size       = HostBenchOption(argc, argv, "--size", 128 * 1024);
+    uint32_t delay_ms = static_cast<uint32_t>(HostBenchOption(argc, argv, "--delay-ms", 20));
+    uint32_t rto_ms   = static_cast<uint32_t>(HostBenchOption(argc, argv, "--rto-ms", 2000));
+    int status        = EXIT_SUCCESS;
+
+    BlockServer server(size);
+    for (double loss : ParseList(argc, argv, "--loss", "0,5,10")) {
+        for (double szx : ParseList(argc, argv, "--szx", "4,6")) {
+            for (bool q_block : { false, true }) {
+                LossyProxy::Options options;
+                options.lossPercent = loss;
+                options.delayUs     = delay_ms * 1000;
+                options.jitterUs    = delay_ms * 200;
+                LossyProxy proxy(server.Port(), options);
+                int fd = LossyProxy::OpenLoopbackSocket(nullptr);
+
+                Transfer transfer;
+                Fetch(fd, LossyProxy::LoopbackAddress(proxy.Port()), q_block, static_cast<uint32_t>(szx), rto_ms, transfer);
+                close(fd);
+                printf("{\"bench\":\"block_transfer\",\"mode\":\"%s\",\"size\":%zu,\"block_size\":%zu,\"loss_percent\":%.1f,"
+                       "\"delay_ms\":%u,\"complete\":%s,\"requests\":%u,\"timeouts\":%u,\"transfer_ms\":%.1f,\"bytes_per_s\":%.0f}\n",
+                       q_block ? "qblock2" : "block2", size, BlockSize(static_cast<uint32_t>(szx)), loss, delay_ms,
+                       transfer.complete ? "true" : "false", transfer.requests, transfer.timeouts, transfer.durationUs / 1000.0,
+                       size * 1e6 / static_cast<double>(transfer.durationUs));
+                fflush(stdout);
+                if (!transfer.complete || !transfer.intact) {
+                    status = EXIT_FAILURE;
+                }
+            }
+        }
+    }
+    return status;
+}
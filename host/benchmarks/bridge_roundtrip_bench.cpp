@@ -0,0 +1,443 @@
+// Benchmark of the round trips through the bridge against local stand-ins, with p50, p99 and p999 and the throughput of
+// every path under concurrency
+// "matter_read", "matter_write" and "matter_command" are sent by --concurrency Matter controllers to the LwM2M devices of a
+// Fleet of Lwm2mSim.h. "coap_read" and "coap_write" are sent by a device with the load generator of lwm2m_sim to the CoAP
+// server of the bridge, which forwards them to a bound Matter device that is a UdpEchoServer
+// The devices, the event loop and the histograms of BridgeLatency.cpp are real, the bridge in between is a model, because
+// main.cpp, CoapClient.cpp, CoapServer.cpp, BindingHandler.cpp and libcoap are not built on the host, see CMakeLists.txt.
+// The model keeps their threading: Matter reads and writes block the event loop for a CoAP exchange bounded like
+// BRIDGE_MATTER_LOOP_WAIT_MS, invokes are handed to a command task and completed on the event loop, requests to the CoAP
+// server are acknowledged, posted to the event loop through a CommandChannel and answered separately once the Matter
+// interaction has finished. Retransmissions, the coalescing of GET requests, interaction timeouts and the encoding of the
+// values are not modelled, and the separate responses are sent from the event loop instead of the CoAP server task
+// Every mode prints the statistics of its BridgePath as a JSON line, the round trip seen by the caller is in "caller"
+//
+//   bridge_roundtrip_bench --xml 3311.xml [--devices 8] [--concurrency 8] [--requests 20000] [--latency-ms 0]
+#include "BridgeLatency.h"
+#include "HostBench.h"
+#include "HostCommandChannel.h"
+#include "HostEventLoop.h"
+#include "LatencyHistogram.h"
+#include "LossyProxy.h"
+#include "Lwm2mSim.h"
+#include "UdpEchoServer.h"
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Bound of the wait of the callbacks on the event loop, BRIDGE_MATTER_LOOP_WAIT_MS of main.cpp
+constexpr uint32_t kLoopWaitMs = 1000;
+// The command task is not bound by the event loop and waits longer
+constexpr uint32_t kCommandWaitMs = 2000;
+constexpr uint8_t kCoapServiceUnavailable = 0xA3;
+// Attributes and commands are forwarded to these resources of object 3311
+constexpr char kDimmerPath[] = "/3311/0/5851";
+constexpr char kOnOffPath[]  = "/3311/0/5850";
+
+/**
+ * Matter interaction of a controller, completed by the bridge
+ */
+struct Interaction
+{
+    BridgePath path;
+    uint16_t port;
+    // Value the write or the command sets
+    uint8_t value;
+    int64_t startUs;
+    bool success;
+    bool done;
+    std::mutex mutex;
+    std::condition_variable completed;
+};
+
+/**
+ * Request to the CoAP server of the bridge, posted to the event loop like the BindingCommandData of PostBindingCommand
+ */
+struct BindingRequest
+{
+    BridgePath path;
+    int64_t startUs;
+    sockaddr_in6 peer;
+    uint8_t token[8];
+    uint8_t tokenLength;
+};
+
+HostEventLoop * sLoop;
+uint32_t sDevices;
+
+// Socket of the CoAP requests sent from the event loop, only used by the event loop
+int sLoopFd;
+uint16_t sLoopMessageId = 1;
+
+// Invokes handed from the event loop to the command task, like gForwardedInvokeQueue of main.cpp
+std::mutex sCommandMutex;
+std::condition_variable sCommandQueued;
+std::deque<Interaction *> sCommandQueue;
+bool sCommandTaskStopped = false;
+
+// CoAP server of the bridge and the socket of the event loop towards the bound Matter device
+int sServerFd;
+std::atomic<uint16_t> sServerMessageId{ 1 };
+int sMatterFd;
+sockaddr_in sMatterDevice;
+HostCommandChannel<BindingRequest, 64> * sBindingChannel;
+// Matter interactions in flight by their id, only used by the event loop
+std::map<uint32_t, BindingRequest> sPendingInteractions;
+uint32_t sNextInteraction = 0;
+
+/**
+ * Function used to send a confirmable request to a device and wait up to wait_ms for its response
+ * Stands in for the requests of CoapClient.cpp, without retransmissions
+ * Returns false if no response arrived in time
+ */
+bool Exchange(int fd, uint16_t & message_id, uint16_t port, uint8_t code, const char * path, const std::vector<uint8_t> & payload,
+              uint32_t wait_ms, uint8_t & response_code)
+{
+    CoapMessage request;
+    request.code        = code;
+    request.messageId   = message_id++;
+    request.tokenLength = 2;
+    memcpy(request.token, &request.messageId, 2);
+    request.path              = path;
+    request.payload           = payload;
+    std::vector<uint8_t> data = CoapEncode(request);
+    sockaddr_in6 to           = TargetAddress("::1", port);
+    sendto(fd, data.data(), data.size(), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+    int64_t deadline = NowUs() + static_cast<int64_t>(wait_ms) * 1000;
+    for (int64_t now = NowUs(); now < deadline; now = NowUs()) {
+        pollfd fds = { fd, POLLIN, 0 };
+        if (poll(&fds, 1, static_cast<int>((deadline - now) / 1000 + 1)) <= 0) {
+            continue;
+        }
+        uint8_t buffer[1500];
+        ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+        CoapMessage response;
+        // Late responses of requests that have already timed out are dropped
+        if (size > 0 && CoapDecode(buffer, static_cast<size_t>(size), response) && response.type == kCoapAck &&
+            response.messageId == request.messageId) {
+            response_code = response.code;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Complete(Interaction & interaction, bool success)
+{
+    std::lock_guard<std::mutex> lock(interaction.mutex);
+    interaction.success = success;
+    interaction.done    = true;
+    interaction.completed.notify_one();
+}
+
+/**
+ * Function used to forward a Matter read or write to the LwM2M device
+ * Runs on the event loop and blocks it for the exchange, like emberAfExternalAttributeReadCallback and
+ * emberAfExternalAttributeWriteCallback
+ */
+void ForwardAttribute(intptr_t context)
+{
+    auto * interaction = reinterpret_cast<Interaction *>(context);
+    bool write         = interaction->path == BridgePath::kMatterWrite;
+    bool success;
+    {
+        BridgeLatencyScope latency(interaction->path);
+        std::vector<uint8_t> payload;
+        if (write) {
+            payload = { interaction->value, 0, 0, 0 };
+        }
+        uint8_t code = kCoapEmpty;
+        success      = Exchange(sLoopFd, sLoopMessageId, interaction->port, write ? kCoapPut : kCoapGet, kDimmerPath, payload,
+                                kLoopWaitMs, code) &&
+            code == (write ? kCoapChanged : kCoapContent);
+        latency.SetSuccess(success);
+    }
+    Complete(*interaction, success);
+}
+
+/**
+ * Function used to answer an invoke once the command task has forwarded it, runs on the event loop like
+ * CompleteForwardedInvoke
+ */
+void CompleteInvoke(intptr_t context)
+{
+    auto * interaction = reinterpret_cast<Interaction *>(context);
+    BridgeLatencyEnd(BridgePath::kMatterCommand, interaction->startUs, interaction->success);
+    Complete(*interaction, interaction->success);
+}
+
+/**
+ * Function used to hand an invoke to the command task, runs on the event loop like emberAfActionsClusterInstantActionCallback
+ */
+void Invoke(intptr_t context)
+{
+    auto * interaction   = reinterpret_cast<Interaction *>(context);
+    interaction->startUs = BridgeLatencyBegin(BridgePath::kMatterCommand);
+    {
+        std::lock_guard<std::mutex> lock(sCommandMutex);
+        sCommandQueue.push_back(interaction);
+    }
+    sCommandQueued.notify_one();
+}
+
+/**
+ * Task used to send the invokes to the LwM2M devices, like CommandForwardingTask
+ */
+void CommandTask()
+{
+    uint16_t port       = 0;
+    int fd              = OpenSocket("::1", port);
+    uint16_t message_id = 1;
+    while (true) {
+        Interaction * interaction;
+        {
+            std::unique_lock<std::mutex> lock(sCommandMutex);
+            sCommandQueued.wait(lock, [] { return sCommandTaskStopped || !sCommandQueue.empty(); });
+            if (sCommandQueue.empty()) {
+                break;
+            }
+            interaction = sCommandQueue.front();
+            sCommandQueue.pop_front();
+        }
+        uint8_t code         = kCoapEmpty;
+        interaction->success = Exchange(fd, message_id, interaction->port, kCoapPut, kOnOffPath, { interaction->value },
+                                        kCommandWaitMs, code) &&
+            code == kCoapChanged;
+        while (!sLoop->ScheduleWork(CompleteInvoke, reinterpret_cast<intptr_t>(interaction))) {
+            std::this_thread::yield();
+        }
+    }
+    close(fd);
+}
+
+/**
+ * Function used to send the separate response to a request of the CoAP server and end its round trip
+ */
+void SendResponse(const BindingRequest & request, uint8_t code)
+{
+    BridgeLatencyEnd(request.path, request.startUs, (code >> 5) == 2);
+    CoapMessage response;
+    response.type        = kCoapCon;
+    response.code        = code;
+    response.messageId   = sServerMessageId++;
+    response.tokenLength = request.tokenLength;
+    memcpy(response.token, request.token, request.tokenLength);
+    std::vector<uint8_t> data = CoapEncode(response);
+    sendto(sServerFd, data.data(), data.size(), 0, reinterpret_cast<const sockaddr *>(&request.peer), sizeof(request.peer));
+}
+
+/**
+ * Function used to start the Matter interaction of a request of the CoAP server, runs on the event loop like the
+ * processing of the binding commands
+ */
+void ProcessBindingRequest(const BindingRequest & request)
+{
+    uint32_t id              = sNextInteraction++;
+    sPendingInteractions[id] = request;
+    uint8_t interaction[32]  = {};
+    memcpy(interaction, &id, sizeof(id));
+    sendto(sMatterFd, interaction, sizeof(interaction), 0, reinterpret_cast<const sockaddr *>(&sMatterDevice), sizeof(sMatterDevice));
+}
+
+/**
+ * Function used to answer a request of the CoAP server once the bound Matter device has answered
+ */
+void ReceiveMatterResponse(int fd, intptr_t context)
+{
+    uint8_t buffer[64];
+    ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+    uint32_t id;
+    if (size < static_cast<ssize_t>(sizeof(id))) {
+        return;
+    }
+    memcpy(&id, buffer, sizeof(id));
+    auto found = sPendingInteractions.find(id);
+    if (found == sPendingInteractions.end()) {
+        return;
+    }
+    SendResponse(found->second, found->second.path == BridgePath::kCoapRead ? kCoapContent : kCoapChanged);
+    sPendingInteractions.erase(found);
+}
+
+/**
+ * Task used to receive the requests of the CoAP server, acknowledge them and post them to the event loop
+ */
+void CoapServerTask(const std::atomic<bool> & stopped)
+{
+    while (!stopped.load()) {
+        pollfd fds = { sServerFd, POLLIN, 0 };
+        if (poll(&fds, 1, 10) <= 0) {
+            continue;
+        }
+        uint8_t buffer[1500];
+        sockaddr_in6 from;
+        socklen_t length = sizeof(from);
+        ssize_t size     = recvfrom(sServerFd, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr *>(&from), &length);
+        CoapMessage request;
+        if (size <= 0 || !CoapDecode(buffer, static_cast<size_t>(size), request) || request.type != kCoapCon ||
+            (request.code != kCoapGet && request.code != kCoapPut)) {
+            continue;
+        }
+        BindingRequest binding;
+        binding.path        = request.code == kCoapGet ? BridgePath::kCoapRead : BridgePath::kCoapWrite;
+        binding.startUs     = BridgeLatencyBegin(binding.path);
+        binding.peer        = from;
+        binding.tokenLength = request.tokenLength;
+        memcpy(binding.token, request.token, request.tokenLength);
+
+        // Empty acknowledgement, the response follows once the Matter interaction has finished
+        CoapMessage ack;
+        ack.type                  = kCoapAck;
+        ack.messageId             = request.messageId;
+        std::vector<uint8_t> data = CoapEncode(ack);
+        sendto(sServerFd, data.data(), data.size(), 0, reinterpret_cast<const sockaddr *>(&from), length);
+        if (!sBindingChannel->Post(binding)) {
+            SendResponse(binding, kCoapServiceUnavailable);
+        }
+    }
+}
+
+void Print(const char * mode, uint32_t concurrency, const BridgePathStats & stats, const LatencyHistogram & caller)
+{
+    printf("{\"bench\":\"bridge_roundtrip\",\"mode\":\"%s\",\"bridge\":\"model\",\"devices\":%u,\"concurrency\":%u,\"path\":\"%s\","
+           "\"count\":%u,\"failures\":%u,\"p50_us\":%u,\"p99_us\":%u,\"p999_us\":%u,\"max_us\":%u,\"throughput_per_s\":%u.%03u,"
+           "\"max_in_flight\":%u,\"caller\":{",
+           mode, sDevices, concurrency, stats.name, stats.count, stats.failures, stats.p50Us, stats.p99Us, stats.p999Us, stats.maxUs,
+           stats.throughputMilli / 1000, stats.throughputMilli % 1000, stats.maxInFlight);
+    HostBenchPrintLatency(caller);
+    printf("}}\n");
+    fflush(stdout);
+}
+
+/**
+ * Function used to send Matter interactions from concurrency controllers, each waits for its interaction to
+ * complete before it sends the next one
+ */
+bool RunMatter(const char * mode, BridgePath path, const std::vector<uint16_t> & ports, uint32_t concurrency, uint64_t requests)
+{
+    LatencyHistogram caller;
+    ResetBridgeLatencies();
+    std::vector<std::thread> controllers;
+    for (uint32_t c = 0; c < concurrency; c++) {
+        controllers.emplace_back([&, c] {
+            Interaction interaction;
+            interaction.path = path;
+            for (uint64_t i = c; i < requests; i += concurrency) {
+                interaction.port  = ports[i % ports.size()];
+                interaction.value = static_cast<uint8_t>(path == BridgePath::kMatterCommand ? i & 1 : i % 101);
+                interaction.done  = false;
+                int64_t sent      = NowUs();
+                while (!sLoop->ScheduleWork(path == BridgePath::kMatterCommand ? Invoke : ForwardAttribute,
+                                            reinterpret_cast<intptr_t>(&interaction))) {
+                    std::this_thread::yield();
+                }
+                std::unique_lock<std::mutex> lock(interaction.mutex);
+                interaction.completed.wait(lock, [&] { return interaction.done; });
+                caller.Record(static_cast<uint32_t>(NowUs() - sent));
+            }
+        });
+    }
+    for (std::thread & controller : controllers) {
+        controller.join();
+    }
+    BridgePathStats stats = GetBridgePathStats(path);
+    Print(mode, concurrency, stats, caller);
+    return stats.count == requests && stats.failures == 0;
+}
+
+/**
+ * Function used to send requests to the CoAP server of the bridge with at most concurrency of them outstanding
+ */
+bool RunCoap(const char * mode, BridgePath path, uint16_t server_port, uint32_t concurrency, uint64_t requests)
+{
+    ResetBridgeLatencies();
+    LoadOptions load;
+    load.target      = "::1";
+    load.ports       = { server_port };
+    load.path        = kDimmerPath;
+    load.put         = path == BridgePath::kCoapWrite;
+    load.concurrency = concurrency;
+    load.requests    = requests;
+    LoadResult result;
+    RunLoad(load, result);
+    BridgePathStats stats = GetBridgePathStats(path);
+    Print(mode, concurrency, stats, result.latency);
+    return result.completed == requests && stats.failures == 0;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    std::vector<SimObjectDefinition> objects;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--xml") == 0) {
+            objects.push_back(LoadSimObjectDefinition(argv[i + 1]));
+        }
+    }
+    if (objects.empty() || objects.back().id < 0) {
+        fprintf(stderr, "bridge_roundtrip_bench: an --xml object definition of object 3311 is needed\n");
+        return EXIT_FAILURE;
+    }
+    sDevices             = static_cast<uint32_t>(HostBenchOption(argc, argv, "--devices", 8));
+    uint32_t concurrency = static_cast<uint32_t>(HostBenchOption(argc, argv, "--concurrency", 8));
+    uint64_t requests    = HostBenchOption(argc, argv, "--requests", 20000);
+
+    Fleet::Options options;
+    options.devices   = sDevices;
+    options.bind      = "::1";
+    options.basePort  = 0;
+    options.latencyUs = static_cast<uint32_t>(HostBenchOption(argc, argv, "--latency-ms", 0) * 1000);
+    Fleet fleet(options, objects);
+    if (!fleet.Open()) {
+        return EXIT_FAILURE;
+    }
+    std::atomic<bool> stopped{ false };
+    std::thread devices([&] { fleet.Run(stopped); });
+
+    HostEventLoop loop;
+    sLoop              = &loop;
+    uint16_t loop_port = 0;
+    sLoopFd            = OpenSocket("::1", loop_port);
+    UdpEchoServer matter_device;
+    sMatterFd     = LossyProxy::OpenLoopbackSocket(nullptr);
+    sMatterDevice = LossyProxy::LoopbackAddress(matter_device.Port());
+    loop.WatchSocket(sMatterFd, ReceiveMatterResponse, 0);
+    HostCommandChannel<BindingRequest, 64> channel(loop, ProcessBindingRequest);
+    sBindingChannel = &channel;
+    std::thread loop_thread([&] { loop.Run(); });
+    std::thread command_task(CommandTask);
+    uint16_t server_port = 0;
+    sServerFd            = OpenSocket("::1", server_port);
+    std::thread server_task([&] { CoapServerTask(stopped); });
+
+    bool ok = true;
+    ok      = RunMatter("matter_read", BridgePath::kMatterRead, fleet.Ports(), concurrency, requests) && ok;
+    ok      = RunMatter("matter_write", BridgePath::kMatterWrite, fleet.Ports(), concurrency, requests) && ok;
+    ok      = RunMatter("matter_command", BridgePath::kMatterCommand, fleet.Ports(), concurrency, requests) && ok;
+    ok      = RunCoap("coap_read", BridgePath::kCoapRead, server_port, concurrency, requests) && ok;
+    ok      = RunCoap("coap_write", BridgePath::kCoapWrite, server_port, concurrency, requests) && ok;
+
+    stopped = true;
+    server_task.join();
+    {
+        std::lock_guard<std::mutex> lock(sCommandMutex);
+        sCommandTaskStopped = true;
+    }
+    sCommandQueued.notify_one();
+    command_task.join();
+    loop.Stop();
+    loop_thread.join();
+    devices.join();
+    close(sServerFd);
+    close(sMatterFd);
+    close(sLoopFd);
+    if (!ok) {
+        fprintf(stderr, "bridge_roundtrip_bench: round trips failed or were lost\n");
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
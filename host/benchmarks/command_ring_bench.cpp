@@ -0,0 +1,98 @@
+// Throughput benchmark of handing commands over to the Matter event loop
+// "schedule_work" allocates every command and posts its own work item, like before the command rings
+// "ring" copies the command into a ring slot and schedules one drain work item per burst
+#include "HostBench.h"
+#include "HostCommandChannel.h"
+#include "HostEventLoop.h"
+#include <cstring>
+#include <thread>
+
+namespace {
+
+constexpr size_t kRingSize = 16;
+
+// Roughly the size of BindingCommandData with an inline TLV value
+struct Command
+{
+    uint64_t sequence;
+    uint8_t payload[248];
+};
+
+uint64_t sProcessed;
+uint64_t sChecksum;
+
+void ProcessCommand(const Command & command)
+{
+    sProcessed++;
+    sChecksum += command.sequence + command.payload[0];
+}
+
+void ProcessAllocatedCommand(intptr_t context)
+{
+    Command * command = reinterpret_cast<Command *>(context);
+    ProcessCommand(*command);
+    delete command;
+}
+
+void Report(const char * mode, uint64_t commands, int64_t elapsed_ns, uint64_t work_items, uint64_t retries)
+{
+    printf("{\"bench\":\"command_handoff\",\"mode\":\"%s\",\"commands\":%llu,\"commands_per_s\":%.0f,\"work_items\":%llu,"
+           "\"mean_batch\":%.2f,\"producer_retries\":%llu}\n",
+           mode, static_cast<unsigned long long>(commands), commands * 1e9 / static_cast<double>(elapsed_ns),
+           static_cast<unsigned long long>(work_items), work_items > 0 ? static_cast<double>(commands) / work_items : 0.0,
+           static_cast<unsigned long long>(retries));
+}
+
+void RunScheduleWork(uint64_t commands)
+{
+    HostEventLoop loop;
+    sProcessed = 0;
+    std::thread loop_thread([&] { loop.Run(); });
+    uint64_t retries = 0;
+    int64_t start    = HostBenchNowNs();
+    for (uint64_t sequence = 0; sequence < commands; sequence++) {
+        Command * command  = new Command;
+        command->sequence  = sequence;
+        memset(command->payload, static_cast<int>(sequence), sizeof(command->payload));
+        while (!loop.ScheduleWork(ProcessAllocatedCommand, reinterpret_cast<intptr_t>(command))) {
+            retries++;
+            std::this_thread::yield();
+        }
+    }
+    uint64_t work_items = loop.ScheduledCount();
+    loop.Stop();
+    loop_thread.join();
+    Report("schedule_work", sProcessed, HostBenchNowNs() - start, work_items, retries);
+}
+
+void RunRing(uint64_t commands)
+{
+    HostEventLoop loop;
+    HostCommandChannel<Command, kRingSize> channel(loop, ProcessCommand);
+    sProcessed = 0;
+    std::thread loop_thread([&] { loop.Run(); });
+    uint64_t retries = 0;
+    int64_t start    = HostBenchNowNs();
+    Command command;
+    for (uint64_t sequence = 0; sequence < commands; sequence++) {
+        command.sequence = sequence;
+        memset(command.payload, static_cast<int>(sequence), sizeof(command.payload));
+        while (!channel.Post(command)) {
+            retries++;
+            std::this_thread::yield();
+        }
+    }
+    loop.Stop();
+    loop_thread.join();
+    Report("ring", sProcessed, HostBenchNowNs() - start, channel.DrainCount(), retries);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    uint64_t commands = HostBenchOption(argc, argv, "--commands", 2000000);
+    RunScheduleWork(commands);
+    RunRing(commands);
+    return 0;
+}
@@ -0,0 +1,200 @@
+// Harness of the hedged requests to the configuration servers
+// Three local stand-in servers answer behind LossyProxy instances with injected delays: the first one never answers,
+// the second one is fast but has a heavy tail and the third one is slower but steady. The fetches are decided by the
+// ConfigFetchPlan of ConfigMirrors.cpp like in LoadConfigDocument, only libcoap is replaced by plain UDP datagrams and
+// every document is a single block
+// Every mode runs two boots in separate processes that share the persisted response times, so the second boot shows
+// which server is tried first after a reboot
+#include "ConfigMirrors.h"
+#include "HostBench.h"
+#include "LatencyHistogram.h"
+#include "LossyProxy.h"
+#include "UdpEchoServer.h"
+#include <dirent.h>
+#include <sys/wait.h>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace {
+
+constexpr size_t kMirrorCount = 3;
+constexpr size_t kTailMirror  = 1;
+
+struct Request
+{
+    uint32_t fetch;
+    uint32_t mirror;
+};
+
+struct StandIn
+{
+    UdpEchoServer server;
+    std::unique_ptr<LossyProxy> proxy;
+};
+
+int64_t NowMs()
+{
+    return HostBenchNowNs() / 1000000;
+}
+
+/**
+ * Function used to fetch a document with the ConfigFetchPlan of LoadConfigDocument, only the transport is replaced
+ * Without hedging the next server is only asked on failures
+ * Returns the time until a server answered in microseconds, or a negative value if no server answered
+ */
+int64_t Fetch(StandIn * stand_ins, uint32_t fetch, bool hedging, uint32_t timeout_ms, uint32_t & hedges)
+{
+    ConfigFetchPlan plan(hedging);
+    int fds[kMaxConfigMirrors];
+    int64_t start_ns = HostBenchNowNs();
+
+    while (!plan.HasWinner()) {
+        int64_t now                = NowMs();
+        ConfigFetchPlan::Step step = plan.Next(now);
+        if (step.action == ConfigFetchPlan::Action::kLaunch) {
+            fds[step.attempt] = LossyProxy::OpenLoopbackSocket(nullptr);
+            if (step.hedge) {
+                hedges++;
+            }
+            Request request     = { fetch, static_cast<uint32_t>(step.mirror) };
+            sockaddr_in address = LossyProxy::LoopbackAddress(stand_ins[step.mirror].proxy->Port());
+            sendto(fds[step.attempt], &request, sizeof(request), 0, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+            plan.Started(step.attempt, now, timeout_ms);
+            continue;
+        }
+        if (step.action == ConfigFetchPlan::Action::kGiveUp) {
+            break;
+        }
+        pollfd polled[kMaxConfigMirrors];
+        size_t indices[kMaxConfigMirrors];
+        nfds_t count = 0;
+        for (size_t i = 0; i < plan.Launched(); i++) {
+            if (!plan.Finished(i)) {
+                polled[count]    = { fds[i], POLLIN, 0 };
+                indices[count++] = i;
+            }
+        }
+        if (poll(polled, count, static_cast<int>(std::max<int64_t>(step.wakeMs - now, 1))) <= 0) {
+            continue;
+        }
+        for (nfds_t i = 0; i < count && !plan.HasWinner(); i++) {
+            Request response;
+            if ((polled[i].revents & POLLIN) && recv(polled[i].fd, &response, sizeof(response), 0) == sizeof(response) &&
+                response.fetch == fetch) {
+                plan.Completed(indices[i], NowMs(), 1);
+            }
+        }
+    }
+
+    plan.Finish(NowMs());
+    for (size_t i = 0; i < plan.Launched(); i++) {
+        close(fds[i]);
+    }
+    return plan.HasWinner() ? (HostBenchNowNs() - start_ns) / 1000 : -1;
+}
+
+/**
+ * Function used to run the fetches of a single boot, returns whether the fastest healthy server was tried first
+ */
+bool RunBoot(const char * mode, bool hedging, int boot, uint32_t fetches, uint32_t timeout_ms)
+{
+    StandIn stand_ins[kMirrorCount];
+    LossyProxy::Options options[kMirrorCount];
+    // The first server never answers
+    options[0].lossPercent = 100;
+    // Fast with a heavy tail, the delay applies to both directions
+    options[1].delayUs     = 5000;
+    options[1].jitterUs    = 2000;
+    options[1].tailPercent = 1;
+    options[1].tailDelayUs = 1000000;
+    // Slower but steady
+    options[2].delayUs  = 20000;
+    options[2].jitterUs = 5000;
+    for (size_t i = 0; i < kMirrorCount; i++) {
+        options[i].seed     = static_cast<uint32_t>(boot * 10 + i);
+        stand_ins[i].proxy = std::make_unique<LossyProxy>(stand_ins[i].server.Port(), options[i]);
+    }
+
+    size_t order[kMaxConfigMirrors];
+    ConfigMirrorsGetOrder(order, kMaxConfigMirrors);
+    size_t first_mirror = order[0];
+
+    LatencyHistogram latency;
+    uint32_t hedges = 0;
+    uint32_t failed = 0;
+    for (uint32_t fetch = 0; fetch < fetches; fetch++) {
+        int64_t elapsed_us = Fetch(stand_ins, fetch, hedging, timeout_ms, hedges);
+        if (elapsed_us < 0) {
+            failed++;
+        } else {
+            latency.Record(static_cast<uint32_t>(elapsed_us));
+        }
+    }
+    ConfigMirrorsPersist();
+
+    ConfigMirrorInfo infos[kMaxConfigMirrors];
+    size_t count = GetConfigMirrorInfo(infos, kMaxConfigMirrors);
+    printf("{\"bench\":\"config_mirrors\",\"mode\":\"%s\",\"boot\":%d,\"first_mirror\":\"%s\",\"fetches\":%u,\"failed\":%u,"
+           "\"hedges\":%u,",
+           mode, boot, ConfigMirrorGetUri(first_mirror), fetches, failed, hedges);
+    HostBenchPrintLatency(latency);
+    printf(",\"mirrors\":[");
+    for (size_t i = 0; i < count; i++) {
+        printf("%s{\"uri\":\"%s\",\"healthy\":%s,\"median_ms\":%u,\"budget_ms\":%u,\"wins\":%u,\"hedges\":%u,\"failures\":%u}",
+               i > 0 ? "," : "", infos[i].uri, infos[i].healthy ? "true" : "false", infos[i].medianMs, infos[i].budgetMs,
+               infos[i].wins, infos[i].hedges, infos[i].failures);
+    }
+    printf("]}\n");
+    fflush(stdout);
+
+    // After the first boot the fastest healthy server has to come first
+    return boot == 1 || first_mirror == kTailMirror;
+}
+
+void ClearDirectory(const char * path)
+{
+    DIR * dir = opendir(path);
+    while (dirent * entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            unlink((std::string(path) + "/" + entry->d_name).c_str());
+        }
+    }
+    closedir(dir);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    uint32_t fetches    = static_cast<uint32_t>(HostBenchOption(argc, argv, "--fetches", 400));
+    uint32_t timeout_ms = static_cast<uint32_t>(HostBenchOption(argc, argv, "--timeout-ms", 6000));
+
+    char nvs_path[] = "/tmp/config_mirror_harness.XXXXXX";
+    if (mkdtemp(nvs_path) == nullptr) {
+        return EXIT_FAILURE;
+    }
+    setenv("HOST_NVS_PATH", nvs_path, 1);
+
+    int status = EXIT_SUCCESS;
+    for (bool hedging : { false, true }) {
+        ClearDirectory(nvs_path);
+        for (int boot = 1; boot <= 2; boot++) {
+            // Every boot starts with the state of a fresh process, only NVS is kept
+            pid_t child = fork();
+            if (child == 0) {
+                _exit(RunBoot(hedging ? "hedged" : "sequential", hedging, boot, fetches, timeout_ms) ? EXIT_SUCCESS
+                                                                                                     : EXIT_FAILURE);
+            }
+            int child_status;
+            if (child < 0 || waitpid(child, &child_status, 0) != child || !WIFEXITED(child_status) ||
+                WEXITSTATUS(child_status) != EXIT_SUCCESS) {
+                status = EXIT_FAILURE;
+            }
+        }
+    }
+    ClearDirectory(nvs_path);
+    rmdir(nvs_path);
+    return status;
+}
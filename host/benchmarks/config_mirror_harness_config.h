@@ -0,0 +1,3 @@
+// Configuration servers of config_mirror_harness, they are mapped to local stand-in servers by their position
+#undef CONFIG_BRIDGE_CONFIG_MIRRORS
+#define CONFIG_BRIDGE_CONFIG_MIRRORS "coap://mirror-down,coap://mirror-tail,coap://mirror-steady"
@@ -0,0 +1,160 @@
+// Benchmark of a model of the hand-off of a CoAP request into the Matter event loop
+// "task" receives on its own thread and hands every request over with a heap-allocated command and ScheduleWork,
+// "loop" watches the socket from the event loop itself like CONFIG_BRIDGE_COAP_ON_MATTER_LOOP
+// Every request is answered from the event loop, the client measures the round trip time
+// The requests are plain UDP datagrams and the event loop is HostEventLoop. The dispatch of CoapServer.cpp, libcoap
+// and the Matter event loop are not built on the host, so the numbers show the cost of the hand-off pattern only
+#include "HostBench.h"
+#include "HostEventLoop.h"
+#include "LatencyHistogram.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+constexpr uint64_t kStopSequence = UINT64_MAX;
+constexpr uint64_t kWarmupRequests = 100;
+
+struct Request
+{
+    uint64_t sequence;
+    // Padding up to the size of a small CoAP request
+    uint8_t payload[48];
+};
+
+struct Command
+{
+    Request request;
+    sockaddr_in peer;
+};
+
+int sServerFd;
+HostEventLoop * sLoop;
+
+int OpenSocket(sockaddr_in & address)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&address, 0, sizeof(address));
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+    return fd;
+}
+
+/**
+ * Function used to handle a request on the event loop, the response stands in for the forwarded Matter interaction
+ */
+void ProcessRequest(const Request & request, const sockaddr_in & peer)
+{
+    sendto(sServerFd, &request, sizeof(request), 0, reinterpret_cast<const sockaddr *>(&peer), sizeof(peer));
+}
+
+void ProcessCommand(intptr_t context)
+{
+    Command * command = reinterpret_cast<Command *>(context);
+    ProcessRequest(command->request, command->peer);
+    delete command;
+}
+
+/**
+ * Function used to receive requests on a separate task and hand them over to the event loop
+ */
+void CoapTask()
+{
+    while (true) {
+        Command * command = new Command;
+        socklen_t length  = sizeof(command->peer);
+        ssize_t received  = recvfrom(sServerFd, &command->request, sizeof(command->request), 0,
+                                     reinterpret_cast<sockaddr *>(&command->peer), &length);
+        if (received != sizeof(Request) || command->request.sequence == kStopSequence) {
+            delete command;
+            return;
+        }
+        sLoop->ScheduleWork(ProcessCommand, reinterpret_cast<intptr_t>(command));
+    }
+}
+
+/**
+ * Function used to receive requests directly on the event loop
+ */
+void OnSocketReadable(int fd, intptr_t)
+{
+    Request request;
+    sockaddr_in peer;
+    socklen_t length = sizeof(peer);
+    while (recvfrom(fd, &request, sizeof(request), MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&peer), &length) ==
+           sizeof(Request)) {
+        ProcessRequest(request, peer);
+        length = sizeof(peer);
+    }
+}
+
+void RunMode(const char * mode, uint64_t requests)
+{
+    sockaddr_in server_address;
+    sServerFd = OpenSocket(server_address);
+    HostEventLoop loop;
+    sLoop          = &loop;
+    bool on_loop   = strcmp(mode, "loop") == 0;
+    if (on_loop) {
+        loop.WatchSocket(sServerFd, OnSocketReadable, 0);
+    }
+    std::thread loop_thread([&] { loop.Run(); });
+    std::thread coap_thread;
+    if (!on_loop) {
+        coap_thread = std::thread(CoapTask);
+    }
+
+    sockaddr_in client_address;
+    int client_fd = OpenSocket(client_address);
+    timeval timeout = { 1, 0 };
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    LatencyHistogram histogram;
+    uint64_t lost = 0;
+    Request request{};
+    for (uint64_t sequence = 0; sequence < requests + kWarmupRequests; sequence++) {
+        request.sequence = sequence;
+        int64_t start    = HostBenchNowNs();
+        sendto(client_fd, &request, sizeof(request), 0, reinterpret_cast<sockaddr *>(&server_address), sizeof(server_address));
+        Request response;
+        if (recv(client_fd, &response, sizeof(response), 0) != sizeof(Request) || response.sequence != sequence) {
+            lost++;
+            continue;
+        }
+        if (sequence >= kWarmupRequests) {
+            histogram.Record(static_cast<uint32_t>((HostBenchNowNs() - start) / 1000));
+        }
+    }
+
+    if (!on_loop) {
+        request.sequence = kStopSequence;
+        sendto(client_fd, &request, sizeof(request), 0, reinterpret_cast<sockaddr *>(&server_address), sizeof(server_address));
+        coap_thread.join();
+    }
+    loop.Stop();
+    loop_thread.join();
+    close(client_fd);
+    close(sServerFd);
+
+    printf("{\"bench\":\"forwarding_latency\",\"model\":\"handoff\",\"mode\":\"%s\",\"lost\":%llu,", mode, static_cast<unsigned long long>(lost));
+    HostBenchPrintLatency(histogram);
+    printf("}\n");
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    uint64_t requests = HostBenchOption(argc, argv, "--requests", 20000);
+    RunMode("task", requests);
+    RunMode("loop", requests);
+    return 0;
+}
@@ -0,0 +1,158 @@
+// Benchmark of the overhead the latency histograms of BridgeLatency.cpp add to every bridge path
+// "clock" takes the two timestamps of a round trip only, "record" adds LatencyHistogram::Record and "path" the whole
+// BridgeLatencyBegin and BridgeLatencyEnd, each from one thread and from --threads threads sharing the histogram
+// "stats" is the cost of GetBridgePathStats, which walks the buckets for every percentile
+// "echo" compares round trips through a local UDP echo server with and without BridgeLatencyBegin and BridgeLatencyEnd
+// around them, the overhead is usually below the noise of the round trip
+// Contended runs fail if a sample is lost
+#include "BridgeLatency.h"
+#include "HostBench.h"
+#include "LatencyHistogram.h"
+#include "LossyProxy.h"
+#include "UdpEchoServer.h"
+#include "esp_timer.h"
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Keeps the compiler from dropping the timestamps of the "clock" mode
+std::atomic<int64_t> sSink{ 0 };
+
+void Report(const char * mode, uint32_t threads, uint64_t ops, int64_t elapsed_ns)
+{
+    printf("{\"bench\":\"histogram_overhead\",\"mode\":\"%s\",\"threads\":%u,\"ops\":%llu,\"ns_per_op\":%.1f}\n", mode, threads,
+           static_cast<unsigned long long>(ops), static_cast<double>(elapsed_ns) / static_cast<double>(ops));
+}
+
+/**
+ * Function used to run an operation ops times on every thread, returns the wall time of the slowest thread
+ */
+template <typename Operation>
+int64_t RunThreads(uint32_t threads, uint64_t ops, Operation operation)
+{
+    std::atomic<uint32_t> ready{ 0 };
+    std::atomic<bool> go{ false };
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            ready++;
+            while (!go.load()) {
+            }
+            // Durations from a few to a few thousand microseconds, so the samples spread over the buckets
+            uint32_t value = 17 + t;
+            for (uint64_t i = 0; i < ops; i++) {
+                value = value * 1103515245u + 12345u;
+                operation((value >> 16) & 0xFFF);
+            }
+        });
+    }
+    while (ready.load() < threads) {
+    }
+    int64_t start = HostBenchNowNs();
+    go            = true;
+    for (std::thread & worker : workers) {
+        worker.join();
+    }
+    return HostBenchNowNs() - start;
+}
+
+bool RunModes(uint32_t threads, uint64_t ops)
+{
+    bool ok = true;
+
+    int64_t elapsed = RunThreads(threads, ops, [](uint32_t) {
+        int64_t start = esp_timer_get_time();
+        sSink.fetch_add(esp_timer_get_time() - start, std::memory_order_relaxed);
+    });
+    Report("clock", threads, ops, elapsed);
+
+    LatencyHistogram histogram;
+    elapsed = RunThreads(threads, ops, [&](uint32_t value) { histogram.Record(value); });
+    Report("record", threads, ops, elapsed);
+    ok = ok && histogram.Count() == threads * ops;
+
+    ResetBridgeLatencies();
+    elapsed = RunThreads(threads, ops, [](uint32_t value) {
+        int64_t start = BridgeLatencyBegin(BridgePath::kCoapRead);
+        BridgeLatencyEnd(BridgePath::kCoapRead, start, (value & 1) != 0);
+    });
+    Report("path", threads, ops, elapsed);
+    BridgePathStats stats = GetBridgePathStats(BridgePath::kCoapRead);
+    ok                    = ok && stats.count == threads * ops && stats.maxInFlight >= 1 && stats.maxInFlight <= threads;
+    if (!ok) {
+        fprintf(stderr, "histogram_overhead_bench: %u threads lost samples, %u of %llu recorded\n", threads, stats.count,
+                static_cast<unsigned long long>(threads * ops));
+    }
+    return ok;
+}
+
+void RunStats(uint64_t calls)
+{
+    uint64_t checksum = 0;
+    int64_t start     = HostBenchNowNs();
+    for (uint64_t i = 0; i < calls; i++) {
+        checksum += GetBridgePathStats(BridgePath::kCoapRead).p999Us;
+    }
+    Report("stats", 1, calls, HostBenchNowNs() - start);
+    sSink += static_cast<int64_t>(checksum);
+}
+
+/**
+ * Function used to send round trips to a local echo server, optionally measured like a bridge path
+ */
+int64_t RunEcho(uint16_t port, uint64_t round_trips, bool measured)
+{
+    int fd             = LossyProxy::OpenLoopbackSocket(nullptr);
+    sockaddr_in to     = LossyProxy::LoopbackAddress(port);
+    uint8_t buffer[64] = {};
+    int64_t start      = HostBenchNowNs();
+    for (uint64_t i = 0; i < round_trips; i++) {
+        int64_t path_start = measured ? BridgeLatencyBegin(BridgePath::kMatterRead) : 0;
+        sendto(fd, buffer, sizeof(buffer), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+        pollfd fds = { fd, POLLIN, 0 };
+        bool ok    = poll(&fds, 1, 1000) > 0 && recv(fd, buffer, sizeof(buffer), 0) == sizeof(buffer);
+        if (measured) {
+            BridgeLatencyEnd(BridgePath::kMatterRead, path_start, ok);
+        }
+    }
+    int64_t elapsed = HostBenchNowNs() - start;
+    close(fd);
+    return elapsed;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    uint64_t ops         = HostBenchOption(argc, argv, "--ops", 10000000);
+    uint32_t threads     = static_cast<uint32_t>(HostBenchOption(argc, argv, "--threads", 4));
+    uint64_t round_trips = HostBenchOption(argc, argv, "--round-trips", 50000);
+
+    bool ok = RunModes(1, ops);
+    if (threads > 1) {
+        ok = RunModes(threads, ops / threads) && ok;
+    }
+    RunStats(ops / 100 > 0 ? ops / 100 : 1);
+
+    UdpEchoServer server;
+    RunEcho(server.Port(), round_trips / 4, false);
+    ResetBridgeLatencies();
+    // Alternating runs, so a drift of the machine does not favour one of them
+    int64_t bare_ns     = 0;
+    int64_t measured_ns = 0;
+    for (int run = 0; run < 4; run++) {
+        bare_ns += RunEcho(server.Port(), round_trips / 4, false);
+        measured_ns += RunEcho(server.Port(), round_trips / 4, true);
+    }
+    BridgePathStats stats = GetBridgePathStats(BridgePath::kMatterRead);
+    printf("{\"bench\":\"histogram_overhead\",\"mode\":\"echo\",\"round_trips\":%llu,\"bare_ns_per_op\":%.0f,"
+           "\"measured_ns_per_op\":%.0f,\"overhead_percent\":%.2f,\"p50_us\":%u,\"p99_us\":%u,\"p999_us\":%u}\n",
+           static_cast<unsigned long long>(round_trips / 4 * 4), static_cast<double>(bare_ns) / (round_trips / 4 * 4),
+           static_cast<double>(measured_ns) / (round_trips / 4 * 4),
+           bare_ns > 0 ? 100.0 * (measured_ns - bare_ns) / bare_ns : 0.0, stats.p50Us, stats.p99Us, stats.p999Us);
+    ok = ok && stats.count == round_trips / 4 * 4;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,152 @@
+// Harness of the confirmable retransmission through a local lossy proxy
+// Requests are echoed by a local server behind a LossyProxy, every loss rate starts with a fresh destination
+// "fixed" retransmits after the RFC 7252 default timeout of two seconds, "cocoa" takes the initial timeout from the
+// CoCoA estimators of CongestionControl.cpp and reports every round trip time back to them
+// Both retransmit at most CONFIG_BRIDGE_COAP_MAX_RETRANSMIT times with a doubling timeout, without the random factor
+#include "CongestionControl.h"
+#include "HostBench.h"
+#include "LatencyHistogram.h"
+#include "LossyProxy.h"
+#include "UdpEchoServer.h"
+#include "esp_timer.h"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Message
+{
+    uint32_t sequence;
+    uint32_t transmission;
+    // Padding up to the size of a small CoAP request
+    uint8_t payload[40];
+};
+
+struct Result
+{
+    LatencyHistogram latency;
+    uint64_t completed     = 0;
+    uint64_t failed        = 0;
+    uint64_t transmissions = 0;
+    int64_t elapsedUs      = 0;
+    uint32_t finalRtoMs    = 0;
+};
+
+/**
+ * Function used to send a request and wait for its response, retransmitting with a doubling timeout
+ * Returns the time from the first transmission to the response, or a negative value if every transmission timed out
+ */
+int64_t Exchange(int fd, const sockaddr_in & to, uint32_t sequence, uint32_t initial_rto_ms, Result & result)
+{
+    Message message{};
+    message.sequence = sequence;
+    int64_t start    = esp_timer_get_time();
+    uint32_t timeout = initial_rto_ms;
+    for (uint32_t transmission = 0; transmission <= CONFIG_BRIDGE_COAP_MAX_RETRANSMIT; transmission++) {
+        message.transmission = transmission;
+        sendto(fd, &message, sizeof(message), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+        result.transmissions++;
+        int64_t deadline = esp_timer_get_time() + static_cast<int64_t>(timeout) * 1000;
+        for (int64_t now = esp_timer_get_time(); now < deadline; now = esp_timer_get_time()) {
+            pollfd fds = { fd, POLLIN, 0 };
+            if (poll(&fds, 1, static_cast<int>((deadline - now + 999) / 1000)) <= 0) {
+                continue;
+            }
+            Message response;
+            // Responses to earlier requests or duplicates of retransmissions are ignored
+            if (recv(fd, &response, sizeof(response), 0) == sizeof(response) && response.sequence == sequence) {
+                return esp_timer_get_time() - start;
+            }
+        }
+        timeout *= 2;
+    }
+    return -1;
+}
+
+void RunMode(bool cocoa, double loss_percent, uint32_t delay_ms, uint32_t requests, uint32_t fixed_rto_ms, Result & result)
+{
+    UdpEchoServer server;
+    LossyProxy::Options options;
+    options.lossPercent = loss_percent;
+    options.delayUs     = delay_ms * 1000;
+    options.jitterUs    = delay_ms * 500;
+    LossyProxy proxy(server.Port(), options);
+
+    int fd         = LossyProxy::OpenLoopbackSocket(nullptr);
+    sockaddr_in to = LossyProxy::LoopbackAddress(proxy.Port());
+    coap_address_t dst;
+    coap_address_init(&dst);
+    dst.size     = sizeof(to);
+    dst.addr.sin = to;
+
+    int64_t start = esp_timer_get_time();
+    for (uint32_t sequence = 0; sequence < requests; sequence++) {
+        if (cocoa && !CongestionAcquire(&dst)) {
+            result.failed++;
+            continue;
+        }
+        uint32_t rto_ms = cocoa ? CongestionGetRto(&dst) : fixed_rto_ms;
+        int64_t rtt_us  = Exchange(fd, to, sequence, rto_ms, result);
+        if (rtt_us >= 0) {
+            result.completed++;
+            result.latency.Record(static_cast<uint32_t>(rtt_us));
+            if (cocoa) {
+                CongestionReportRtt(&dst, static_cast<uint32_t>(rtt_us / 1000), rto_ms);
+            }
+        } else {
+            result.failed++;
+        }
+        if (cocoa) {
+            CongestionRelease(&dst);
+        }
+    }
+    result.elapsedUs  = esp_timer_get_time() - start;
+    result.finalRtoMs = cocoa ? CongestionGetRto(&dst) : fixed_rto_ms;
+    close(fd);
+}
+
+std::vector<double> ParseList(int argc, char ** argv, const char * name, const char * default_value)
+{
+    const char * value = default_value;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            value = argv[i + 1];
+        }
+    }
+    std::vector<double> list;
+    for (char * end = nullptr; *value != '\0'; value = *end == ',' ? end + 1 : end) {
+        list.push_back(strtod(value, &end));
+    }
+    return list;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    uint32_t requests     = static_cast<uint32_t>(HostBenchOption(argc, argv, "--requests", 200));
+    uint32_t delay_ms     = static_cast<uint32_t>(HostBenchOption(argc, argv, "--delay-ms", 20));
+    uint32_t fixed_rto_ms = static_cast<uint32_t>(HostBenchOption(argc, argv, "--fixed-rto-ms", 2000));
+    int status            = EXIT_SUCCESS;
+
+    for (double loss : ParseList(argc, argv, "--loss", "0,5,10,20")) {
+        for (bool cocoa : { false, true }) {
+            Result result;
+            RunMode(cocoa, loss, delay_ms, requests, fixed_rto_ms, result);
+            printf("{\"bench\":\"retransmission\",\"mode\":\"%s\",\"loss_percent\":%.1f,\"delay_ms\":%u,\"completed\":%llu,"
+                   "\"failed\":%llu,\"transmissions\":%llu,\"goodput_per_s\":%.2f,\"final_rto_ms\":%u,",
+                   cocoa ? "cocoa" : "fixed", loss, delay_ms, static_cast<unsigned long long>(result.completed),
+                   static_cast<unsigned long long>(result.failed), static_cast<unsigned long long>(result.transmissions),
+                   result.completed * 1e6 / static_cast<double>(result.elapsedUs), result.finalRtoMs);
+            HostBenchPrintLatency(result.latency);
+            printf("}\n");
+            // Without loss every request has to complete and the estimators have to learn the round trip time
+            if (loss == 0 && (result.failed != 0 || (cocoa && result.finalRtoMs >= 2000))) {
+                status = EXIT_FAILURE;
+            }
+        }
+    }
+    return status;
+}
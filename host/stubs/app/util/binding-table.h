@@ -0,0 +1,88 @@
+#ifndef HOST_BINDING_TABLE_H
+#define HOST_BINDING_TABLE_H
+
+// Host stand-in of the binding table of the CHIP SDK
+// The entries are added by the host tests instead of being loaded from persistent storage
+#include <lib/core/DataModelTypes.h>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef EMBER_BINDING_TABLE_SIZE
+#define EMBER_BINDING_TABLE_SIZE 10
+#endif
+
+enum EmberBindingType : uint8_t
+{
+    EMBER_UNUSED_BINDING   = 0,
+    EMBER_UNICAST_BINDING  = 1,
+    EMBER_MULTICAST_BINDING = 2,
+};
+
+struct EmberBindingTableEntry
+{
+    EmberBindingType type = EMBER_UNUSED_BINDING;
+    chip::FabricIndex fabricIndex = 0;
+    chip::EndpointId local = 0;
+    chip::Optional<chip::ClusterId> clusterId;
+    chip::EndpointId remote = 0;
+    chip::NodeId nodeId = 0;
+    chip::GroupId groupId = 0;
+};
+
+namespace chip {
+
+class BindingTable
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const BindingTable * table, uint8_t index) : mTable(table), mIndex(index) {}
+
+        const EmberBindingTableEntry & operator*() const { return mTable->mEntries[mIndex]; }
+        const EmberBindingTableEntry * operator->() const { return &mTable->mEntries[mIndex]; }
+        Iterator & operator++()
+        {
+            mIndex++;
+            return *this;
+        }
+        bool operator==(const Iterator & other) const { return mIndex == other.mIndex; }
+        bool operator!=(const Iterator & other) const { return mIndex != other.mIndex; }
+        uint8_t GetIndex() const { return mIndex; }
+
+    private:
+        const BindingTable * mTable;
+        uint8_t mIndex;
+    };
+
+    static BindingTable & GetInstance()
+    {
+        static BindingTable sInstance;
+        return sInstance;
+    }
+
+    // Returns false if the table is full
+    bool Add(const EmberBindingTableEntry & entry)
+    {
+        if (mSize >= EMBER_BINDING_TABLE_SIZE) {
+            return false;
+        }
+        mEntries[mSize++] = entry;
+        return true;
+    }
+
+    void Clear() { mSize = 0; }
+    size_t Size() const { return mSize; }
+    const EmberBindingTableEntry & GetAt(uint8_t index) const { return mEntries[index]; }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, mSize); }
+
+private:
+    EmberBindingTableEntry mEntries[EMBER_BINDING_TABLE_SIZE];
+    uint8_t mSize = 0;
+};
+
+} // namespace chip
+
+#endif //HOST_BINDING_TABLE_H
@@ -0,0 +1,69 @@
+#ifndef HOST_COAP_H
+#define HOST_COAP_H
+
+// Host stand-in of the parts of libcoap the portable modules of the bridge use
+// Like the ESP-IDF port of libcoap, it makes the configuration of the bridge available
+#include "sdkconfig.h"
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <cstdint>
+#include <cstring>
+
+struct coap_address_t
+{
+    socklen_t size;
+    union
+    {
+        struct sockaddr sa;
+        struct sockaddr_in sin;
+        struct sockaddr_in6 sin6;
+    } addr;
+};
+
+struct coap_fixed_point_t
+{
+    uint16_t integer_part;
+    uint16_t fractional_part;
+};
+
+// Only the transmission parameters of a session are modelled
+struct coap_session_t
+{
+    coap_fixed_point_t ack_timeout;
+    uint16_t max_retransmit;
+};
+
+inline void coap_address_init(coap_address_t * address)
+{
+    memset(address, 0, sizeof(*address));
+    address->size = sizeof(address->addr);
+}
+
+inline int coap_address_equals(const coap_address_t * a, const coap_address_t * b)
+{
+    if (a->addr.sa.sa_family != b->addr.sa.sa_family) {
+        return 0;
+    }
+    switch (a->addr.sa.sa_family) {
+        case AF_INET:
+            return a->addr.sin.sin_port == b->addr.sin.sin_port &&
+                a->addr.sin.sin_addr.s_addr == b->addr.sin.sin_addr.s_addr;
+        case AF_INET6:
+            return a->addr.sin6.sin6_port == b->addr.sin6.sin6_port &&
+                memcmp(&a->addr.sin6.sin6_addr, &b->addr.sin6.sin6_addr, sizeof(a->addr.sin6.sin6_addr)) == 0;
+        default:
+            return 0;
+    }
+}
+
+inline void coap_session_set_ack_timeout(coap_session_t * session, coap_fixed_point_t value)
+{
+    session->ack_timeout = value;
+}
+
+inline void coap_session_set_max_retransmit(coap_session_t * session, uint16_t value)
+{
+    session->max_retransmit = value;
+}
+
+#endif //HOST_COAP_H
@@ -0,0 +1,15 @@
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Host stand-in of the ESP-IDF timer, microseconds since an arbitrary point in time
+ */
+inline int64_t esp_timer_get_time()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif //HOST_ESP_TIMER_H
@@ -0,0 +1,39 @@
+#ifndef HOST_DATA_MODEL_TYPES_H
+#define HOST_DATA_MODEL_TYPES_H
+
+// Host stand-in of the data model types of the CHIP SDK
+#include <cstdint>
+
+namespace chip {
+
+typedef uint16_t EndpointId;
+typedef uint32_t ClusterId;
+typedef uint64_t NodeId;
+typedef uint16_t GroupId;
+typedef uint8_t FabricIndex;
+
+constexpr EndpointId kInvalidEndpointId = 0xFFFF;
+constexpr ClusterId kInvalidClusterId   = 0xFFFF'FFFF;
+
+/**
+ * Minimal chip::Optional, only what the binding table entries need
+ */
+template <typename T>
+class Optional
+{
+public:
+    Optional() = default;
+    explicit Optional(const T & value) : mValue(value), mHasValue(true) {}
+
+    bool HasValue() const { return mHasValue; }
+    const T & Value() const { return mValue; }
+    T ValueOr(T other) const { return mHasValue ? mValue : other; }
+
+private:
+    T mValue{};
+    bool mHasValue = false;
+};
+
+} // namespace chip
+
+#endif //HOST_DATA_MODEL_TYPES_H
@@ -0,0 +1,22 @@
+#ifndef HOST_CODE_UTILS_H
+#define HOST_CODE_UTILS_H
+
+// Host stand-in of the error handling macros of the CHIP SDK
+
+#define VerifyOrReturn(expr, ...)                                                                                                  \
+    do {                                                                                                                           \
+        if (!(expr)) {                                                                                                             \
+            __VA_ARGS__;                                                                                                           \
+            return;                                                                                                                \
+        }                                                                                                                          \
+    } while (false)
+
+#define VerifyOrReturnValue(expr, value, ...)                                                                                      \
+    do {                                                                                                                           \
+        if (!(expr)) {                                                                                                             \
+            __VA_ARGS__;                                                                                                           \
+            return (value);                                                                                                        \
+        }                                                                                                                          \
+    } while (false)
+
+#endif //HOST_CODE_UTILS_H
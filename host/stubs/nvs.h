@@ -0,0 +1,73 @@
+#ifndef HOST_NVS_H
+#define HOST_NVS_H
+
+// Host stand-in of the ESP-IDF non-volatile storage, only blobs are supported
+// Every blob is kept in a file named <namespace>.<key> below the directory given by the HOST_NVS_PATH environment
+// variable, so it survives a restart of the process like NVS survives a reboot. Without the variable nothing is found
+#include "sdkconfig.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+typedef int esp_err_t;
+typedef std::string * nvs_handle_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+
+typedef enum
+{
+    NVS_READONLY,
+    NVS_READWRITE,
+} nvs_open_mode_t;
+
+inline const char * esp_err_to_name(esp_err_t err)
+{
+    return err == ESP_OK ? "ESP_OK" : err == ESP_ERR_NVS_NOT_FOUND ? "ESP_ERR_NVS_NOT_FOUND" : "ESP_FAIL";
+}
+
+inline esp_err_t nvs_open(const char * name, nvs_open_mode_t, nvs_handle_t * handle)
+{
+    const char * path = getenv("HOST_NVS_PATH");
+    if (path == nullptr) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *handle = new std::string(std::string(path) + "/" + name + ".");
+    return ESP_OK;
+}
+
+inline void nvs_close(nvs_handle_t handle)
+{
+    delete handle;
+}
+
+inline esp_err_t nvs_get_blob(nvs_handle_t handle, const char * key, void * value, size_t * length)
+{
+    FILE * file = fopen((*handle + key).c_str(), "rb");
+    if (file == nullptr) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *length = fread(value, 1, *length, file);
+    fclose(file);
+    return ESP_OK;
+}
+
+inline esp_err_t nvs_set_blob(nvs_handle_t handle, const char * key, const void * value, size_t length)
+{
+    FILE * file = fopen((*handle + key).c_str(), "wb");
+    if (file == nullptr) {
+        return ESP_FAIL;
+    }
+    size_t written = fwrite(value, 1, length, file);
+    fclose(file);
+    return written == length ? ESP_OK : ESP_FAIL;
+}
+
+inline esp_err_t nvs_commit(nvs_handle_t)
+{
+    return ESP_OK;
+}
+
+#endif //HOST_NVS_H
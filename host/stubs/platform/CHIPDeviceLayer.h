@@ -0,0 +1,38 @@
+#ifndef HOST_CHIP_DEVICE_LAYER_H
+#define HOST_CHIP_DEVICE_LAYER_H
+
+// Host stand-in of the device layer of the CHIP SDK, only the system layer timers
+// Timers are accepted but never fire, the host tools report on their own
+#include "sdkconfig.h"
+#include "support/logging/CHIPLogging.h"
+#include <cstdint>
+
+namespace chip {
+namespace System {
+
+namespace Clock {
+typedef uint32_t Seconds32;
+} // namespace Clock
+
+class Layer
+{
+public:
+    typedef void (*TimerCompleteCallback)(Layer * layer, void * context);
+
+    void StartTimer(Clock::Seconds32, TimerCompleteCallback, void *) {}
+};
+
+} // namespace System
+
+namespace DeviceLayer {
+
+inline System::Layer & SystemLayer()
+{
+    static System::Layer sLayer;
+    return sLayer;
+}
+
+} // namespace DeviceLayer
+} // namespace chip
+
+#endif //HOST_CHIP_DEVICE_LAYER_H
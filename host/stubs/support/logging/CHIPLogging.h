@@ -0,0 +1,10 @@
+#ifndef HOST_CHIP_LOGGING_H
+#define HOST_CHIP_LOGGING_H
+
+// Host stand-in of the logging macros of the CHIP SDK, everything is written to stderr
+#include <cstdio>
+
+#define ChipLogError(module, fmt, ...) fprintf(stderr, "E [" #module "] " fmt "\n", ##__VA_ARGS__)
+#define ChipLogProgress(module, fmt, ...) fprintf(stderr, "I [" #module "] " fmt "\n", ##__VA_ARGS__)
+
+#endif //HOST_CHIP_LOGGING_H
@@ -0,0 +1,48 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Minimal checks shared by the host tests, a failed check is reported and makes the test exit with an error
+#include <cstdio>
+#include <cstdlib>
+
+inline int sHostTestFailures = 0;
+
+#define HOST_CHECK(condition)                                                                                                      \
+    do {                                                                                                                           \
+        if (!(condition)) {                                                                                                        \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                          \
+            sHostTestFailures++;                                                                                                   \
+        }                                                                                                                          \
+    } while (0)
+
+#define HOST_CHECK_EQ(a, b)                                                                                                        \
+    do {                                                                                                                           \
+        auto host_a = (a);                                                                                                         \
+        auto host_b = (b);                                                                                                         \
+        if (!(host_a == host_b)) {                                                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b,                          \
+                    static_cast<long long>(host_a), static_cast<long long>(host_b));                                               \
+            sHostTestFailures++;                                                                                                   \
+        }                                                                                                                          \
+    } while (0)
+
+/**
+ * Function used to run a test case and report its name
+ */
+template <typename Function>
+void HostTestRun(const char * name, Function && function)
+{
+    int failures = sHostTestFailures;
+    function();
+    printf("%s %s\n", sHostTestFailures == failures ? "[PASS]" : "[FAIL]", name);
+}
+
+/**
+ * Function used to get the exit code of a test
+ */
+inline int HostTestResult()
+{
+    return sHostTestFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif //HOST_TEST_H
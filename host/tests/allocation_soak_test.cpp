@@ -0,0 +1,185 @@
+// Soak test of the steady-state forwarding path
+// A producer task allocates a request context from an object pool and posts a command through a command ring, the
+// event loop looks up the bindings, records the latency, runs the congestion control and releases the context.
+// Every heap allocation of the process is counted, after the warm-up none may happen
+#include "BindingIndex.h"
+#include "CongestionControl.h"
+#include "HostBench.h"
+#include "HostCommandChannel.h"
+#include "HostEventLoop.h"
+#include "HostTest.h"
+#include "LatencyHistogram.h"
+#include "ObjectPool.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+extern "C" void * __libc_malloc(size_t size);
+extern "C" void * __libc_calloc(size_t count, size_t size);
+extern "C" void * __libc_realloc(void * pointer, size_t size);
+extern "C" void * __libc_memalign(size_t alignment, size_t size);
+extern "C" void __libc_free(void * pointer);
+
+namespace {
+
+std::atomic<uint64_t> sAllocations{ 0 };
+
+} // namespace
+
+// Every allocation of the process, including the C++ runtime and the C library, goes through these functions
+extern "C" void * malloc(size_t size)
+{
+    sAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void * calloc(size_t count, size_t size)
+{
+    sAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void * realloc(void * pointer, size_t size)
+{
+    sAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void * memalign(size_t alignment, size_t size)
+{
+    sAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void free(void * pointer)
+{
+    __libc_free(pointer);
+}
+
+void * operator new(size_t size)
+{
+    void * pointer = malloc(size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void * pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void * pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+namespace {
+
+constexpr size_t kRingSize        = 16;
+constexpr uint64_t kWarmupRequests = 10000;
+
+// Stand-in for the per-request context of a forwarded CoAP request
+struct RequestContext
+{
+    uint64_t sequence;
+    int64_t postedNs;
+    chip::EndpointId endpoint;
+    chip::ClusterId cluster;
+    uint8_t token[8];
+};
+
+struct Command
+{
+    RequestContext * context;
+};
+
+ObjectPool<RequestContext, 32> sContextPool("soak contexts");
+BindingIndex sBindingIndex;
+LatencyHistogram sLatency;
+coap_address_t sDestination;
+std::atomic<uint64_t> sProcessed{ 0 };
+uint64_t sRoutes;
+
+void ProcessCommand(const Command & command)
+{
+    RequestContext * context = command.context;
+    sBindingIndex.ForEach(context->endpoint, context->cluster, [](uint8_t) { sRoutes++; });
+    if (CongestionAcquire(&sDestination)) {
+        uint32_t rto = CongestionGetRto(&sDestination);
+        CongestionReportRtt(&sDestination, 20 + static_cast<uint32_t>(context->sequence % 50), rto);
+        CongestionRelease(&sDestination);
+    }
+    sLatency.Record(static_cast<uint32_t>((HostBenchNowNs() - context->postedNs) / 1000));
+    sContextPool.Release(context);
+    sProcessed.fetch_add(1, std::memory_order_release);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    uint64_t requests = HostBenchOption(argc, argv, "--requests", 1000000);
+
+    auto & table = chip::BindingTable::GetInstance();
+    for (chip::EndpointId endpoint = 1; endpoint <= 4; endpoint++) {
+        EmberBindingTableEntry entry;
+        entry.type      = EMBER_UNICAST_BINDING;
+        entry.local     = endpoint;
+        entry.clusterId = chip::Optional<chip::ClusterId>(6);
+        table.Add(entry);
+    }
+    sBindingIndex.Rebuild();
+    coap_address_init(&sDestination);
+    sDestination.addr.sin.sin_family      = AF_INET;
+    sDestination.addr.sin.sin_port        = htons(5683);
+    sDestination.addr.sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    HostEventLoop loop;
+    HostCommandChannel<Command, kRingSize> channel(loop, ProcessCommand);
+    std::thread loop_thread([&] { loop.Run(); });
+
+    uint64_t pool_exhausted = 0;
+    uint64_t steady_allocations = 0;
+    for (uint64_t sequence = 0; sequence < kWarmupRequests + requests; sequence++) {
+        if (sequence == kWarmupRequests) {
+            steady_allocations = sAllocations.load();
+        }
+        RequestContext * context;
+        while ((context = sContextPool.Allocate()) == nullptr) {
+            pool_exhausted++;
+            std::this_thread::yield();
+        }
+        context->sequence = sequence;
+        context->postedNs = HostBenchNowNs();
+        context->endpoint = static_cast<chip::EndpointId>(1 + sequence % 4);
+        context->cluster  = 6;
+        while (!channel.Post(Command{ context })) {
+            std::this_thread::yield();
+        }
+    }
+    while (sProcessed.load(std::memory_order_acquire) < kWarmupRequests + requests) {
+        std::this_thread::yield();
+    }
+    steady_allocations = sAllocations.load() - steady_allocations;
+
+    loop.Stop();
+    loop_thread.join();
+
+    HostTestRun("Zero allocations on the steady-state forwarding path", [&] {
+        // Starting the event loop thread allocates, which shows that the counting hooks are in place
+        HOST_CHECK(sAllocations.load() > 0);
+        HOST_CHECK_EQ(steady_allocations, 0u);
+        HOST_CHECK_EQ(sRoutes, kWarmupRequests + requests);
+        HOST_CHECK_EQ(sContextPool.GetStats().inUse, 0u);
+    });
+    printf("{\"test\":\"allocation_soak\",\"requests\":%llu,\"allocations\":%llu,\"pool_exhausted\":%llu,",
+           static_cast<unsigned long long>(requests), static_cast<unsigned long long>(steady_allocations),
+           static_cast<unsigned long long>(pool_exhausted));
+    HostBenchPrintLatency(sLatency);
+    printf("}\n");
+    return HostTestResult();
+}
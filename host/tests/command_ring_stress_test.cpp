@@ -0,0 +1,138 @@
+// Stress test of the command rings between the producer tasks and the Matter event loop
+// Every producer posts numbered commands whose payload is derived from the number, the event loop checks that
+// every command arrives exactly once, in order and intact
+// Both producers share one CommandChannel like the producers of PostBindingCommand
+#include "HostBench.h"
+#include "HostCommandChannel.h"
+#include "HostEventLoop.h"
+#include "HostTest.h"
+#include <chrono>
+#include <thread>
+
+namespace {
+
+// Same number of slots as the command rings of the bridge
+constexpr size_t kRingSize      = 16;
+constexpr size_t kProducerCount = 2;
+
+struct Command
+{
+    uint8_t producer;
+    uint64_t sequence;
+    uint32_t payload[48];
+};
+
+uint64_t sExpected[kProducerCount];
+uint64_t sCorrupted;
+uint64_t sOutOfOrder;
+
+uint32_t PayloadWord(uint64_t sequence, size_t index)
+{
+    return static_cast<uint32_t>(sequence * 2654435761u) ^ static_cast<uint32_t>(index);
+}
+
+void ProcessCommand(const Command & command)
+{
+    if (command.sequence != sExpected[command.producer]) {
+        sOutOfOrder++;
+    }
+    sExpected[command.producer] = command.sequence + 1;
+    for (size_t i = 0; i < sizeof(command.payload) / sizeof(command.payload[0]); i++) {
+        if (command.payload[i] != PayloadWord(command.sequence, i)) {
+            sCorrupted++;
+            break;
+        }
+    }
+}
+
+std::atomic<uint32_t> sRecovered{ 0 };
+
+void CountCommand(const Command &)
+{
+    sRecovered++;
+}
+
+/**
+ * Function used to check that a failed drain scheduling does not block later drains
+ */
+void TestScheduleFailure()
+{
+    HostEventLoop loop;
+    std::thread loop_thread([&] { loop.Run(); });
+    HostCommandChannel<Command, kRingSize> channel(loop, CountCommand);
+    typedef HostCommandChannel<Command, kRingSize>::PostResult PostResult;
+
+    Command command{};
+    channel.FailNextSchedules(1);
+    HOST_CHECK(channel.TryPost(command) == PostResult::kNotScheduled);
+    HOST_CHECK(!channel.DrainScheduled());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    HOST_CHECK_EQ(sRecovered.load(), 0u);
+
+    // The next post schedules a drain that also picks up the stranded command
+    HOST_CHECK(channel.TryPost(command) == PostResult::kPosted);
+    for (int i = 0; i < 1000 && sRecovered.load() < 2; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    HOST_CHECK_EQ(sRecovered.load(), 2u);
+    HOST_CHECK_EQ(channel.DrainCount(), 1u);
+
+    // A full ring is reported without scheduling anything
+    channel.FailNextSchedules(1000);
+    size_t posted = 0;
+    while (channel.TryPost(command) != PostResult::kFull) {
+        posted++;
+    }
+    HOST_CHECK_EQ(posted, kRingSize);
+    loop.Stop();
+    loop_thread.join();
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    uint64_t commands = HostBenchOption(argc, argv, "--commands", 1000000);
+
+    HostEventLoop loop;
+    std::thread loop_thread([&] { loop.Run(); });
+    HostCommandChannel<Command, kRingSize, kProducerCount> channel(loop, ProcessCommand);
+
+    uint64_t ring_full[kProducerCount] = {};
+    std::thread producers[kProducerCount];
+    for (size_t p = 0; p < kProducerCount; p++) {
+        producers[p] = std::thread([&, p] {
+            Command command;
+            command.producer = static_cast<uint8_t>(p);
+            for (uint64_t sequence = 0; sequence < commands; sequence++) {
+                command.sequence = sequence;
+                for (size_t i = 0; i < sizeof(command.payload) / sizeof(command.payload[0]); i++) {
+                    command.payload[i] = PayloadWord(sequence, i);
+                }
+                while (!channel.Post(command, p)) {
+                    ring_full[p]++;
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto & producer : producers) {
+        producer.join();
+    }
+    loop.Stop();
+    loop_thread.join();
+
+    HostTestRun("Command ring stress", [&] {
+        for (size_t p = 0; p < kProducerCount; p++) {
+            HOST_CHECK_EQ(sExpected[p], commands);
+        }
+        HOST_CHECK_EQ(sOutOfOrder, 0u);
+        HOST_CHECK_EQ(sCorrupted, 0u);
+    });
+    HostTestRun("Command ring schedule failure", TestScheduleFailure);
+    printf("{\"test\":\"command_ring_stress\",\"commands\":%llu,\"drains\":%llu,\"ring_full\":%llu}\n",
+           static_cast<unsigned long long>(commands * kProducerCount),
+           static_cast<unsigned long long>(channel.DrainCount()),
+           static_cast<unsigned long long>(ring_full[0] + ring_full[1]));
+    return HostTestResult();
+}
@@ -0,0 +1,246 @@
+// Host test of the portable primitives of the bridge
+#include "BindingIndex.h"
+#include "CommandRing.h"
+#include "CongestionControl.h"
+#include "HostTest.h"
+#include "LatencyHistogram.h"
+#include "ObjectPool.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Tracked
+{
+    explicit Tracked(int v) : value(v) { sAlive++; }
+    ~Tracked() { sAlive--; }
+    int value;
+    static inline int sAlive = 0;
+};
+
+void TestObjectPool()
+{
+    static ObjectPool<Tracked, 40> pool("test");
+    std::vector<Tracked *> objects;
+    for (int i = 0; i < 40; i++) {
+        Tracked * object = pool.Allocate(i);
+        HOST_CHECK(object != nullptr);
+        objects.push_back(object);
+    }
+    HOST_CHECK(pool.Allocate(40) == nullptr);
+    HOST_CHECK_EQ(Tracked::sAlive, 40);
+    for (int i = 0; i < 40; i++) {
+        HOST_CHECK_EQ(objects[i]->value, i);
+    }
+
+    pool.Release(objects[33]);
+    Tracked * reused = pool.Allocate(99);
+    HOST_CHECK(reused == objects[33]);
+    HOST_CHECK_EQ(reused->value, 99);
+    for (Tracked * object : objects) {
+        pool.Release(object);
+    }
+    HOST_CHECK_EQ(Tracked::sAlive, 0);
+
+    ObjectPoolStats stats = pool.GetStats();
+    HOST_CHECK_EQ(stats.capacity, 40u);
+    HOST_CHECK_EQ(stats.allocations, 41u);
+    HOST_CHECK_EQ(stats.failures, 1u);
+    HOST_CHECK_EQ(stats.inUse, 0u);
+    HOST_CHECK_EQ(stats.highWater, 40u);
+}
+
+void TestObjectPoolConcurrent()
+{
+    static ObjectPool<Tracked, 16> pool("concurrent");
+    constexpr int kIterations = 20000;
+    auto worker = [] {
+        for (int i = 0; i < kIterations; i++) {
+            Tracked * object = pool.Allocate(i);
+            if (object != nullptr) {
+                HOST_CHECK_EQ(object->value, i);
+                pool.Release(object);
+            }
+        }
+    };
+    std::thread a(worker), b(worker), c(worker);
+    a.join();
+    b.join();
+    c.join();
+    HOST_CHECK_EQ(pool.GetStats().inUse, 0u);
+    HOST_CHECK_EQ(Tracked::sAlive, 0);
+}
+
+void TestSpscRing()
+{
+    SpscRing<int, 4> ring;
+    HOST_CHECK(ring.Front() == nullptr);
+    for (int i = 0; i < 4; i++) {
+        int * slot = ring.Acquire();
+        HOST_CHECK(slot != nullptr);
+        *slot = i;
+        ring.Commit();
+    }
+    HOST_CHECK(ring.Acquire() == nullptr);
+    HOST_CHECK_EQ(ring.Size(), 4u);
+    for (int i = 0; i < 4; i++) {
+        int * slot = ring.Front();
+        HOST_CHECK(slot != nullptr);
+        HOST_CHECK_EQ(*slot, i);
+        ring.Pop();
+    }
+    HOST_CHECK(ring.Front() == nullptr);
+    HOST_CHECK_EQ(ring.Size(), 0u);
+}
+
+void TestLatencyHistogram()
+{
+    for (uint32_t value : { 0u, 1u, 3u, 4u, 5u, 7u, 8u, 100u, 1000u, 65535u, 1u << 25 }) {
+        size_t index = LatencyHistogram::BucketIndex(value);
+        HOST_CHECK(value <= LatencyHistogram::BucketUpperBound(index));
+        HOST_CHECK(index == 0 || value > LatencyHistogram::BucketUpperBound(index - 1));
+    }
+    HOST_CHECK_EQ(LatencyHistogram::BucketIndex(UINT32_MAX), LatencyHistogram::kBucketCount - 1);
+
+    static LatencyHistogram histogram;
+    HOST_CHECK_EQ(histogram.Percentile(500), 0u);
+    for (uint32_t value = 1; value <= 1000; value++) {
+        histogram.Record(value);
+    }
+    HOST_CHECK_EQ(histogram.Count(), 1000u);
+    HOST_CHECK_EQ(histogram.Max(), 1000u);
+    HOST_CHECK_EQ(histogram.Mean(), 500u);
+    // A percentile is the upper bound of its bucket, so it is off by at most 25 %
+    for (uint32_t per_mille : { 500u, 900u, 990u }) {
+        uint32_t percentile = histogram.Percentile(per_mille);
+        HOST_CHECK(percentile >= per_mille && percentile <= per_mille * 5 / 4);
+    }
+    HOST_CHECK_EQ(histogram.Percentile(1000), 1000u);
+    histogram.Reset();
+    HOST_CHECK_EQ(histogram.Count(), 0u);
+    HOST_CHECK_EQ(histogram.Max(), 0u);
+}
+
+EmberBindingTableEntry MakeBinding(chip::EndpointId local, chip::ClusterId cluster)
+{
+    EmberBindingTableEntry entry;
+    entry.type  = EMBER_UNICAST_BINDING;
+    entry.local = local;
+    if (cluster != chip::kInvalidClusterId) {
+        entry.clusterId = chip::Optional<chip::ClusterId>(cluster);
+    }
+    return entry;
+}
+
+std::vector<uint8_t> Lookup(const BindingIndex & index, chip::EndpointId endpoint, chip::ClusterId cluster)
+{
+    std::vector<uint8_t> result;
+    index.ForEach(endpoint, cluster, [&](uint8_t binding) { result.push_back(binding); });
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void TestBindingIndex()
+{
+    auto & table = chip::BindingTable::GetInstance();
+    table.Clear();
+    table.Add(MakeBinding(1, 6));
+    table.Add(MakeBinding(1, 8));
+    table.Add(MakeBinding(2, 6));
+    table.Add(MakeBinding(1, 6));
+    table.Add(MakeBinding(1, chip::kInvalidClusterId));
+
+    static BindingIndex index;
+    index.Rebuild();
+    HOST_CHECK((Lookup(index, 1, 6) == std::vector<uint8_t>{ 0, 3, 4 }));
+    HOST_CHECK((Lookup(index, 1, 8) == std::vector<uint8_t>{ 1, 4 }));
+    HOST_CHECK((Lookup(index, 1, 0x300) == std::vector<uint8_t>{ 4 }));
+    HOST_CHECK((Lookup(index, 2, 6) == std::vector<uint8_t>{ 2 }));
+    HOST_CHECK(Lookup(index, 3, 6).empty());
+    HOST_CHECK(Lookup(index, chip::kInvalidEndpointId, 6).empty());
+
+    // A full table with every key distinct
+    table.Clear();
+    for (uint8_t i = 0; i < EMBER_BINDING_TABLE_SIZE; i++) {
+        table.Add(MakeBinding(static_cast<chip::EndpointId>(i + 1), 6));
+    }
+    index.Rebuild();
+    for (uint8_t i = 0; i < EMBER_BINDING_TABLE_SIZE; i++) {
+        HOST_CHECK((Lookup(index, static_cast<chip::EndpointId>(i + 1), 6) == std::vector<uint8_t>{ i }));
+    }
+    table.Clear();
+}
+
+coap_address_t MakeAddress(uint16_t port)
+{
+    coap_address_t address;
+    coap_address_init(&address);
+    address.size                      = sizeof(address.addr.sin);
+    address.addr.sin.sin_family       = AF_INET;
+    address.addr.sin.sin_port         = htons(port);
+    address.addr.sin.sin_addr.s_addr  = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+void TestCongestionControl()
+{
+    coap_address_t dst = MakeAddress(5683);
+    HOST_CHECK_EQ(CongestionGetRto(&dst), 2000u);
+
+    for (int i = 0; i < CONFIG_BRIDGE_COAP_NSTART; i++) {
+        HOST_CHECK(CongestionAcquire(&dst));
+    }
+    HOST_CHECK(!CongestionAcquire(&dst));
+    for (int i = 0; i < CONFIG_BRIDGE_COAP_NSTART; i++) {
+        CongestionRelease(&dst);
+    }
+    HOST_CHECK(CongestionAcquire(&dst));
+    CongestionRelease(&dst);
+
+    // Strong samples move the timeout towards the measured round trip time
+    for (int i = 0; i < 20; i++) {
+        CongestionReportRtt(&dst, 50, CongestionGetRto(&dst));
+    }
+    uint32_t rto = CongestionGetRto(&dst);
+    HOST_CHECK(rto >= 100 && rto < 300);
+
+    // Samples after too many retransmissions are ambiguous and ignored
+    CongestionReportRtt(&dst, 60000, 100);
+    HOST_CHECK_EQ(CongestionGetRto(&dst), rto);
+
+    coap_session_t session{};
+    HOST_CHECK_EQ(CongestionApplyToSession(&session, &dst), rto);
+    HOST_CHECK_EQ(session.ack_timeout.integer_part * 1000u + session.ack_timeout.fractional_part, rto);
+    HOST_CHECK_EQ(session.max_retransmit, CONFIG_BRIDGE_COAP_MAX_RETRANSMIT);
+
+    // Only the retransmissions whose exchange ends within a budget are sent
+    HOST_CHECK_EQ(CongestionGetExchangeLifetime(200), CongestionGetExchangeLifetime(200, CONFIG_BRIDGE_COAP_MAX_RETRANSMIT));
+    HOST_CHECK_EQ(CongestionGetExchangeLifetime(200, 0), 300u);
+    HOST_CHECK_EQ(CongestionGetExchangeLifetime(200, 1), 900u);
+    HOST_CHECK_EQ(CongestionGetMaxRetransmitWithin(200, 1000), 1);
+    HOST_CHECK_EQ(CongestionGetMaxRetransmitWithin(2000, 1000), 0);
+    HOST_CHECK_EQ(CongestionGetMaxRetransmitWithin(200, 1000000), CONFIG_BRIDGE_COAP_MAX_RETRANSMIT);
+
+    coap_address_t other = MakeAddress(5684);
+    HOST_CHECK_EQ(CongestionGetRto(&other), 2000u);
+
+    CongestionInfo infos[8];
+    size_t count = GetCongestionInfo(infos, 8);
+    HOST_CHECK_EQ(count, 2u);
+    HOST_CHECK(infos[0].strongSamples == 20 || infos[1].strongSamples == 20);
+}
+
+} // namespace
+
+int main()
+{
+    HostTestRun("ObjectPool", TestObjectPool);
+    HostTestRun("ObjectPool concurrent", TestObjectPoolConcurrent);
+    HostTestRun("SpscRing", TestSpscRing);
+    HostTestRun("LatencyHistogram", TestLatencyHistogram);
+    HostTestRun("BindingIndex", TestBindingIndex);
+    HostTestRun("CongestionControl", TestCongestionControl);
+    return HostTestResult();
+}
@@ -0,0 +1,43 @@
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+// Helpers shared by the host benchmarks and harnesses
+// Results are printed as one JSON object per line, so runs can be compared by scripts
+#include "LatencyHistogram.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * Function used to get the value of a numeric option like "--requests 1000", returns the default if it is not given
+ */
+inline uint64_t HostBenchOption(int argc, char ** argv, const char * name, uint64_t default_value)
+{
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return strtoull(argv[i + 1], nullptr, 0);
+        }
+    }
+    return default_value;
+}
+
+/**
+ * Function used to get the monotonic time in nanoseconds
+ */
+inline int64_t HostBenchNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Function used to print the percentiles of a histogram as JSON fields, without the enclosing braces
+ */
+inline void HostBenchPrintLatency(const LatencyHistogram & histogram)
+{
+    printf("\"samples\":%u,\"mean_us\":%u,\"p50_us\":%u,\"p99_us\":%u,\"p999_us\":%u,\"max_us\":%u", histogram.Count(),
+           histogram.Mean(), histogram.Percentile(500), histogram.Percentile(990), histogram.Percentile(999), histogram.Max());
+}
+
+#endif //HOST_BENCH_H
@@ -0,0 +1,67 @@
+#ifndef HOST_COMMAND_CHANNEL_H
+#define HOST_COMMAND_CHANNEL_H
+
+// CommandChannel of CommandRing.h, the template PostBindingCommand and DrainBindingCommands instantiate, bound to a
+// HostEventLoop instead of the Matter event loop
+// Commands are copied into the slots of the producer's ring, only one drain work item is scheduled per burst
+#include "CommandRing.h"
+#include "HostEventLoop.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+template <typename T, size_t N, size_t Producers = 1>
+class HostCommandChannel
+{
+public:
+    typedef void (*ProcessFunction)(const T & command);
+    typedef typename CommandChannel<T, N, Producers>::PostResult PostResult;
+
+    HostCommandChannel(HostEventLoop & loop, ProcessFunction process) : mLoop(loop), mProcess(process) {}
+
+    /**
+     * Function used to post a command, returns false if the ring is full
+     * Must only be called by the single producer of the ring
+     */
+    bool Post(const T & command, size_t producer = 0) { return TryPost(command, producer) != PostResult::kFull; }
+
+    /**
+     * Function used to post a command and get the result of CommandChannel::Post
+     */
+    PostResult TryPost(const T & command, size_t producer = 0)
+    {
+        return mChannel.Post(
+            producer, [&](T & slot) { slot = command; },
+            [this] { return mScheduleFails.load() == 0 ? mLoop.ScheduleWork(Drain, reinterpret_cast<intptr_t>(this)) : Fail(); });
+    }
+
+    // Make the next count attempts to schedule a drain fail like a full Matter work queue
+    void FailNextSchedules(uint32_t count) { mScheduleFails = count; }
+
+    // Number of drain work items that have run
+    uint64_t DrainCount() const { return mDrains.load(std::memory_order_relaxed); }
+
+    bool DrainScheduled() const { return mChannel.DrainScheduled(); }
+
+private:
+    static void Drain(intptr_t context)
+    {
+        auto * channel = reinterpret_cast<HostCommandChannel *>(context);
+        channel->mDrains.fetch_add(1, std::memory_order_relaxed);
+        channel->mChannel.Drain([](T &, const T &) { return false; }, [channel](T & command) { channel->mProcess(command); });
+    }
+
+    bool Fail()
+    {
+        mScheduleFails--;
+        return false;
+    }
+
+    HostEventLoop & mLoop;
+    ProcessFunction mProcess;
+    CommandChannel<T, N, Producers> mChannel;
+    std::atomic<uint32_t> mScheduleFails{ 0 };
+    std::atomic<uint64_t> mDrains{ 0 };
+};
+
+#endif //HOST_COMMAND_CHANNEL_H
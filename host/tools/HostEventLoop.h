@@ -0,0 +1,143 @@
+#ifndef HOST_EVENT_LOOP_H
+#define HOST_EVENT_LOOP_H
+
+// Host stand-in of the Matter event loop
+// Work items are posted from any thread like with PlatformMgr().ScheduleWork, sockets can be watched like with the
+// socket watcher of the CHIP system layer, both are handled by the single thread that calls Run
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+class HostEventLoop
+{
+public:
+    typedef void (*WorkFunction)(intptr_t context);
+    typedef void (*SocketHandler)(int fd, intptr_t context);
+
+    HostEventLoop() : mWakeFd(eventfd(0, EFD_NONBLOCK)) {}
+    ~HostEventLoop() { close(mWakeFd); }
+
+    /**
+     * Function used to post a work item, returns false if the queue is full
+     * Like the FreeRTOS queue behind ScheduleWork, the queue has a fixed capacity and never allocates
+     */
+    bool ScheduleWork(WorkFunction function, intptr_t context)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mTail - mHead == kQueueSize) {
+                return false;
+            }
+            mQueue[mTail++ % kQueueSize] = { function, context };
+            mScheduled++;
+        }
+        uint64_t one = 1;
+        ssize_t written = write(mWakeFd, &one, sizeof(one));
+        (void) written;
+        return true;
+    }
+
+    /**
+     * Function used to call the handler whenever the socket is readable, must be called before Run
+     */
+    bool WatchSocket(int fd, SocketHandler handler, intptr_t context)
+    {
+        if (mWatchCount == kMaxWatches) {
+            return false;
+        }
+        mWatches[mWatchCount++] = { fd, handler, context };
+        return true;
+    }
+
+    /**
+     * Function used to process work items and socket events until Stop is called
+     */
+    void Run()
+    {
+        mStopped = false;
+        while (!mStopped) {
+            pollfd fds[kMaxWatches + 1];
+            fds[0] = { mWakeFd, POLLIN, 0 };
+            for (size_t i = 0; i < mWatchCount; i++) {
+                fds[i + 1] = { mWatches[i].fd, POLLIN, 0 };
+            }
+            if (poll(fds, mWatchCount + 1, -1) <= 0) {
+                continue;
+            }
+            for (size_t i = 0; i < mWatchCount; i++) {
+                if (fds[i + 1].revents & POLLIN) {
+                    mWatches[i].handler(mWatches[i].fd, mWatches[i].context);
+                }
+            }
+            if (fds[0].revents & POLLIN) {
+                uint64_t count;
+                ssize_t bytes = read(mWakeFd, &count, sizeof(count));
+                (void) bytes;
+                RunWork();
+            }
+        }
+    }
+
+    /**
+     * Function used to end Run after the pending work items, can be called from any thread
+     */
+    void Stop()
+    {
+        ScheduleWork([](intptr_t context) { reinterpret_cast<HostEventLoop *>(context)->mStopped = true; },
+                     reinterpret_cast<intptr_t>(this));
+    }
+
+    // Number of work items that have been posted
+    uint64_t ScheduledCount()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mScheduled;
+    }
+
+private:
+    static constexpr size_t kQueueSize  = 1024;
+    static constexpr size_t kMaxWatches = 4;
+
+    struct Work
+    {
+        WorkFunction function;
+        intptr_t context;
+    };
+
+    struct Watch
+    {
+        int fd;
+        SocketHandler handler;
+        intptr_t context;
+    };
+
+    void RunWork()
+    {
+        while (true) {
+            Work work;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (mHead == mTail) {
+                    return;
+                }
+                work = mQueue[mHead++ % kQueueSize];
+            }
+            work.function(work.context);
+        }
+    }
+
+    int mWakeFd;
+    std::mutex mMutex;
+    Work mQueue[kQueueSize];
+    size_t mHead        = 0;
+    size_t mTail        = 0;
+    uint64_t mScheduled = 0;
+    Watch mWatches[kMaxWatches];
+    size_t mWatchCount = 0;
+    bool mStopped      = false;
+};
+
+#endif //HOST_EVENT_LOOP_H
@@ -0,0 +1,171 @@
+#ifndef LOSSY_PROXY_H
+#define LOSSY_PROXY_H
+
+// Local UDP proxy that drops and delays datagrams, used to emulate a lossy Thread mesh between a client and a server
+// The peer that sent to the proxy last is the client, everything it sends is relayed to the server and answers go back to it
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+class LossyProxy
+{
+public:
+    struct Options
+    {
+        // Probability in percent that a datagram is dropped, applied to both directions
+        double lossPercent = 0;
+        // One-way delay and the maximum jitter that is added to it
+        uint32_t delayUs  = 0;
+        uint32_t jitterUs = 0;
+        // Probability in percent that a datagram is held back for the additional tail delay
+        double tailPercent   = 0;
+        uint32_t tailDelayUs = 0;
+        uint32_t seed        = 1;
+    };
+
+    LossyProxy(uint16_t server_port, const Options & options) : mOptions(options), mRandom(options.seed)
+    {
+        mServer   = LoopbackAddress(server_port);
+        mClientFd = OpenLoopbackSocket(&mPort);
+        mServerFd = OpenLoopbackSocket(nullptr);
+        mThread              = std::thread([this] { Run(); });
+    }
+
+    ~LossyProxy()
+    {
+        mStopped = true;
+        mThread.join();
+        close(mClientFd);
+        close(mServerFd);
+    }
+
+    // Port the client sends to instead of the port of the server
+    uint16_t Port() const { return mPort; }
+
+    uint64_t Dropped() const { return mDropped.load(); }
+    uint64_t Relayed() const { return mRelayed.load(); }
+
+    static sockaddr_in LoopbackAddress(uint16_t port)
+    {
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family      = AF_INET;
+        address.sin_port        = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return address;
+    }
+
+    // Open a UDP socket on an ephemeral loopback port and optionally get the port
+    static int OpenLoopbackSocket(uint16_t * port)
+    {
+        int fd              = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in address = LoopbackAddress(0);
+        bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        // Large buffers, so a burst is lost by the proxy and not by the kernel
+        int buffer = 4 * 1024 * 1024;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+        if (port != nullptr) {
+            socklen_t length = sizeof(address);
+            getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+            *port = ntohs(address.sin_port);
+        }
+        return fd;
+    }
+
+private:
+    struct Pending
+    {
+        int64_t dueUs;
+        bool toServer;
+        std::vector<uint8_t> data;
+    };
+
+    static int64_t NowUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void Receive(int fd, bool to_server)
+    {
+        uint8_t buffer[2048];
+        sockaddr_in from;
+        socklen_t length = sizeof(from);
+        ssize_t size     = recvfrom(fd, buffer, sizeof(buffer), MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&from), &length);
+        if (size < 0) {
+            return;
+        }
+        if (to_server) {
+            mClient = from;
+        }
+        if (std::uniform_real_distribution<double>(0, 100)(mRandom) < mOptions.lossPercent) {
+            mDropped++;
+            return;
+        }
+        uint32_t delay = mOptions.delayUs;
+        if (mOptions.jitterUs > 0) {
+            delay += std::uniform_int_distribution<uint32_t>(0, mOptions.jitterUs)(mRandom);
+        }
+        if (std::uniform_real_distribution<double>(0, 100)(mRandom) < mOptions.tailPercent) {
+            delay += mOptions.tailDelayUs;
+        }
+        mPending.push_back({ NowUs() + delay, to_server, std::vector<uint8_t>(buffer, buffer + size) });
+    }
+
+    void Run()
+    {
+        while (!mStopped) {
+            int64_t now    = NowUs();
+            int timeout_ms = 10;
+            for (size_t i = 0; i < mPending.size();) {
+                Pending & pending = mPending[i];
+                if (pending.dueUs <= now) {
+                    int fd                 = pending.toServer ? mServerFd : mClientFd;
+                    const sockaddr_in & to    = pending.toServer ? mServer : mClient;
+                    sendto(fd, pending.data.data(), pending.data.size(), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+                    mRelayed++;
+                    mPending.erase(mPending.begin() + static_cast<ptrdiff_t>(i));
+                    continue;
+                }
+                timeout_ms = std::min<int>(timeout_ms, static_cast<int>((pending.dueUs - now + 999) / 1000));
+                i++;
+            }
+            pollfd fds[2] = { { mClientFd, POLLIN, 0 }, { mServerFd, POLLIN, 0 } };
+            if (poll(fds, 2, timeout_ms) > 0) {
+                if (fds[0].revents & POLLIN) {
+                    Receive(mClientFd, true);
+                }
+                if (fds[1].revents & POLLIN) {
+                    Receive(mServerFd, false);
+                }
+            }
+        }
+    }
+
+    Options mOptions;
+    std::mt19937 mRandom;
+    sockaddr_in mServer;
+    sockaddr_in mClient = LoopbackAddress(0);
+    int mClientFd;
+    int mServerFd;
+    uint16_t mPort = 0;
+    std::vector<Pending> mPending;
+    std::atomic<bool> mStopped{ false };
+    std::atomic<uint64_t> mDropped{ 0 };
+    std::atomic<uint64_t> mRelayed{ 0 };
+    std::thread mThread;
+};
+
+#endif //LOSSY_PROXY_H
@@ -0,0 +1,551 @@
+#ifndef LWM2M_SIM_H
+#define LWM2M_SIM_H
+
+// Fleet of simulated LwM2M devices and the load generator of lwm2m_sim, shared with the benchmarks that need local
+// LwM2M devices or a device that sends requests to the bridge
+#include "HostBench.h"
+#include "LatencyHistogram.h"
+#include "MiniCoap.h"
+#include "ObjectXml.h"
+#include "sdkconfig.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+inline int64_t NowUs()
+{
+    return HostBenchNowNs() / 1000;
+}
+
+/**
+ * Function used to open a dual-stack UDP socket bound to the given address and port, the port is 0 for an ephemeral one
+ * Returns -1 if the address is invalid or the port is taken, the bound port is stored in port
+ */
+inline int OpenSocket(const char * host, uint16_t & port)
+{
+    sockaddr_in6 address;
+    memset(&address, 0, sizeof(address));
+    address.sin6_family = AF_INET6;
+    address.sin6_port   = htons(port);
+    if (inet_pton(AF_INET6, host, &address.sin6_addr) != 1) {
+        return -1;
+    }
+    int fd = socket(AF_INET6, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int off = 0;
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    // Large buffers, so a burst is lost by the configured loss and not by the kernel
+    int buffer = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+    socklen_t length = sizeof(address);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length) != 0) {
+        close(fd);
+        return -1;
+    }
+    port = ntohs(address.sin6_port);
+    return fd;
+}
+
+// IPv4 targets are reached through their IPv4-mapped address
+inline sockaddr_in6 TargetAddress(const std::string & host, uint16_t port)
+{
+    sockaddr_in6 address;
+    memset(&address, 0, sizeof(address));
+    address.sin6_family = AF_INET6;
+    address.sin6_port   = htons(port);
+    std::string mapped  = host.find(':') == std::string::npos ? "::ffff:" + host : host;
+    inet_pton(AF_INET6, mapped.c_str(), &address.sin6_addr);
+    return address;
+}
+
+inline bool SameAddress(const sockaddr_in6 & a, const sockaddr_in6 & b)
+{
+    return a.sin6_port == b.sin6_port && memcmp(&a.sin6_addr, &b.sin6_addr, sizeof(a.sin6_addr)) == 0;
+}
+
+/**
+ * Function used to get the initial value of a resource in the representation the bridge expects
+ */
+inline std::vector<uint8_t> InitialValue(const SimResourceDefinition & definition)
+{
+    if (definition.type == "Boolean") {
+        return { 0 };
+    }
+    if (definition.type == "Integer" || definition.type == "Unsigned Integer" || definition.type == "Time" ||
+        definition.type == "Float") {
+        return { 0, 0, 0, 0 };
+    }
+    if (definition.type == "String") {
+        return std::vector<uint8_t>(definition.name.begin(), definition.name.end());
+    }
+    return {};
+}
+
+/**
+ * Function used to change a value like a sensor or a local user would, returns false if the type never changes
+ */
+inline bool ChangeValue(const SimResourceDefinition & definition, std::vector<uint8_t> & value)
+{
+    if (definition.type == "Boolean" && value.size() == 1) {
+        value[0] = !value[0];
+        return true;
+    }
+    if (value.size() != 4) {
+        return false;
+    }
+    if (definition.type == "Integer" || definition.type == "Unsigned Integer" || definition.type == "Time") {
+        int32_t number;
+        memcpy(&number, value.data(), sizeof(number));
+        // Integers stay within the 0..100 range most IPSO levels use
+        number = definition.type == "Time" ? number + 1 : (number + 1) % 101;
+        memcpy(value.data(), &number, sizeof(number));
+        return true;
+    }
+    if (definition.type == "Float") {
+        float number;
+        memcpy(&number, value.data(), sizeof(number));
+        number += 0.5f;
+        memcpy(value.data(), &number, sizeof(number));
+        return true;
+    }
+    return false;
+}
+
+class Fleet
+{
+public:
+    struct Options
+    {
+        uint32_t devices   = 1;
+        std::string bind   = "::";
+        uint16_t basePort  = CONFIG_BRIDGE_LWM2M_DEVICE_PORT;
+        uint32_t latencyUs = 0;
+        uint32_t jitterUs  = 0;
+        // Probability in percent that a datagram is dropped, applied to requests and to responses
+        double lossPercent = 0;
+        // Changes per second of every readable numeric or boolean resource
+        double changeRate = 0;
+        uint32_t seed     = 1;
+    };
+
+    struct Stats
+    {
+        uint64_t requests      = 0;
+        uint64_t responses     = 0;
+        uint64_t notifications = 0;
+        uint64_t changes       = 0;
+        uint64_t dropped       = 0;
+        uint64_t malformed     = 0;
+    };
+
+    Fleet(const Options & options, const std::vector<SimObjectDefinition> & objects) :
+        mOptions(options), mObjects(objects), mRandom(options.seed)
+    {}
+
+    ~Fleet()
+    {
+        for (Device & device : mDevices) {
+            close(device.fd);
+        }
+    }
+
+    /**
+     * Function used to open the sockets of all devices, on consecutive ports or on ephemeral ports if the base port is 0
+     */
+    bool Open()
+    {
+        int64_t now = NowUs();
+        mDevices.resize(mOptions.devices);
+        for (uint32_t i = 0; i < mOptions.devices; i++) {
+            Device & device = mDevices[i];
+            device.port     = mOptions.basePort == 0 ? 0 : static_cast<uint16_t>(mOptions.basePort + i);
+            device.fd       = OpenSocket(mOptions.bind.c_str(), device.port);
+            if (device.fd < 0) {
+                fprintf(stderr, "lwm2m_sim: cannot bind [%s]:%u\n", mOptions.bind.c_str(), device.port);
+                return false;
+            }
+            for (const SimObjectDefinition & object : mObjects) {
+                for (const SimResourceDefinition & definition : object.resources) {
+                    std::string path      = "/" + std::to_string(object.id) + "/0/" + std::to_string(definition.id);
+                    Resource & resource   = device.resources[path];
+                    resource.definition   = definition;
+                    resource.value        = InitialValue(definition);
+                    resource.nextChangeUs = NextChange(now);
+                }
+            }
+        }
+        return true;
+    }
+
+    std::vector<uint16_t> Ports() const
+    {
+        std::vector<uint16_t> ports;
+        for (const Device & device : mDevices) {
+            ports.push_back(device.port);
+        }
+        return ports;
+    }
+
+    const Stats & GetStats() const { return mStats; }
+
+    /**
+     * Function used to serve requests until stopped is set
+     */
+    void Run(const std::atomic<bool> & stopped)
+    {
+        std::vector<pollfd> fds;
+        for (const Device & device : mDevices) {
+            fds.push_back({ device.fd, POLLIN, 0 });
+        }
+        while (!stopped.load()) {
+            int64_t now = NowUs();
+            FlushSends(now);
+            if (mOptions.changeRate > 0 && now >= mNextScanUs) {
+                ChangeValues(now);
+                mNextScanUs = now + 1000;
+            }
+            // Wake up for the next delayed datagram, otherwise at least every 10 ms to notice the stop
+            int64_t wait = 10000;
+            if (!mSends.empty()) {
+                wait = std::min<int64_t>(wait, mSends.top().dueUs - now);
+            }
+            if (mOptions.changeRate > 0) {
+                wait = std::min<int64_t>(wait, mNextScanUs - now);
+            }
+            if (poll(fds.data(), fds.size(), static_cast<int>(std::max<int64_t>(wait, 0) / 1000)) <= 0) {
+                continue;
+            }
+            for (size_t i = 0; i < fds.size(); i++) {
+                if (fds[i].revents & POLLIN) {
+                    Receive(mDevices[i]);
+                }
+            }
+        }
+    }
+
+private:
+    struct Resource
+    {
+        SimResourceDefinition definition;
+        std::vector<uint8_t> value;
+        int64_t nextChangeUs = 0;
+    };
+
+    struct Observer
+    {
+        std::string path;
+        sockaddr_in6 address;
+        uint8_t token[8];
+        uint8_t tokenLength;
+        // Message id of the last notification, a reset with this id cancels the observation
+        uint16_t messageId;
+    };
+
+    struct Device
+    {
+        int fd        = -1;
+        uint16_t port = 0;
+        std::map<std::string, Resource> resources;
+        std::vector<Observer> observers;
+        uint16_t nextMessageId = 1;
+        // Observe sequence number shared by all observations of the device, so it only increases
+        uint32_t observeSequence = 2;
+    };
+
+    struct Send
+    {
+        int64_t dueUs;
+        int fd;
+        sockaddr_in6 to;
+        std::vector<uint8_t> data;
+
+        bool operator>(const Send & other) const { return dueUs > other.dueUs; }
+    };
+
+    bool Lost() { return mOptions.lossPercent > 0 && std::uniform_real_distribution<double>(0, 100)(mRandom) < mOptions.lossPercent; }
+
+    int64_t NextChange(int64_t now)
+    {
+        if (mOptions.changeRate <= 0) {
+            return INT64_MAX;
+        }
+        return now + static_cast<int64_t>(std::exponential_distribution<double>(mOptions.changeRate)(mRandom) * 1e6);
+    }
+
+    void Queue(const Device & device, const sockaddr_in6 & to, const CoapMessage & message)
+    {
+        if (Lost()) {
+            mStats.dropped++;
+            return;
+        }
+        uint32_t delay = mOptions.latencyUs;
+        if (mOptions.jitterUs > 0) {
+            delay += std::uniform_int_distribution<uint32_t>(0, mOptions.jitterUs)(mRandom);
+        }
+        mSends.push({ NowUs() + delay, device.fd, to, CoapEncode(message) });
+    }
+
+    void FlushSends(int64_t now)
+    {
+        while (!mSends.empty() && mSends.top().dueUs <= now) {
+            const Send & send = mSends.top();
+            sendto(send.fd, send.data.data(), send.data.size(), 0, reinterpret_cast<const sockaddr *>(&send.to), sizeof(send.to));
+            mSends.pop();
+        }
+    }
+
+    void Notify(Device & device, const std::string & path, const Resource & resource)
+    {
+        for (Observer & observer : device.observers) {
+            if (observer.path != path) {
+                continue;
+            }
+            CoapMessage notification;
+            notification.type             = kCoapNon;
+            notification.code             = kCoapContent;
+            notification.messageId        = device.nextMessageId++;
+            notification.tokenLength      = observer.tokenLength;
+            notification.hasObserve       = true;
+            notification.observe          = device.observeSequence++;
+            notification.hasContentFormat = true;
+            notification.contentFormat    = resource.definition.type == "String" ? 0 : 42;
+            notification.payload          = resource.value;
+            memcpy(notification.token, observer.token, observer.tokenLength);
+            observer.messageId = notification.messageId;
+            mStats.notifications++;
+            Queue(device, observer.address, notification);
+        }
+    }
+
+    void ChangeValues(int64_t now)
+    {
+        for (Device & device : mDevices) {
+            for (auto & entry : device.resources) {
+                Resource & resource = entry.second;
+                if (now < resource.nextChangeUs) {
+                    continue;
+                }
+                resource.nextChangeUs = NextChange(now);
+                if (resource.definition.operations.find('R') == std::string::npos ||
+                    !ChangeValue(resource.definition, resource.value)) {
+                    resource.nextChangeUs = INT64_MAX;
+                    continue;
+                }
+                mStats.changes++;
+                Notify(device, entry.first, resource);
+            }
+        }
+    }
+
+    void Receive(Device & device)
+    {
+        uint8_t buffer[1500];
+        sockaddr_in6 from;
+        socklen_t length = sizeof(from);
+        ssize_t size     = recvfrom(device.fd, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr *>(&from), &length);
+        if (size <= 0) {
+            return;
+        }
+        if (Lost()) {
+            mStats.dropped++;
+            return;
+        }
+        CoapMessage request;
+        if (!CoapDecode(buffer, static_cast<size_t>(size), request)) {
+            mStats.malformed++;
+            return;
+        }
+        if (request.type == kCoapRst) {
+            // RFC 7641: a reset to a notification cancels the observation
+            device.observers.erase(std::remove_if(device.observers.begin(), device.observers.end(),
+                                                  [&](const Observer & observer) {
+                                                      return SameAddress(observer.address, from) &&
+                                                          observer.messageId == request.messageId;
+                                                  }),
+                                   device.observers.end());
+            return;
+        }
+        if (request.type == kCoapAck) {
+            return;
+        }
+
+        CoapMessage response;
+        response.type        = request.type == kCoapCon ? kCoapAck : kCoapNon;
+        response.messageId   = request.type == kCoapCon ? request.messageId : device.nextMessageId++;
+        response.tokenLength = request.tokenLength;
+        memcpy(response.token, request.token, request.tokenLength);
+        if (request.code == kCoapEmpty) {
+            // CoAP ping
+            response.type = kCoapRst;
+            Queue(device, from, response);
+            return;
+        }
+        mStats.requests++;
+        response.code = Handle(device, from, request, response);
+        mStats.responses++;
+        Queue(device, from, response);
+    }
+
+    uint8_t Handle(Device & device, const sockaddr_in6 & from, const CoapMessage & request, CoapMessage & response)
+    {
+        auto found = device.resources.find(request.path);
+        if (found == device.resources.end()) {
+            return kCoapNotFound;
+        }
+        Resource & resource            = found->second;
+        const std::string & operations = resource.definition.operations;
+        switch (request.code) {
+        case kCoapGet: {
+            if (operations.find('R') == std::string::npos) {
+                return kCoapMethodNotAllowed;
+            }
+            auto same = [&](const Observer & observer) {
+                return observer.path == request.path && SameAddress(observer.address, from) &&
+                    observer.tokenLength == request.tokenLength && memcmp(observer.token, request.token, request.tokenLength) == 0;
+            };
+            device.observers.erase(std::remove_if(device.observers.begin(), device.observers.end(), same), device.observers.end());
+            if (request.hasObserve && request.observe == 0) {
+                Observer observer;
+                observer.path        = request.path;
+                observer.address     = from;
+                observer.tokenLength = request.tokenLength;
+                observer.messageId   = 0;
+                memcpy(observer.token, request.token, request.tokenLength);
+                device.observers.push_back(observer);
+                response.hasObserve = true;
+                response.observe    = device.observeSequence++;
+            }
+            response.hasContentFormat = true;
+            response.contentFormat    = resource.definition.type == "String" ? 0 : 42;
+            response.payload          = resource.value;
+            return kCoapContent;
+        }
+        case kCoapPut:
+            if (operations.find('W') == std::string::npos) {
+                return kCoapMethodNotAllowed;
+            }
+            if (request.payload != resource.value) {
+                resource.value = request.payload;
+                Notify(device, request.path, resource);
+            }
+            return kCoapChanged;
+        case kCoapPost:
+            return operations.find('E') == std::string::npos ? kCoapMethodNotAllowed : kCoapChanged;
+        default:
+            return kCoapMethodNotAllowed;
+        }
+    }
+
+    Options mOptions;
+    std::vector<SimObjectDefinition> mObjects;
+    std::vector<Device> mDevices;
+    std::priority_queue<Send, std::vector<Send>, std::greater<Send>> mSends;
+    std::mt19937 mRandom;
+    int64_t mNextScanUs = 0;
+    Stats mStats;
+};
+
+struct LoadOptions
+{
+    std::string target = "::1";
+    std::vector<uint16_t> ports;
+    std::string path     = "/3311/0/5850";
+    bool put             = false;
+    uint32_t concurrency = 8;
+    uint64_t requests    = 10000;
+    uint32_t timeoutMs   = 2000;
+};
+
+struct LoadResult
+{
+    LatencyHistogram latency;
+    uint64_t completed = 0;
+    // Responses with a code other than 2.xx
+    uint64_t errors   = 0;
+    uint64_t lost     = 0;
+    int64_t elapsedUs = 0;
+};
+
+/**
+ * Function used to send confirmable requests round robin to the devices, with at most concurrency requests outstanding
+ * Requests are not retransmitted, a request without a response within the timeout counts as lost
+ */
+inline void RunLoad(const LoadOptions & options, LoadResult & result)
+{
+    struct Outstanding
+    {
+        uint32_t sequence;
+        int64_t sentUs;
+    };
+
+    uint16_t port = 0;
+    int fd        = OpenSocket("::", port);
+    std::vector<Outstanding> outstanding;
+    uint32_t next = 0;
+    int64_t start = NowUs();
+    while (result.completed + result.errors + result.lost < options.requests) {
+        while (next < options.requests && outstanding.size() < options.concurrency) {
+            CoapMessage request;
+            request.code        = options.put ? kCoapPut : kCoapGet;
+            request.messageId   = static_cast<uint16_t>(next);
+            request.tokenLength = 4;
+            memcpy(request.token, &next, 4);
+            request.path = options.path;
+            if (options.put) {
+                request.payload = { static_cast<uint8_t>(next & 1) };
+            }
+            std::vector<uint8_t> data = CoapEncode(request);
+            sockaddr_in6 to           = TargetAddress(options.target, options.ports[next % options.ports.size()]);
+            sendto(fd, data.data(), data.size(), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+            outstanding.push_back({ next++, NowUs() });
+        }
+
+        int64_t deadline = outstanding.front().sentUs + static_cast<int64_t>(options.timeoutMs) * 1000;
+        pollfd fds       = { fd, POLLIN, 0 };
+        if (poll(&fds, 1, static_cast<int>(std::max<int64_t>(deadline - NowUs(), 0) / 1000 + 1)) > 0) {
+            uint8_t buffer[1500];
+            ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+            CoapMessage response;
+            uint32_t sequence;
+            if (size > 0 && CoapDecode(buffer, static_cast<size_t>(size), response) && response.tokenLength == 4) {
+                memcpy(&sequence, response.token, 4);
+                auto found = std::find_if(outstanding.begin(), outstanding.end(),
+                                          [&](const Outstanding & entry) { return entry.sequence == sequence; });
+                if (found != outstanding.end()) {
+                    result.latency.Record(static_cast<uint32_t>(NowUs() - found->sentUs));
+                    if ((response.code >> 5) == 2) {
+                        result.completed++;
+                    } else {
+                        result.errors++;
+                    }
+                    outstanding.erase(found);
+                }
+            }
+        }
+        int64_t now = NowUs();
+        while (!outstanding.empty() && outstanding.front().sentUs + static_cast<int64_t>(options.timeoutMs) * 1000 <= now) {
+            result.lost++;
+            outstanding.erase(outstanding.begin());
+        }
+    }
+    result.elapsedUs = NowUs() - start;
+    close(fd);
+}
+
+#endif //LWM2M_SIM_H
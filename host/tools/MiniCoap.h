@@ -0,0 +1,203 @@
+#ifndef MINI_COAP_H
+#define MINI_COAP_H
+
+// Minimal CoAP codec of RFC 7252 for the host tools
+// Only the options the bridge uses towards LwM2M devices are decoded: Observe, Uri-Path and Content-Format
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum CoapType : uint8_t
+{
+    kCoapCon = 0,
+    kCoapNon = 1,
+    kCoapAck = 2,
+    kCoapRst = 3,
+};
+
+// Codes as class * 32 + detail
+constexpr uint8_t kCoapEmpty            = 0x00;
+constexpr uint8_t kCoapGet              = 0x01;
+constexpr uint8_t kCoapPost             = 0x02;
+constexpr uint8_t kCoapPut              = 0x03;
+constexpr uint8_t kCoapChanged          = 0x44;
+constexpr uint8_t kCoapContent          = 0x45;
+constexpr uint8_t kCoapBadRequest       = 0x80;
+constexpr uint8_t kCoapNotFound         = 0x84;
+constexpr uint8_t kCoapMethodNotAllowed = 0x85;
+
+constexpr uint16_t kCoapOptionObserve       = 6;
+constexpr uint16_t kCoapOptionUriPath       = 11;
+constexpr uint16_t kCoapOptionContentFormat = 12;
+
+struct CoapMessage
+{
+    CoapType type          = kCoapCon;
+    uint8_t code           = kCoapEmpty;
+    uint16_t messageId     = 0;
+    uint8_t token[8]       = {};
+    uint8_t tokenLength    = 0;
+    bool hasObserve        = false;
+    uint32_t observe       = 0;
+    bool hasContentFormat  = false;
+    uint16_t contentFormat = 0;
+    // Uri-Path options joined with a leading slash each, e.g. /3311/0/5850
+    std::string path;
+    std::vector<uint8_t> payload;
+};
+
+namespace CoapCodec {
+
+inline uint8_t Nibble(size_t value)
+{
+    return value < 13 ? static_cast<uint8_t>(value) : value < 269 ? 13 : 14;
+}
+
+inline void PutExtended(std::vector<uint8_t> & out, size_t value)
+{
+    if (value >= 269) {
+        out.push_back(static_cast<uint8_t>((value - 269) >> 8));
+        out.push_back(static_cast<uint8_t>(value - 269));
+    } else if (value >= 13) {
+        out.push_back(static_cast<uint8_t>(value - 13));
+    }
+}
+
+inline void PutOption(std::vector<uint8_t> & out, uint16_t & last, uint16_t number, const uint8_t * value, size_t length)
+{
+    size_t delta = number - last;
+    last         = number;
+    out.push_back(static_cast<uint8_t>(Nibble(delta) << 4 | Nibble(length)));
+    PutExtended(out, delta);
+    PutExtended(out, length);
+    out.insert(out.end(), value, value + length);
+}
+
+// Unsigned option values are sent in network byte order without leading zero bytes
+inline void PutUintOption(std::vector<uint8_t> & out, uint16_t & last, uint16_t number, uint32_t value)
+{
+    uint8_t bytes[4];
+    size_t length = 0;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        if (length > 0 || (value >> shift) != 0) {
+            bytes[length++] = static_cast<uint8_t>(value >> shift);
+        }
+    }
+    PutOption(out, last, number, bytes, length);
+}
+
+inline bool GetExtended(const uint8_t * data, size_t size, size_t & pos, size_t & value)
+{
+    if (value == 13) {
+        if (pos + 1 > size) {
+            return false;
+        }
+        value = 13 + data[pos++];
+    } else if (value == 14) {
+        if (pos + 2 > size) {
+            return false;
+        }
+        value = 269 + (static_cast<size_t>(data[pos]) << 8 | data[pos + 1]);
+        pos += 2;
+    } else if (value == 15) {
+        return false;
+    }
+    return true;
+}
+
+} // namespace CoapCodec
+
+/**
+ * Function used to encode a message, the options are written in the order of their numbers
+ */
+inline std::vector<uint8_t> CoapEncode(const CoapMessage & message)
+{
+    std::vector<uint8_t> out;
+    out.push_back(static_cast<uint8_t>(1 << 6 | message.type << 4 | message.tokenLength));
+    out.push_back(message.code);
+    out.push_back(static_cast<uint8_t>(message.messageId >> 8));
+    out.push_back(static_cast<uint8_t>(message.messageId));
+    out.insert(out.end(), message.token, message.token + message.tokenLength);
+
+    uint16_t last = 0;
+    if (message.hasObserve) {
+        CoapCodec::PutUintOption(out, last, kCoapOptionObserve, message.observe & 0xFFFFFF);
+    }
+    for (size_t start = 0; start < message.path.size();) {
+        size_t end = message.path.find('/', start + 1);
+        if (end == std::string::npos) {
+            end = message.path.size();
+        }
+        CoapCodec::PutOption(out, last, kCoapOptionUriPath, reinterpret_cast<const uint8_t *>(message.path.data()) + start + 1,
+                             end - start - 1);
+        start = end;
+    }
+    if (message.hasContentFormat) {
+        CoapCodec::PutUintOption(out, last, kCoapOptionContentFormat, message.contentFormat);
+    }
+    if (!message.payload.empty()) {
+        out.push_back(0xFF);
+        out.insert(out.end(), message.payload.begin(), message.payload.end());
+    }
+    return out;
+}
+
+/**
+ * Function used to decode a message, returns false if it is malformed
+ */
+inline bool CoapDecode(const uint8_t * data, size_t size, CoapMessage & message)
+{
+    if (size < 4 || (data[0] >> 6) != 1 || (data[0] & 0x0F) > 8) {
+        return false;
+    }
+    message             = CoapMessage();
+    message.type        = static_cast<CoapType>((data[0] >> 4) & 0x03);
+    message.tokenLength = data[0] & 0x0F;
+    message.code        = data[1];
+    message.messageId   = static_cast<uint16_t>(data[2] << 8 | data[3]);
+    size_t pos          = 4;
+    if (pos + message.tokenLength > size) {
+        return false;
+    }
+    for (uint8_t i = 0; i < message.tokenLength; i++) {
+        message.token[i] = data[pos++];
+    }
+
+    size_t number = 0;
+    while (pos < size) {
+        if (data[pos] == 0xFF) {
+            if (pos + 1 == size) {
+                return false;
+            }
+            message.payload.assign(data + pos + 1, data + size);
+            break;
+        }
+        size_t delta  = data[pos] >> 4;
+        size_t length = data[pos] & 0x0F;
+        pos++;
+        if (!CoapCodec::GetExtended(data, size, pos, delta) || !CoapCodec::GetExtended(data, size, pos, length) ||
+            pos + length > size) {
+            return false;
+        }
+        number += delta;
+        uint32_t value = 0;
+        for (size_t i = 0; i < length && i < 4; i++) {
+            value = value << 8 | data[pos + i];
+        }
+        if (number == kCoapOptionObserve) {
+            message.hasObserve = true;
+            message.observe    = value;
+        } else if (number == kCoapOptionUriPath) {
+            message.path += "/";
+            message.path.append(reinterpret_cast<const char *>(data + pos), length);
+        } else if (number == kCoapOptionContentFormat) {
+            message.hasContentFormat = true;
+            message.contentFormat    = static_cast<uint16_t>(value);
+        }
+        pos += length;
+    }
+    return true;
+}
+
+#endif //MINI_COAP_H
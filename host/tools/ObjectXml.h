@@ -0,0 +1,104 @@
+#ifndef OBJECT_XML_H
+#define OBJECT_XML_H
+
+// Minimal reader of OMA LwM2M object definitions for the host tools
+// It extracts the same fields as ParseObjectDefinition in LwM2MObject.hpp, without depending on pugixml
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct SimResourceDefinition
+{
+    int id;
+    std::string name;
+    std::string type;
+    std::string operations;
+    bool instanceMandatory;
+};
+
+struct SimObjectDefinition
+{
+    int id = -1;
+    std::string name;
+    std::vector<SimResourceDefinition> resources;
+};
+
+namespace ObjectXml {
+
+/**
+ * Function used to get the text of the first element with the given name between begin and end
+ * Returns an empty string if there is no such element
+ */
+inline std::string ElementText(const std::string & xml, const std::string & name, size_t begin = 0,
+                               size_t end = std::string::npos)
+{
+    size_t open = xml.find("<" + name, begin);
+    while (open != std::string::npos && open < end && xml[open + 1 + name.size()] != '>' &&
+           xml[open + 1 + name.size()] != ' ') {
+        open = xml.find("<" + name, open + 1);
+    }
+    if (open == std::string::npos || open >= end) {
+        return "";
+    }
+    size_t content = xml.find('>', open);
+    size_t close   = xml.find("</" + name + ">", content);
+    if (content == std::string::npos || close == std::string::npos) {
+        return "";
+    }
+    std::string text = xml.substr(content + 1, close - content - 1);
+    size_t first     = text.find_first_not_of(" \t\r\n");
+    size_t last      = text.find_last_not_of(" \t\r\n");
+    return first == std::string::npos ? "" : text.substr(first, last - first + 1);
+}
+
+} // namespace ObjectXml
+
+/**
+ * Function used to parse an object definition, the id is -1 if the document is not an object definition
+ */
+inline SimObjectDefinition ParseSimObjectDefinition(const std::string & xml)
+{
+    SimObjectDefinition object;
+    size_t object_begin = xml.find("<Object");
+    size_t resources    = xml.find("<Resources>", object_begin);
+    if (object_begin == std::string::npos || resources == std::string::npos) {
+        return object;
+    }
+    object.id   = atoi(ObjectXml::ElementText(xml, "ObjectID", object_begin, resources).c_str());
+    object.name = ObjectXml::ElementText(xml, "Name", object_begin, resources);
+
+    size_t resources_end = xml.find("</Resources>", resources);
+    for (size_t item = xml.find("<Item ", resources); item != std::string::npos && item < resources_end;) {
+        size_t item_end = xml.find("</Item>", item);
+        size_t id       = xml.find("ID=\"", item);
+        if (item_end == std::string::npos || id == std::string::npos || id > item_end) {
+            break;
+        }
+        SimResourceDefinition resource;
+        resource.id                = atoi(xml.c_str() + id + 4);
+        resource.name              = ObjectXml::ElementText(xml, "Name", item, item_end);
+        resource.type              = ObjectXml::ElementText(xml, "Type", item, item_end);
+        resource.operations        = ObjectXml::ElementText(xml, "Operations", item, item_end);
+        // Read like pugixml's as_bool, which ParseObjectDefinition uses
+        std::string mandatory      = ObjectXml::ElementText(xml, "InstanceMandatory", item, item_end);
+        resource.instanceMandatory = !mandatory.empty() && std::string("1tTyY").find(mandatory[0]) != std::string::npos;
+        object.resources.push_back(resource);
+        item = xml.find("<Item ", item_end);
+    }
+    return object;
+}
+
+/**
+ * Function used to read and parse an object definition from a file
+ */
+inline SimObjectDefinition LoadSimObjectDefinition(const std::string & path)
+{
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return ParseSimObjectDefinition(content.str());
+}
+
+#endif //OBJECT_XML_H
@@ -0,0 +1,51 @@
+#ifndef UDP_ECHO_SERVER_H
+#define UDP_ECHO_SERVER_H
+
+// Local UDP server that answers every datagram with the datagram itself
+#include "LossyProxy.h"
+#include <atomic>
+#include <thread>
+
+class UdpEchoServer
+{
+public:
+    UdpEchoServer()
+    {
+        mFd     = LossyProxy::OpenLoopbackSocket(&mPort);
+        mThread = std::thread([this] { Run(); });
+    }
+
+    ~UdpEchoServer()
+    {
+        mStopped = true;
+        mThread.join();
+        close(mFd);
+    }
+
+    uint16_t Port() const { return mPort; }
+
+private:
+    void Run()
+    {
+        while (!mStopped) {
+            pollfd fds = { mFd, POLLIN, 0 };
+            if (poll(&fds, 1, 10) <= 0) {
+                continue;
+            }
+            uint8_t buffer[2048];
+            sockaddr_in from;
+            socklen_t length = sizeof(from);
+            ssize_t size     = recvfrom(mFd, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr *>(&from), &length);
+            if (size > 0) {
+                sendto(mFd, buffer, static_cast<size_t>(size), 0, reinterpret_cast<sockaddr *>(&from), length);
+            }
+        }
+    }
+
+    int mFd;
+    uint16_t mPort = 0;
+    std::atomic<bool> mStopped{ false };
+    std::thread mThread;
+};
+
+#endif //UDP_ECHO_SERVER_H
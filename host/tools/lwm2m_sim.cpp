@@ -0,0 +1,332 @@
+// Simulator of a fleet of LwM2M devices and load generator for the bridge
+// Every device listens on its own UDP port, like the devices the bridge reaches at CONFIG_BRIDGE_LWM2M_DEVICE_PORT + i, and
+// serves instance 0 of the objects given as OMA XML definitions. Values are the raw little endian bytes the bridge copies
+// into its attributes: Boolean as one byte, Integer, Unsigned Integer and Time as int32, Float as IEEE single, String as text
+// Readable numeric resources change at --change-rate per second and are reported to observers with NON notifications
+//
+//   lwm2m_sim --xml 3311.xml [--xml ...] [--devices 32] [--base-port 5184] [--bind ::] [--latency-ms 20] [--jitter-ms 10]
+//             [--loss 5] [--change-rate 0.5] [--duration-s 0] [--seed 1]
+//   lwm2m_sim --load [--target ::1] [--target-port 5184] [--devices 32] [--path /3311/0/5850] [--method get|put]
+//             [--concurrency 8] [--requests 10000] [--timeout-ms 2000]
+//   lwm2m_sim --load --observe [--target ::1] [--target-port 5184] [--devices 32] [--path /3311/0/5851] [--duration-s 10]
+//   lwm2m_sim --self-test --xml 3311.xml
+//
+// The fleet runs until it is interrupted or --duration-s has passed, both modes print their counters as a JSON line
+#include "Lwm2mSim.h"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+std::atomic<bool> sStopped{ false };
+
+const char * StringOption(int argc, char ** argv, const char * name, const char * default_value)
+{
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return default_value;
+}
+
+double DoubleOption(int argc, char ** argv, const char * name, double default_value)
+{
+    const char * value = StringOption(argc, argv, name, nullptr);
+    return value != nullptr ? strtod(value, nullptr) : default_value;
+}
+
+bool FlagOption(int argc, char ** argv, const char * name)
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct ObserveResult
+{
+    uint64_t registered    = 0;
+    uint64_t notifications = 0;
+    // Notifications whose sequence number is not larger than the one before
+    uint64_t reordered = 0;
+};
+
+/**
+ * Function used to observe a resource on every device and count the notifications until the duration has passed
+ */
+void RunObserve(const LoadOptions & options, int64_t duration_us, ObserveResult & result)
+{
+    uint16_t port = 0;
+    int fd        = OpenSocket("::", port);
+    for (uint32_t i = 0; i < options.ports.size(); i++) {
+        CoapMessage request;
+        request.code        = kCoapGet;
+        request.messageId   = static_cast<uint16_t>(i);
+        request.tokenLength = 4;
+        memcpy(request.token, &i, 4);
+        request.path       = options.path;
+        request.hasObserve = true;
+        request.observe    = 0;
+        std::vector<uint8_t> data = CoapEncode(request);
+        sockaddr_in6 to           = TargetAddress(options.target, options.ports[i]);
+        sendto(fd, data.data(), data.size(), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+    }
+
+    std::vector<int64_t> last(options.ports.size(), -1);
+    int64_t end = NowUs() + duration_us;
+    for (int64_t now = NowUs(); now < end && !sStopped.load(); now = NowUs()) {
+        pollfd fds = { fd, POLLIN, 0 };
+        if (poll(&fds, 1, static_cast<int>(std::min<int64_t>(end - now, 100000) / 1000 + 1)) <= 0) {
+            continue;
+        }
+        uint8_t buffer[1500];
+        ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+        CoapMessage message;
+        uint32_t device;
+        if (size <= 0 || !CoapDecode(buffer, static_cast<size_t>(size), message) || message.tokenLength != 4 || !message.hasObserve) {
+            continue;
+        }
+        memcpy(&device, message.token, 4);
+        if (device >= last.size()) {
+            continue;
+        }
+        if (last[device] < 0) {
+            result.registered++;
+        } else {
+            result.notifications++;
+            result.reordered += static_cast<int64_t>(message.observe) <= last[device] ? 1 : 0;
+        }
+        last[device] = message.observe;
+    }
+    close(fd);
+}
+
+void PrintLoad(const char * label, const LoadOptions & options, const LoadResult & result)
+{
+    printf("{\"bench\":\"lwm2m_load\",\"label\":\"%s\",\"devices\":%zu,\"method\":\"%s\",\"concurrency\":%u,\"completed\":%llu,"
+           "\"errors\":%llu,\"lost\":%llu,\"throughput_per_s\":%.0f,",
+           label, options.ports.size(), options.put ? "put" : "get", options.concurrency,
+           static_cast<unsigned long long>(result.completed), static_cast<unsigned long long>(result.errors),
+           static_cast<unsigned long long>(result.lost),
+           result.elapsedUs > 0 ? (result.completed + result.errors) * 1e6 / result.elapsedUs : 0.0);
+    HostBenchPrintLatency(result.latency);
+    printf("}\n");
+    fflush(stdout);
+}
+
+void PrintFleet(const Fleet::Stats & stats, uint32_t devices)
+{
+    printf("{\"bench\":\"lwm2m_fleet\",\"devices\":%u,\"requests\":%llu,\"responses\":%llu,\"notifications\":%llu,"
+           "\"changes\":%llu,\"dropped\":%llu,\"malformed\":%llu}\n",
+           devices, static_cast<unsigned long long>(stats.requests), static_cast<unsigned long long>(stats.responses),
+           static_cast<unsigned long long>(stats.notifications), static_cast<unsigned long long>(stats.changes),
+           static_cast<unsigned long long>(stats.dropped), static_cast<unsigned long long>(stats.malformed));
+    fflush(stdout);
+}
+
+/**
+ * Function used to send a single confirmable request to a device and wait up to a second for its response
+ */
+bool Exchange(uint16_t port, CoapMessage request, CoapMessage & response)
+{
+    static uint16_t sMessageId = 0x4000;
+    uint16_t local             = 0;
+    int fd                     = OpenSocket("::1", local);
+    request.messageId          = sMessageId++;
+    request.tokenLength        = 2;
+    memcpy(request.token, &request.messageId, 2);
+    std::vector<uint8_t> data = CoapEncode(request);
+    sockaddr_in6 to           = TargetAddress("::1", port);
+    sendto(fd, data.data(), data.size(), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+    pollfd fds    = { fd, POLLIN, 0 };
+    bool received = false;
+    if (poll(&fds, 1, 1000) > 0) {
+        uint8_t buffer[1500];
+        ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+        received     = size > 0 && CoapDecode(buffer, static_cast<size_t>(size), response) &&
+            response.messageId == request.messageId && response.type == kCoapAck;
+    }
+    close(fd);
+    return received;
+}
+
+int Check(bool condition, const char * what)
+{
+    if (!condition) {
+        fprintf(stderr, "lwm2m_sim: self-test failed: %s\n", what);
+    }
+    return condition ? 0 : 1;
+}
+
+/**
+ * Function used to run a fleet on ephemeral loopback ports and check it against the load generator
+ */
+int SelfTest(const std::vector<SimObjectDefinition> & objects)
+{
+    int failures = 0;
+    Fleet::Options fleet_options;
+    fleet_options.devices    = 8;
+    fleet_options.bind       = "::1";
+    fleet_options.basePort   = 0;
+    fleet_options.changeRate = 50;
+    Fleet fleet(fleet_options, objects);
+    if (!fleet.Open()) {
+        return 1;
+    }
+    std::atomic<bool> stopped{ false };
+    std::thread runner([&] { fleet.Run(stopped); });
+    std::vector<uint16_t> ports = fleet.Ports();
+
+    CoapMessage request, response;
+    request.code = kCoapGet;
+    request.path = "/3311/0/5850";
+    failures += Check(Exchange(ports[0], request, response) && response.code == kCoapContent && response.payload.size() == 1,
+                      "GET of a Boolean resource");
+    // The value may change on its own, the write is checked by its code only
+    request.code    = kCoapPut;
+    request.payload = { 1 };
+    failures += Check(Exchange(ports[1], request, response) && response.code == kCoapChanged, "PUT of a writable resource");
+    request.path = "/3311/0/5805";
+    failures += Check(Exchange(ports[2], request, response) && response.code == kCoapMethodNotAllowed,
+                      "PUT of a read-only resource");
+    request.code = kCoapGet;
+    request.path = "/3311/0/9999";
+    failures += Check(Exchange(ports[3], request, response) && response.code == kCoapNotFound, "GET of an unknown resource");
+    request.path = "/3311/1/5850";
+    failures += Check(Exchange(ports[3], request, response) && response.code == kCoapNotFound, "GET of another instance");
+
+    LoadOptions load;
+    load.target      = "::1";
+    load.ports       = ports;
+    load.path        = "/3311/0/5851";
+    load.requests    = 2000;
+    load.concurrency = 8;
+    LoadResult result;
+    RunLoad(load, result);
+    PrintLoad("self-test", load, result);
+    failures += Check(result.completed == load.requests && result.errors == 0 && result.lost == 0, "GET load without loss");
+
+    ObserveResult observed;
+    RunObserve(load, 500000, observed);
+    printf("{\"bench\":\"lwm2m_observe\",\"label\":\"self-test\",\"registered\":%llu,\"notifications\":%llu,\"reordered\":%llu}\n",
+           static_cast<unsigned long long>(observed.registered), static_cast<unsigned long long>(observed.notifications),
+           static_cast<unsigned long long>(observed.reordered));
+    failures += Check(observed.registered == ports.size() && observed.notifications > ports.size() && observed.reordered == 0,
+                      "Observe notifications");
+
+    stopped = true;
+    runner.join();
+    PrintFleet(fleet.GetStats(), fleet_options.devices);
+
+    // A lossy fleet has to lose requests, otherwise the loss option has no effect
+    fleet_options.lossPercent = 20;
+    fleet_options.changeRate  = 0;
+    Fleet lossy(fleet_options, objects);
+    if (!lossy.Open()) {
+        return 1;
+    }
+    stopped = false;
+    runner  = std::thread([&] { lossy.Run(stopped); });
+    load.ports     = lossy.Ports();
+    load.requests  = 200;
+    load.timeoutMs = 200;
+    LoadResult lossy_result;
+    RunLoad(load, lossy_result);
+    PrintLoad("self-test-lossy", load, lossy_result);
+    failures += Check(lossy_result.lost > 0 && lossy_result.completed > 0, "Loss of the lossy fleet");
+    stopped = true;
+    runner.join();
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    std::vector<SimObjectDefinition> objects;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--xml") == 0) {
+            objects.push_back(LoadSimObjectDefinition(argv[i + 1]));
+            if (objects.back().id < 0) {
+                fprintf(stderr, "lwm2m_sim: %s is not an object definition\n", argv[i + 1]);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    signal(SIGINT, [](int) { sStopped = true; });
+    signal(SIGTERM, [](int) { sStopped = true; });
+
+    if (FlagOption(argc, argv, "--self-test")) {
+        return objects.empty() ? EXIT_FAILURE : SelfTest(objects);
+    }
+
+    uint32_t devices     = static_cast<uint32_t>(HostBenchOption(argc, argv, "--devices", CONFIG_BRIDGE_LWM2M_DEVICE_COUNT));
+    uint64_t duration_us = HostBenchOption(argc, argv, "--duration-s", 0) * 1000000;
+    if (FlagOption(argc, argv, "--load")) {
+        LoadOptions load;
+        load.target      = StringOption(argc, argv, "--target", "::1");
+        load.path        = StringOption(argc, argv, "--path", "/3311/0/5850");
+        load.put         = strcmp(StringOption(argc, argv, "--method", "get"), "put") == 0;
+        load.concurrency = static_cast<uint32_t>(HostBenchOption(argc, argv, "--concurrency", 8));
+        load.requests    = HostBenchOption(argc, argv, "--requests", 10000);
+        load.timeoutMs   = static_cast<uint32_t>(HostBenchOption(argc, argv, "--timeout-ms", 2000));
+        uint16_t first   = static_cast<uint16_t>(HostBenchOption(argc, argv, "--target-port", CONFIG_BRIDGE_LWM2M_DEVICE_PORT));
+        for (uint32_t i = 0; i < devices; i++) {
+            load.ports.push_back(static_cast<uint16_t>(first + i));
+        }
+        if (FlagOption(argc, argv, "--observe")) {
+            ObserveResult observed;
+            RunObserve(load, duration_us > 0 ? duration_us : 10000000, observed);
+            printf("{\"bench\":\"lwm2m_observe\",\"devices\":%u,\"registered\":%llu,\"notifications\":%llu,\"reordered\":%llu}\n",
+                   devices, static_cast<unsigned long long>(observed.registered),
+                   static_cast<unsigned long long>(observed.notifications), static_cast<unsigned long long>(observed.reordered));
+            return EXIT_SUCCESS;
+        }
+        LoadResult result;
+        RunLoad(load, result);
+        PrintLoad("load", load, result);
+        return result.lost == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (objects.empty()) {
+        fprintf(stderr, "lwm2m_sim: at least one --xml object definition is needed\n");
+        return EXIT_FAILURE;
+    }
+    Fleet::Options options;
+    options.devices     = devices;
+    options.bind        = StringOption(argc, argv, "--bind", "::");
+    options.basePort    = static_cast<uint16_t>(HostBenchOption(argc, argv, "--base-port", CONFIG_BRIDGE_LWM2M_DEVICE_PORT));
+    options.latencyUs   = static_cast<uint32_t>(HostBenchOption(argc, argv, "--latency-ms", 0) * 1000);
+    options.jitterUs    = static_cast<uint32_t>(HostBenchOption(argc, argv, "--jitter-ms", 0) * 1000);
+    options.lossPercent = DoubleOption(argc, argv, "--loss", 0);
+    options.changeRate  = DoubleOption(argc, argv, "--change-rate", 0);
+    options.seed        = static_cast<uint32_t>(HostBenchOption(argc, argv, "--seed", 1));
+    Fleet fleet(options, objects);
+    if (!fleet.Open()) {
+        return EXIT_FAILURE;
+    }
+    std::vector<uint16_t> ports = fleet.Ports();
+    printf("{\"event\":\"listening\",\"bind\":\"%s\",\"first_port\":%u,\"devices\":%u}\n", options.bind.c_str(), ports.front(),
+           devices);
+    fflush(stdout);
+    std::thread stopper;
+    if (duration_us > 0) {
+        stopper = std::thread([duration_us] {
+            for (int64_t end = NowUs() + static_cast<int64_t>(duration_us); NowUs() < end && !sStopped.load();) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            sStopped = true;
+        });
+    }
+    fleet.Run(sStopped);
+    if (stopper.joinable()) {
+        stopper.join();
+    }
+    PrintFleet(fleet.GetStats(), devices);
+    return EXIT_SUCCESS;
+}
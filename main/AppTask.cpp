@@ -23,6 +23,7 @@
 
 #include "AppTask.h"
 #include "BindingHandler.h"
+#include "BridgeMemory.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 
@@ -31,6 +32,8 @@
 #define APP_TASK_STACK_SIZE (3072)
 #define BUTTON_PRESSED 1
 #define APP_LIGHT_SWITCH 1
+// Endpoint whose bindings are toggled by the button
+#define APP_LIGHT_SWITCH_ENDPOINT 2
 
 using namespace chip;
 
@@ -83,6 +86,7 @@ CHIP_ERROR AppTask::Init()
 void AppTask::AppTaskMain(void * pvParameter)
 {
     AppEvent event;
+    BridgeMemoryWatchTask(xTaskGetCurrentTaskHandle(), APP_TASK_STACK_SIZE);
     CHIP_ERROR err = sAppTask.Init();
     if (err != CHIP_NO_ERROR)
     {
@@ -152,11 +156,12 @@ void AppTask::SwitchActionEventHandler(AppEvent * aEvent)
 {
     if (aEvent->Type == AppEvent::kEventType_Button)
     {
-        BindingCommandData * data = Platform::New<BindingCommandData>();
-        data->commandId           = chip::app::Clusters::OnOff::Commands::Toggle::Id;
-        data->clusterId           = chip::app::Clusters::OnOff::Id;
+        BindingCommandData data;
+        data.localEndpointId = APP_LIGHT_SWITCH_ENDPOINT;
+        data.commandId       = chip::app::Clusters::OnOff::Commands::Toggle::Id;
+        data.clusterId       = chip::app::Clusters::OnOff::Id;
 
-        DeviceLayer::PlatformMgr().ScheduleWork(SwitchWorkerFunction, reinterpret_cast<intptr_t>(data));
+        PostBindingCommand(CommandProducer::kAppTask, data);
     }
 }
 
@@ -17,128 +17,481 @@
  */
 
 #include "BindingHandler.h"
+#include "BindingIndex.h"
+#include "BridgeLatency.h"
+#include "BridgeMetrics.h"
+#include "BridgeTrace.h"
+#include "CommandRing.h"
+#include "ObjectPool.h"
+#include "SessionKeeper.h"
+#include "SubscriptionManager.h"
 #include "app/CommandSender.h"
+#include "app/InteractionModelEngine.h"
+#include "app/MessageDef/CommandDataIB.h"
+#include "app/ReadClient.h"
+#include "app/WriteClient.h"
 #include "app/clusters/bindings/BindingManager.h"
 #include "app/server/Server.h"
-#include "controller/InvokeInteraction.h"
-#include "controller/ReadInteraction.h"
-#include "controller/WriteInteraction.h"
 #include "platform/CHIPDeviceLayer.h"
+#include "transport/GroupSession.h"
 #include <app/clusters/bindings/bindings.h>
 #include <lib/support/CodeUtils.h>
-#include <variant>
+#include <lib/support/TypeTraits.h>
+#include <atomic>
 #include <optional>
 
 using namespace chip;
 using namespace chip::app;
 
-// Globally defined pointer
-// This pointer will contain the result of a Read action
-std::unique_ptr<std::variant<uint16_t, bool>> result_ptr = nullptr;
-
 namespace {
 
+// Number of slots of each command ring
+constexpr size_t kCommandRingSize = 16;
+// Number of commands that can be processed by the binding manager at the same time
+constexpr size_t kCommandContextCount = CONFIG_BRIDGE_COMMAND_CONTEXT_POOL_SIZE;
+// Number of read, write and invoke interactions of each kind that can be in flight at the same time
+constexpr size_t kMaxBatchedInteractions = 4;
+
+// One ring per producing task, all of them are drained on the Matter event loop
+CommandChannel<BindingCommandData, kCommandRingSize, static_cast<size_t>(CommandProducer::kCount)> sCommandChannel;
+
+// Number of unicast bindings that can wait for their CASE session at the same time
+constexpr size_t kMaxPendingRoutes = 8;
+
+// Contexts of the commands that are routed to bound devices, only used on the Matter event loop
+// A context is released once every bound device it has been routed to has been served
+BindingCommandData sCommandContexts[kCommandContextCount];
+uint8_t sCommandContextReferences[kCommandContextCount];
+
+// Index of the binding table used to route commands straight to the matching bindings
+BindingIndex sBindingIndex;
+
+// Binding entries that wait for BindingWorkerFunction on the Matter event loop
+ObjectPool<EmberBindingTableEntry, CONFIG_BRIDGE_BINDING_ENTRY_POOL_SIZE> sBindingEntryPool("binding_entry");
+
 /**
- * Function used to send a write interaction to a cluster in the binding table
+ * Function used to hand the result of a read interaction to its requester
+ * Results without a callback are dropped
  */
-template <typename T>
-void ProcessWriteAttribute(ClusterId clusterId, AttributeId attributeId, T& value, const EmberBindingTableEntry & binding,
-                                        Messaging::ExchangeManager * exchangeMgr, const SessionHandle & sessionHandle)
+void CompleteRead(ReadCompleteCallback onComplete, void * completeContext, const TlvValue * value)
 {
-    auto onSuccess = [](const app::ConcreteAttributePath &) {
-        ChipLogProgress(NotSpecified, "Write Attribute Success");
-    };
-
-    auto onError = [](const app::ConcreteAttributePath * path, CHIP_ERROR err) {
-        ChipLogError(NotSpecified, "Write Attribute Failure: %" CHIP_ERROR_FORMAT, err.Format());
-    };
+    if (onComplete != nullptr) {
+        onComplete(completeContext, value);
+    }
+}
 
-    auto onDone = [](app::WriteClient *) {
-        ChipLogProgress(NotSpecified, "Write Attribute Done");
-    };
+/**
+ * Function used to check if any attribute of a batch still waits for its result
+ */
+bool HasReadCompletions(const AttributeBatch & batch)
+{
+    for (uint8_t i = 0; i < batch.count; i++) {
+        if (batch.onReadComplete[i] != nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    Controller::WriteAttribute<T>(sessionHandle, binding.remote, clusterId, attributeId, value, onSuccess, onError, NullOptional, onDone);
+/**
+ * Function used to fail every completion that has not been taken over by an interaction
+ */
+void FailCompletions(BindingCommandData & data)
+{
+    if (data.onCommandComplete != nullptr) {
+        data.onCommandComplete(data.commandContext, Protocols::InteractionModel::Status::Failure, nullptr);
+        data.onCommandComplete = nullptr;
+        BridgeMetricIncrement(BridgeCounter::kBindingFailedCompletions);
+    }
+    if (data.onReadComplete != nullptr) {
+        data.onReadComplete(data.readContext, nullptr);
+        data.onReadComplete = nullptr;
+        BridgeMetricIncrement(BridgeCounter::kBindingFailedCompletions);
+    }
+    for (uint8_t i = 0; i < data.batch.count; i++) {
+        if (data.batch.onReadComplete[i] != nullptr) {
+            data.batch.onReadComplete[i](data.batch.readContexts[i], nullptr);
+            data.batch.onReadComplete[i] = nullptr;
+            BridgeMetricIncrement(BridgeCounter::kBindingFailedCompletions);
+        }
+    }
 }
 
 /**
- * Function used to send a read interaction to a cluster in the binding table
- * The result of the read interaction gets written into the global result pointer
+ * Read interaction that covers several attributes of a cluster with a single exchange
+ * Every reported attribute is handed to the completion callback that has been registered for it
  */
-template <typename T>
-void ProcessReadAttribute(ClusterId clusterId, AttributeId attributeId, const EmberBindingTableEntry & binding,
-                                       Messaging::ExchangeManager * exchangeMgr, const SessionHandle & sessionHandle)
+class BatchedRead : public ReadClient::Callback
 {
-    auto onSuccess = [](const ConcreteDataAttributePath & attributePath, const auto & dataResponse) {
-        result_ptr = std::make_unique<std::variant<uint16_t, bool>>(dataResponse);
-        ChipLogProgress(NotSpecified, "Read attribute succeeded");
-    };
+public:
+    bool InUse() const { return mReadClient.has_value(); }
 
-    auto onFailure = [](const ConcreteDataAttributePath * attributePath, CHIP_ERROR error) {
-        ChipLogError(NotSpecified, "Read attribute failed: %" CHIP_ERROR_FORMAT, error.Format());
-    };
-    Controller::ReadAttribute<T>(exchangeMgr, sessionHandle, binding.remote, clusterId, attributeId, onSuccess, onFailure);
-}
+    CHIP_ERROR Send(ClusterId clusterId, const AttributeBatch & batch, const EmberBindingTableEntry & binding,
+                    Messaging::ExchangeManager * exchangeMgr, const SessionHandle & sessionHandle)
+    {
+        mTraceId = BridgeTraceCurrent();
+        mStartUs = BridgeTraceNow();
+        mBatch   = batch;
+        for (uint8_t i = 0; i < mBatch.count; i++) {
+            mPaths[i]   = AttributePathParams(binding.remote, clusterId, mBatch.attributeIds[i]);
+            mPending[i] = true;
+        }
+
+        ReadPrepareParams params(sessionHandle);
+        params.mpAttributePathParamsList    = mPaths;
+        params.mAttributePathParamsListSize = mBatch.count;
+
+        mReadClient.emplace(InteractionModelEngine::GetInstance(), exchangeMgr, *this, ReadClient::InteractionType::Read);
+        CHIP_ERROR err = mReadClient->SendRequest(params);
+        if (err != CHIP_NO_ERROR) {
+            // The completions are still owned by the caller
+            mReadClient.reset();
+        }
+        return err;
+    }
+
+    void OnAttributeData(const ConcreteDataAttributePath & aPath, TLV::TLVReader * apData, const StatusIB & aStatus) override
+    {
+        for (uint8_t i = 0; i < mBatch.count; i++) {
+            if (mPending[i] && mBatch.attributeIds[i] == aPath.mAttributeId) {
+                TlvValue value;
+                bool success = apData != nullptr && aStatus.IsSuccess() && DecodeAttributeValue(*apData, value) == CHIP_NO_ERROR;
+                Complete(i, success ? &value : nullptr);
+            }
+        }
+    }
+
+    void OnError(CHIP_ERROR aError) override
+    {
+        ChipLogError(NotSpecified, "Batched read failed: %" CHIP_ERROR_FORMAT, aError.Format());
+    }
+
+    void OnDone(ReadClient * apReadClient) override
+    {
+        // Attributes that have not been reported are failed
+        for (uint8_t i = 0; i < mBatch.count; i++) {
+            if (mPending[i]) {
+                Complete(i, nullptr);
+            }
+        }
+        ChipLogProgress(NotSpecified, "Batched read of %u attributes done", mBatch.count);
+        BridgeTraceSpan(mTraceId, "matter.read", mStartUs);
+        mReadClient.reset();
+    }
+
+    // The attribute paths are owned by this object
+    void OnDeallocatePaths(ReadPrepareParams && aReadPrepareParams) override {}
+
+private:
+    void Complete(uint8_t index, const TlvValue * value)
+    {
+        mPending[index] = false;
+        CompleteRead(mBatch.onReadComplete[index], mBatch.readContexts[index], value);
+    }
+
+    std::optional<ReadClient> mReadClient;
+    uint32_t mTraceId = kNoTraceId;
+    int64_t mStartUs  = 0;
+    AttributeBatch mBatch;
+    AttributePathParams mPaths[kMaxBatchAttributes];
+    bool mPending[kMaxBatchAttributes];
+};
 
 /**
- * Function used to send a unicast invoke interaction to a cluster in the binding table
- * Note that currently no function is provided to flexibly send such requests
+ * Write interaction that covers several attributes of a cluster with a single exchange
  */
-void ProcessOnOffUnicastBindingCommand(CommandId commandId, const EmberBindingTableEntry & binding,
-                                       Messaging::ExchangeManager * exchangeMgr, const SessionHandle & sessionHandle)
+class BatchedWrite : public WriteClient::Callback
 {
-    auto onSuccess = [](const ConcreteCommandPath & commandPath, const StatusIB & status, const auto & dataResponse) {
-        ChipLogProgress(NotSpecified, "OnOff command succeeds");
-    };
+public:
+    bool InUse() const { return mWriteClient.has_value(); }
 
-    auto onFailure = [](CHIP_ERROR error) {
-        ChipLogError(NotSpecified, "OnOff command failed: %" CHIP_ERROR_FORMAT, error.Format());
-    };
+    CHIP_ERROR Send(const BindingCommandData & data, const EmberBindingTableEntry & binding, Messaging::ExchangeManager * exchangeMgr,
+                    const SessionHandle & sessionHandle)
+    {
+        const AttributeBatch & batch = data.batch;
+        mWriteClient.emplace(exchangeMgr, this, NullOptional);
 
-    switch (commandId)
+        // The values are copied as they are, so any attribute type can be written without type specific code
+        CHIP_ERROR err = CHIP_NO_ERROR;
+        for (uint8_t i = 0; i < batch.count && err == CHIP_NO_ERROR; i++) {
+            TLV::TLVReader reader;
+            err = batch.values[i].GetReader(reader);
+            if (err == CHIP_NO_ERROR) {
+                err = mWriteClient->PutPreencodedAttribute(ConcreteDataAttributePath(binding.remote, data.clusterId, batch.attributeIds[i]), reader);
+            }
+        }
+        if (err == CHIP_NO_ERROR) {
+            err = mWriteClient->SendWriteRequest(sessionHandle);
+        }
+        if (err != CHIP_NO_ERROR) {
+            // The completion is still owned by the caller
+            mWriteClient.reset();
+            return err;
+        }
+        // The shadow holds the values from before the write, reads go to the device until it reports the new ones
+        mFabricIndex = binding.fabricIndex;
+        mNodeId      = binding.nodeId;
+        for (uint8_t i = 0; i < batch.count; i++) {
+            InvalidateShadowAttribute(mFabricIndex, mNodeId, binding.remote, data.clusterId, batch.attributeIds[i]);
+        }
+        mOnComplete      = data.onCommandComplete;
+        mCompleteContext = data.commandContext;
+        mStatus          = Protocols::InteractionModel::Status::Success;
+        mTraceId         = data.traceId;
+        mStartUs         = BridgeTraceNow();
+        return CHIP_NO_ERROR;
+    }
+
+    void OnResponse(const WriteClient * apWriteClient, const ConcreteDataAttributePath & aPath, StatusIB aStatus) override
     {
-    case Clusters::OnOff::Commands::Toggle::Id:
-        Clusters::OnOff::Commands::Toggle::Type toggleCommand;
-        Controller::InvokeCommandRequest(exchangeMgr, sessionHandle, binding.remote, toggleCommand, onSuccess, onFailure);
-        break;
+        // A report sent before the write has been applied may have filled the shadow again in the meantime
+        InvalidateShadowAttribute(mFabricIndex, mNodeId, aPath.mEndpointId, aPath.mClusterId, aPath.mAttributeId);
+        if (aStatus.IsSuccess()) {
+            ChipLogProgress(NotSpecified, "Write Attribute 0x%" PRIx32 " Success", aPath.mAttributeId);
+        } else {
+            ChipLogError(NotSpecified, "Write Attribute 0x%" PRIx32 " Failure: %" CHIP_ERROR_FORMAT, aPath.mAttributeId,
+                         aStatus.ToChipError().Format());
+            Fail(aStatus.mStatus);
+        }
+    }
+
+    void OnError(const WriteClient * apWriteClient, CHIP_ERROR aError) override
+    {
+        ChipLogError(NotSpecified, "Batched write failed: %" CHIP_ERROR_FORMAT, aError.Format());
+        // Errors reported by the bound device carry their interaction model status
+        Fail(StatusIB(aError).mStatus);
+    }
 
-    case Clusters::OnOff::Commands::On::Id:
-        Clusters::OnOff::Commands::On::Type onCommand;
-        Controller::InvokeCommandRequest(exchangeMgr, sessionHandle, binding.remote, onCommand, onSuccess, onFailure);
-        break;
+    void OnDone(WriteClient * apWriteClient) override
+    {
+        ChipLogProgress(NotSpecified, "Batched write done");
+        if (mOnComplete != nullptr) {
+            mOnComplete(mCompleteContext, mStatus, nullptr);
+            mOnComplete = nullptr;
+        }
+        BridgeTraceSpan(mTraceId, "matter.write", mStartUs);
+        mWriteClient.reset();
+    }
 
-    case Clusters::OnOff::Commands::Off::Id:
-        Clusters::OnOff::Commands::Off::Type offCommand;
-        Controller::InvokeCommandRequest(exchangeMgr, sessionHandle, binding.remote, offCommand, onSuccess, onFailure);
-        break;
+private:
+    // The first failing attribute decides the status of the whole batch
+    void Fail(Protocols::InteractionModel::Status status)
+    {
+        if (mStatus == Protocols::InteractionModel::Status::Success) {
+            mStatus = status == Protocols::InteractionModel::Status::Success ? Protocols::InteractionModel::Status::Failure : status;
+        }
     }
+
+    std::optional<WriteClient> mWriteClient;
+    FabricIndex mFabricIndex                    = kUndefinedFabricIndex;
+    NodeId mNodeId                              = kUndefinedNodeId;
+    CommandCompleteCallback mOnComplete         = nullptr;
+    void * mCompleteContext                     = nullptr;
+    Protocols::InteractionModel::Status mStatus = Protocols::InteractionModel::Status::Success;
+    uint32_t mTraceId                           = kNoTraceId;
+    int64_t mStartUs                            = 0;
+};
+
+BatchedRead sBatchedReads[kMaxBatchedInteractions];
+BatchedWrite sBatchedWrites[kMaxBatchedInteractions];
+
+/**
+ * Function used to send a read interaction for every attribute of a batch to a cluster in the binding table
+ * The completion callbacks are taken over by the interaction, unless it could not be sent
+ * A batch whose results have already been taken over by another bound device is not read again
+ */
+void ProcessBatchedRead(ClusterId clusterId, AttributeBatch & batch, const EmberBindingTableEntry & binding,
+                        Messaging::ExchangeManager * exchangeMgr, const SessionHandle & sessionHandle)
+{
+    VerifyOrReturn(HasReadCompletions(batch));
+    for (auto & read : sBatchedReads) {
+        if (!read.InUse()) {
+            CHIP_ERROR err = read.Send(clusterId, batch, binding, exchangeMgr, sessionHandle);
+            VerifyOrReturn(err == CHIP_NO_ERROR, ChipLogError(NotSpecified, "Batched read failed: %" CHIP_ERROR_FORMAT, err.Format()));
+            for (auto & onComplete : batch.onReadComplete) {
+                onComplete = nullptr;
+            }
+            return;
+        }
+    }
+    ChipLogError(NotSpecified, "ProcessBatchedRead - No free read interaction");
 }
 
 /**
- * Function used to send a multicast invoke interaction to a group in the binding table
- * Note that currently no function is provided to flexibly send such requests
+ * Function used to send a write interaction for every attribute of a batch to a cluster in the binding table
+ * The completion callback is taken over by the interaction, unless it could not be sent
  */
-void ProcessOnOffGroupBindingCommand(CommandId commandId, const EmberBindingTableEntry & binding)
+void ProcessBatchedWrite(BindingCommandData & data, const EmberBindingTableEntry & binding, Messaging::ExchangeManager * exchangeMgr,
+                         const SessionHandle & sessionHandle)
 {
-    Messaging::ExchangeManager & exchangeMgr = Server::GetInstance().GetExchangeManager();
+    for (auto & write : sBatchedWrites) {
+        if (!write.InUse()) {
+            CHIP_ERROR err = write.Send(data, binding, exchangeMgr, sessionHandle);
+            VerifyOrReturn(err == CHIP_NO_ERROR, ChipLogError(NotSpecified, "Batched write failed: %" CHIP_ERROR_FORMAT, err.Format()));
+            // The status is handed over to the first bound device
+            data.onCommandComplete = nullptr;
+            return;
+        }
+    }
+    ChipLogError(NotSpecified, "ProcessBatchedWrite - No free write interaction");
+}
+
+/**
+ * Function used to add a command with pre-encoded fields to a command sender
+ */
+CHIP_ERROR EncodeCommand(CommandSender & sender, const CommandPathParams & path, const TlvValue & fields)
+{
+    TlvValue empty;
+    const TlvValue * encoded = &fields;
+    if (fields.IsEmpty()) {
+        ReturnErrorOnFailure(empty.EncodeEmptyStructure());
+        encoded = &empty;
+    }
 
-    switch (commandId)
+    TLV::TLVReader reader;
+    ReturnErrorOnFailure(encoded->GetReader(reader));
+    ReturnErrorOnFailure(sender.PrepareCommand(path, /* aStartDataStruct = */ false));
+    TLV::TLVWriter * writer = sender.GetCommandDataIBTLVWriter();
+    VerifyOrReturnError(writer != nullptr, CHIP_ERROR_INCORRECT_STATE);
+    ReturnErrorOnFailure(writer->CopyElement(TLV::ContextTag(to_underlying(CommandDataIB::Tag::kFields)), reader));
+    return sender.FinishCommand(/* aEndDataStruct = */ false);
+}
+
+/**
+ * Invoke interaction whose command fields have been encoded by the requester
+ * Any command of any cluster can be sent without command specific code
+ */
+class PassThroughCommand : public CommandSender::Callback
+{
+public:
+    bool InUse() const { return mCommandSender.has_value(); }
+
+    CHIP_ERROR Send(const BindingCommandData & data, const EmberBindingTableEntry & binding, Messaging::ExchangeManager * exchangeMgr,
+                    const SessionHandle & sessionHandle)
+    {
+        CommandPathParams path(binding.remote, 0, data.clusterId, data.commandId,
+                               BitFlags<CommandPathFlags>(CommandPathFlags::kEndpointIdValid));
+
+        mCommandSender.emplace(this, exchangeMgr);
+        CHIP_ERROR err = EncodeCommand(*mCommandSender, path, data.value);
+        if (err == CHIP_NO_ERROR) {
+            err = mCommandSender->SendCommandRequest(sessionHandle);
+        }
+        if (err != CHIP_NO_ERROR) {
+            // The completion is still owned by the caller
+            mCommandSender.reset();
+            return err;
+        }
+        mOnComplete      = data.onCommandComplete;
+        mCompleteContext = data.commandContext;
+        mTraceId         = data.traceId;
+        mStartUs         = BridgeTraceNow();
+        return CHIP_NO_ERROR;
+    }
+
+    void OnResponse(CommandSender * apCommandSender, const ConcreteCommandPath & aPath, const StatusIB & aStatusIB,
+                    TLV::TLVReader * apData) override
     {
-    case Clusters::OnOff::Commands::Toggle::Id:
-        Clusters::OnOff::Commands::Toggle::Type toggleCommand;
-        Controller::InvokeGroupCommandRequest(&exchangeMgr, binding.fabricIndex, binding.groupId, toggleCommand);
-        break;
+        if (aStatusIB.IsSuccess()) {
+            ChipLogProgress(NotSpecified, "Command 0x%" PRIx32 " succeeded", aPath.mCommandId);
+        } else {
+            ChipLogError(NotSpecified, "Command 0x%" PRIx32 " failed: %" CHIP_ERROR_FORMAT, aPath.mCommandId,
+                         aStatusIB.ToChipError().Format());
+        }
+        Complete(aStatusIB.mStatus, aStatusIB.IsSuccess() ? apData : nullptr);
+    }
 
-    case Clusters::OnOff::Commands::On::Id:
-        Clusters::OnOff::Commands::On::Type onCommand;
-        Controller::InvokeGroupCommandRequest(&exchangeMgr, binding.fabricIndex, binding.groupId, onCommand);
+    void OnError(const CommandSender * apCommandSender, CHIP_ERROR aError) override
+    {
+        ChipLogError(NotSpecified, "Command failed: %" CHIP_ERROR_FORMAT, aError.Format());
+        // Errors reported by the bound device carry their interaction model status
+        Complete(StatusIB(aError).mStatus, nullptr);
+    }
+
+    void OnDone(CommandSender * apCommandSender) override
+    {
+        Complete(Protocols::InteractionModel::Status::Failure, nullptr);
+        BridgeTraceSpan(mTraceId, "matter.invoke", mStartUs);
+        mCommandSender.reset();
+    }
+
+private:
+    void Complete(Protocols::InteractionModel::Status status, TLV::TLVReader * response)
+    {
+        if (mOnComplete != nullptr) {
+            mOnComplete(mCompleteContext, status, response);
+            mOnComplete = nullptr;
+        }
+    }
+
+    std::optional<CommandSender> mCommandSender;
+    CommandCompleteCallback mOnComplete = nullptr;
+    void * mCompleteContext             = nullptr;
+    uint32_t mTraceId                   = kNoTraceId;
+    int64_t mStartUs                    = 0;
+};
+
+PassThroughCommand sPassThroughCommands[kMaxBatchedInteractions];
+
+/**
+ * Function used to send a unicast invoke interaction to a cluster in the binding table
+ */
+void ProcessUnicastCommand(BindingCommandData & data, const EmberBindingTableEntry & binding,
+                           Messaging::ExchangeManager * exchangeMgr, const SessionHandle & sessionHandle)
+{
+    for (auto & command : sPassThroughCommands) {
+        if (!command.InUse()) {
+            CHIP_ERROR err = command.Send(data, binding, exchangeMgr, sessionHandle);
+            VerifyOrReturn(err == CHIP_NO_ERROR, ChipLogError(NotSpecified, "Command failed: %" CHIP_ERROR_FORMAT, err.Format()));
+            // The completion is handed over to the first bound device
+            data.onCommandComplete = nullptr;
+            return;
+        }
+    }
+    ChipLogError(NotSpecified, "ProcessUnicastCommand - No free invoke interaction");
+}
 
-        break;
+/**
+ * Function used to send a multicast invoke interaction to a group in the binding table
+ * Group commands have no responses, so the command sender is not kept alive
+ */
+void ProcessGroupCommand(BindingCommandData & data, const EmberBindingTableEntry & binding)
+{
+    Messaging::ExchangeManager & exchangeMgr = Server::GetInstance().GetExchangeManager();
+    CommandPathParams path(0, binding.groupId, data.clusterId, data.commandId,
+                           BitFlags<CommandPathFlags>(CommandPathFlags::kGroupIdValid));
+    CommandSender sender(nullptr, &exchangeMgr);
 
-    case Clusters::OnOff::Commands::Off::Id:
-        Clusters::OnOff::Commands::Off::Type offCommand;
-        Controller::InvokeGroupCommandRequest(&exchangeMgr, binding.fabricIndex, binding.groupId, offCommand);
-        break;
+    CHIP_ERROR err = EncodeCommand(sender, path, data.value);
+    if (err == CHIP_NO_ERROR) {
+        Transport::OutgoingGroupSession session(binding.groupId, binding.fabricIndex);
+        err = sender.SendGroupCommandRequest(SessionHandle(session));
     }
+    if (err != CHIP_NO_ERROR) {
+        ChipLogError(NotSpecified, "Group command failed: %" CHIP_ERROR_FORMAT, err.Format());
+        return;
+    }
+    // Group commands are acknowledged as soon as they have been sent
+    if (data.onCommandComplete != nullptr) {
+        data.onCommandComplete(data.commandContext, Protocols::InteractionModel::Status::Success, nullptr);
+        data.onCommandComplete = nullptr;
+    }
+}
+
+/**
+ * Function used to turn a read or write of a single attribute into a batch with one entry
+ * Afterwards every read and write interaction is sent through the same type-erased code path
+ */
+void PromoteToBatch(BindingCommandData & data)
+{
+    AttributeBatch & batch = data.batch;
+    VerifyOrReturn(batch.count == 0);
+    batch.attributeIds[0]   = data.attributeId;
+    batch.values[0]         = data.value;
+    batch.onReadComplete[0] = data.onReadComplete;
+    batch.readContexts[0]   = data.readContext;
+    batch.count             = 1;
+    data.onReadComplete     = nullptr;
 }
 
 /**
@@ -149,46 +502,38 @@ void StateChangedHandler(const EmberBindingTableEntry & binding, OperationalDevi
     ChipLogProgress(DeviceLayer, "Light Switch Changed Handler - Status Changes!");
     VerifyOrReturn(context != nullptr, ChipLogError(NotSpecified, "OnDeviceConnectedFn: context is null"));
     BindingCommandData * data = static_cast<BindingCommandData *>(context);
+    // Interactions sent for the command belong to its trace, also if the session has only just been established
+    BridgeTraceContext trace(data->traceId);
     
-    // Check if a write interaction should be used
-    if (data->writeAttribute) {
-        // Check which data type should be used
-        if (std::holds_alternative<uint16_t>(data->data)) {
-            ProcessWriteAttribute(data->clusterId, data->attributeId, std::get<uint16_t>(data->data), binding, peer_device->GetExchangeManager(), peer_device->GetSecureSession().Value());
-        } else if (std::holds_alternative<bool>(data->data)) {
-            ProcessWriteAttribute(data->clusterId, data->attributeId, std::get<bool>(data->data), binding, peer_device->GetExchangeManager(), peer_device->GetSecureSession().Value());
+    // Check if the cluster of the bound device should be subscribed
+    if (data->subscribeAttributes) {
+        if (binding.type == EMBER_UNICAST_BINDING) {
+            SubscribeBoundCluster(binding, peer_device);
         }
     }
+    // Check if a write interaction should be used
+    else if (data->writeAttribute) {
+        VerifyOrReturn(peer_device != nullptr && peer_device->ConnectionReady());
+        PromoteToBatch(*data);
+        ProcessBatchedWrite(*data, binding, peer_device->GetExchangeManager(), peer_device->GetSecureSession().Value());
+    }
     // Check if a read interaction should be used
     else if (data->readAttribute) {
-        // Check which data type should be used
-        if (std::holds_alternative<uint16_t>(data->data)) {
-            ProcessReadAttribute<uint16_t>(data->clusterId, data->attributeId, binding, peer_device->GetExchangeManager(), peer_device->GetSecureSession().Value());
-        } else if (std::holds_alternative<bool>(data->data)) {
-            ProcessReadAttribute<bool>(data->clusterId, data->attributeId, binding, peer_device->GetExchangeManager(), peer_device->GetSecureSession().Value());
-        }
+        // The completion callbacks are handed over to the first read interaction
+        VerifyOrReturn(peer_device != nullptr && peer_device->ConnectionReady());
+        PromoteToBatch(*data);
+        ProcessBatchedRead(data->clusterId, data->batch, binding, peer_device->GetExchangeManager(), peer_device->GetSecureSession().Value());
     }
     // Check if a unicast invoke interaction should be used
     else if (binding.type == EMBER_UNICAST_BINDING && !data->isGroup)
     {
-        switch (data->clusterId)
-        {
-        case Clusters::OnOff::Id:
-            VerifyOrDie(peer_device != nullptr && peer_device->ConnectionReady());
-            ProcessOnOffUnicastBindingCommand(data->commandId, binding, peer_device->GetExchangeManager(),
-                                              peer_device->GetSecureSession().Value());
-            break;
-        }
+        VerifyOrReturn(peer_device != nullptr && peer_device->ConnectionReady());
+        ProcessUnicastCommand(*data, binding, peer_device->GetExchangeManager(), peer_device->GetSecureSession().Value());
     }
     // Check if a multicast invoke interaction should be used
     else if (binding.type == EMBER_MULTICAST_BINDING && data->isGroup)
     {
-        switch (data->clusterId)
-        {
-        case Clusters::OnOff::Id:
-            ProcessOnOffGroupBindingCommand(data->commandId, binding);
-            break;
-        }
+        ProcessGroupCommand(*data, binding);
     }
 }
 
@@ -199,7 +544,131 @@ void ContextReleaseHandler(void * context)
 {
     VerifyOrReturn(context != nullptr, ChipLogError(NotSpecified, "Invalid context for Light switch context release handler"));
 
-    Platform::Delete(static_cast<BindingCommandData *>(context));
+    BindingCommandData * data = static_cast<BindingCommandData *>(context);
+    // Fail pending requests if no bound device has taken over their completion callbacks
+    FailCompletions(*data);
+    sCommandContextReferences[data - sCommandContexts] = 0;
+}
+
+/**
+ * Function used to release a reference to a command context
+ */
+void ReleaseCommandContext(BindingCommandData * data)
+{
+    if (--sCommandContextReferences[data - sCommandContexts] == 0) {
+        ContextReleaseHandler(data);
+    }
+}
+
+/**
+ * Unicast binding whose command waits for the CASE session to the bound device
+ * Sessions that are already established are handed over right away by the CASE session manager
+ */
+class PendingRoute
+{
+public:
+    PendingRoute() : mOnConnected(HandleConnected, this), mOnConnectionFailure(HandleConnectionFailure, this) {}
+
+    bool InUse() const { return mContext != nullptr; }
+
+    void Start(uint8_t bindingIndex, BindingCommandData * context)
+    {
+        const EmberBindingTableEntry & entry = BindingTable::GetInstance().GetAt(bindingIndex);
+        mBindingIndex = bindingIndex;
+        mBinding      = entry;
+        mContext      = context;
+        // The callbacks may be invoked before this call returns
+        Server::GetInstance().GetCASESessionManager()->FindOrEstablishSession(ScopedNodeId(entry.nodeId, entry.fabricIndex),
+                                                                             &mOnConnected, &mOnConnectionFailure);
+    }
+
+private:
+    static void HandleConnected(void * context, Messaging::ExchangeManager & exchangeMgr, const SessionHandle & sessionHandle)
+    {
+        PendingRoute * route = static_cast<PendingRoute *>(context);
+        const EmberBindingTableEntry & entry = BindingTable::GetInstance().GetAt(route->mBindingIndex);
+        // The binding may have been removed while the session was established, and its index taken by another binding
+        if (route->IsSameBinding(entry)) {
+            OperationalDeviceProxy peer_device(&exchangeMgr, sessionHandle);
+            StateChangedHandler(entry, &peer_device, route->mContext);
+        } else {
+            ChipLogError(NotSpecified, "Binding %u changed while its session was established, command dropped",
+                         route->mBindingIndex);
+        }
+        route->Finish();
+    }
+
+    static void HandleConnectionFailure(void * context, const ScopedNodeId & peerId, CHIP_ERROR error)
+    {
+        PendingRoute * route = static_cast<PendingRoute *>(context);
+        ChipLogError(NotSpecified, "Cannot route command to " ChipLogFormatScopedNodeId ": %" CHIP_ERROR_FORMAT,
+                     ChipLogValueScopedNodeId(peerId), error.Format());
+        route->Finish();
+    }
+
+    bool IsSameBinding(const EmberBindingTableEntry & entry) const
+    {
+        return entry.type == EMBER_UNICAST_BINDING && entry.fabricIndex == mBinding.fabricIndex &&
+            entry.nodeId == mBinding.nodeId && entry.local == mBinding.local && entry.remote == mBinding.remote &&
+            entry.clusterId == mBinding.clusterId;
+    }
+
+    void Finish()
+    {
+        BindingCommandData * data = mContext;
+        mContext = nullptr;
+        ReleaseCommandContext(data);
+    }
+
+    Callback::Callback<OnDeviceConnected> mOnConnected;
+    Callback::Callback<OnDeviceConnectionFailure> mOnConnectionFailure;
+    BindingCommandData * mContext = nullptr;
+    uint8_t mBindingIndex = 0;
+    // Copy of the binding the route has been started for
+    EmberBindingTableEntry mBinding;
+};
+
+PendingRoute sPendingRoutes[kMaxPendingRoutes];
+
+/**
+ * Function used to route a command to a single binding
+ * Multicast bindings are served directly, unicast bindings once the session to the bound device is available
+ */
+void RouteCommand(uint8_t bindingIndex, BindingCommandData * data)
+{
+    const EmberBindingTableEntry & entry = BindingTable::GetInstance().GetAt(bindingIndex);
+    if (entry.type == EMBER_MULTICAST_BINDING) {
+        StateChangedHandler(entry, nullptr, data);
+        return;
+    }
+    VerifyOrReturn(entry.type == EMBER_UNICAST_BINDING);
+
+    for (auto & route : sPendingRoutes) {
+        if (!route.InUse()) {
+            sCommandContextReferences[data - sCommandContexts]++;
+            route.Start(bindingIndex, data);
+            return;
+        }
+    }
+    ChipLogError(NotSpecified, "RouteCommand - No free route");
+}
+
+/**
+ * Event handler used to rebuild the binding index if the binding table has been written through the binding cluster
+ */
+void BindingEventHandler(const DeviceLayer::ChipDeviceEvent * event, intptr_t arg)
+{
+    if (event->Type == DeviceLayer::DeviceEventType::kBindingsChangedViaCluster) {
+        sBindingIndex.Rebuild();
+#if CONFIG_BRIDGE_SESSION_KEEPER
+        WarmBoundPeerSessions();
+#endif
+#if CONFIG_BRIDGE_SUBSCRIBE_BOUND_CLUSTERS
+        // Subscriptions of removed bindings are ended, added bindings are subscribed
+        UnsubscribeRemovedBindings();
+        SubscribeBoundClusters();
+#endif
+    }
 }
 
 /**
@@ -210,32 +679,175 @@ void InitBindingHandlerInternal(intptr_t arg)
     auto & server = chip::Server::GetInstance();
     chip::BindingManager::GetInstance().Init(
         { &server.GetFabricTable(), server.GetCASESessionManager(), &server.GetPersistentStorage() });
-    chip::BindingManager::GetInstance().RegisterBoundDeviceChangedHandler(StateChangedHandler);
-    chip::BindingManager::GetInstance().RegisterBoundDeviceContextReleaseHandler(ContextReleaseHandler);
+    // Commands are routed through the binding index instead of the binding manager
+    sBindingIndex.Rebuild();
+    chip::DeviceLayer::PlatformMgr().AddEventHandler(BindingEventHandler, 0);
+
+#if CONFIG_BRIDGE_SESSION_KEEPER
+    // Establish the sessions to all bound devices before the first request has to be forwarded
+    StartSessionKeeper();
+#endif
+#if CONFIG_BRIDGE_SUBSCRIBE_BOUND_CLUSTERS
+    // Keep a shadow of the attributes of all bound devices
+    SubscribeBoundClusters();
+#endif
+#if CONFIG_BRIDGE_POOL_STATS_INTERVAL > 0
+    StartObjectPoolStats();
+#endif
+#if CONFIG_BRIDGE_LATENCY_REPORT_INTERVAL > 0
+    StartBridgeLatencyReport();
+#endif
 }
 
 } // namespace
 
 /**
- * Worker function that can be invoked with BindingCommandData to send a read, write or invoke interaction to a cluster
+ * Function used to copy the TLV representation of a reported attribute value
+ * The element is kept as it is, so every attribute type is handed to the requester without conversion
+ */
+CHIP_ERROR DecodeAttributeValue(TLV::TLVReader & reader, TlvValue & value)
+{
+    CHIP_ERROR err = value.CopyElement(reader);
+    if (err == CHIP_ERROR_BUFFER_TOO_SMALL) {
+        ChipLogError(NotSpecified, "Attribute value exceeds %u bytes", static_cast<unsigned>(kMaxAttributeValueSize));
+    }
+    return err;
+}
+
+/**
+ * Function used to send a read, write or invoke interaction to a cluster
+ * The data is copied into a free command context and routed to every binding of the local endpoint and the cluster
+ */
+void ProcessBindingCommand(const BindingCommandData & data)
+{
+    BridgeTraceScope trace(data.traceId, "binding.route");
+    BridgeMetricIncrement(BridgeCounter::kBindingCommands);
+    if (data.localEndpointId == kInvalidEndpointId) {
+        // Commands must name the local endpoint whose bindings they use, they are never fanned out to every binding
+        ChipLogError(NotSpecified, "ProcessBindingCommand - No local endpoint for cluster 0x%" PRIx32, data.clusterId);
+        BindingCommandData failed = data;
+        FailCompletions(failed);
+        return;
+    }
+    for (size_t i = 0; i < kCommandContextCount; i++) {
+        if (sCommandContextReferences[i] == 0) {
+            // The reference held while routing keeps the context alive if every route completes right away
+            sCommandContextReferences[i] = 1;
+            sCommandContexts[i]          = data;
+            sBindingIndex.ForEach(data.localEndpointId, data.clusterId,
+                                  [&](uint8_t bindingIndex) { RouteCommand(bindingIndex, &sCommandContexts[i]); });
+            ReleaseCommandContext(&sCommandContexts[i]);
+            return;
+        }
+    }
+
+    ChipLogError(NotSpecified, "ProcessBindingCommand - No free command context");
+    BridgeMetricIncrement(BridgeCounter::kBindingNoContext);
+    BindingCommandData failed = data;
+    FailCompletions(failed);
+}
+
+/**
+ * Function used to check if a posted read can be added to the batch of another read
+ */
+static bool CanCoalesceRead(const BindingCommandData & command, const BindingCommandData & next)
+{
+    return next.readAttribute && next.batch.count == 0 && !next.subscribeAttributes && next.isGroup == command.isGroup &&
+        next.localEndpointId == command.localEndpointId && next.clusterId == command.clusterId;
+}
+
+/**
+ * Function used to add a posted read to the batch of another read
+ * A single read is turned into a batch first
  */
-void SwitchWorkerFunction(intptr_t context)
+static void CoalesceRead(BindingCommandData & command, const BindingCommandData & next)
 {
-    VerifyOrReturn(context != 0, ChipLogError(NotSpecified, "SwitchWorkerFunction - Invalid work data"));
-    BindingCommandData * data = reinterpret_cast<BindingCommandData *>(context);
-    BindingManager::GetInstance().NotifyBoundClusterChanged(data->localEndpointId, data->clusterId, static_cast<void *>(data));
+    AttributeBatch & batch = command.batch;
+    PromoteToBatch(command);
+    batch.attributeIds[batch.count]   = next.attributeId;
+    batch.onReadComplete[batch.count] = next.onReadComplete;
+    batch.readContexts[batch.count]   = next.readContext;
+    batch.count++;
+}
+
+/**
+ * Worker function used to process every command that has been posted to the command rings
+ */
+void DrainBindingCommands(intptr_t context)
+{
+    sCommandChannel.Drain(
+        [](BindingCommandData & command, const BindingCommandData & next) {
+            // Reads of the same cluster that have been posted within one burst share a single read interaction
+            if (!command.readAttribute || command.batch.count >= kMaxBatchAttributes || !CanCoalesceRead(command, next)) {
+                return false;
+            }
+            BridgeTraceSpan(next.traceId, "binding.queue", next.postedUs);
+            CoalesceRead(command, next);
+            return true;
+        },
+        [](BindingCommandData & command) {
+            BridgeTraceSpan(command.traceId, "binding.queue", command.postedUs);
+            ProcessBindingCommand(command);
+        });
+}
+
+/**
+ * Function used to post a command from a task other than the Matter event loop
+ * Only a single work item is scheduled for a burst of commands
+ */
+CHIP_ERROR PostBindingCommand(CommandProducer producer, const BindingCommandData & data)
+{
+    auto result = sCommandChannel.Post(
+        static_cast<size_t>(producer),
+        [&](BindingCommandData & slot) {
+            slot          = data;
+            slot.postedUs = BridgeTraceNow();
+        },
+        [] { return chip::DeviceLayer::PlatformMgr().ScheduleWork(DrainBindingCommands) == CHIP_NO_ERROR; });
+    if (result == decltype(sCommandChannel)::PostResult::kFull) {
+        ChipLogError(NotSpecified, "PostBindingCommand - Command ring is full");
+        BridgeMetricIncrement(BridgeCounter::kBindingRingFull);
+        return CHIP_ERROR_NO_MEMORY;
+    }
+    if (result == decltype(sCommandChannel)::PostResult::kNotScheduled) {
+        // The command stays in the ring, the next post schedules the drain again
+        ChipLogError(NotSpecified, "PostBindingCommand - Cannot schedule the drain of the command rings");
+    }
+    return CHIP_NO_ERROR;
 }
 
 /**
  * Worker function for the binding cluster used to add new entries
+ * The entry has to be taken from the binding entry pool, use ScheduleBindingEntry
  */
 void BindingWorkerFunction(intptr_t context)
 {
     VerifyOrReturn(context != 0, ChipLogError(NotSpecified, "BindingWorkerFunction - Invalid work data"));
     EmberBindingTableEntry * entry = reinterpret_cast<EmberBindingTableEntry *>(context);
     AddBindingEntry(*entry);
+    sBindingIndex.Rebuild();
+#if CONFIG_BRIDGE_SESSION_KEEPER
+    WarmBoundPeerSessions();
+#endif
+#if CONFIG_BRIDGE_SUBSCRIBE_BOUND_CLUSTERS
+    SubscribeBoundClusters();
+#endif
 
-    Platform::Delete(entry);
+    sBindingEntryPool.Release(entry);
+}
+
+/**
+ * Function used to add an entry to the binding table from any task
+ */
+CHIP_ERROR ScheduleBindingEntry(const EmberBindingTableEntry & entry)
+{
+    EmberBindingTableEntry * pooled = sBindingEntryPool.Allocate(entry);
+    VerifyOrReturnError(pooled != nullptr, CHIP_ERROR_NO_MEMORY);
+    CHIP_ERROR err = chip::DeviceLayer::PlatformMgr().ScheduleWork(BindingWorkerFunction, reinterpret_cast<intptr_t>(pooled));
+    if (err != CHIP_NO_ERROR) {
+        sBindingEntryPool.Release(pooled);
+    }
+    return err;
 }
 
 /**
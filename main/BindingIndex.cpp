@@ -0,0 +1,51 @@
+#include "BindingIndex.h"
+
+using namespace chip;
+
+/**
+ * Function used to get the first binding of a key, returns kNoBinding if the key is not indexed
+ */
+uint8_t BindingIndex::Find(EndpointId endpoint, ClusterId cluster) const
+{
+    for (size_t i = Hash(endpoint, cluster);; i = (i + 1) & (kBucketCount - 1)) {
+        const Bucket & bucket = mBuckets[i];
+        if (bucket.head == kNoBinding) {
+            return kNoBinding;
+        }
+        if (bucket.endpoint == endpoint && bucket.cluster == cluster) {
+            return bucket.head;
+        }
+    }
+}
+
+/**
+ * Function used to link a binding into the chain of a key
+ */
+void BindingIndex::Insert(EndpointId endpoint, ClusterId cluster, uint8_t index)
+{
+    for (size_t i = Hash(endpoint, cluster);; i = (i + 1) & (kBucketCount - 1)) {
+        Bucket & bucket = mBuckets[i];
+        if (bucket.head == kNoBinding) {
+            bucket.endpoint = endpoint;
+            bucket.cluster  = cluster;
+        } else if (bucket.endpoint != endpoint || bucket.cluster != cluster) {
+            continue;
+        }
+        mNext[index] = bucket.head;
+        bucket.head  = index;
+        return;
+    }
+}
+
+void BindingIndex::Rebuild()
+{
+    for (auto & bucket : mBuckets) {
+        bucket.head = kNoBinding;
+    }
+
+    auto & table = BindingTable::GetInstance();
+    for (auto iter = table.begin(); iter != table.end(); ++iter) {
+        ClusterId cluster = iter->clusterId.HasValue() ? iter->clusterId.Value() : kInvalidClusterId;
+        Insert(iter->local, cluster, iter.GetIndex());
+    }
+}
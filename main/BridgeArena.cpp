@@ -0,0 +1,180 @@
+#include "BridgeArena.h"
+
+#if CONFIG_BRIDGE_CONFIG_ARENA
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <lib/support/CodeUtils.h>
+#include <support/logging/CHIPLogging.h>
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+
+namespace {
+
+constexpr size_t kChunkSize = CONFIG_BRIDGE_CONFIG_ARENA_CHUNK_SIZE;
+constexpr size_t kAlignment = alignof(std::max_align_t);
+// Objects larger than this get a chunk of their own, so the free space of the current chunk is not wasted
+constexpr size_t kMaxSharedSize = kChunkSize / 4;
+
+// The chunk lists are only changed with the mutex held, Owns is called by every task that frees memory
+std::mutex sArenaMutex;
+// Arena that holds memory, its chunks are checked when memory is freed
+std::atomic<BridgeArena *> sLiveArena{ nullptr };
+// Address range that covers every chunk of the live arena, only grown with the mutex held
+// Memory outside of it is rejected without the mutex, so freeing heap memory on other tasks never waits for the arena
+std::atomic<uintptr_t> sLiveBegin{ UINTPTR_MAX };
+std::atomic<uintptr_t> sLiveEnd{ 0 };
+// Arena the allocations of sActiveTask are made from
+std::atomic<BridgeArena *> sActiveArena{ nullptr };
+std::atomic<TaskHandle_t> sActiveTask{ nullptr };
+// Only changed and read by the active task
+bool sSuspended = false;
+
+constexpr size_t AlignUp(size_t size)
+{
+    return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+} // namespace
+
+struct BridgeArena::Chunk
+{
+    Chunk * next;
+    uint8_t * cursor;
+    uint8_t * end;
+
+    uint8_t * Begin() { return reinterpret_cast<uint8_t *>(this) + AlignUp(sizeof(Chunk)); }
+};
+
+BridgeArena::Chunk * BridgeArena::AddChunk(size_t size)
+{
+    std::lock_guard<std::mutex> lock(sArenaMutex);
+    BridgeArena * live = sLiveArena.load(std::memory_order_relaxed);
+    if (live != nullptr && live != this) {
+        ChipLogError(DeviceLayer, "Bridge-Arena: Another arena still holds memory, allocating from the heap");
+        return nullptr;
+    }
+
+    void * memory = malloc(AlignUp(sizeof(Chunk)) + size);
+    VerifyOrReturnValue(memory != nullptr, nullptr);
+    Chunk * chunk  = static_cast<Chunk *>(memory);
+    chunk->cursor  = chunk->Begin();
+    chunk->end     = chunk->cursor + size;
+    chunk->next    = mChunks.load(std::memory_order_relaxed);
+    mChunks.store(chunk, std::memory_order_release);
+    mReserved += size;
+    sLiveBegin.store(std::min(sLiveBegin.load(std::memory_order_relaxed), reinterpret_cast<uintptr_t>(chunk->Begin())),
+                     std::memory_order_release);
+    sLiveEnd.store(std::max(sLiveEnd.load(std::memory_order_relaxed), reinterpret_cast<uintptr_t>(chunk->end)),
+                   std::memory_order_release);
+    sLiveArena.store(this, std::memory_order_release);
+    return chunk;
+}
+
+void * BridgeArena::Allocate(size_t size)
+{
+    size = AlignUp(size > 0 ? size : 1);
+    Chunk * chunk = mChunks.load(std::memory_order_relaxed);
+    // The first chunk of the list is the one objects are bumped from, dedicated chunks are inserted behind it
+    if (size > kMaxSharedSize) {
+        Chunk * dedicated = AddChunk(size);
+        VerifyOrReturnValue(dedicated != nullptr, nullptr);
+        if (chunk != nullptr) {
+            std::lock_guard<std::mutex> lock(sArenaMutex);
+            mChunks.store(dedicated->next, std::memory_order_relaxed);
+            dedicated->next = chunk->next;
+            chunk->next     = dedicated;
+        }
+        chunk = dedicated;
+    } else if (chunk == nullptr || static_cast<size_t>(chunk->end - chunk->cursor) < size) {
+        chunk = AddChunk(kChunkSize);
+        VerifyOrReturnValue(chunk != nullptr, nullptr);
+    }
+
+    void * ptr = chunk->cursor;
+    chunk->cursor += size;
+    mUsed += size;
+    return ptr;
+}
+
+bool BridgeArena::Owns(const void * ptr) const
+{
+    const uint8_t * address = static_cast<const uint8_t *>(ptr);
+    uintptr_t value         = reinterpret_cast<uintptr_t>(ptr);
+    // Heap memory between the chunks still takes the mutex, anything else is decided without it
+    VerifyOrReturnValue(value >= sLiveBegin.load(std::memory_order_acquire) && value < sLiveEnd.load(std::memory_order_acquire),
+                        false);
+    std::lock_guard<std::mutex> lock(sArenaMutex);
+    for (Chunk * chunk = mChunks.load(std::memory_order_acquire); chunk != nullptr; chunk = chunk->next) {
+        if (address >= chunk->Begin() && address < chunk->end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BridgeArena::Release()
+{
+    std::lock_guard<std::mutex> lock(sArenaMutex);
+    VerifyOrReturn(mChunks.load(std::memory_order_relaxed) != nullptr);
+    ChipLogProgress(DeviceLayer, "Bridge-Arena: Releasing %u bytes allocated in %u bytes of chunks", static_cast<unsigned>(mUsed),
+                    static_cast<unsigned>(mReserved));
+
+    Chunk * chunk = mChunks.exchange(nullptr, std::memory_order_acq_rel);
+    // Only a single arena holds memory, so the range is empty afterwards
+    sLiveBegin.store(UINTPTR_MAX, std::memory_order_release);
+    sLiveEnd.store(0, std::memory_order_release);
+    while (chunk != nullptr) {
+        Chunk * next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    mUsed     = 0;
+    mReserved = 0;
+    if (sLiveArena.load(std::memory_order_relaxed) == this) {
+        sLiveArena.store(nullptr, std::memory_order_release);
+    }
+}
+
+void * BridgeArenaAllocate(size_t size)
+{
+    BridgeArena * arena = sActiveArena.load(std::memory_order_acquire);
+    VerifyOrReturnValue(arena != nullptr, nullptr);
+    VerifyOrReturnValue(sActiveTask.load(std::memory_order_relaxed) == xTaskGetCurrentTaskHandle(), nullptr);
+    VerifyOrReturnValue(!sSuspended, nullptr);
+    return arena->Allocate(size);
+}
+
+bool BridgeArenaOwns(const void * ptr)
+{
+    BridgeArena * arena = sLiveArena.load(std::memory_order_acquire);
+    return arena != nullptr && ptr != nullptr && arena->Owns(ptr);
+}
+
+void BridgeArenaActivate(BridgeArena * arena)
+{
+    if (arena == nullptr) {
+        sActiveArena.store(nullptr, std::memory_order_release);
+        sActiveTask.store(nullptr, std::memory_order_relaxed);
+        return;
+    }
+
+    if (sActiveArena.load(std::memory_order_relaxed) != nullptr) {
+        ChipLogError(DeviceLayer, "Bridge-Arena: An arena is already active");
+        return;
+    }
+    sSuspended = false;
+    sActiveTask.store(xTaskGetCurrentTaskHandle(), std::memory_order_relaxed);
+    sActiveArena.store(arena, std::memory_order_release);
+}
+
+bool BridgeArenaSetSuspended(bool suspended)
+{
+    VerifyOrReturnValue(sActiveTask.load(std::memory_order_relaxed) == xTaskGetCurrentTaskHandle(), false);
+    bool previous = sSuspended;
+    sSuspended    = suspended;
+    return previous;
+}
+
+#endif // CONFIG_BRIDGE_CONFIG_ARENA
@@ -0,0 +1,116 @@
+#include "BridgeLatency.h"
+#include "esp_timer.h"
+#include <lib/support/CodeUtils.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <atomic>
+#include <cinttypes>
+
+using namespace chip;
+
+namespace {
+
+constexpr size_t kPathCount = static_cast<size_t>(BridgePath::kCount);
+
+constexpr const char * kPathNames[kPathCount] = { "matter_read", "matter_write", "matter_command",
+                                                  "coap_read",   "coap_write",   "coap_command" };
+
+// Measurements of a single bridge path, updated by every task that completes a round trip
+struct PathState
+{
+    LatencyHistogram latency;
+    std::atomic<uint32_t> failures{ 0 };
+    std::atomic<uint32_t> inFlight{ 0 };
+    std::atomic<uint32_t> maxInFlight{ 0 };
+};
+
+PathState sPaths[kPathCount];
+std::atomic<int64_t> sResetUs{ 0 };
+
+PathState & GetPath(BridgePath path)
+{
+    return sPaths[static_cast<size_t>(path)];
+}
+
+/**
+ * Timer handler used to log the statistics periodically
+ */
+void ReportTimerHandler(System::Layer * layer, void * context)
+{
+    LogBridgeLatencies();
+    DeviceLayer::SystemLayer().StartTimer(System::Clock::Seconds32(CONFIG_BRIDGE_LATENCY_REPORT_INTERVAL), ReportTimerHandler,
+                                          nullptr);
+}
+
+} // namespace
+
+int64_t BridgeLatencyBegin(BridgePath path)
+{
+    PathState & state = GetPath(path);
+    uint32_t in_flight = state.inFlight.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint32_t max       = state.maxInFlight.load(std::memory_order_relaxed);
+    while (in_flight > max && !state.maxInFlight.compare_exchange_weak(max, in_flight, std::memory_order_relaxed)) {
+    }
+    return esp_timer_get_time();
+}
+
+void BridgeLatencyEnd(BridgePath path, int64_t start_us, bool success)
+{
+    PathState & state = GetPath(path);
+    int64_t elapsed   = esp_timer_get_time() - start_us;
+    state.latency.Record(elapsed > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(elapsed));
+    if (!success) {
+        state.failures.fetch_add(1, std::memory_order_relaxed);
+    }
+    state.inFlight.fetch_sub(1, std::memory_order_relaxed);
+}
+
+BridgePathStats GetBridgePathStats(BridgePath path)
+{
+    const PathState & state = GetPath(path);
+    BridgePathStats stats;
+    stats.name        = kPathNames[static_cast<size_t>(path)];
+    stats.count       = state.latency.Count();
+    stats.failures    = state.failures.load(std::memory_order_relaxed);
+    stats.p50Us       = state.latency.Percentile(500);
+    stats.p99Us       = state.latency.Percentile(990);
+    stats.p999Us      = state.latency.Percentile(999);
+    stats.maxUs       = state.latency.Max();
+    stats.maxInFlight = state.maxInFlight.load(std::memory_order_relaxed);
+
+    int64_t elapsed_ms    = (esp_timer_get_time() - sResetUs.load(std::memory_order_relaxed)) / 1000;
+    stats.throughputMilli = elapsed_ms > 0 ? static_cast<uint32_t>(static_cast<int64_t>(stats.count) * 1000000 / elapsed_ms) : 0;
+    return stats;
+}
+
+void LogBridgeLatencies()
+{
+    for (size_t i = 0; i < kPathCount; i++) {
+        BridgePathStats stats = GetBridgePathStats(static_cast<BridgePath>(i));
+        ChipLogProgress(DeviceLayer,
+                        "bridge-latency: {\"path\":\"%s\",\"count\":%" PRIu32 ",\"failures\":%" PRIu32 ",\"p50_us\":%" PRIu32
+                        ",\"p99_us\":%" PRIu32 ",\"p999_us\":%" PRIu32 ",\"max_us\":%" PRIu32 ",\"rps\":%" PRIu32 ".%03" PRIu32
+                        ",\"max_in_flight\":%" PRIu32 "}",
+                        stats.name, stats.count, stats.failures, stats.p50Us, stats.p99Us, stats.p999Us, stats.maxUs,
+                        stats.throughputMilli / 1000, stats.throughputMilli % 1000, stats.maxInFlight);
+    }
+}
+
+void ResetBridgeLatencies()
+{
+    for (auto & state : sPaths) {
+        state.latency.Reset();
+        state.failures.store(0, std::memory_order_relaxed);
+        // Round trips that are in flight keep counting towards the concurrency
+        state.maxInFlight.store(state.inFlight.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    sResetUs.store(esp_timer_get_time(), std::memory_order_relaxed);
+}
+
+/**
+ * Function used to log the statistics every CONFIG_BRIDGE_LATENCY_REPORT_INTERVAL seconds
+ */
+void StartBridgeLatencyReport()
+{
+    DeviceLayer::SystemLayer().StartTimer(System::Clock::Seconds32(CONFIG_BRIDGE_LATENCY_REPORT_INTERVAL), ReportTimerHandler,
+                                          nullptr);
+}
@@ -0,0 +1,150 @@
+#include "BridgeLog.h"
+#include "esp_timer.h"
+#include <lib/support/CodeUtils.h>
+#include <support/logging/CHIPLogging.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+constexpr size_t kRecordCount = CONFIG_BRIDGE_LOG_BUFFER_SIZE;
+// Upper bound of a formatted record including its time stamp
+constexpr size_t kMaxLineLength = 160;
+
+constexpr char kLevelLetters[] = { 'E', 'I', 'D', 'V' };
+
+// Record of the log ring, the sequence is zero while the record is written
+struct Record
+{
+    std::atomic<uint32_t> sequence{ 0 };
+    int64_t timeUs;
+    const char * format;
+    BridgeLogLevel level;
+    uint8_t argCount;
+    uint32_t args[kMaxBridgeLogArgs];
+};
+
+Record sRecords[kRecordCount];
+std::atomic<uint32_t> sHead{ 0 };
+std::atomic<uint32_t> sSuppressed{ 0 };
+
+/**
+ * Function used to copy a record out of the ring
+ * Returns false if the slot is empty or has been overwritten while it was copied
+ */
+bool ReadRecord(uint32_t index, Record & record)
+{
+    const Record & slot = sRecords[index % kRecordCount];
+    uint32_t sequence   = slot.sequence.load(std::memory_order_acquire);
+    VerifyOrReturnValue(sequence == index + 1, false);
+    record.timeUs   = slot.timeUs;
+    record.format   = slot.format;
+    record.level    = slot.level;
+    record.argCount = slot.argCount;
+    for (size_t i = 0; i < kMaxBridgeLogArgs; i++) {
+        record.args[i] = slot.args[i];
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+/**
+ * Function used to expand the format of a record, this is the deferred part of logging
+ * The formats are string literals of the log statements, which only consume 32-bit integers
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+int FormatRecord(char * buffer, size_t size, const Record & record)
+{
+    return snprintf(buffer, size, record.format, record.args[0], record.args[1], record.args[2], record.args[3]);
+}
+#pragma GCC diagnostic pop
+
+} // namespace
+
+bool BridgeLogSampler::Allow()
+{
+#if CONFIG_BRIDGE_LOG_RATE_LIMIT > 0
+    uint32_t now    = static_cast<uint32_t>(esp_timer_get_time() / 1000000);
+    uint32_t window = mWindow.load(std::memory_order_relaxed);
+    if (window != now && mWindow.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+        mCount.store(0, std::memory_order_relaxed);
+    }
+    if (mCount.fetch_add(1, std::memory_order_relaxed) >= CONFIG_BRIDGE_LOG_RATE_LIMIT) {
+        BridgeLogCountSuppressed();
+        return false;
+    }
+#endif
+    return true;
+}
+
+void BridgeLogCountSuppressed()
+{
+    sSuppressed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BridgeLogWrite(BridgeLogLevel level, const char * format, const uint32_t * args, size_t arg_count)
+{
+    uint32_t index = sHead.fetch_add(1, std::memory_order_relaxed);
+    Record & slot  = sRecords[index % kRecordCount];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timeUs   = esp_timer_get_time();
+    slot.format   = format;
+    slot.level    = level;
+    slot.argCount = static_cast<uint8_t>(arg_count);
+    for (size_t i = 0; i < kMaxBridgeLogArgs; i++) {
+        slot.args[i] = i < arg_count ? args[i] : 0;
+    }
+    slot.sequence.store(index + 1, std::memory_order_release);
+
+#if CONFIG_BRIDGE_LOG_ECHO
+    char line[kMaxLineLength];
+    FormatRecord(line, sizeof(line), slot);
+    ChipLogProgress(DeviceLayer, "%s", line);
+#endif
+}
+
+size_t GetBridgeLogExportSize()
+{
+    uint32_t head  = sHead.load(std::memory_order_relaxed);
+    size_t records = head < kRecordCount ? head : kRecordCount;
+    return (records + 1) * kMaxLineLength;
+}
+
+size_t ExportBridgeLog(char * buffer, size_t size)
+{
+    uint32_t head  = sHead.load(std::memory_order_acquire);
+    uint32_t first = head > kRecordCount ? head - kRecordCount : 0;
+    size_t length  = 0;
+
+    for (uint32_t index = first; index < head; index++) {
+        Record record;
+        if (!ReadRecord(index, record)) {
+            continue;
+        }
+        VerifyOrReturnValue(size - length > kMaxLineLength, 0);
+        int written = snprintf(buffer + length, size - length, "%" PRId64 ".%06" PRId64 " %c ", record.timeUs / 1000000,
+                               record.timeUs % 1000000, kLevelLetters[static_cast<size_t>(record.level)]);
+        VerifyOrReturnValue(written > 0, 0);
+        length += static_cast<size_t>(written);
+        written = FormatRecord(buffer + length, size - length - 1, record);
+        VerifyOrReturnValue(written >= 0, 0);
+        // Long records are truncated
+        length += std::min(static_cast<size_t>(written), size - length - 2);
+        buffer[length++] = '\n';
+    }
+
+    int written = snprintf(buffer + length, size - length, "suppressed %" PRIu32 "\n", sSuppressed.load(std::memory_order_relaxed));
+    VerifyOrReturnValue(written > 0 && static_cast<size_t>(written) < size - length, 0);
+    return length + static_cast<size_t>(written);
+}
+
+void ClearBridgeLog()
+{
+    for (auto & slot : sRecords) {
+        slot.sequence.store(0, std::memory_order_relaxed);
+    }
+    sSuppressed.store(0, std::memory_order_relaxed);
+}
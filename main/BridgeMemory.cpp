@@ -0,0 +1,339 @@
+#include "BridgeMemory.h"
+#include "BridgeArena.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include <lib/support/CodeUtils.h>
+#include <support/logging/CHIPLogging.h>
+#include <pugixml.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace {
+
+constexpr size_t kPhaseCount = static_cast<size_t>(BridgePhase::kCount);
+// Number of tasks whose stacks can be watched
+constexpr size_t kMaxWatchedTasks = 8;
+
+constexpr const char * kPhaseNames[kPhaseCount] = { "fetch", "parse", "convert", "deploy", "steady" };
+
+// State of a phase, the atomics are updated by the tracking allocator without taking the mutex
+struct PhaseState
+{
+    std::atomic<uint32_t> active{ 0 };
+    std::atomic<uint32_t> heapFreeMin{ UINT32_MAX };
+    std::atomic<uint32_t> trackedPeak{ 0 };
+    std::atomic<uint32_t> trackedAllocations{ 0 };
+    uint32_t heapFreeStart = 0;
+    // Minimum free heap of the system when the phase became active, a lower minimum was reached during the phase
+    uint32_t systemMinAtStart = 0;
+    int64_t activeSinceUs = 0;
+    int64_t durationUs = 0;
+};
+
+struct WatchedTask
+{
+    TaskHandle_t handle;
+    BridgeTaskStackStats stats;
+};
+
+PhaseState sPhases[kPhaseCount];
+std::mutex sPhasesMutex;
+std::atomic<uint32_t> sTrackedBytes{ 0 };
+
+WatchedTask sTasks[kMaxWatchedTasks];
+size_t sTaskCount = 0;
+std::mutex sTasksMutex;
+
+uint32_t FreeHeap()
+{
+    return static_cast<uint32_t>(heap_caps_get_free_size(MALLOC_CAP_8BIT));
+}
+
+/**
+ * Function used to lower an atomic minimum
+ * Returns true if the value is the new minimum
+ */
+bool UpdateMin(std::atomic<uint32_t> & minimum, uint32_t value)
+{
+    uint32_t current = minimum.load(std::memory_order_relaxed);
+    while (value < current) {
+        if (minimum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Function used to raise an atomic maximum
+ * Returns true if the value is the new maximum
+ */
+bool UpdateMax(std::atomic<uint32_t> & maximum, uint32_t value)
+{
+    uint32_t current = maximum.load(std::memory_order_relaxed);
+    while (value > current) {
+        if (maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Function used to sample the free heap for a phase, must be called with the mutex held
+ * The minimum of the system covers allocations between two samples, as long as it has been reached during the phase
+ */
+void SamplePhaseHeap(PhaseState & state)
+{
+    UpdateMin(state.heapFreeMin, FreeHeap());
+    uint32_t system_min = static_cast<uint32_t>(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    if (system_min < state.systemMinAtStart) {
+        UpdateMin(state.heapFreeMin, system_min);
+    }
+}
+
+/**
+ * Function used to sample the stack of a watched task, must be called with the mutex held
+ */
+void SampleTask(WatchedTask & task)
+{
+    VerifyOrReturn(task.handle != nullptr);
+    task.stats.minFree = static_cast<uint32_t>(uxTaskGetStackHighWaterMark(task.handle));
+}
+
+} // namespace
+
+void * BridgeTrackedAllocate(size_t size)
+{
+    // The arena is accounted for by the chunks it allocates from the heap
+    void * arena_ptr = BridgeArenaAllocate(size);
+    VerifyOrReturnValue(arena_ptr == nullptr, arena_ptr);
+
+    void * ptr = malloc(size > 0 ? size : 1);
+    VerifyOrReturnValue(ptr != nullptr, nullptr);
+    // The size is taken from the heap instead of a header, so tracked allocations are plain heap blocks
+    size = heap_caps_get_allocated_size(ptr);
+
+    uint32_t tracked = sTrackedBytes.fetch_add(static_cast<uint32_t>(size), std::memory_order_relaxed) + static_cast<uint32_t>(size);
+    for (auto & state : sPhases) {
+        if (state.active.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        state.trackedAllocations.fetch_add(1, std::memory_order_relaxed);
+        // The free heap is only sampled when the peak of the phase grows, which bounds the cost
+        if (UpdateMax(state.trackedPeak, tracked)) {
+            UpdateMin(state.heapFreeMin, FreeHeap());
+        }
+    }
+    return ptr;
+}
+
+void BridgeTrackedFree(void * ptr)
+{
+    VerifyOrReturn(ptr != nullptr);
+    // Memory of the arena is released with the arena
+    VerifyOrReturn(!BridgeArenaOwns(ptr));
+    sTrackedBytes.fetch_sub(static_cast<uint32_t>(heap_caps_get_allocated_size(ptr)), std::memory_order_relaxed);
+    free(ptr);
+}
+
+void InitBridgeMemory()
+{
+    pugi::set_memory_management_functions(BridgeTrackedAllocate, BridgeTrackedFree);
+}
+
+void BridgeMemoryEnterPhase(BridgePhase phase)
+{
+    PhaseState & state = sPhases[static_cast<size_t>(phase)];
+    std::lock_guard<std::mutex> lock(sPhasesMutex);
+    if (state.active.load(std::memory_order_relaxed) == 0) {
+        state.systemMinAtStart = static_cast<uint32_t>(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+        if (state.heapFreeStart == 0) {
+            state.heapFreeStart = FreeHeap();
+        }
+        state.activeSinceUs = esp_timer_get_time();
+    }
+    state.active.fetch_add(1, std::memory_order_relaxed);
+    SamplePhaseHeap(state);
+}
+
+void BridgeMemoryLeavePhase(BridgePhase phase)
+{
+    PhaseState & state = sPhases[static_cast<size_t>(phase)];
+    std::lock_guard<std::mutex> lock(sPhasesMutex);
+    VerifyOrReturn(state.active.load(std::memory_order_relaxed) > 0);
+    SamplePhaseHeap(state);
+    if (state.active.fetch_sub(1, std::memory_order_relaxed) == 1) {
+        state.durationUs += esp_timer_get_time() - state.activeSinceUs;
+    }
+}
+
+BridgePhaseStats GetBridgePhaseStats(BridgePhase phase)
+{
+    PhaseState & state = sPhases[static_cast<size_t>(phase)];
+    std::lock_guard<std::mutex> lock(sPhasesMutex);
+    int64_t duration = state.durationUs;
+    if (state.active.load(std::memory_order_relaxed) > 0) {
+        SamplePhaseHeap(state);
+        duration += esp_timer_get_time() - state.activeSinceUs;
+    }
+
+    BridgePhaseStats stats;
+    stats.name               = kPhaseNames[static_cast<size_t>(phase)];
+    stats.heapFreeStart      = state.heapFreeStart;
+    stats.heapFreeMin        = state.heapFreeStart != 0 ? state.heapFreeMin.load(std::memory_order_relaxed) : 0;
+    stats.trackedPeak        = state.trackedPeak.load(std::memory_order_relaxed);
+    stats.trackedAllocations = state.trackedAllocations.load(std::memory_order_relaxed);
+    stats.durationMs         = static_cast<uint32_t>(duration / 1000);
+    return stats;
+}
+
+void BridgeMemoryWatchTask(TaskHandle_t task, uint32_t stack_size)
+{
+    std::lock_guard<std::mutex> lock(sTasksMutex);
+    if (sTaskCount == kMaxWatchedTasks) {
+        ChipLogError(DeviceLayer, "Bridge-Memory: Cannot watch more than %u tasks", static_cast<unsigned>(kMaxWatchedTasks));
+        return;
+    }
+
+    WatchedTask & watched = sTasks[sTaskCount++];
+    watched.handle        = task;
+    strncpy(watched.stats.name, pcTaskGetName(task), sizeof(watched.stats.name) - 1);
+    watched.stats.name[sizeof(watched.stats.name) - 1] = '\0';
+    watched.stats.stackSize = stack_size;
+    watched.stats.exited    = false;
+    SampleTask(watched);
+}
+
+void BridgeMemoryTaskExiting()
+{
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    std::lock_guard<std::mutex> lock(sTasksMutex);
+    for (size_t i = 0; i < sTaskCount; i++) {
+        if (sTasks[i].handle == current) {
+            SampleTask(sTasks[i]);
+            sTasks[i].handle       = nullptr;
+            sTasks[i].stats.exited = true;
+        }
+    }
+}
+
+size_t GetBridgeTaskStackStats(BridgeTaskStackStats * stats, size_t max_stats)
+{
+    std::lock_guard<std::mutex> lock(sTasksMutex);
+    size_t count = 0;
+    for (size_t i = 0; i < sTaskCount && count < max_stats; i++) {
+        SampleTask(sTasks[i]);
+        stats[count++] = sTasks[i].stats;
+    }
+    return count;
+}
+
+void LogBridgeMemoryBudget()
+{
+    BridgeTaskStackStats stacks[kMaxWatchedTasks];
+    size_t count = GetBridgeTaskStackStats(stacks, kMaxWatchedTasks);
+    for (size_t i = 0; i < count; i++) {
+        ChipLogProgress(DeviceLayer, "Bridge-Memory: Task %s used %u of %u stack bytes%s", stacks[i].name,
+                        static_cast<unsigned>(stacks[i].stackSize - stacks[i].minFree), static_cast<unsigned>(stacks[i].stackSize),
+                        stacks[i].exited ? " before it exited" : "");
+    }
+
+    for (size_t i = 0; i < kPhaseCount; i++) {
+        BridgePhaseStats phase = GetBridgePhaseStats(static_cast<BridgePhase>(i));
+        if (phase.heapFreeStart == 0) {
+            continue;
+        }
+        ChipLogProgress(DeviceLayer, "Bridge-Memory: Phase %s took %u ms, heap peak %u bytes, tracked peak %u bytes in %u allocations",
+                        phase.name, static_cast<unsigned>(phase.durationMs),
+                        static_cast<unsigned>(phase.heapFreeStart > phase.heapFreeMin ? phase.heapFreeStart - phase.heapFreeMin : 0),
+                        static_cast<unsigned>(phase.trackedPeak), static_cast<unsigned>(phase.trackedAllocations));
+    }
+}
+
+#if CONFIG_BRIDGE_MEMORY_TRACKING || CONFIG_BRIDGE_CONFIG_ARENA
+// nlohmann::json and the converter allocate through std::allocator, so operator new is where their allocations are
+// tracked and routed to the configuration arena
+// The converter fixes the JSON type to nlohmann::ordered_json, a custom allocator type would not be accepted by it
+namespace {
+
+void * AllocateObject(size_t size)
+{
+#if CONFIG_BRIDGE_MEMORY_TRACKING
+    return BridgeTrackedAllocate(size);
+#else
+    void * ptr = BridgeArenaAllocate(size);
+    return ptr != nullptr ? ptr : malloc(size > 0 ? size : 1);
+#endif
+}
+
+void FreeObject(void * ptr)
+{
+#if CONFIG_BRIDGE_MEMORY_TRACKING
+    BridgeTrackedFree(ptr);
+#else
+    if (!BridgeArenaOwns(ptr)) {
+        free(ptr);
+    }
+#endif
+}
+
+} // namespace
+
+void * operator new(size_t size)
+{
+    void * ptr = AllocateObject(size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void * operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return AllocateObject(size);
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return AllocateObject(size);
+}
+
+void operator delete(void * ptr) noexcept
+{
+    FreeObject(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+    FreeObject(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept
+{
+    FreeObject(ptr);
+}
+
+void operator delete[](void * ptr, size_t) noexcept
+{
+    FreeObject(ptr);
+}
+
+void operator delete(void * ptr, const std::nothrow_t &) noexcept
+{
+    FreeObject(ptr);
+}
+
+void operator delete[](void * ptr, const std::nothrow_t &) noexcept
+{
+    FreeObject(ptr);
+}
+#endif // CONFIG_BRIDGE_MEMORY_TRACKING || CONFIG_BRIDGE_CONFIG_ARENA
@@ -0,0 +1,236 @@
+#include "BridgeMetrics.h"
+#include "BridgeLatency.h"
+#include "BridgeMemory.h"
+#include "CoapClient.h"
+#include "LatencyHistogram.h"
+#include "ObjectPool.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+// Number of watched task stacks that are exported
+constexpr size_t kMaxExportedStacks = 8;
+
+constexpr size_t kCounterCount   = static_cast<size_t>(BridgeCounter::kCount);
+constexpr size_t kHistogramCount = static_cast<size_t>(BridgeHistogram::kCount);
+
+constexpr const char * kCounterNames[kCounterCount] = {
+    "coap_client_requests",
+    "coap_client_responses",
+    "coap_client_timeouts",
+    "coap_client_rejected",
+    "coap_client_congested",
+    "coap_client_budget_expired",
+    "coap_client_nack_too_many_retries",
+    "coap_client_nack_not_deliverable",
+    "coap_client_nack_rst",
+    "coap_client_nack_icmp",
+    "coap_client_nack_other",
+    "coap_server_bad_requests",
+    "coap_server_bad_gateway",
+    "coap_server_unavailable",
+    "binding_commands",
+    "binding_no_context",
+    "binding_ring_full",
+    "binding_failed_completions",
+    "shadow_hits",
+    "shadow_misses",
+};
+
+constexpr const char * kHistogramNames[kHistogramCount] = { "coap_client_rtt_us" };
+
+std::atomic<uint32_t> sCounters[kCounterCount] = {};
+LatencyHistogram sHistograms[kHistogramCount];
+
+/**
+ * Writer of the CBOR subset used by the metrics: maps of indefinite length, text strings and unsigned integers
+ * Writing past the end of the buffer is recorded and checked once the encoding is complete
+ */
+class CborWriter
+{
+public:
+    CborWriter(uint8_t * buffer, size_t size) : mBuffer(buffer), mSize(size) {}
+
+    void BeginMap() { Put(0xbf); }
+    void EndMap() { Put(0xff); }
+
+    void Text(const char * text)
+    {
+        size_t length = strlen(text);
+        Head(3, length);
+        if (mLength + length <= mSize) {
+            memcpy(mBuffer + mLength, text, length);
+        }
+        mLength += length;
+    }
+
+    void Uint(uint64_t value) { Head(0, value); }
+
+    void Entry(const char * key, uint64_t value)
+    {
+        Text(key);
+        Uint(value);
+    }
+
+    void BeginMap(const char * key)
+    {
+        Text(key);
+        BeginMap();
+    }
+
+    size_t Finish() const { return mLength <= mSize ? mLength : 0; }
+
+private:
+    void Put(uint8_t byte)
+    {
+        if (mLength < mSize) {
+            mBuffer[mLength] = byte;
+        }
+        mLength++;
+    }
+
+    void Head(uint8_t major, uint64_t value)
+    {
+        major = static_cast<uint8_t>(major << 5);
+        if (value < 24) {
+            Put(static_cast<uint8_t>(major | value));
+            return;
+        }
+        unsigned bytes = value <= UINT8_MAX ? 1 : value <= UINT16_MAX ? 2 : value <= UINT32_MAX ? 4 : 8;
+        // Additional information 24, 25, 26 and 27 announce 1, 2, 4 and 8 bytes
+        Put(static_cast<uint8_t>(major | (24 + __builtin_ctz(bytes))));
+        for (unsigned i = bytes; i > 0; i--) {
+            Put(static_cast<uint8_t>(value >> ((i - 1) * 8)));
+        }
+    }
+
+    uint8_t * mBuffer;
+    size_t mSize;
+    size_t mLength = 0;
+};
+
+/**
+ * Function used to encode the percentiles of a histogram
+ */
+void EncodeHistogram(CborWriter & writer, const char * name, const LatencyHistogram & histogram)
+{
+    writer.BeginMap(name);
+    writer.Entry("count", histogram.Count());
+    writer.Entry("mean", histogram.Mean());
+    writer.Entry("p50", histogram.Percentile(500));
+    writer.Entry("p99", histogram.Percentile(990));
+    writer.Entry("p999", histogram.Percentile(999));
+    writer.Entry("max", histogram.Max());
+    writer.EndMap();
+}
+
+} // namespace
+
+void BridgeMetricIncrement(BridgeCounter counter, uint32_t value)
+{
+    sCounters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+void BridgeMetricRecord(BridgeHistogram histogram, uint32_t value_us)
+{
+    sHistograms[static_cast<size_t>(histogram)].Record(value_us);
+}
+
+uint32_t BridgeMetricGet(BridgeCounter counter)
+{
+    return sCounters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+size_t EncodeBridgeMetrics(uint8_t * buffer, size_t size)
+{
+    CborWriter writer(buffer, size);
+    writer.BeginMap();
+    writer.Entry("uptime_ms", static_cast<uint64_t>(esp_timer_get_time() / 1000));
+
+    writer.BeginMap("counters");
+    for (size_t i = 0; i < kCounterCount; i++) {
+        writer.Entry(kCounterNames[i], sCounters[i].load(std::memory_order_relaxed));
+    }
+    writer.EndMap();
+
+    writer.BeginMap("histograms");
+    for (size_t i = 0; i < kHistogramCount; i++) {
+        EncodeHistogram(writer, kHistogramNames[i], sHistograms[i]);
+    }
+    writer.EndMap();
+
+    writer.BeginMap("paths");
+    for (size_t i = 0; i < static_cast<size_t>(BridgePath::kCount); i++) {
+        BridgePathStats stats = GetBridgePathStats(static_cast<BridgePath>(i));
+        writer.BeginMap(stats.name);
+        writer.Entry("count", stats.count);
+        writer.Entry("failures", stats.failures);
+        writer.Entry("p50_us", stats.p50Us);
+        writer.Entry("p99_us", stats.p99Us);
+        writer.Entry("p999_us", stats.p999Us);
+        writer.Entry("max_us", stats.maxUs);
+        writer.Entry("rps_milli", stats.throughputMilli);
+        writer.Entry("max_in_flight", stats.maxInFlight);
+        writer.EndMap();
+    }
+    writer.EndMap();
+
+    // The pools bound the queues of the bridge, so their fill levels are the queue depths
+    writer.BeginMap("pools");
+    for (const ObjectPoolBase * pool = ObjectPoolBase::First(); pool != nullptr; pool = pool->Next()) {
+        ObjectPoolStats stats = pool->GetStats();
+        writer.BeginMap(stats.name);
+        writer.Entry("capacity", stats.capacity);
+        writer.Entry("in_use", stats.inUse);
+        writer.Entry("high_water", stats.highWater);
+        writer.Entry("allocations", stats.allocations);
+        writer.Entry("failures", stats.failures);
+        writer.EndMap();
+    }
+    writer.EndMap();
+
+    CoapClientCoalescingStats coalescing = GetCoapClientCoalescingStats();
+    writer.BeginMap("coalescing");
+    writer.Entry("requests", coalescing.requests);
+    writer.Entry("in_flight_hits", coalescing.in_flight_hits);
+    writer.Entry("window_hits", coalescing.window_hits);
+    writer.Entry("in_flight_bypasses", coalescing.in_flight_bypasses);
+    writer.EndMap();
+
+    writer.BeginMap("heap");
+    writer.Entry("free", heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    writer.Entry("min_free", heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    writer.Entry("largest_block", heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    writer.Entry("fragmentation", GetHeapFragmentation());
+    writer.EndMap();
+
+    writer.BeginMap("phases");
+    for (size_t i = 0; i < static_cast<size_t>(BridgePhase::kCount); i++) {
+        BridgePhaseStats stats = GetBridgePhaseStats(static_cast<BridgePhase>(i));
+        writer.BeginMap(stats.name);
+        writer.Entry("heap_free_start", stats.heapFreeStart);
+        writer.Entry("heap_free_min", stats.heapFreeMin);
+        writer.Entry("tracked_peak", stats.trackedPeak);
+        writer.Entry("tracked_allocations", stats.trackedAllocations);
+        writer.Entry("duration_ms", stats.durationMs);
+        writer.EndMap();
+    }
+    writer.EndMap();
+
+    BridgeTaskStackStats stacks[kMaxExportedStacks];
+    size_t stack_count = GetBridgeTaskStackStats(stacks, kMaxExportedStacks);
+    writer.BeginMap("stacks");
+    for (size_t i = 0; i < stack_count; i++) {
+        writer.BeginMap(stacks[i].name);
+        writer.Entry("size", stacks[i].stackSize);
+        writer.Entry("min_free", stacks[i].minFree);
+        writer.EndMap();
+    }
+    writer.EndMap();
+
+    writer.EndMap();
+    return writer.Finish();
+}
@@ -0,0 +1,205 @@
+#include "BridgeTrace.h"
+
+#if CONFIG_BRIDGE_TRACE
+
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <lib/support/CodeUtils.h>
+#include <atomic>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kSpanCount = CONFIG_BRIDGE_TRACE_BUFFER_SIZE;
+// Upper bound of the JSON of a single trace event, span names are short string literals
+constexpr size_t kMaxEventLength = 192;
+// Number of tasks that get a name in the exported trace
+constexpr size_t kMaxTraceTasks = 16;
+// The name of a task is copied, the task may have been deleted when the trace is exported
+constexpr size_t kTaskNameSize = configMAX_TASK_NAME_LEN;
+
+// Span of a trace, the sequence is zero while the span is written
+struct Span
+{
+    std::atomic<uint32_t> sequence{ 0 };
+    uint32_t traceId;
+    const char * name;
+    char task[kTaskNameSize];
+    uint32_t tid;
+    int64_t startUs;
+    uint32_t durationUs;
+};
+
+Span sSpans[kSpanCount];
+std::atomic<uint32_t> sHead{ 0 };
+thread_local uint32_t sCurrentTraceId = kNoTraceId;
+
+/**
+ * Function used to copy a span out of the ring
+ * Returns false if the slot is empty or has been overwritten while it was copied
+ */
+bool ReadSpan(uint32_t index, Span & span)
+{
+    const Span & slot = sSpans[index % kSpanCount];
+    uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+    VerifyOrReturnValue(sequence == index + 1, false);
+    span.traceId    = slot.traceId;
+    span.name       = slot.name;
+    memcpy(span.task, slot.task, sizeof(span.task));
+    span.task[sizeof(span.task) - 1] = '\0';
+    span.tid        = slot.tid;
+    span.startUs    = slot.startUs;
+    span.durationUs = slot.durationUs;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+/**
+ * Function used to append formatted text to the export buffer
+ * Returns false if the text did not fit
+ */
+bool Append(char * buffer, size_t size, size_t & length, const char * format, ...) __attribute__((format(printf, 4, 5)));
+bool Append(char * buffer, size_t size, size_t & length, const char * format, ...)
+{
+    VerifyOrReturnValue(length < size, false);
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + length, size - length, format, args);
+    va_end(args);
+    VerifyOrReturnValue(written >= 0 && static_cast<size_t>(written) < size - length, false);
+    length += static_cast<size_t>(written);
+    return true;
+}
+
+} // namespace
+
+uint32_t BridgeTraceNewId()
+{
+    uint32_t trace_id;
+    do {
+        trace_id = esp_random();
+    } while (trace_id == kNoTraceId);
+    return trace_id;
+}
+
+uint32_t BridgeTraceIdFromToken(const uint8_t * token, size_t length)
+{
+    VerifyOrReturnValue(length > 0, BridgeTraceNewId());
+    uint32_t trace_id = 0;
+    if (length == sizeof(uint32_t)) {
+        // Tokens of the bridge carry the trace ID as it is, so both sides of a forwarded request share it
+        trace_id = static_cast<uint32_t>(token[0]) << 24 | static_cast<uint32_t>(token[1]) << 16 |
+            static_cast<uint32_t>(token[2]) << 8 | token[3];
+    } else {
+        // FNV-1a
+        trace_id = 2166136261u;
+        for (size_t i = 0; i < length; i++) {
+            trace_id = (trace_id ^ token[i]) * 16777619u;
+        }
+    }
+    return trace_id != kNoTraceId ? trace_id : 1;
+}
+
+uint32_t BridgeTraceCurrent()
+{
+    return sCurrentTraceId;
+}
+
+uint32_t BridgeTraceSetCurrent(uint32_t trace_id)
+{
+    uint32_t previous = sCurrentTraceId;
+    sCurrentTraceId   = trace_id;
+    return previous;
+}
+
+int64_t BridgeTraceNow()
+{
+    return esp_timer_get_time();
+}
+
+void BridgeTraceSpan(uint32_t trace_id, const char * name, int64_t start_us)
+{
+    VerifyOrReturn(trace_id != kNoTraceId);
+    int64_t duration = esp_timer_get_time() - start_us;
+    uint32_t index   = sHead.fetch_add(1, std::memory_order_relaxed);
+    Span & slot      = sSpans[index % kSpanCount];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.traceId    = trace_id;
+    slot.name       = name;
+    strncpy(slot.task, pcTaskGetName(nullptr), sizeof(slot.task) - 1);
+    slot.task[sizeof(slot.task) - 1] = '\0';
+    slot.tid        = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(xTaskGetCurrentTaskHandle()));
+    slot.startUs    = start_us;
+    slot.durationUs = duration > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(duration);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+size_t GetBridgeTraceExportSize()
+{
+    uint32_t head = sHead.load(std::memory_order_relaxed);
+    size_t spans  = head < kSpanCount ? head : kSpanCount;
+    return (spans + kMaxTraceTasks + 2) * kMaxEventLength;
+}
+
+size_t ExportBridgeTrace(char * buffer, size_t size)
+{
+    uint32_t head  = sHead.load(std::memory_order_acquire);
+    uint32_t first = head > kSpanCount ? head - kSpanCount : 0;
+    uint32_t tids[kMaxTraceTasks];
+    char tasks[kMaxTraceTasks][kTaskNameSize];
+    size_t task_count = 0;
+    size_t length     = 0;
+    const char * separator = "";
+
+    VerifyOrReturnValue(Append(buffer, size, length, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0);
+    for (uint32_t index = first; index < head; index++) {
+        Span span;
+        if (!ReadSpan(index, span)) {
+            continue;
+        }
+        VerifyOrReturnValue(Append(buffer, size, length,
+                                   "%s{\"name\":\"%s\",\"cat\":\"bridge\",\"ph\":\"X\",\"ts\":%" PRId64 ",\"dur\":%" PRIu32
+                                   ",\"pid\":1,\"tid\":%" PRIu32 ",\"args\":{\"trace_id\":\"%08" PRIx32 "\"}}",
+                                   separator, span.name, span.startUs, span.durationUs, span.tid, span.traceId),
+                            0);
+        separator = ",";
+
+        size_t task = 0;
+        while (task < task_count && tids[task] != span.tid) {
+            task++;
+        }
+        if (task == task_count && task_count < kMaxTraceTasks) {
+            tids[task_count]  = span.tid;
+            memcpy(tasks[task_count], span.task, sizeof(span.task));
+            task_count++;
+        }
+    }
+
+    // Perfetto shows the name of the task instead of its handle
+    for (size_t task = 0; task < task_count; task++) {
+        VerifyOrReturnValue(Append(buffer, size, length,
+                                   "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu32
+                                   ",\"args\":{\"name\":\"%s\"}}",
+                                   separator, tids[task], tasks[task]),
+                            0);
+        separator = ",";
+    }
+    VerifyOrReturnValue(Append(buffer, size, length, "]}"), 0);
+    return length;
+}
+
+void ClearBridgeTrace()
+{
+    for (auto & slot : sSpans) {
+        slot.sequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+#endif // CONFIG_BRIDGE_TRACE
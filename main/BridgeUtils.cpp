@@ -63,3 +63,77 @@ std::string Ip6ToStr(esp_ip6_addr_t &ip6addr)
            decToHexa(block7) + ":" +  
            decToHexa(block8);
 }
+
+/**
+ * Function used to map the status of a Matter interaction onto a CoAP response code
+ * Failures of the bound device are reported as gateway errors
+ */
+coap_pdu_code_t ImStatusToCoapCode(chip::Protocols::InteractionModel::Status status)
+{
+    using chip::Protocols::InteractionModel::Status;
+
+    switch (status) {
+    case Status::Success:
+        return COAP_RESPONSE_CODE_CHANGED;
+    case Status::InvalidCommand:
+    case Status::InvalidAction:
+    case Status::ConstraintError:
+        return COAP_RESPONSE_CODE_BAD_REQUEST;
+    case Status::UnsupportedAccess:
+    case Status::NeedsTimedInteraction:
+        return COAP_RESPONSE_CODE_FORBIDDEN;
+    case Status::UnsupportedEndpoint:
+    case Status::UnsupportedCluster:
+    case Status::NotFound:
+        return COAP_RESPONSE_CODE_NOT_FOUND;
+    case Status::UnsupportedCommand:
+        return COAP_RESPONSE_CODE_NOT_ALLOWED;
+    case Status::InvalidDataType:
+        return COAP_RESPONSE_CODE_UNSUPPORTED_CONTENT_FORMAT;
+    case Status::ResourceExhausted:
+        return COAP_RESPONSE_CODE_REQUEST_TOO_LARGE;
+    case Status::Busy:
+        return COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE;
+    case Status::Timeout:
+        return COAP_RESPONSE_CODE_GATEWAY_TIMEOUT;
+    default:
+        return COAP_RESPONSE_CODE_BAD_GATEWAY;
+    }
+}
+
+/**
+ * Function used to map a CoAP response code onto the status of a Matter interaction
+ */
+chip::Protocols::InteractionModel::Status CoapCodeToImStatus(coap_pdu_code_t code)
+{
+    using chip::Protocols::InteractionModel::Status;
+
+    switch (code) {
+    case COAP_RESPONSE_CODE_CREATED:
+    case COAP_RESPONSE_CODE_DELETED:
+    case COAP_RESPONSE_CODE_VALID:
+    case COAP_RESPONSE_CODE_CHANGED:
+    case COAP_RESPONSE_CODE_CONTENT:
+        return Status::Success;
+    case COAP_RESPONSE_CODE_BAD_REQUEST:
+    case COAP_RESPONSE_CODE_BAD_OPTION:
+        return Status::InvalidCommand;
+    case COAP_RESPONSE_CODE_UNAUTHORIZED:
+    case COAP_RESPONSE_CODE_FORBIDDEN:
+        return Status::UnsupportedAccess;
+    case COAP_RESPONSE_CODE_NOT_FOUND:
+        return Status::NotFound;
+    case COAP_RESPONSE_CODE_NOT_ALLOWED:
+        return Status::UnsupportedCommand;
+    case COAP_RESPONSE_CODE_UNSUPPORTED_CONTENT_FORMAT:
+        return Status::InvalidDataType;
+    case COAP_RESPONSE_CODE_REQUEST_TOO_LARGE:
+        return Status::ResourceExhausted;
+    case COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE:
+        return Status::Busy;
+    case COAP_RESPONSE_CODE_GATEWAY_TIMEOUT:
+        return Status::Timeout;
+    default:
+        return Status::Failure;
+    }
+}
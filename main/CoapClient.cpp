@@ -1,13 +1,30 @@
 #include "CoapClient.h"
-#include <iostream>
+#include "BridgeArena.h"
+#include "BridgeLog.h"
+#include "BridgeMemory.h"
+#include "BridgeMetrics.h"
+#include "BridgeTrace.h"
+#include "ConfigMirrors.h"
+#include "CongestionControl.h"
+#include "DeviceHealth.h"
 
 #include "pugixml.hpp"
 #include "esp_heap_caps.h"
 #include "esp_attr.h"
+#include "esp_timer.h"
+#include <algorithm>
+#include <condition_variable>
 #include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
 
-static coap_context_t *ctx = NULL;
-static coap_optlist_t *optlist = NULL;
+// Message type used for requests to bridged devices
+#if CONFIG_BRIDGE_COAP_CONFIRMABLE
+#define BRIDGE_REQUEST_TYPE COAP_MESSAGE_CON
+#else
+#define BRIDGE_REQUEST_TYPE COAP_MESSAGE_NON
+#endif
 
 /**
  * Handler invoked if a confirmable message is dropped after all retries have been exhausted
@@ -33,526 +50,628 @@ static void nack_handler(coap_session_t *session COAP_UNUSED, const coap_pdu_t *
 }
 
 /**
- * Function used to load the Cluster xml from the CoAP server
+ * Handler used by requests to bridged devices to store the response in the CoapClientResponse of the session
  */
-int LoadClusterXmlFile(const char* client_uri)
+static coap_response_t tracked_response_handler(coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received, const coap_mid_t id)
 {
-    coap_session_t *session = NULL;
-    coap_pdu_t *pdu = nullptr;
-    coap_address_t dst;
-
-    int result = EXIT_FAILURE;;
-    int len;
-    int res;
-    unsigned int wait_ms;
-    coap_uri_t uri;
-    const char *coap_uri = client_uri;
-    unsigned char scratch[BUFSIZE];
-
-    /* Initialize libcoap library */
-    coap_startup();
+    const uint8_t *data;
+    size_t len;
+
+    (void)sent;
+    (void)id;
+    CoapClientResponse *response = (CoapClientResponse *)coap_session_get_app_data(session);
+    response->received = true;
+    response->code = coap_pdu_get_code(received);
+    if (response->payload && coap_get_data(received, &len, &data)) {
+        response->length = std::min(len, response->payload_size);
+        memcpy(response->payload, data, response->length);
+    }
+    return COAP_RESPONSE_OK;
+}
 
-    /* Parse the URI */
-    len = coap_split_uri((const unsigned char *)coap_uri, strlen(coap_uri), &uri);
-    if (len != 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to parse uri %s", coap_uri);
-        goto finish;
+/**
+ * Handler used by requests to bridged devices to end the wait as soon as the message is known to be lost
+ */
+static void tracked_nack_handler(coap_session_t *session, const coap_pdu_t *sent, const coap_nack_reason_t reason, const coap_mid_t id)
+{
+    nack_handler(session, sent, reason, id);
+    CoapClientResponse *response = (CoapClientResponse *)coap_session_get_app_data(session);
+    switch (reason) {
+        case COAP_NACK_TOO_MANY_RETRIES:
+            BridgeMetricIncrement(BridgeCounter::kCoapClientNackTooManyRetries);
+            response->failed = true;
+            break;
+        case COAP_NACK_NOT_DELIVERABLE:
+            BridgeMetricIncrement(BridgeCounter::kCoapClientNackNotDeliverable);
+            response->failed = true;
+            break;
+        case COAP_NACK_RST:
+            BridgeMetricIncrement(BridgeCounter::kCoapClientNackRst);
+            response->failed = true;
+            break;
+        case COAP_NACK_ICMP_ISSUE:
+            BridgeMetricIncrement(BridgeCounter::kCoapClientNackIcmp);
+            response->failed = true;
+            break;
+        default:
+            BridgeMetricIncrement(BridgeCounter::kCoapClientNackOther);
+            break;
     }
+}
 
-    /* resolve destination address where server should be sent */
-    len = resolve_address(&uri.host, uri.port, &dst, 1 << uri.scheme);
-    if (len <= 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to resolve address %*.*s", (int)uri.host.length, (int)uri.host.length, (const char *)uri.host.s);
-        goto finish;
-    }
+/**
+ * Handler used by pings to bridged devices, the answer to a ping is an empty message
+ */
+static void tracked_pong_handler(coap_session_t *session, const coap_pdu_t *received, const coap_mid_t id)
+{
+    (void)received;
+    (void)id;
+    CoapClientResponse *response = (CoapClientResponse *)coap_session_get_app_data(session);
+    response->received = true;
+}
 
-    /* create CoAP context and a client session */
-    if (!(ctx = coap_new_context(nullptr))) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create libcoap context");
-        goto finish;
+/**
+ * Function used to carry the trace of the calling task in the token of a request to a bridged device
+ * The token has to be added before any option
+ */
+static void AddTraceToken(coap_pdu_t *pdu)
+{
+    uint32_t trace_id = BridgeTraceCurrent();
+    if (trace_id == kNoTraceId) {
+        return;
     }
+    uint8_t token[sizeof(trace_id)] = { static_cast<uint8_t>(trace_id >> 24), static_cast<uint8_t>(trace_id >> 16),
+                                        static_cast<uint8_t>(trace_id >> 8), static_cast<uint8_t>(trace_id) };
+    coap_add_token(pdu, sizeof(token), token);
+}
 
-    /* Support large responses */
-    coap_context_set_block_mode(ctx, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY);
+// Time the requests of the calling task wait at most for their response, zero if they wait for the whole exchange
+static thread_local unsigned int wait_budget_ms = 0;
 
-    session = coap_new_client_session(ctx, NULL, &dst, COAP_PROTO_UDP);
-    if (!session) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create client session");
-        goto finish;
-    }
+CoapClientWaitBudgetScope::CoapClientWaitBudgetScope(unsigned int budget_ms) : mPreviousBudgetMs(wait_budget_ms)
+{
+    wait_budget_ms = budget_ms;
+}
 
-    coap_register_response_handler(ctx,
-                                [](coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received, const coap_mid_t id) {
-                                    const uint8_t *data;
-                                    size_t len;
-                                    size_t offset;
-                                    size_t total;
-
-                                    (void)session;
-                                    (void)sent;
-                                    (void)id;
-                                    have_response = 1;
-                                    if (coap_get_data_large(received, &len, &data, &offset, &total)) {
-                                        pugi::xml_parse_result result = cluster_xml.load_buffer(data, len);
-                                        std::cout << "DATA SIZE: " << len << std::endl;
-                                        ChipLogProgress(DeviceLayer, "CoAP Client: Result of the parsing: %s", result.description());
-                                        ChipLogProgress(DeviceLayer, "%*.*s", (int)len, (int)len, (const char *)data);
-                                    }
-                                    return COAP_RESPONSE_OK;
-                                });
-    coap_register_nack_handler(ctx, nack_handler);
+CoapClientWaitBudgetScope::~CoapClientWaitBudgetScope()
+{
+    wait_budget_ms = mPreviousBudgetMs;
+}
 
-    /* construct CoAP message */
-    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_GET, coap_new_message_id(session), coap_session_max_pdu_size(session));
-    if (!pdu) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create PDU");
-        goto finish;
-    }
+/**
+ * Function used to wait for the response of a request to a bridged device
+ * The wait is cut short by the budget of the calling task. The result is reported to the health tracking of the
+ * destination, a request that gave up before a healthy device would have answered does not count against it.
+ */
+static void WaitForTrackedResponse(coap_context_t *context, const coap_address_t *dst, unsigned int wait_ms, uint32_t rto_ms, CoapClientResponse &response)
+{
+    int64_t start = esp_timer_get_time();
+    int res;
+    bool budgeted = wait_budget_ms > 0 && wait_budget_ms < wait_ms;
+    // The waited time is counted down in wait_ms
+    unsigned int budget_ms = budgeted ? wait_budget_ms : 0;
+    // Time in which a healthy device answers, the retransmission timeout or the timeout of a non-confirmable request
+    unsigned int answer_ms = std::min<unsigned int>(rto_ms, wait_ms);
 
-    /* Add option list (which will be sorted) to the PDU */
-    len = coap_uri_into_options(&uri, &dst, &optlist, 1, scratch, sizeof(scratch));
-    if (len) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to create options");
-        goto finish;
+    if (budgeted) {
+        wait_ms = budget_ms;
     }
 
-    if (optlist) {
-        res = coap_add_optlist_pdu(pdu, &optlist);
-        if (res != 1) {
-            ChipLogError(DeviceLayer, "CoAP Client: Failed to add options to PDU");
-            goto finish;
+    BridgeMetricIncrement(BridgeCounter::kCoapClientRequests);
+    while (!response.received && !response.failed) {
+        res = coap_io_process(context, std::min(wait_ms, 1000u));
+        if (res < 0) {
+            break;
         }
-    }
-
-    coap_show_pdu(COAP_LOG_WARN, pdu);
-
-    /* and send the PDU */
-    if (coap_send(session, pdu) == COAP_INVALID_MID) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP pdu");
-        goto finish;
-    }
-
-    wait_ms = (coap_session_get_default_leisure(session).integer_part + 1) * 1000;
-
-    while (have_response == 0) {
-        res = coap_io_process(ctx, 1000);
-        if (res >= 0) {
-            if (wait_ms > 0) {
-                if ((unsigned)res >= wait_ms) {
-                    ChipLogError(DeviceLayer, "CoAP Client: Timeout");
-                    break;
-                } else {
-                    wait_ms -= res;
-                }
-            }
+        if ((unsigned)res >= wait_ms) {
+            ChipLogError(DeviceLayer, "CoAP Client: Timeout");
+            break;
+        }
+        wait_ms -= res;
+    }
+
+    if (response.received) {
+        int64_t rtt_us = esp_timer_get_time() - start;
+        uint32_t rtt_ms = static_cast<uint32_t>(rtt_us / 1000);
+        CongestionReportRtt(dst, rtt_ms, rto_ms);
+        Lwm2mDeviceReportSuccess(dst, rtt_ms);
+        BridgeMetricIncrement(BridgeCounter::kCoapClientResponses);
+        BridgeMetricRecord(BridgeHistogram::kCoapClientRtt, rtt_us > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(rtt_us));
+    } else if (budgeted && !response.failed && budget_ms < answer_ms) {
+        // The device had no chance to answer, the caller just could not wait any longer
+        Lwm2mDeviceCancelRequest(dst);
+        BridgeMetricIncrement(BridgeCounter::kCoapClientBudgetExpired);
+    } else {
+        Lwm2mDeviceReportFailure(dst);
+        if (!response.failed) {
+            BridgeMetricIncrement(budgeted ? BridgeCounter::kCoapClientBudgetExpired : BridgeCounter::kCoapClientTimeouts);
         }
     }
-
-finish:
-    have_response = 0;
-    coap_delete_optlist(optlist);
-    optlist = NULL;
-    coap_session_release(session);
-    session = NULL;
-    coap_free_context(ctx);
-    ctx = NULL;
-    coap_cleanup();
-
-    return result;
 }
 
 /**
- * Function used to load the sdf-model from the CoAP server
+ * Function used to send a request to a bridged device and wait for its response
+ * Confirmable requests use the retransmission timeout of the destination and are retransmitted as often as the wait
+ * budget of the caller allows, at most CONFIG_BRIDGE_COAP_NSTART requests are outstanding per destination.
+ * The PDU is consumed in any case.
+ * The outcome is reported to the health tracking of the destination, a request that is not admitted because of too
+ * many outstanding requests is a local failure and does not count against the device.
+ * Returns false if the request could not be sent
  */
-int LoadSdfModelFile(const char* client_uri)
+static bool SendTrackedPdu(coap_context_t *context, coap_session_t *session, coap_pdu_t *pdu, const coap_address_t *dst, CoapClientResponse &response)
 {
-    coap_session_t *session = NULL;
-    coap_pdu_t *pdu = nullptr;
-    coap_address_t dst;
-
-    int result = EXIT_FAILURE;;
-    int len;
-    int res;
-    unsigned int wait_ms;
-    coap_uri_t uri;
-    const char *coap_uri = client_uri;
-    unsigned char scratch[BUFSIZE];
-
-    /* Initialize libcoap library */
-    coap_startup();
+    bool confirmable = coap_pdu_get_type(pdu) == COAP_MESSAGE_CON;
+    unsigned int leisure_ms = (coap_session_get_default_leisure(session).integer_part + 1) * 1000;
+    uint32_t rto_ms = confirmable ? CongestionApplyToSession(session, dst) : leisure_ms;
+    unsigned int wait_ms = confirmable ? CongestionGetExchangeLifetime(rto_ms) : Lwm2mDeviceRequestTimeout(dst, leisure_ms);
 
-    /* Parse the URI */
-    len = coap_split_uri((const unsigned char *)coap_uri, strlen(coap_uri), &uri);
-    if (len != 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to parse uri %s\n", coap_uri);
-        goto finish;
+    if (confirmable && wait_budget_ms > 0 && wait_budget_ms < wait_ms) {
+        // Only the retransmissions that end within the budget of the caller are sent, so a lost request is reported
+        // by a NACK before the caller stops waiting. If not even the first transmission fits, the budget ends the wait.
+        uint8_t max_retransmit = CongestionGetMaxRetransmitWithin(rto_ms, wait_budget_ms);
+        coap_session_set_max_retransmit(session, max_retransmit);
+        wait_ms = CongestionGetExchangeLifetime(rto_ms, max_retransmit);
     }
 
-    /* resolve destination address where server should be sent */
-    len = resolve_address(&uri.host, uri.port, &dst, 1 << uri.scheme);
-    if (len <= 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to resolve address %*.*s\n", (int)uri.host.length, (int)uri.host.length, (const char *)uri.host.s);
-        goto finish;
-    }
-
-    /* create CoAP context and a client session */
-    if (!(ctx = coap_new_context(nullptr))) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create libcoap context\n");
-        goto finish;
+    if (!CongestionAcquire(dst)) {
+        ChipLogError(DeviceLayer, "CoAP Client: Too many outstanding requests");
+        BridgeMetricIncrement(BridgeCounter::kCoapClientCongested);
+        Lwm2mDeviceCancelRequest(dst);
+        coap_delete_pdu(pdu);
+        return false;
     }
 
-    /* Support large responses */
-    coap_context_set_block_mode(ctx, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY);
-
-    session = coap_new_client_session(ctx, NULL, &dst, COAP_PROTO_UDP);
-    if (!session) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create client session\n");
-        goto finish;
+    int64_t start_us = BridgeTraceNow();
+    if (coap_send(session, pdu) == COAP_INVALID_MID) {
+        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP pdu");
+        Lwm2mDeviceReportFailure(dst);
+        CongestionRelease(dst);
+        return false;
     }
 
-    /* coap_register_response_handler(ctx, response_handler); */
-    coap_register_response_handler(ctx,
-                            [](coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received, const coap_mid_t id) {
-                                const uint8_t *data;
-                                size_t len;
-                                size_t offset;
-                                size_t total;
-
-                                (void)session;
-                                (void)sent;
-                                (void)id;
-                                have_response = 1;
-                                if (coap_get_data_large(received, &len, &data, &offset, &total)) {
-                                    sdf_model_file = nlohmann::json::parse((const char *)data, (const char *)data + (int)len);
-                                    ChipLogProgress(DeviceLayer, "%*.*s", (int)len, (int)len, (const char *)data);
-                                }
-                                return COAP_RESPONSE_OK;
-                            });
-    coap_register_nack_handler(ctx, nack_handler);
+    WaitForTrackedResponse(context, dst, wait_ms, rto_ms, response);
+    BridgeTraceSpan(BridgeTraceCurrent(), "coap.request", start_us);
+    CongestionRelease(dst);
+    return true;
+}
 
-    /* construct CoAP message */
-    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_GET, coap_new_message_id(session), coap_session_max_pdu_size(session));
+// Maximum length of the URI of a configuration document on a mirror
+static constexpr size_t kMaxConfigUriLength = 128;
+// Block size that is requested for configuration documents, see RFC 7959
+static constexpr unsigned int kConfigBlockSzx = CONFIG_BRIDGE_CONFIG_BLOCK_SZX;
+static constexpr size_t kConfigBlockSize = 16u << kConfigBlockSzx;
+// Number of completed transfers whose timing is kept
+static constexpr size_t kConfigTransferHistory = 8;
+// Largest configuration document that is assembled from blocks, a larger one is treated as a broken transfer
+static constexpr size_t kConfigMaxDocumentSize = 512 * 1024;
+
+// Block-wise transfer mode of configuration documents, Q-Block2 sends several blocks per round trip (RFC 9177)
+// The option that carries the block size with the first request matches the mode, a request must not carry both
+// Every block is handed to the response handler, which assembles the document, so each block counts as progress
+#if CONFIG_BRIDGE_CONFIG_Q_BLOCK
+#define CONFIG_BLOCK_MODE (COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_TRY_Q_BLOCK)
+#define CONFIG_BLOCK_OPTION COAP_OPTION_Q_BLOCK2
+#else
+#define CONFIG_BLOCK_MODE (COAP_BLOCK_USE_LIBCOAP)
+#define CONFIG_BLOCK_OPTION COAP_OPTION_BLOCK2
+#endif
+
+static ConfigTransferStats config_transfers[kConfigTransferHistory];
+static size_t config_transfer_count = 0;
+static std::mutex config_transfers_mutex;
+
+struct ConfigFetch;
+
+// Request for a configuration document to a single mirror, its timeouts and hedging are decided by ConfigFetchPlan
+struct ConfigAttempt
+{
+    size_t index = 0;
+    size_t mirror = 0;
+    coap_session_t *session = nullptr;
+    int64_t start_ms = 0;
+    // The attempt times out once no block arrives for timeout_ms
+    unsigned int timeout_ms = 0;
+    ConfigFetch *fetch = nullptr;
+    // Blocks of a document that spans several responses, the length is known once the last block arrived
+    std::vector<uint8_t> body;
+    std::vector<bool> received_blocks;
+    size_t received = 0;
+    size_t length = 0;
+    bool last_block = false;
+};
+
+// Configuration document that is requested from one or more mirrors, the first response is parsed
+struct ConfigFetch
+{
+    ConfigDocumentParser parser;
+    ConfigFetchPlan *plan = nullptr;
+    ConfigAttempt *winner = nullptr;
+    uint32_t duration_ms = 0;
+    size_t length = 0;
+    size_t block_size = 0;
+};
 
-    if (!pdu) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create PDU\n");
-        goto finish;
+/**
+ * Function used to add a block of a configuration document to its attempt
+ * Blocks may arrive out of order with Q-Block2, repeated blocks are ignored
+ * Returns false if the block does not fit the document
+ */
+static bool AddConfigBlock(ConfigAttempt &attempt, const coap_block_b_t &block, const uint8_t *data, size_t len, size_t offset)
+{
+    size_t end = offset + len;
+    if (end > kConfigMaxDocumentSize || (attempt.last_block && end > attempt.length)) {
+        return false;
     }
-
-    /* Add option list (which will be sorted) to the PDU */
-    len = coap_uri_into_options(&uri, &dst, &optlist, 1, scratch, sizeof(scratch));
-    if (len) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to create options\n");
-        goto finish;
+    if (block.num >= attempt.received_blocks.size()) {
+        attempt.received_blocks.resize(block.num + 1, false);
     }
-
-    if (optlist) {
-        res = coap_add_optlist_pdu(pdu, &optlist);
-        if (res != 1) {
-            ChipLogError(DeviceLayer, "CoAP Client: Failed to add options to PDU\n");
-            goto finish;
-        }
+    if (attempt.received_blocks[block.num]) {
+        return true;
     }
-
-    coap_show_pdu(COAP_LOG_WARN, pdu);
-
-    /* and send the PDU */
-    if (coap_send(session, pdu) == COAP_INVALID_MID) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP PDU\n");
-        goto finish;
+    attempt.received_blocks[block.num] = true;
+    if (attempt.body.size() < end) {
+        attempt.body.resize(end);
     }
-
-    wait_ms = (coap_session_get_default_leisure(session).integer_part + 1) * 1000;
-
-    while (have_response == 0) {
-        res = coap_io_process(ctx, 1000);
-        if (res >= 0) {
-            if (wait_ms > 0) {
-                if ((unsigned)res >= wait_ms) {
-                    ChipLogError(DeviceLayer, "CoAP Client: Timeout");
-                    break;
-                } else {
-                    wait_ms -= res;
-                }
-            }
-        }
+    memcpy(attempt.body.data() + offset, data, len);
+    attempt.received += len;
+    if (!block.m) {
+        attempt.last_block = true;
+        attempt.length = end;
     }
+    return true;
+}
 
-finish:
-    have_response = 0;
-    coap_delete_optlist(optlist);
-    optlist = NULL;
-    coap_session_release(session);
-    session = NULL;
-    coap_free_context(ctx);
-    ctx = NULL;
-    coap_cleanup();
+/**
+ * Handler used by requests for configuration documents, only the first successful response is parsed
+ * Documents larger than a block arrive in several responses, each of them keeps the attempt from timing out
+ */
+static coap_response_t config_response_handler(coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received, const coap_mid_t id)
+{
+    const uint8_t *data;
+    size_t len;
+    size_t offset;
+    size_t total;
+    coap_block_b_t block;
+
+    (void)sent;
+    (void)id;
+    ConfigAttempt *attempt = (ConfigAttempt *)coap_session_get_app_data(session);
+    if (attempt == nullptr || attempt->fetch->plan->Finished(attempt->index)) {
+        return COAP_RESPONSE_OK;
+    }
+    ConfigFetchPlan *plan = attempt->fetch->plan;
+
+    coap_pdu_code_t code = coap_pdu_get_code(received);
+    if (COAP_RESPONSE_CLASS(code) != 2 || !coap_get_data_large(received, &len, &data, &offset, &total)) {
+        ChipLogError(DeviceLayer, "CoAP Client: %s answered with %d.%02d", ConfigMirrorGetUri(attempt->mirror), code >> 5, code & 0x1F);
+        plan->Failed(attempt->index);
+        return COAP_RESPONSE_OK;
+    }
+    int64_t now_ms = esp_timer_get_time() / 1000;
+
+    // The server may have answered with smaller blocks than requested
+    bool block_wise = coap_get_block_b(session, received, COAP_OPTION_BLOCK2, &block) ||
+                      coap_get_block_b(session, received, COAP_OPTION_Q_BLOCK2, &block);
+    if (block_wise && (block.m || offset > 0)) {
+        if (!AddConfigBlock(*attempt, block, data, len, offset)) {
+            ChipLogError(DeviceLayer, "CoAP Client: %s sent a block beyond the end of the document", ConfigMirrorGetUri(attempt->mirror));
+            plan->Failed(attempt->index);
+            return COAP_RESPONSE_OK;
+        }
+        if (!attempt->last_block || attempt->received < attempt->length) {
+            plan->Progress(attempt->index, now_ms);
+            return COAP_RESPONSE_OK;
+        }
+        data = attempt->body.data();
+        len = attempt->length;
+        total = attempt->length;
+    }
+
+    uint32_t blocks = block_wise ? static_cast<uint32_t>(std::max<size_t>(attempt->received_blocks.size(), 1)) : 1;
+    ConfigFetch *fetch = attempt->fetch;
+    if (plan->Completed(attempt->index, now_ms, blocks)) {
+        fetch->winner = attempt;
+        fetch->duration_ms = static_cast<uint32_t>(now_ms - attempt->start_ms);
+        fetch->length = total;
+        fetch->block_size = block_wise ? 16u << std::min<unsigned int>(block.szx, 6) : kConfigBlockSize;
+        BridgePhaseScope phase(BridgePhase::kParse);
+        BridgeArenaResumeScope arena;
+        fetch->parser(data, len);
+    }
+    return COAP_RESPONSE_OK;
+}
 
-    return result;
+/**
+ * Handler used by requests for configuration documents to fail over as soon as a request is known to be lost
+ */
+static void config_nack_handler(coap_session_t *session, const coap_pdu_t *sent, const coap_nack_reason_t reason, const coap_mid_t id)
+{
+    nack_handler(session, sent, reason, id);
+    ConfigAttempt *attempt = (ConfigAttempt *)coap_session_get_app_data(session);
+    if (attempt == nullptr) {
+        return;
+    }
+    switch (reason) {
+        case COAP_NACK_TOO_MANY_RETRIES:
+        case COAP_NACK_NOT_DELIVERABLE:
+        case COAP_NACK_RST:
+        case COAP_NACK_ICMP_ISSUE:
+            attempt->fetch->plan->Failed(attempt->index);
+            break;
+        default:
+            break;
+    }
 }
 
 /**
- * Function used to load the LwM2M to Matter merged mapping from the CoAP server
+ * Function used to send the request for a configuration document to the mirror of an attempt
+ * Returns false if the request could not be sent
  */
-int LoadSdfMappingLwm2mFile(const char* client_uri)
+static bool StartConfigRequest(coap_context_t *context, ConfigAttempt &attempt, const char *path)
 {
-    coap_session_t *session = NULL;
+    coap_optlist_t *options = NULL;
     coap_pdu_t *pdu = nullptr;
     coap_address_t dst;
-
-    int result = EXIT_FAILURE;;
-    int len;
-    int res;
-    unsigned int wait_ms;
     coap_uri_t uri;
-    const char *coap_uri = client_uri;
+    char coap_uri[kMaxConfigUriLength];
     unsigned char scratch[BUFSIZE];
+    unsigned char block[4];
+    int len;
 
-    /* Initialize libcoap library */
-    coap_startup();
+    len = snprintf(coap_uri, sizeof(coap_uri), "%s%s", ConfigMirrorGetUri(attempt.mirror), path);
+    if (len < 0 || (size_t)len >= sizeof(coap_uri)) {
+        ChipLogError(DeviceLayer, "CoAP Client: URI of %s is too long", path);
+        return false;
+    }
 
     /* Parse the URI */
-    len = coap_split_uri((const unsigned char *)coap_uri, strlen(coap_uri), &uri);
-    if (len != 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to parse uri %s\n", coap_uri);
-        goto finish;
+    if (coap_split_uri((const unsigned char *)coap_uri, strlen(coap_uri), &uri) != 0) {
+        ChipLogError(DeviceLayer, "CoAP Client: Failed to parse uri %s", coap_uri);
+        return false;
     }
 
     /* resolve destination address where server should be sent */
-    len = resolve_address(&uri.host, uri.port, &dst, 1 << uri.scheme);
-    if (len <= 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to resolve address %*.*s\n", (int)uri.host.length, (int)uri.host.length, (const char *)uri.host.s);
-        goto finish;
-    }
-
-    /* create CoAP context and a client session */
-    if (!(ctx = coap_new_context(nullptr))) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create libcoap context\n");
-        goto finish;
+    if (resolve_address(&uri.host, uri.port, &dst, 1 << uri.scheme) <= 0) {
+        ChipLogError(DeviceLayer, "CoAP Client: Failed to resolve address %*.*s", (int)uri.host.length, (int)uri.host.length, (const char *)uri.host.s);
+        return false;
     }
 
-    /* Support large responses */
-    coap_context_set_block_mode(ctx, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY);
-
-    session = coap_new_client_session(ctx, NULL, &dst, COAP_PROTO_UDP);
-    if (!session) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create client session\n");
-        goto finish;
+    /* Every mirror has its own session, so the responses can be told apart */
+    attempt.session = coap_new_client_session(context, NULL, &dst, COAP_PROTO_UDP);
+    if (!attempt.session) {
+        ChipLogError(DeviceLayer, "CoAP Client: Cannot create client session");
+        return false;
     }
-
-    /* coap_register_response_handler(ctx, response_handler); */
-    coap_register_response_handler(ctx,
-                            [](coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received, const coap_mid_t id) {
-                                const uint8_t *data;
-                                size_t len;
-                                size_t offset;
-                                size_t total;
-
-                                (void)session;
-                                (void)sent;
-                                (void)id;
-                                have_response = 1;
-                                if (coap_get_data_large(received, &len, &data, &offset, &total)) {
-                                    sdf_mapping_lwm2m_file = nlohmann::json::parse((const char *)data, (const char *)data + (int)len);
-                                    ChipLogProgress(DeviceLayer, "%*.*s", (int)len, (int)len, (const char *)data);
-                                }
-                                return COAP_RESPONSE_OK;
-                            });
-    coap_register_nack_handler(ctx, nack_handler);
+    coap_session_set_app_data(attempt.session, &attempt);
 
     /* construct CoAP message */
-    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_GET, coap_new_message_id(session), coap_session_max_pdu_size(session));
-
+    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_GET, coap_new_message_id(attempt.session), coap_session_max_pdu_size(attempt.session));
     if (!pdu) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create PDU\n");
-        goto finish;
+        ChipLogError(DeviceLayer, "CoAP Client: Cannot create PDU");
+        return false;
     }
 
     /* Add option list (which will be sorted) to the PDU */
-    len = coap_uri_into_options(&uri, &dst, &optlist, 1, scratch, sizeof(scratch));
-    if (len) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to create options\n");
-        goto finish;
-    }
-
-    if (optlist) {
-        res = coap_add_optlist_pdu(pdu, &optlist);
-        if (res != 1) {
-            ChipLogError(DeviceLayer, "CoAP Client: Failed to add options to PDU\n");
-            goto finish;
-        }
-    }
-
-    coap_show_pdu(COAP_LOG_WARN, pdu);
-
-    /* and send the PDU */
-    if (coap_send(session, pdu) == COAP_INVALID_MID) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP PDU\n");
-        goto finish;
-    }
-
-    wait_ms = (coap_session_get_default_leisure(session).integer_part + 1) * 1000;
-
-    while (have_response == 0) {
-        res = coap_io_process(ctx, 1000);
-        if (res >= 0) {
-            if (wait_ms > 0) {
-                if ((unsigned)res >= wait_ms) {
-                    ChipLogError(DeviceLayer, "CoAP Client: Timeout");
-                    break;
-                } else {
-                    wait_ms -= res;
-                }
-            }
-        }
+    if (coap_uri_into_options(&uri, &dst, &options, 1, scratch, sizeof(scratch)) != 0) {
+        ChipLogError(DeviceLayer, "CoAP Client: Failed to create options");
+        coap_delete_optlist(options);
+        coap_delete_pdu(pdu);
+        return false;
+    }
+    /* Ask for the block size with the first request, so the server does not pick a larger one (early negotiation) */
+    coap_insert_optlist(&options, coap_new_optlist(CONFIG_BLOCK_OPTION, coap_encode_var_safe(block, sizeof(block), kConfigBlockSzx), block));
+    if (coap_add_optlist_pdu(pdu, &options) != 1) {
+        ChipLogError(DeviceLayer, "CoAP Client: Failed to add options to PDU");
+        coap_delete_optlist(options);
+        coap_delete_pdu(pdu);
+        return false;
+    }
+    coap_delete_optlist(options);
+
+    BRIDGE_LOG_PDU("CoAP Client: Request", pdu);
+
+    attempt.start_ms = esp_timer_get_time() / 1000;
+    // The timeout applies to the wait for the next block, not to the whole document
+    attempt.timeout_ms = (coap_session_get_default_leisure(attempt.session).integer_part + 1) * 1000;
+    if (coap_send(attempt.session, pdu) == COAP_INVALID_MID) {
+        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP pdu");
+        return false;
     }
-
-finish:
-    have_response = 0;
-    coap_delete_optlist(optlist);
-    optlist = NULL;
-    coap_session_release(session);
-    session = NULL;
-    coap_free_context(ctx);
-    ctx = NULL;
-    coap_cleanup();
-
-    return result;
+    return true;
 }
 
 /**
- * Function used to load the Matter to LwM2M merged mapping from the CoAP server
+ * Function used to keep and log the timing of a completed configuration document transfer
  */
-int LoadSdfMappingMatterFile(const char* client_uri)
+static void RecordConfigTransfer(const char *path, const ConfigFetch &fetch, size_t requests)
 {
-    coap_session_t *session = NULL;
-    coap_pdu_t *pdu = nullptr;
-    coap_address_t dst;
-
-    int result = EXIT_FAILURE;;
-    int len;
-    int res;
-    unsigned int wait_ms;
-    coap_uri_t uri;
-    const char *coap_uri = client_uri;
-    unsigned char scratch[BUFSIZE];
+    ConfigTransferStats stats = {};
+    strncpy(stats.path, path, sizeof(stats.path) - 1);
+    stats.mirror = fetch.winner->mirror;
+    stats.length = fetch.length;
+    stats.block_size = static_cast<uint16_t>(fetch.block_size);
+    stats.blocks = static_cast<uint32_t>(std::max<size_t>((fetch.length + fetch.block_size - 1) / fetch.block_size, 1));
+    stats.duration_ms = fetch.duration_ms;
+    stats.requests = static_cast<uint8_t>(requests);
+
+    ChipLogProgress(DeviceLayer, "CoAP Client: Received %u bytes of %s in %u blocks of %u bytes within %u ms (%u B/s)",
+                    (unsigned)stats.length, path, (unsigned)stats.blocks, (unsigned)stats.block_size, (unsigned)stats.duration_ms,
+                    (unsigned)(stats.length * 1000 / std::max<uint32_t>(stats.duration_ms, 1)));
+
+    std::lock_guard<std::mutex> lock(config_transfers_mutex);
+    config_transfers[config_transfer_count % kConfigTransferHistory] = stats;
+    config_transfer_count++;
+}
 
-    /* Initialize libcoap library */
+int LoadConfigDocument(const char* path, ConfigDocumentParser parser)
+{
+    BridgePhaseScope phase(BridgePhase::kFetch);
+    // Of an active arena only the parsed document is allocated from it, the sessions and the mirror state live on
+    BridgeArenaSuspendScope arena;
+    coap_context_t *context = NULL;
+    ConfigFetchPlan plan;
+    ConfigFetch fetch = { parser, &plan };
+    ConfigAttempt attempts[kMaxConfigMirrors];
+    int64_t now;
+
+    /* Initialize libcoap library, the server keeps using it afterwards */
     coap_startup();
 
-    /* Parse the URI */
-    len = coap_split_uri((const unsigned char *)coap_uri, strlen(coap_uri), &uri);
-    if (len != 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to parse uri %s\n", coap_uri);
-        goto finish;
-    }
+    /* create CoAP context, the sessions to the mirrors are created on demand */
+    if (!(context = coap_new_context(nullptr))) {
+        ChipLogError(DeviceLayer, "CoAP Client: Cannot create libcoap context");
+        return EXIT_FAILURE;
+    }
+
+    /* Support large responses, the blocks are at most as large as configured */
+    coap_context_set_block_mode(context, CONFIG_BLOCK_MODE);
+    coap_context_set_max_block_size(context, kConfigBlockSize);
+    coap_register_response_handler(context, config_response_handler);
+    coap_register_nack_handler(context, config_nack_handler);
+
+    /* the plan decides when a mirror is asked and when a request has failed, the loop only does the I/O */
+    while (fetch.winner == nullptr) {
+        now = esp_timer_get_time() / 1000;
+        ConfigFetchPlan::Step step = plan.Next(now);
+
+        if (step.action == ConfigFetchPlan::Action::kLaunch) {
+            ConfigAttempt &attempt = attempts[step.attempt];
+            attempt.index = step.attempt;
+            attempt.mirror = step.mirror;
+            attempt.fetch = &fetch;
+            if (step.hedge) {
+                ChipLogProgress(DeviceLayer, "CoAP Client: Hedging request for %s with %s", path, ConfigMirrorGetUri(attempt.mirror));
+            }
+            if (StartConfigRequest(context, attempt, path)) {
+                plan.Started(step.attempt, attempt.start_ms, attempt.timeout_ms);
+            } else {
+                plan.Failed(step.attempt);
+            }
+            continue;
+        }
 
-    /* resolve destination address where server should be sent */
-    len = resolve_address(&uri.host, uri.port, &dst, 1 << uri.scheme);
-    if (len <= 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to resolve address %*.*s\n", (int)uri.host.length, (int)uri.host.length, (const char *)uri.host.s);
-        goto finish;
+        if (step.action == ConfigFetchPlan::Action::kGiveUp) {
+            ChipLogError(DeviceLayer, "CoAP Client: No configuration server delivered %s", path);
+            break;
+        }
+        coap_io_process(context, static_cast<uint32_t>(std::max<int64_t>(step.wakeMs - now, 1)));
     }
 
-    /* create CoAP context and a client session */
-    if (!(ctx = coap_new_context(nullptr))) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create libcoap context\n");
-        goto finish;
+    plan.Finish(esp_timer_get_time() / 1000);
+    for (size_t i = 0; i < plan.Launched(); i++) {
+        ConfigAttempt &attempt = attempts[i];
+        if (attempt.session) {
+            coap_session_set_app_data(attempt.session, nullptr);
+            coap_session_release(attempt.session);
+        }
     }
+    coap_free_context(context);
 
-    /* Support large responses */
-    coap_context_set_block_mode(ctx, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY);
-
-    session = coap_new_client_session(ctx, NULL, &dst, COAP_PROTO_UDP);
-    if (!session) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create client session\n");
-        goto finish;
+    if (fetch.winner != nullptr) {
+        RecordConfigTransfer(path, fetch, plan.Launched());
     }
+    return fetch.winner != nullptr ? EXIT_SUCCESS : EXIT_FAILURE;
+}
 
-    /* coap_register_response_handler(ctx, response_handler); */
-    coap_register_response_handler(ctx,
-                            [](coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received, const coap_mid_t id) {
-                                const uint8_t *data;
-                                size_t len;
-                                size_t offset;
-                                size_t total;
-
-                                (void)session;
-                                (void)sent;
-                                (void)id;
-                                have_response = 1;
-                                if (coap_get_data_large(received, &len, &data, &offset, &total)) {
-                                    sdf_mapping_matter_file = nlohmann::json::parse((const char *)data, (const char *)data + (int)len);
-                                    ChipLogProgress(DeviceLayer, "%*.*s", (int)len, (int)len, (const char *)data);
-                                }
-                                return COAP_RESPONSE_OK;
-                            });
-    coap_register_nack_handler(ctx, nack_handler);
-
-    /* construct CoAP message */
-    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_GET, coap_new_message_id(session), coap_session_max_pdu_size(session));
-
-    if (!pdu) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create PDU\n");
-        goto finish;
+size_t GetConfigTransferStats(ConfigTransferStats* stats, size_t max_stats)
+{
+    std::lock_guard<std::mutex> lock(config_transfers_mutex);
+    size_t count = std::min({ config_transfer_count, kConfigTransferHistory, max_stats });
+    // Oldest transfer first
+    for (size_t i = 0; i < count; i++) {
+        stats[i] = config_transfers[(config_transfer_count - count + i) % kConfigTransferHistory];
     }
+    return count;
+}
 
-    /* Add option list (which will be sorted) to the PDU */
-    len = coap_uri_into_options(&uri, &dst, &optlist, 1, scratch, sizeof(scratch));
-    if (len) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to create options\n");
-        goto finish;
-    }
+/**
+ * Function used to load the Cluster xml from the configuration servers
+ */
+int LoadClusterXmlFile(const char* path)
+{
+    return LoadConfigDocument(path, [](const uint8_t *data, size_t len) {
+        pugi::xml_parse_result result = cluster_xml.load_buffer(data, len);
+        BRIDGE_LOG_INFO("CoAP Client: Parsed %" PRIu32 " bytes of XML, status %" PRIu32, len, result.status);
+        BRIDGE_LOG_PAYLOAD("CoAP Client: XML", data, len);
+    });
+}
 
-    if (optlist) {
-        res = coap_add_optlist_pdu(pdu, &optlist);
-        if (res != 1) {
-            ChipLogError(DeviceLayer, "CoAP Client: Failed to add options to PDU\n");
-            goto finish;
-        }
-    }
+/**
+ * Function used to load the sdf-model from the configuration servers
+ */
+int LoadSdfModelFile(const char* path)
+{
+    return LoadConfigDocument(path, [](const uint8_t *data, size_t len) {
+        sdf_model_file = nlohmann::json::parse((const char *)data, (const char *)data + (int)len);
+        BRIDGE_LOG_PAYLOAD("CoAP Client: JSON", data, len);
+    });
+}
 
-    coap_show_pdu(COAP_LOG_WARN, pdu);
+/**
+ * Function used to load the LwM2M to Matter merged mapping from the configuration servers
+ */
+int LoadSdfMappingLwm2mFile(const char* path)
+{
+    return LoadConfigDocument(path, [](const uint8_t *data, size_t len) {
+        sdf_mapping_lwm2m_file = nlohmann::json::parse((const char *)data, (const char *)data + (int)len);
+        BRIDGE_LOG_PAYLOAD("CoAP Client: JSON", data, len);
+    });
+}
 
-    /* and send the PDU */
-    if (coap_send(session, pdu) == COAP_INVALID_MID) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP PDU\n");
-        goto finish;
-    }
+/**
+ * Function used to load the Matter to LwM2M merged mapping from the configuration servers
+ */
+int LoadSdfMappingMatterFile(const char* path)
+{
+    return LoadConfigDocument(path, [](const uint8_t *data, size_t len) {
+        sdf_mapping_matter_file = nlohmann::json::parse((const char *)data, (const char *)data + (int)len);
+        BRIDGE_LOG_PAYLOAD("CoAP Client: JSON", data, len);
+    });
+}
 
-    wait_ms = (coap_session_get_default_leisure(session).integer_part + 1) * 1000;
+/**
+ * Function used to load the converted LwM2M definition from the configuration servers
+ */
+int LoadLwm2mFile(const char* path)
+{
+    return LoadConfigDocument(path, [](const uint8_t *data, size_t len) {
+        pugi::xml_parse_result result = lwm2m_xml_file.load_buffer(data, len);
+        BRIDGE_LOG_INFO("CoAP Client: Parsed %" PRIu32 " bytes of XML, status %" PRIu32, len, result.status);
+        BRIDGE_LOG_PAYLOAD("CoAP Client: XML", data, len);
+    });
+}
 
-    while (have_response == 0) {
-        res = coap_io_process(ctx, 1000);
-        if (res >= 0) {
-            if (wait_ms > 0) {
-                if ((unsigned)res >= wait_ms) {
-                    ChipLogError(DeviceLayer, "CoAP Client: Timeout");
-                    break;
-                } else {
-                    wait_ms -= res;
-                }
-            }
-        }
-    }
+/**
+ * Function used to send a simple CoAP GET request without a payload
+ * The request goes through the health tracking of the device like every other request, the answer is only logged
+ */
+int CoapClientGet(const char* client_uri)
+{
+    char answer[BUFSIZE];
 
-finish:
-    have_response = 0;
-    coap_delete_optlist(optlist);
-    optlist = NULL;
-    coap_session_release(session);
-    session = NULL;
-    coap_free_context(ctx);
-    ctx = NULL;
-    coap_cleanup();
+    return CoapClientGet(client_uri, answer, sizeof(answer));
+}
 
-    return result;
+/**
+ * Function used to send a simple CoAP PUT request without a payload
+ * The request goes through the health tracking of the device like every other request
+ */
+int CoapClientPut(const char* client_uri)
+{
+    char message[] = "off";
+
+    return CoapClientPut(client_uri, message, strlen(message));
 }
 
 /**
- * Function used to load the converted LwM2M definition from the CoAP server
+ * Function used to send a CoAP GET request to a bridged device and wait for the answer
+ * Every call sends its own request, CoapClientGet shares requests between concurrent callers
  */
-int LoadLwm2mFile(const char* client_uri)
+static int SendGet(const char* client_uri, char* answer, size_t answer_size)
 {
+    // Everything is local, so concurrent requests from other tasks and the server do not interfere
+    coap_context_t *context = NULL;
+    coap_optlist_t *options = NULL;
     coap_session_t *session = NULL;
     coap_pdu_t *pdu = nullptr;
     coap_address_t dst;
@@ -560,12 +679,13 @@ int LoadLwm2mFile(const char* client_uri)
     int result = EXIT_FAILURE;;
     int len;
     int res;
-    unsigned int wait_ms;
+    bool allowed = false;
     coap_uri_t uri;
+    CoapClientResponse response;
     const char *coap_uri = client_uri;
     unsigned char scratch[BUFSIZE];
 
-    /* Initialize libcoap library */
+    /* Initialize libcoap library, the server keeps using it afterwards */
     coap_startup();
 
     /* Parse the URI */
@@ -582,231 +702,252 @@ int LoadLwm2mFile(const char* client_uri)
         goto finish;
     }
 
+    /* fail fast while the device is known to be unreachable */
+    if (!Lwm2mDeviceAllowsRequest(&dst)) {
+        ChipLogError(DeviceLayer, "CoAP Client: Device %s is unreachable", coap_uri);
+        goto finish;
+    }
+    allowed = true;
+
     /* create CoAP context and a client session */
-    if (!(ctx = coap_new_context(nullptr))) {
+    if (!(context = coap_new_context(nullptr))) {
         ChipLogError(DeviceLayer, "CoAP Client: Cannot create libcoap context");
         goto finish;
     }
 
     /* Support large responses */
-    coap_context_set_block_mode(ctx, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY);
+    coap_context_set_block_mode(context, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY);
 
-    session = coap_new_client_session(ctx, NULL, &dst, COAP_PROTO_UDP);
+    session = coap_new_client_session(context, NULL, &dst, COAP_PROTO_UDP);
     if (!session) {
         ChipLogError(DeviceLayer, "CoAP Client: Cannot create client session");
         goto finish;
     }
 
-    coap_register_response_handler(ctx,
-                                [](coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received, const coap_mid_t id) {
-                                    const uint8_t *data;
-                                    size_t len;
-                                    size_t offset;
-                                    size_t total;
-
-                                    (void)session;
-                                    (void)sent;
-                                    (void)id;
-                                    have_response = 1;
-                                    if (coap_get_data_large(received, &len, &data, &offset, &total)) {
-                                        pugi::xml_parse_result result = lwm2m_xml_file.load_buffer(data, len);
-                                        std::cout << "DATA SIZE: " << len << std::endl;
-                                        ChipLogProgress(DeviceLayer, "CoAP Client: Result of the parsing: %s", result.description());
-                                        ChipLogProgress(DeviceLayer, "%*.*s", (int)len, (int)len, (const char *)data);
-                                    }
-                                    return COAP_RESPONSE_OK;
-                                });
-    coap_register_nack_handler(ctx, nack_handler);
+    // Set the response as application data for the session
+    // One byte of the answer is kept for the terminating null character
+    response.payload = reinterpret_cast<uint8_t*>(answer);
+    response.payload_size = answer_size > 0 ? answer_size - 1 : 0;
+    coap_session_set_app_data(session, &response);
+
+    coap_register_response_handler(context, tracked_response_handler);
+    coap_register_nack_handler(context, tracked_nack_handler);
 
     /* construct CoAP message */
-    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_GET, coap_new_message_id(session), coap_session_max_pdu_size(session));
+    pdu = coap_pdu_init(BRIDGE_REQUEST_TYPE, COAP_REQUEST_CODE_GET, coap_new_message_id(session), coap_session_max_pdu_size(session));
     if (!pdu) {
         ChipLogError(DeviceLayer, "CoAP Client: Cannot create PDU");
         goto finish;
     }
+    AddTraceToken(pdu);
 
     /* Add option list (which will be sorted) to the PDU */
-    len = coap_uri_into_options(&uri, &dst, &optlist, 1, scratch, sizeof(scratch));
+    len = coap_uri_into_options(&uri, NULL, &options, 1, scratch, sizeof(scratch));
     if (len) {
         ChipLogError(DeviceLayer, "CoAP Client: Failed to create options");
         goto finish;
     }
 
-    if (optlist) {
-        res = coap_add_optlist_pdu(pdu, &optlist);
+    if (options) {
+        res = coap_add_optlist_pdu(pdu, &options);
         if (res != 1) {
             ChipLogError(DeviceLayer, "CoAP Client: Failed to add options to PDU");
             goto finish;
         }
     }
 
-    coap_show_pdu(COAP_LOG_WARN, pdu);
+    BRIDGE_LOG_PDU("CoAP Client: Request", pdu);
 
-    /* and send the PDU */
-    if (coap_send(session, pdu) == COAP_INVALID_MID) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP pdu");
+    /* and send the PDU, it is consumed and its outcome is reported even if it cannot be sent */
+    res = SendTrackedPdu(context, session, pdu, &dst, response);
+    pdu = nullptr;
+    allowed = false;
+    if (!res) {
         goto finish;
     }
 
-    wait_ms = (coap_session_get_default_leisure(session).integer_part + 1) * 1000;
-
-    while (have_response == 0) {
-        res = coap_io_process(ctx, 1000);
-        if (res >= 0) {
-            if (wait_ms > 0) {
-                if ((unsigned)res >= wait_ms) {
-                    ChipLogError(DeviceLayer, "CoAP Client: Timeout");
-                    break;
-                } else {
-                    wait_ms -= res;
-                }
-            }
-        }
+    if (response.received && answer_size > 0) {
+        answer[response.length] = '\0';
+        BRIDGE_LOG_PAYLOAD("CoAP Client: Response", reinterpret_cast<const uint8_t *>(answer), response.length);
+        result = EXIT_SUCCESS;
     }
 
 finish:
-    have_response = 0;
-    coap_delete_optlist(optlist);
-    optlist = NULL;
+    /* a request that was let through but never sent still counts as failed */
+    if (allowed) {
+        Lwm2mDeviceReportFailure(&dst);
+    }
+    if (pdu) {
+        coap_delete_pdu(pdu);
+    }
+    coap_delete_optlist(options);
     coap_session_release(session);
-    session = NULL;
-    coap_free_context(ctx);
-    ctx = NULL;
-    coap_cleanup();
+    coap_free_context(context);
 
     return result;
 }
 
-/**
- * Function used to send a simple CoAP GET request without a payload
- */
-int CoapClientGet(const char* client_uri)
-{
-    coap_session_t *session = NULL;
-    coap_pdu_t *pdu = nullptr;
-    coap_address_t dst;
-
-    int result = EXIT_FAILURE;;
-    int len;
-    int res;
-    unsigned int wait_ms;
-    coap_uri_t uri;
-    const char *coap_uri = client_uri;
-    unsigned char scratch[BUFSIZE];
-
-    /* Initialize libcoap library */
-    coap_startup();
+namespace {
 
-    /* Parse the URI */
-    len = coap_split_uri((const unsigned char *)coap_uri, strlen(coap_uri), &uri);
-    if (len != 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to parse uri %s", coap_uri);
-        goto finish;
-    }
+// Number of different GET requests that can be shared at the same time
+constexpr size_t kMaxSharedGets = 4;
+// Longest URI and answer that are shared, longer ones are always requested separately
+constexpr size_t kMaxSharedUriLength = 96;
+constexpr size_t kMaxSharedAnswerLength = 64;
 
-    /* resolve destination address where server should be sent */
-    len = resolve_address(&uri.host, uri.port, &dst, 1 << uri.scheme);
-    if (len <= 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to resolve address %*.*s", (int)uri.host.length, (int)uri.host.length, (const char *)uri.host.s);
-        goto finish;
-    }
-
-    /* create CoAP context and a client session */
-    if (!(ctx = coap_new_context(nullptr))) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create libcoap context");
-        goto finish;
-    }
-
-    /* Support large responses */
-    coap_context_set_block_mode(ctx, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY);
-
-    session = coap_new_client_session(ctx, NULL, &dst, COAP_PROTO_UDP);
-    if (!session) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create client session");
-        goto finish;
-    }
-
-    /* coap_register_response_handler(ctx, response_handler); */
-    coap_register_response_handler(ctx,
-                                 [](coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received, const coap_mid_t id) {
-                                        const uint8_t *data;
-                                        size_t len;
-
-                                        (void)session;
-                                        (void)sent;
-                                        (void)id;
-                                        have_response = 1;
-                                        if (coap_get_data(received, &len, &data)) {
-                                            ChipLogProgress(DeviceLayer, "%*.*s", (int)len, (int)len, (const char *)data);
-                                        }
-                                        return COAP_RESPONSE_OK;
-                                  });
-    coap_register_nack_handler(ctx, nack_handler);
+// GET request whose answer is handed to every caller that asks for the same URI
+struct SharedGet
+{
+    char uri[kMaxSharedUriLength];
+    bool in_flight = false;
+    int result = EXIT_FAILURE;
+    char answer[kMaxSharedAnswerLength];
+    size_t length = 0;
+    int64_t completed_ms = 0;
+    // Callers that still have to copy the answer
+    int waiters = 0;
+    // Set if the resource has been written while the request was in flight, the answer is not shared with later callers
+    bool invalidated = false;
+};
+
+// GET requests are sent from the Matter event loop as well as from the bridge tasks
+SharedGet shared_gets[kMaxSharedGets];
+std::mutex shared_gets_mutex;
+std::condition_variable shared_get_done;
+CoapClientCoalescingStats coalescing_stats;
 
-    /* construct CoAP message */
-    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_GET, coap_new_message_id(session), coap_session_max_pdu_size(session));
-    if (!pdu) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create PDU");
-        goto finish;
+/**
+ * Function used to hand the answer of a shared request to a caller, must be called with the mutex held
+ * Returns false if the answer does not fit into the buffer of the caller
+ */
+bool CopySharedAnswer(const SharedGet& get, char* answer, size_t answer_size, int& result)
+{
+    if (get.result == EXIT_SUCCESS && get.length >= answer_size) {
+        return false;
     }
-
-    /* Add option list (which will be sorted) to the PDU */
-    len = coap_uri_into_options(&uri, NULL, &optlist, 1, scratch, sizeof(scratch));
-    if (len) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to create options");
-        goto finish;
+    if (get.result == EXIT_SUCCESS) {
+        memcpy(answer, get.answer, get.length);
+        answer[get.length] = '\0';
     }
+    result = get.result;
+    return true;
+}
 
-    if (optlist) {
-        res = coap_add_optlist_pdu(pdu, &optlist);
-        if (res != 1) {
-            ChipLogError(DeviceLayer, "CoAP Client: Failed to add options to PDU");
-            goto finish;
+/**
+ * Function used to drop the shared answer of a URI after it has been written
+ * A request that is still in flight keeps serving the callers that joined it, but not the ones that ask later
+ */
+void InvalidateSharedGet(const char* client_uri)
+{
+    std::lock_guard<std::mutex> lock(shared_gets_mutex);
+    for (auto& get : shared_gets) {
+        if (strcmp(get.uri, client_uri) != 0) {
+            continue;
+        }
+        if (get.in_flight) {
+            get.invalidated = true;
+        } else {
+            get.uri[0] = '\0';
+            get.result = EXIT_FAILURE;
+            get.length = 0;
         }
     }
+}
 
-    coap_show_pdu(COAP_LOG_WARN, pdu);
-
-    /* and send the PDU */
-    if (coap_send(session, pdu) == COAP_INVALID_MID) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP pdu");
-        goto finish;
-    }
-
-    wait_ms = (coap_session_get_default_leisure(session).integer_part + 1) * 1000;
+} // namespace
 
-    while (have_response == 0) {
-        res = coap_io_process(ctx, 1000);
-        if (res >= 0) {
-            if (wait_ms > 0) {
-                if ((unsigned)res >= wait_ms) {
-                    ChipLogError(DeviceLayer, "CoAP Client: Timeout");
-                    break;
-                } else {
-                    wait_ms -= res;
+/**
+ * Function used to send a simple CoAP GET request with a payload
+ * Callers that ask for the same URI while a request is in flight, or within CONFIG_BRIDGE_COAP_COALESCE_WINDOW_MS
+ * after it has completed, get the same answer instead of sending their own request
+ * Callers with a wait budget only take answers that are already there, they do not join a request in flight
+ */
+int CoapClientGet(const char* client_uri, char* answer, size_t answer_size)
+{
+    SharedGet* leader = nullptr;
+    int result;
+
+    if (strlen(client_uri) < kMaxSharedUriLength) {
+        std::unique_lock<std::mutex> lock(shared_gets_mutex);
+        coalescing_stats.requests++;
+        int64_t now = esp_timer_get_time() / 1000;
+        SharedGet* free_get = nullptr;
+        for (auto& get : shared_gets) {
+            if (strcmp(get.uri, client_uri) == 0 && !get.invalidated &&
+                (get.in_flight || now - get.completed_ms <= CONFIG_BRIDGE_COAP_COALESCE_WINDOW_MS)) {
+                if (get.in_flight && wait_budget_ms > 0) {
+                    // A caller with a wait budget, e.g. on the Matter event loop, never waits for the request of
+                    // another task, whose wait is not bounded by its budget. It sends a request of its own.
+                    coalescing_stats.in_flight_bypasses++;
+                } else if (get.in_flight) {
+                    // Join the outstanding request
+                    get.waiters++;
+                    shared_get_done.wait(lock, [&get] { return !get.in_flight; });
+                    get.waiters--;
+                    if (CopySharedAnswer(get, answer, answer_size, result)) {
+                        coalescing_stats.in_flight_hits++;
+                        return result;
+                    }
+                } else if (get.result == EXIT_SUCCESS && CopySharedAnswer(get, answer, answer_size, result)) {
+                    coalescing_stats.window_hits++;
+                    return result;
                 }
+                free_get = nullptr;
+                break;
             }
+            if (!get.in_flight && get.waiters == 0 && (free_get == nullptr || get.completed_ms < free_get->completed_ms)) {
+                free_get = &get;
+            }
+        }
+        if (free_get != nullptr) {
+            leader = free_get;
+            strcpy(leader->uri, client_uri);
+            leader->in_flight = true;
         }
     }
 
-finish:
-    have_response = 0;
-    coap_delete_optlist(optlist);
-    optlist = NULL;
-    coap_session_release(session);
-    session = NULL;
-    coap_free_context(ctx);
-    ctx = NULL;
-    coap_cleanup();
-
+    result = SendGet(client_uri, answer, answer_size);
+
+    if (leader != nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(shared_gets_mutex);
+            leader->length = result == EXIT_SUCCESS ? strnlen(answer, answer_size) : 0;
+            // Answers that cannot be shared completely are not shared at all
+            if (leader->length >= kMaxSharedAnswerLength) {
+                leader->result = EXIT_FAILURE;
+                leader->length = 0;
+                leader->uri[0] = '\0';
+            } else {
+                leader->result = result;
+                memcpy(leader->answer, answer, leader->length);
+            }
+            // An answer outdated by a write still goes to the callers that joined the request, but not to later ones
+            if (leader->invalidated) {
+                leader->uri[0] = '\0';
+                leader->invalidated = false;
+            }
+            leader->completed_ms = esp_timer_get_time() / 1000;
+            leader->in_flight = false;
+        }
+        shared_get_done.notify_all();
+    }
     return result;
 }
 
+CoapClientCoalescingStats GetCoapClientCoalescingStats()
+{
+    std::lock_guard<std::mutex> lock(shared_gets_mutex);
+    return coalescing_stats;
+}
+
 /**
- * Function used to send a simple CoAP PUT request without a payload
+ * Function used to send a simple CoAP PUT request with a payload
  */
-int CoapClientPut(const char* client_uri)
+int CoapClientPut(const char* client_uri, char* data, size_t data_size)
 {
+    // Everything is local, so concurrent requests from other tasks and the server do not interfere
+    coap_context_t *context = NULL;
+    coap_optlist_t *options = NULL;
     coap_session_t *session = NULL;
     coap_pdu_t *pdu = nullptr;
     coap_address_t dst;
@@ -814,12 +955,13 @@ int CoapClientPut(const char* client_uri)
     int result = EXIT_FAILURE;;
     int len;
     int res;
+    bool allowed = false;
     coap_uri_t uri;
+    CoapClientResponse response;
     const char *coap_uri = client_uri;
-    const char *message = "off";
     unsigned char scratch[BUFSIZE];
 
-    /* Initialize libcoap library */
+    /* Initialize libcoap library, the server keeps using it afterwards */
     coap_startup();
 
     /* Parse the URI */
@@ -836,92 +978,122 @@ int CoapClientPut(const char* client_uri)
         goto finish;
     }
 
+    /* fail fast while the device is known to be unreachable */
+    if (!Lwm2mDeviceAllowsRequest(&dst)) {
+        ChipLogError(DeviceLayer, "CoAP Client: Device %s is unreachable", coap_uri);
+        goto finish;
+    }
+    allowed = true;
+
     /* create CoAP context and a client session */
-    if (!(ctx = coap_new_context(nullptr))) {
+    if (!(context = coap_new_context(nullptr))) {
         ChipLogError(DeviceLayer, "CoAP Client: Cannot create libcoap context");
         goto finish;
     }
 
     /* Support large responses */
-    session = coap_new_client_session(ctx, NULL, &dst, COAP_PROTO_UDP);
+    session = coap_new_client_session(context, NULL, &dst, COAP_PROTO_UDP);
     if (!session) {
         ChipLogError(DeviceLayer, "CoAP Client: Cannot create client session");
         goto finish;
     }
 
+    // The response is only needed to learn whether the write was applied
+    coap_session_set_app_data(session, &response);
+    coap_register_response_handler(context, tracked_response_handler);
+    coap_register_nack_handler(context, tracked_nack_handler);
+
     /* construct CoAP message */
-    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_PUT, coap_new_message_id(session), coap_session_max_pdu_size(session));
+    pdu = coap_pdu_init(BRIDGE_REQUEST_TYPE, COAP_REQUEST_CODE_PUT, coap_new_message_id(session), coap_session_max_pdu_size(session));
     if (!pdu) {
         ChipLogError(DeviceLayer, "CoAP Client: Cannot create PDU");
         goto finish;
     }
+    AddTraceToken(pdu);
 
-    /* Add option list (which will be sorted) to the PDU */   
-    len = coap_uri_into_options(&uri, NULL, &optlist, 1, scratch, sizeof(scratch));
+    /* Add option list (which will be sorted) to the PDU */
+    
+    len = coap_uri_into_options(&uri, NULL, &options, 1, scratch, sizeof(scratch));
     if (len < 0) {
         ChipLogError(DeviceLayer, "CoAP Client: Failed to create options");
         goto finish;
     }
 
-    if (optlist) {
-        res = coap_add_optlist_pdu(pdu, &optlist);
+    if (options) {
+        res = coap_add_optlist_pdu(pdu, &options);
         if (res != 1) {
             ChipLogError(DeviceLayer, "CoAP Client: Failed to add options to PDU");
             goto finish;
         }
     }
 
-    len = coap_add_data(pdu, sizeof(message), (const uint8_t*)message);
+    len = coap_add_data(pdu, data_size, (const uint8_t*)data);
     if (!len) {
         ChipLogError(DeviceLayer, "CoAP Client: Failed to add large data");
         goto finish;
     }
 
-    coap_show_pdu(COAP_LOG_WARN, pdu);
+    BRIDGE_LOG_PDU("CoAP Client: Request", pdu);
 
-    /* and send the PDU */
-    if (coap_send(session, pdu) == COAP_INVALID_MID) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP pdu");
+    /* and send the PDU, it is consumed and its outcome is reported even if it cannot be sent */
+    res = SendTrackedPdu(context, session, pdu, &dst, response);
+    pdu = nullptr;
+    allowed = false;
+    if (!res) {
         goto finish;
     }
 
+    /* the outcome has been reported to the health tracking, which also ends a probe of the device */
+    if (response.received && COAP_RESPONSE_CLASS(response.code) == 2) {
+        result = EXIT_SUCCESS;
+    }
+
 finish:
-    have_response = 0;
-    coap_delete_optlist(optlist);
-    optlist = NULL;
+    /* a request that was let through but never sent still counts as failed */
+    if (allowed) {
+        Lwm2mDeviceReportFailure(&dst);
+    }
+    /* the write may have been applied even if it failed, a shared GET answer of the resource is outdated */
+    InvalidateSharedGet(client_uri);
+    if (pdu) {
+        coap_delete_pdu(pdu);
+    }
+    coap_delete_optlist(options);
     coap_session_release(session);
-    session = NULL;
-    coap_free_context(ctx);
-    ctx = NULL;
-    coap_cleanup();
+    coap_free_context(context);
 
     return result;
 }
-
 /**
- * Function used to send a simple CoAP GET request with a payload
+ * Function used to send a CoAP PUT request with a payload and wait for the response
  */
-int CoapClientGet(const char* client_uri, char* answer, size_t answer_size)
+int CoapClientPutWithResponse(const char* client_uri, const uint8_t* data, size_t data_size, CoapClientResponse& response)
 {
+    // Everything is local, so concurrent requests from other tasks do not interfere
+    coap_context_t *context = NULL;
+    coap_optlist_t *options = NULL;
     coap_session_t *session = NULL;
     coap_pdu_t *pdu = nullptr;
     coap_address_t dst;
 
-    int result = EXIT_FAILURE;;
+    int result = EXIT_FAILURE;
     int len;
     int res;
-    unsigned int wait_ms;
+    bool allowed = false;
     coap_uri_t uri;
-    const char *coap_uri = client_uri;
     unsigned char scratch[BUFSIZE];
 
-    /* Initialize libcoap library */
+    response.received = false;
+    response.failed = false;
+    response.length = 0;
+
+    /* Initialize libcoap library, the server keeps using it afterwards */
     coap_startup();
 
     /* Parse the URI */
-    len = coap_split_uri((const unsigned char *)coap_uri, strlen(coap_uri), &uri);
+    len = coap_split_uri((const unsigned char *)client_uri, strlen(client_uri), &uri);
     if (len != 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to parse uri %s", coap_uri);
+        ChipLogError(DeviceLayer, "CoAP Client: Failed to parse uri %s", client_uri);
         goto finish;
     }
 
@@ -932,125 +1104,111 @@ int CoapClientGet(const char* client_uri, char* answer, size_t answer_size)
         goto finish;
     }
 
+    /* fail fast while the device is known to be unreachable */
+    if (!Lwm2mDeviceAllowsRequest(&dst)) {
+        ChipLogError(DeviceLayer, "CoAP Client: Device %s is unreachable", client_uri);
+        goto finish;
+    }
+    allowed = true;
+
     /* create CoAP context and a client session */
-    if (!(ctx = coap_new_context(nullptr))) {
+    if (!(context = coap_new_context(nullptr))) {
         ChipLogError(DeviceLayer, "CoAP Client: Cannot create libcoap context");
         goto finish;
     }
 
-    /* Support large responses */
-    coap_context_set_block_mode(ctx, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY);
-
-    session = coap_new_client_session(ctx, NULL, &dst, COAP_PROTO_UDP);
+    session = coap_new_client_session(context, NULL, &dst, COAP_PROTO_UDP);
     if (!session) {
         ChipLogError(DeviceLayer, "CoAP Client: Cannot create client session");
         goto finish;
     }
 
-    // Set the result buffer as application data for the session
-    coap_session_set_app_data(session, answer);
-
-    coap_register_response_handler(ctx,
-                                 [](coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received, const coap_mid_t id) {
-                                        const uint8_t *data;
-                                        size_t len;
-
-                                        (void)session;
-                                        (void)sent;
-                                        (void)id;
-                                        have_response = 1;
-                                        if (coap_get_data(received, &len, &data)) {
-                                            char *result_buffer = (char *)coap_session_get_app_data(session);
-                                            strncpy(result_buffer, (const char *)data, len);
-                                            result_buffer[len] = '\0';
-                                            ChipLogProgress(DeviceLayer, "%*.*s", (int)len, (int)len, (const char *)data);
-                                        }
-                                        return COAP_RESPONSE_OK;
-                                  });
-    coap_register_nack_handler(ctx, nack_handler);
+    // Set the response as application data for the session
+    coap_session_set_app_data(session, &response);
 
-    /* construct CoAP message */
-    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_GET, coap_new_message_id(session), coap_session_max_pdu_size(session));
+    coap_register_response_handler(context, tracked_response_handler);
+    coap_register_nack_handler(context, tracked_nack_handler);
+
+    /* construct CoAP message, the response code is needed so the request is confirmable */
+    pdu = coap_pdu_init(COAP_MESSAGE_CON, COAP_REQUEST_CODE_PUT, coap_new_message_id(session), coap_session_max_pdu_size(session));
     if (!pdu) {
         ChipLogError(DeviceLayer, "CoAP Client: Cannot create PDU");
         goto finish;
     }
+    AddTraceToken(pdu);
 
     /* Add option list (which will be sorted) to the PDU */
-    len = coap_uri_into_options(&uri, NULL, &optlist, 1, scratch, sizeof(scratch));
-    if (len) {
+    len = coap_uri_into_options(&uri, NULL, &options, 1, scratch, sizeof(scratch));
+    if (len < 0) {
         ChipLogError(DeviceLayer, "CoAP Client: Failed to create options");
         goto finish;
     }
 
-    if (optlist) {
-        res = coap_add_optlist_pdu(pdu, &optlist);
+    if (options) {
+        res = coap_add_optlist_pdu(pdu, &options);
         if (res != 1) {
             ChipLogError(DeviceLayer, "CoAP Client: Failed to add options to PDU");
             goto finish;
         }
     }
 
-    coap_show_pdu(COAP_LOG_WARN, pdu);
-
-    /* and send the PDU */
-    if (coap_send(session, pdu) == COAP_INVALID_MID) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP pdu");
+    if (data_size > 0 && !coap_add_data(pdu, data_size, data)) {
+        ChipLogError(DeviceLayer, "CoAP Client: Failed to add data");
         goto finish;
     }
 
-    wait_ms = (coap_session_get_default_leisure(session).integer_part + 1) * 1000;
+    /* and send the PDU, it is consumed and its outcome is reported even if it cannot be sent */
+    res = SendTrackedPdu(context, session, pdu, &dst, response);
+    pdu = nullptr;
+    allowed = false;
+    if (!res) {
+        goto finish;
+    }
 
-    while (have_response == 0) {
-        res = coap_io_process(ctx, 1000);
-        if (res >= 0) {
-            if (wait_ms > 0) {
-                if ((unsigned)res >= wait_ms) {
-                    ChipLogError(DeviceLayer, "CoAP Client: Timeout");
-                    break;
-                } else {
-                    wait_ms -= res;
-                }
-            }
-        }
+    if (response.received) {
+        result = EXIT_SUCCESS;
     }
 
 finish:
-    have_response = 0;
-    coap_delete_optlist(optlist);
-    optlist = NULL;
+    /* a request that was let through but never sent still counts as failed */
+    if (allowed) {
+        Lwm2mDeviceReportFailure(&dst);
+    }
+    /* the write may have been applied even if it failed, a shared GET answer of the resource is outdated */
+    InvalidateSharedGet(client_uri);
+    if (pdu) {
+        coap_delete_pdu(pdu);
+    }
+    coap_delete_optlist(options);
     coap_session_release(session);
-    session = NULL;
-    coap_free_context(ctx);
-    ctx = NULL;
-    coap_cleanup();
+    coap_free_context(context);
 
     return result;
 }
 
 /**
- * Function used to send a simple CoAP PUT request with a payload
+ * Function used to check whether a CoAP endpoint is alive with a CoAP ping
  */
-int CoapClientPut(const char* client_uri, char* data, size_t data_size)
+int CoapClientPing(const char* client_uri)
 {
+    coap_context_t *context = NULL;
     coap_session_t *session = NULL;
-    coap_pdu_t *pdu = nullptr;
     coap_address_t dst;
 
-    int result = EXIT_FAILURE;;
+    int result = EXIT_FAILURE;
     int len;
-    int res;
+    bool allowed = false;
+    uint32_t rto_ms;
     coap_uri_t uri;
-    const char *coap_uri = client_uri;
-    unsigned char scratch[BUFSIZE];
+    CoapClientResponse response;
 
-    /* Initialize libcoap library */
+    /* Initialize libcoap library, the server keeps using it afterwards */
     coap_startup();
 
     /* Parse the URI */
-    len = coap_split_uri((const unsigned char *)coap_uri, strlen(coap_uri), &uri);
+    len = coap_split_uri((const unsigned char *)client_uri, strlen(client_uri), &uri);
     if (len != 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to parse uri %s", coap_uri);
+        ChipLogError(DeviceLayer, "CoAP Client: Failed to parse uri %s", client_uri);
         goto finish;
     }
 
@@ -1061,65 +1219,58 @@ int CoapClientPut(const char* client_uri, char* data, size_t data_size)
         goto finish;
     }
 
+    /* an unreachable device is only pinged once its backoff has expired */
+    if (!Lwm2mDeviceAllowsRequest(&dst)) {
+        goto finish;
+    }
+    allowed = true;
+
     /* create CoAP context and a client session */
-    if (!(ctx = coap_new_context(nullptr))) {
+    if (!(context = coap_new_context(nullptr))) {
         ChipLogError(DeviceLayer, "CoAP Client: Cannot create libcoap context");
         goto finish;
     }
 
-    /* Support large responses */
-    session = coap_new_client_session(ctx, NULL, &dst, COAP_PROTO_UDP);
+    session = coap_new_client_session(context, NULL, &dst, COAP_PROTO_UDP);
     if (!session) {
         ChipLogError(DeviceLayer, "CoAP Client: Cannot create client session");
         goto finish;
     }
 
-    /* construct CoAP message */
-    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_PUT, coap_new_message_id(session), coap_session_max_pdu_size(session));
-    if (!pdu) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot create PDU");
-        goto finish;
-    }
+    coap_session_set_app_data(session, &response);
+    coap_register_pong_handler(context, tracked_pong_handler);
+    coap_register_nack_handler(context, tracked_nack_handler);
 
-    /* Add option list (which will be sorted) to the PDU */
-    
-    len = coap_uri_into_options(&uri, NULL, &optlist, 1, scratch, sizeof(scratch));
-    if (len < 0) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to create options");
+    /* a ping is an empty confirmable message that is answered with a reset */
+    rto_ms = CongestionApplyToSession(session, &dst);
+    if (!CongestionAcquire(&dst)) {
+        // Not a failure of the device, the probe task pings it again later
+        BridgeMetricIncrement(BridgeCounter::kCoapClientCongested);
+        Lwm2mDeviceCancelRequest(&dst);
+        allowed = false;
         goto finish;
     }
-
-    if (optlist) {
-        res = coap_add_optlist_pdu(pdu, &optlist);
-        if (res != 1) {
-            ChipLogError(DeviceLayer, "CoAP Client: Failed to add options to PDU");
-            goto finish;
-        }
-    }
-
-    len = coap_add_data(pdu, data_size, (const uint8_t*)data);
-    if (!len) {
-        ChipLogError(DeviceLayer, "CoAP Client: Failed to add large data");
+    if (coap_session_send_ping(session) == COAP_INVALID_MID) {
+        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP ping");
+        CongestionRelease(&dst);
         goto finish;
     }
 
-    coap_show_pdu(COAP_LOG_WARN, pdu);
+    allowed = false;
+    WaitForTrackedResponse(context, &dst, CongestionGetExchangeLifetime(rto_ms), rto_ms, response);
+    CongestionRelease(&dst);
 
-    /* and send the PDU */
-    if (coap_send(session, pdu) == COAP_INVALID_MID) {
-        ChipLogError(DeviceLayer, "CoAP Client: Cannot send CoAP pdu");
-        goto finish;
+    if (response.received) {
+        result = EXIT_SUCCESS;
     }
 
 finish:
-    have_response = 0;
-    coap_delete_optlist(optlist);
-    optlist = NULL;
+    /* a request that was let through but never sent still counts as failed */
+    if (allowed) {
+        Lwm2mDeviceReportFailure(&dst);
+    }
     coap_session_release(session);
-    session = NULL;
-    coap_free_context(ctx);
-    ctx = NULL;
-    coap_cleanup();
+    coap_free_context(context);
 
     return result;
-}
\ No newline at end of file
+}
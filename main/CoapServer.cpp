@@ -1,14 +1,25 @@
 #include <support/logging/CHIPLogging.h>
 #include "CoapServer.h"
 #include "BindingHandler.h"
+#include "SubscriptionManager.h"
+#include "CommandRing.h"
+#include "ObjectPool.h"
+#include "BridgeLatency.h"
+#include "BridgeLog.h"
+#include "BridgeMetrics.h"
+#include "BridgeReload.h"
+#include "BridgeTrace.h"
 #include <platform/CHIPDeviceLayer.h>
+#include <lib/core/TLVWriter.h>
+#include <lib/support/CodeUtils.h>
 #include "freertos/FreeRTOS.h"
-#include <iostream>
 #include <vector>
-#include <chrono>
-#include <thread>
+#include <atomic>
+#include <optional>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 
 coap_resource_t *resource = nullptr;
@@ -20,6 +31,173 @@ using namespace chip::app;
 // Map that links resources with their respective type
 std::map<std::string, std::string> type_map;
 
+// Resources of an object instance that are mapped to readable and writable attributes
+struct ObjectInstanceResources
+{
+    std::vector<int> readable;
+    std::vector<int> writable;
+};
+
+// Map that links object instance resources with the resources of the object
+std::map<std::string, ObjectInstanceResources> object_map;
+
+#if CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+// Token used to watch the libcoap file descriptor with the CHIP system layer
+static chip::System::SocketWatchToken coap_watch_token;
+#endif
+
+// Request whose response is sent separately once the Matter interaction has finished
+struct DeferredResponse
+{
+    coap_session_t * session;
+    coap_bin_const_t * token;
+    coap_pdu_type_t type;
+    // Time the request was received, the round trip ends with the separate response
+    int64_t start_us;
+    // Trace of the request, derived from its token
+    uint32_t trace_id;
+};
+
+// Maximum length of the JSON representation of a command response
+constexpr size_t kMaxCommandResponseLength = 256;
+
+// Forwarded command or write whose response is sent once every interaction it has been split into has finished
+struct CommandResponse
+{
+    DeferredResponse deferred;
+    // Path and span the round trip is recorded as
+    BridgePath path;
+    const char * span;
+    // The first failing interaction decides the response code
+    std::atomic<coap_pdu_code_t> code{ COAP_RESPONSE_CODE_CHANGED };
+    uint8_t payload[kMaxCommandResponseLength];
+    size_t length = 0;
+    // Interactions that have not completed, the CoAP handler holds one more until it has dispatched all of them
+    std::atomic<uint8_t> pending{ 1 };
+};
+
+// Read of a single attribute whose response is sent separately once the read interaction has finished
+struct AttributeRead
+{
+    DeferredResponse deferred;
+    // Empty if the read interaction failed
+    std::optional<TlvValue> value;
+    // The read interaction and the CoAP handler each hold a reference until they are done with the read
+    std::atomic<uint8_t> pending{ 2 };
+};
+
+// Forwarded commands, writes and deferred reads are kept in pools, so their contexts do not fragment the heap
+// The URI parsing and the PDUs of libcoap still allocate, those are short-lived and freed before the request is answered
+// The number of forwarded commands and writes that wait for their response at the same time is limited by the pool
+static ObjectPool<CommandResponse, CONFIG_BRIDGE_COMMAND_RESPONSE_POOL_SIZE> command_response_pool("command_response");
+static ObjectPool<AttributeRead, CONFIG_BRIDGE_DEFERRED_READ_POOL_SIZE> attribute_read_pool("attribute_read");
+
+// Number of requests that wait for a separate response
+static std::atomic<size_t> pending_responses{ 0 };
+
+#if !CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+// Capacity of the ring that hands completed commands back to the CoAP server task
+constexpr size_t CompletedCommandsCapacity(size_t value, size_t power = 1)
+{
+    return power >= value ? power : CompletedCommandsCapacity(value, power * 2);
+}
+
+// Commands and writes that have been completed on the Matter event loop and are answered by the CoAP server task
+static SpscRing<CommandResponse *, CompletedCommandsCapacity(CONFIG_BRIDGE_COMMAND_RESPONSE_POOL_SIZE)> completed_commands;
+// Reads of attributes that have been completed on the Matter event loop and are answered by the CoAP server task
+static SpscRing<AttributeRead *, CompletedCommandsCapacity(CONFIG_BRIDGE_DEFERRED_READ_POOL_SIZE)> completed_attribute_reads;
+
+// Work that is run by the CoAP server task, e.g. applying a reloaded configuration to the ressources
+static std::atomic<void (*)(intptr_t)> server_work{ nullptr };
+static intptr_t server_work_context;
+#endif
+
+// Local endpoints of the object instances, the instance id is the index of the bridged LwM2M device
+static std::atomic<EndpointId> instance_endpoints[CONFIG_BRIDGE_LWM2M_DEVICE_COUNT];
+// Bit i is set once the endpoint of instance i has been assigned
+static std::atomic<uint32_t> assigned_instances{ 0 };
+
+/**
+ * Function used to get the local endpoint of the object instance of a split URI
+ * Returns kInvalidEndpointId if the instance does not belong to a deployed LwM2M device
+ */
+static EndpointId GetInstanceEndpoint(const std::vector<std::string> & split_string)
+{
+    int instance_id = split_string.size() > 1 ? std::atoi(split_string[1].c_str()) : -1;
+    VerifyOrReturnValue(instance_id >= 0 && instance_id < CONFIG_BRIDGE_LWM2M_DEVICE_COUNT, kInvalidEndpointId);
+    VerifyOrReturnValue((assigned_instances.load(std::memory_order_acquire) & (1u << instance_id)) != 0, kInvalidEndpointId);
+    return instance_endpoints[instance_id].load(std::memory_order_relaxed);
+}
+
+/**
+ * Function used to hand BindingCommandData over to the Matter event loop
+ * If the CoAP I/O is processed on the Matter event loop, the data is processed directly
+ * Otherwise it is posted to the command ring of the CoAP server
+ */
+static CHIP_ERROR DispatchBindingCommand(const BindingCommandData & data)
+{
+#if CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+    ProcessBindingCommand(data);
+    return CHIP_NO_ERROR;
+#else
+    return PostBindingCommand(CommandProducer::kCoapServer, data);
+#endif
+}
+
+/**
+ * Function used to set the code of an error response and count it
+ */
+static void SetErrorResponse(coap_pdu_t * pdu, coap_pdu_code_t code)
+{
+    coap_pdu_set_code(pdu, code);
+    switch (code) {
+    case COAP_RESPONSE_CODE_BAD_REQUEST:
+        BridgeMetricIncrement(BridgeCounter::kCoapServerBadRequests);
+        break;
+    case COAP_RESPONSE_CODE_BAD_GATEWAY:
+        BridgeMetricIncrement(BridgeCounter::kCoapServerBadGateway);
+        break;
+    case COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE:
+        BridgeMetricIncrement(BridgeCounter::kCoapServerUnavailable);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Function used to get the trace of a request from its token
+ */
+static uint32_t GetRequestTraceId(const coap_pdu_t * request)
+{
+    coap_bin_const_t token = coap_pdu_get_token(request);
+    return BridgeTraceIdFromToken(token.s, token.length);
+}
+
+/**
+ * Function used to keep everything that is needed to answer a request separately
+ */
+static void DeferResponse(DeferredResponse & deferred, coap_session_t * session, const coap_pdu_t * request, int64_t start_us)
+{
+    coap_bin_const_t token = coap_pdu_get_token(request);
+    deferred.session  = coap_session_reference(session);
+    deferred.token    = coap_new_bin_const(token.s, token.length);
+    deferred.type     = coap_pdu_get_type(request) == COAP_MESSAGE_CON ? COAP_MESSAGE_CON : COAP_MESSAGE_NON;
+    deferred.start_us = start_us;
+    deferred.trace_id = BridgeTraceCurrent();
+    pending_responses++;
+}
+
+/**
+ * Function used to release what has been kept to answer a request, once it has been answered
+ */
+static void ReleaseDeferredResponse(DeferredResponse & deferred)
+{
+    coap_delete_bin_const(deferred.token);
+    coap_session_release(deferred.session);
+    pending_responses--;
+}
+
 /**
  * Function used to split a string accoring to a delimiter into a vector containing the resulting substrings 
  */ 
@@ -39,10 +217,11 @@ std::vector<std::string> SplitString(const std::string& str, char delimiter) {
 }
 
 /**
- * Function used to forward messages based on the uri of the resource that was accessed 
+ * Function used to prepare the write of an attribute based on the uri of the resource that was accessed
  * This function is used in combination with a CoAP resource handler
+ * Returns false if the payload cannot be encoded
  */ 
-void ForwardAttributeWriteMessage(coap_string_t* uri_path, char payload[])
+static bool PrepareAttributeWrite(coap_string_t* uri_path, const char* payload, size_t size, BindingCommandData& data)
 {
     // Convert the URI where the request was made into a string
     std::string uri = std::string(reinterpret_cast<const char*>(uri_path->s), uri_path->length);
@@ -53,117 +232,825 @@ void ForwardAttributeWriteMessage(coap_string_t* uri_path, char payload[])
     int resource_id = std::stoi(split_string.at(2));
     
     // Determine the cluster and the attribute id from the object and the resource id using the mapper structure
-    std::cout << "Got request on object id: " << object_id << " and resource id: " << resource_id << std::endl;
+    BRIDGE_LOG_DETAIL("CoAP Server: Request on object %" PRIu32 " resource %" PRIu32, object_id, resource_id);
     int cluster_id = coap_mapping.cluster_object_map.get_matter_id(object_id);
     int attribute_id = coap_mapping.attribute_resource_map.get_matter_id(resource_id);
-    std::cout << "Sending request to cluster: " << cluster_id << " with attribute: " << attribute_id << std::endl;
+    BRIDGE_LOG_DETAIL("CoAP Server: Forwarding to cluster 0x%" PRIx32 " attribute 0x%" PRIx32, cluster_id, attribute_id);
 
     // Prepare the data
-    BindingCommandData * data = chip::Platform::New<BindingCommandData>();
-    data->attributeId         = attribute_id;
-    data->clusterId           = cluster_id;
-    data->writeAttribute      = true;
+    data.localEndpointId = GetInstanceEndpoint(split_string);
+    data.attributeId     = attribute_id;
+    data.clusterId       = cluster_id;
+    data.writeAttribute  = true;
+
+    // The type of the LwM2M resource decides how the payload is encoded
+    // This way the Matter attribute is written without any type specific code
+    CHIP_ERROR err = data.value.EncodeLwm2mText(type_map.at(uri), payload, size);
+    coap_delete_string(uri_path);
+    VerifyOrReturnValue(err == CHIP_NO_ERROR, false,
+                        ChipLogError(DeviceLayer, "CoAP Server: Cannot encode value: %" CHIP_ERROR_FORMAT, err.Format()));
+    return true;
+}
+
+/**
+ * Function used to convert a TLV element into its JSON representation
+ * The fields of structures are keyed by their context tags, byte strings are hex encoded
+ */
+static CHIP_ERROR TlvToJson(chip::TLV::TLVReader & reader, nlohmann::json & value)
+{
+    using namespace chip::TLV;
+
+    switch (reader.GetType()) {
+    case kTLVType_Boolean: {
+        bool v;
+        ReturnErrorOnFailure(reader.Get(v));
+        value = v;
+        return CHIP_NO_ERROR;
+    }
+    case kTLVType_SignedInteger: {
+        int64_t v;
+        ReturnErrorOnFailure(reader.Get(v));
+        value = v;
+        return CHIP_NO_ERROR;
+    }
+    case kTLVType_UnsignedInteger: {
+        uint64_t v;
+        ReturnErrorOnFailure(reader.Get(v));
+        value = v;
+        return CHIP_NO_ERROR;
+    }
+    case kTLVType_FloatingPointNumber: {
+        double v;
+        ReturnErrorOnFailure(reader.Get(v));
+        value = v;
+        return CHIP_NO_ERROR;
+    }
+    case kTLVType_UTF8String: {
+        chip::CharSpan v;
+        ReturnErrorOnFailure(reader.Get(v));
+        value = std::string(v.data(), v.size());
+        return CHIP_NO_ERROR;
+    }
+    case kTLVType_ByteString: {
+        chip::ByteSpan v;
+        ReturnErrorOnFailure(reader.Get(v));
+        std::string hex;
+        char byte[3];
+        for (uint8_t b : v) {
+            snprintf(byte, sizeof(byte), "%02x", b);
+            hex += byte;
+        }
+        value = hex;
+        return CHIP_NO_ERROR;
+    }
+    case kTLVType_Null:
+        value = nullptr;
+        return CHIP_NO_ERROR;
+    case kTLVType_Structure:
+    case kTLVType_Array:
+    case kTLVType_List: {
+        bool is_structure = reader.GetType() == kTLVType_Structure;
+        value = is_structure ? nlohmann::json::object() : nlohmann::json::array();
+        TLVType container;
+        ReturnErrorOnFailure(reader.EnterContainer(container));
+        CHIP_ERROR err;
+        while ((err = reader.Next()) == CHIP_NO_ERROR) {
+            nlohmann::json element;
+            ReturnErrorOnFailure(TlvToJson(reader, element));
+            if (is_structure && IsContextTag(reader.GetTag())) {
+                value[std::to_string(TagNumFromTag(reader.GetTag()))] = element;
+            } else if (is_structure) {
+                value[std::to_string(value.size())] = element;
+            } else {
+                value.push_back(element);
+            }
+        }
+        VerifyOrReturnError(err == CHIP_END_OF_TLV, err);
+        return reader.ExitContainer(container);
+    }
+    default:
+        return CHIP_ERROR_WRONG_TLV_TYPE;
+    }
+}
+
+// Longest text representation of an attribute value, byte strings are hex encoded and floats need up to 24 characters
+static constexpr size_t kMaxAttributeTextLength = std::max<size_t>(2 * kMaxAttributeValueSize, 24) + 1;
 
-    // Depending on the type we set the type of our data
-    // This way the Matter function will be invoked with the correct type
-    if (type_map.at(uri) == "Boolean") {
-        data->data = *reinterpret_cast<bool*>(payload);
-    } else if (type_map.at(uri) == "Unsigned Integer") {
-        data->data = *reinterpret_cast<uint16_t*>(payload);
+/**
+ * Function used to write the text representation of an attribute value into a buffer
+ * Booleans are written as 0 or 1 and strings without quotes, as in the LwM2M plain text format
+ */
+static size_t FormatAttributeValue(const TlvValue & value, char * buffer, size_t buf_len)
+{
+    chip::TLV::TLVReader reader;
+    nlohmann::json json;
+    VerifyOrReturnValue(buf_len > 0, 0);
+    VerifyOrReturnValue(value.GetReader(reader) == CHIP_NO_ERROR && TlvToJson(reader, json) == CHIP_NO_ERROR, 0,
+                        ChipLogError(DeviceLayer, "CoAP Server: Cannot decode attribute value"));
+
+    std::string text;
+    if (json.is_string()) {
+        text = json.get_ref<const std::string &>();
+    } else if (json.is_boolean()) {
+        text = json.get<bool>() ? "1" : "0";
+    } else {
+        text = json.dump();
     }
+    size_t len = std::min(text.size(), buf_len - 1);
+    memcpy(buffer, text.data(), len);
+    buffer[len] = '\0';
+    return len;
+}
 
-    // Schedule sending of the command
-    chip::DeviceLayer::PlatformMgr().ScheduleWork(SwitchWorkerFunction, reinterpret_cast<intptr_t>(data));
+/**
+ * Function used to add an attribute value as the payload of a response
+ */
+static void AddAttributeValue(coap_pdu_t * pdu, const TlvValue & value)
+{
+    char buf[kMaxAttributeTextLength];
+    unsigned char opt[4];
+    size_t len = FormatAttributeValue(value, buf, sizeof(buf));
+
+    coap_pdu_set_code(pdu, COAP_RESPONSE_CODE_CONTENT);
+    coap_add_option(pdu, COAP_OPTION_CONTENT_FORMAT, coap_encode_var_safe(opt, sizeof(opt), COAP_MEDIATYPE_TEXT_PLAIN), opt);
+    coap_add_option(pdu, COAP_OPTION_MAXAGE, coap_encode_var_safe(opt, sizeof(opt), 0x01), opt);
+    coap_add_data(pdu, len, reinterpret_cast<const uint8_t *>(buf));
 }
 
 /**
- * Function used to forward messages based on the uri of the resource that was accessed
- * This function is used in combination with a CoAP resource handler
+ * Function used to fill the response to the read of an attribute
  */
-void ForwardAttributeReadMessage(coap_string_t* uri_path, uint8_t* buffer, size_t buf_len, size_t& size)
+static void AddAttributeReadResponse(coap_pdu_t * pdu, const AttributeRead & read)
 {
-    // Convert the URI where the request was made into a string
+    if (read.value.has_value()) {
+        AddAttributeValue(pdu, *read.value);
+    } else {
+        SetErrorResponse(pdu, COAP_RESPONSE_CODE_BAD_GATEWAY);
+    }
+}
+
+/**
+ * Function used to record a read of an attribute and to return it to the pool, once it has been answered
+ */
+static void FinishAttributeRead(AttributeRead * read)
+{
+    DeferredResponse & deferred = read->deferred;
+    BridgeLatencyEnd(BridgePath::kCoapRead, deferred.start_us, read->value.has_value());
+    BridgeTraceSpan(deferred.trace_id, "coap.read", deferred.start_us);
+    ReleaseDeferredResponse(deferred);
+    attribute_read_pool.Release(read);
+}
+
+/**
+ * Function used to send the separate response to the read of an attribute
+ * Must be called from the task that processes the CoAP I/O
+ */
+static void SendAttributeReadResponse(AttributeRead * read)
+{
+    DeferredResponse & deferred = read->deferred;
+    coap_pdu_t * pdu = coap_pdu_init(deferred.type, COAP_RESPONSE_CODE_CONTENT, coap_new_message_id(deferred.session),
+                                     coap_session_max_pdu_size(deferred.session));
+    if (pdu) {
+        coap_add_token(pdu, deferred.token->length, deferred.token->s);
+        AddAttributeReadResponse(pdu, *read);
+        if (coap_send(deferred.session, pdu) == COAP_INVALID_MID) {
+            ChipLogError(DeviceLayer, "CoAP Server: Cannot send separate response");
+        }
+    } else {
+        ChipLogError(DeviceLayer, "CoAP Server: Cannot create separate response PDU");
+    }
+    FinishAttributeRead(read);
+}
+
+/**
+ * Function used to collect the result of the read of an attribute
+ * Called on the Matter event loop, the value is a nullptr if the read interaction failed
+ */
+static void CompleteAttributeRead(void * context, const TlvValue * value)
+{
+    AttributeRead * read = static_cast<AttributeRead *>(context);
+    if (value) {
+        read->value = *value;
+    }
+    VerifyOrReturn(read->pending.fetch_sub(1) == 1);
+
+#if CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+    SendAttributeReadResponse(read);
+#else
+    // The ring holds at least as many entries as the pool, so it cannot be full
+    AttributeRead ** completed = completed_attribute_reads.Acquire();
+    VerifyOrDie(completed != nullptr);
+    *completed = read;
+    completed_attribute_reads.Commit();
+#endif
+}
+
+/**
+ * Function used to forward a read request without waiting for its result
+ * If the attribute shadow holds the value, the response is filled directly
+ * Otherwise the response code is left unset, so libcoap only acknowledges the request and the value is sent separately
+ */
+void ForwardAttributeReadMessage(coap_session_t * session, const coap_pdu_t * request, coap_pdu_t * response)
+{
+    int64_t start_us = BridgeLatencyBegin(BridgePath::kCoapRead);
+    coap_string_t * uri_path = coap_get_uri_path(request);
     std::string uri = std::string(reinterpret_cast<const char*>(uri_path->s), uri_path->length);
+    coap_delete_string(uri_path);
     // Split the string into their ids.
     // The URI should always compose of three IDs, the first being the object and the last being the resource
     std::vector<std::string> split_string = SplitString(uri, '/');
     int object_id = std::stoi(split_string.at(0));
     int resource_id = std::stoi(split_string.at(2));
-    
+
     // Determine the cluster and the attribute id from the object and the resource id using the mapper structure
-    std::cout << "Got request on object id: " << object_id << " and resource id: " << resource_id << std::endl;
+    BRIDGE_LOG_DETAIL("CoAP Server: Request on object %" PRIu32 " resource %" PRIu32, object_id, resource_id);
     int cluster_id = coap_mapping.cluster_object_map.get_matter_id(object_id);
     int attribute_id = coap_mapping.attribute_resource_map.get_matter_id(resource_id);
-    std::cout << "Sending request to cluster: " << cluster_id << " with attribute: " << attribute_id << std::endl;
+    EndpointId endpoint_id = GetInstanceEndpoint(split_string);
+    if (endpoint_id == kInvalidEndpointId) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_NOT_FOUND);
+        BridgeLatencyEnd(BridgePath::kCoapRead, start_us, false);
+        return;
+    }
+
+    // Answer from the attribute shadow if the device the endpoint is bound to reports the attribute
+    TlvValue value;
+    if (GetShadowAttribute(endpoint_id, cluster_id, attribute_id, value)) {
+        AddAttributeValue(response, value);
+        BridgeLatencyEnd(BridgePath::kCoapRead, start_us, true);
+        return;
+    }
+    BRIDGE_LOG_DETAIL("CoAP Server: Forwarding to cluster 0x%" PRIx32 " attribute 0x%" PRIx32, cluster_id, attribute_id);
+
+    // Keep everything that is needed to answer the request later on
+    AttributeRead * read = attribute_read_pool.Allocate();
+    if (read == nullptr) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE);
+        BridgeLatencyEnd(BridgePath::kCoapRead, start_us, false);
+        return;
+    }
+    DeferResponse(read->deferred, session, request, start_us);
 
     // Prepare the data
-    BindingCommandData * data = chip::Platform::New<BindingCommandData>();
-    data->attributeId         = attribute_id;
-    data->clusterId           = cluster_id;
-    data->readAttribute       = true;
-
-    // Depending on the type we set the type of our data
-    // This way the Matter function will be invoked with the correct type
-    if (type_map.at(uri) == "Boolean") {
-        data->data = *reinterpret_cast<bool*>(buffer);
-    } else if (type_map.at(uri) == "Unsigned Integer") {
-        data->data = *reinterpret_cast<uint16_t*>(buffer);
-    }
-
-    // Schedule sending of the command
-    chip::DeviceLayer::PlatformMgr().ScheduleWork(SwitchWorkerFunction, reinterpret_cast<intptr_t>(data));
-
-    // Afterwards we wait for the response of the command and write it to the buffer
-    int tries = 10;
-    // Wait for the response
-    while (tries > 0) {
-        // Wait 5 seconds after each try
-        std::this_thread::sleep_for(std::chrono::seconds(5));
-        // We check the contents of a global pointer that will contain the result
-        if (result_ptr != nullptr)
-        {
-            if (std::holds_alternative<uint16_t>(*result_ptr))
-            {
-                size = snprintf((char *)buffer, buf_len, std::to_string(std::get<uint16_t>(*result_ptr)).c_str());
-                break;
-            } else if (std::holds_alternative<bool>(*result_ptr)) {
-                size = snprintf((char *)buffer, buf_len, std::to_string(std::get<bool>(*result_ptr)).c_str());
-                break;
-            }
+    BindingCommandData data;
+    data.localEndpointId = endpoint_id;
+    data.attributeId     = attribute_id;
+    data.clusterId       = cluster_id;
+    data.readAttribute   = true;
+    data.onReadComplete  = CompleteAttributeRead;
+    data.readContext     = read;
+
+    // The last reference answers the request, nothing has been handed to the Matter event loop if the dispatch fails
+    uint8_t references = DispatchBindingCommand(data) == CHIP_NO_ERROR ? 1 : 2;
+    if (read->pending.fetch_sub(references) == references) {
+        AddAttributeReadResponse(response, *read);
+        FinishAttributeRead(read);
+    }
+}
+
+/**
+ * Function used to encode the payload of a command request as the fields of a Matter command
+ * The payload is a JSON object whose keys are the context tags of the fields
+ */
+static CHIP_ERROR EncodeCommandFields(const uint8_t * payload, size_t size, TlvValue & fields)
+{
+    nlohmann::json json = nlohmann::json::parse(payload, payload + size, nullptr, false);
+    VerifyOrReturnError(!json.is_discarded() && json.is_object(), CHIP_ERROR_INVALID_ARGUMENT);
+
+    chip::TLV::TLVWriter writer;
+    chip::TLV::TLVType container;
+    writer.Init(fields.buffer, sizeof(fields.buffer));
+    ReturnErrorOnFailure(writer.StartContainer(chip::TLV::AnonymousTag(), chip::TLV::kTLVType_Structure, container));
+    for (const auto & field : json.items()) {
+        char * end = nullptr;
+        unsigned long tag = strtoul(field.key().c_str(), &end, 10);
+        VerifyOrReturnError(*end == '\0' && tag <= UINT8_MAX, CHIP_ERROR_INVALID_ARGUMENT);
+        const nlohmann::json & v = field.value();
+        if (v.is_boolean()) {
+            ReturnErrorOnFailure(writer.Put(chip::TLV::ContextTag(static_cast<uint8_t>(tag)), v.get<bool>()));
+        } else if (v.is_number_unsigned()) {
+            ReturnErrorOnFailure(writer.Put(chip::TLV::ContextTag(static_cast<uint8_t>(tag)), v.get<uint64_t>()));
+        } else if (v.is_number_integer()) {
+            ReturnErrorOnFailure(writer.Put(chip::TLV::ContextTag(static_cast<uint8_t>(tag)), v.get<int64_t>()));
+        } else if (v.is_number_float()) {
+            ReturnErrorOnFailure(writer.Put(chip::TLV::ContextTag(static_cast<uint8_t>(tag)), v.get<float>()));
+        } else if (v.is_string()) {
+            const std::string & str = v.get_ref<const std::string &>();
+            ReturnErrorOnFailure(writer.PutString(chip::TLV::ContextTag(static_cast<uint8_t>(tag)), chip::CharSpan(str.data(), str.size())));
+        } else {
+            return CHIP_ERROR_INVALID_ARGUMENT;
         }
-        
-        tries--;
     }
-    // Reset the result pointer
-    result_ptr = nullptr;
+    ReturnErrorOnFailure(writer.EndContainer(container));
+    ReturnErrorOnFailure(writer.Finalize());
+    fields.length = static_cast<uint8_t>(writer.GetLengthWritten());
+    return CHIP_NO_ERROR;
 }
 
 /**
- * Function used to forward messages based on the uri of the resource that was accessed 
- * This function is used in combination with a CoAP resource handler
+ * Function used to set the response code of a forwarded command or write, unless an interaction has already failed
  */
-void ForwardCommandMessage(coap_string_t* uri_path)
+static void SetCommandResponseCode(CommandResponse & command, coap_pdu_code_t code)
 {
-    // Convert the URI where the request was made into a string
+    coap_pdu_code_t expected = COAP_RESPONSE_CODE_CHANGED;
+    command.code.compare_exchange_strong(expected, code);
+}
+
+/**
+ * Function used to fill the response of a forwarded command or write
+ */
+static void AddCommandResponse(coap_pdu_t * pdu, const CommandResponse & command)
+{
+    coap_pdu_code_t code = command.code.load();
+    if (COAP_RESPONSE_CLASS(code) == 2) {
+        coap_pdu_set_code(pdu, code);
+    } else {
+        SetErrorResponse(pdu, code);
+    }
+    if (command.length > 0) {
+        unsigned char opt[4];
+        coap_add_option(pdu, COAP_OPTION_CONTENT_FORMAT, coap_encode_var_safe(opt, sizeof(opt), COAP_MEDIATYPE_APPLICATION_JSON), opt);
+        coap_add_data(pdu, command.length, command.payload);
+    }
+}
+
+/**
+ * Function used to release a forwarded command or write once it has been answered
+ */
+static void FinishCommandResponse(CommandResponse * command)
+{
+    DeferredResponse & deferred = command->deferred;
+    BridgeLatencyEnd(command->path, deferred.start_us, COAP_RESPONSE_CLASS(command->code.load()) == 2);
+    BridgeTraceSpan(deferred.trace_id, command->span, deferred.start_us);
+    ReleaseDeferredResponse(deferred);
+    command_response_pool.Release(command);
+}
+
+/**
+ * Function used to send the separate response of a forwarded command or write
+ * Must be called from the task that processes the CoAP I/O
+ */
+static void SendCommandResponse(CommandResponse * command)
+{
+    DeferredResponse & deferred = command->deferred;
+    coap_pdu_t * pdu = coap_pdu_init(deferred.type, COAP_RESPONSE_CODE_CHANGED, coap_new_message_id(deferred.session),
+                                     coap_session_max_pdu_size(deferred.session));
+    if (pdu) {
+        coap_add_token(pdu, deferred.token->length, deferred.token->s);
+        AddCommandResponse(pdu, *command);
+        if (coap_send(deferred.session, pdu) == COAP_INVALID_MID) {
+            ChipLogError(DeviceLayer, "CoAP Server: Cannot send separate response");
+        }
+    } else {
+        ChipLogError(DeviceLayer, "CoAP Server: Cannot create separate response PDU");
+    }
+    FinishCommandResponse(command);
+}
+
+#if !CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+/**
+ * Function used to run the work that has been scheduled for the CoAP server task
+ * The server polls from the moment a reload has been requested until its work has run, see hnd_reload_post
+ */
+static void RunServerWork()
+{
+    void (*work)(intptr_t) = server_work.load(std::memory_order_acquire);
+    VerifyOrReturn(work != nullptr);
+    work(server_work_context);
+    server_work.store(nullptr, std::memory_order_release);
+    pending_responses.fetch_sub(1);
+}
+#endif
+
+/**
+ * Function used to collect the status and the response of a forwarded command or write
+ * Called on the Matter event loop, the response is sent by the task that processes the CoAP I/O
+ */
+static void CompleteForwardedCommand(void * context, chip::Protocols::InteractionModel::Status status, chip::TLV::TLVReader * response)
+{
+    CommandResponse * command = static_cast<CommandResponse *>(context);
+    SetCommandResponseCode(*command, ImStatusToCoapCode(status));
+
+    // The response fields are handed to the LwM2M caller as JSON, only commands have a single interaction with a response
+    nlohmann::json json;
+    if (response != nullptr && TlvToJson(*response, json) == CHIP_NO_ERROR) {
+        std::string payload = json.dump();
+        if (payload.size() <= sizeof(command->payload)) {
+            memcpy(command->payload, payload.data(), payload.size());
+            command->length = payload.size();
+        } else {
+            ChipLogError(DeviceLayer, "CoAP Server: Command response of %u bytes is too large", static_cast<unsigned>(payload.size()));
+        }
+    }
+    VerifyOrReturn(command->pending.fetch_sub(1) == 1);
+
+#if CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+    SendCommandResponse(command);
+#else
+    // The ring holds at least as many entries as the pool, so it cannot be full
+    CommandResponse ** slot = completed_commands.Acquire();
+    VerifyOrDie(slot != nullptr);
+    *slot = command;
+    completed_commands.Commit();
+#endif
+}
+
+/**
+ * Function used to take a forwarded command or write from the pool
+ * Returns nullptr if too many requests wait for their response
+ */
+static CommandResponse * AllocateCommandResponse(coap_session_t * session, const coap_pdu_t * request, int64_t start_us,
+                                                 BridgePath path, const char * span)
+{
+    CommandResponse * command = command_response_pool.Allocate();
+    VerifyOrReturnValue(command != nullptr, nullptr);
+    DeferResponse(command->deferred, session, request, start_us);
+    command->path = path;
+    command->span = span;
+    return command;
+}
+
+/**
+ * Function used to dispatch the interactions a forwarded command or write has been split into
+ * If every interaction has completed once they have been dispatched, e.g. because none could be dispatched, the response
+ * is filled directly. Otherwise the response code is left unset, so libcoap only acknowledges the request and the result
+ * is sent separately.
+ */
+static void DispatchCommandResponse(CommandResponse * command, BindingCommandData * commands, size_t count, coap_pdu_t * response)
+{
+    command->pending.store(static_cast<uint8_t>(count + 1));
+    uint8_t failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        commands[i].onCommandComplete = CompleteForwardedCommand;
+        commands[i].commandContext    = command;
+        if (DispatchBindingCommand(commands[i]) != CHIP_NO_ERROR) {
+            // Nothing has been handed to the Matter event loop, so no completion will arrive
+            SetCommandResponseCode(*command, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE);
+            failed++;
+        }
+    }
+    if (command->pending.fetch_sub(failed + 1) == failed + 1) {
+        AddCommandResponse(response, *command);
+        FinishCommandResponse(command);
+    }
+}
+
+/**
+ * Function used to forward a command request without waiting for its result
+ * The Matter status and the response fields are returned once the invoke interaction has finished
+ */
+void ForwardCommandMessage(coap_resource_t * resource, coap_session_t * session, const coap_pdu_t * request, coap_pdu_t * response)
+{
+    int64_t start_us = BridgeLatencyBegin(BridgePath::kCoapCommand);
+    coap_str_const_t * uri_path = coap_resource_get_uri_path(resource);
     std::string uri = std::string(reinterpret_cast<const char*>(uri_path->s), uri_path->length);
     // Split the string into their ids.
     // The URI should always compose of three IDs, the first being the object and the last being the resource
     std::vector<std::string> split_string = SplitString(uri, '/');
     int object_id = std::stoi(split_string.at(0));
     int resource_id = std::stoi(split_string.at(2));
-    
-    std::cout << "Got request on object id: " << object_id << " and resource id: " << resource_id << std::endl;
-    int cluster_id = coap_mapping.cluster_object_map.get_matter_id(object_id);
-    int command_id = coap_mapping.command_resource_map.get_matter_id(resource_id);
-    std::cout << "Sending request to cluster: " << cluster_id << " with command: " << command_id << std::endl;
 
     // Prepare the data
-    BindingCommandData * data = chip::Platform::New<BindingCommandData>();
-    data->commandId           = command_id;
-    data->clusterId           = cluster_id;
+    BindingCommandData data;
+    data.localEndpointId = GetInstanceEndpoint(split_string);
+    data.commandId       = coap_mapping.command_resource_map.get_matter_id(resource_id);
+    data.clusterId       = coap_mapping.cluster_object_map.get_matter_id(object_id);
+    if (data.localEndpointId == kInvalidEndpointId) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_NOT_FOUND);
+        BridgeLatencyEnd(BridgePath::kCoapCommand, start_us, false);
+        return;
+    }
+
+    // The payload carries the fields of the command
+    size_t size;
+    const uint8_t * payload;
+    if (coap_get_data(request, &size, &payload) && size > 0 && EncodeCommandFields(payload, size, data.value) != CHIP_NO_ERROR) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+        BridgeLatencyEnd(BridgePath::kCoapCommand, start_us, false);
+        return;
+    }
+
+    // Keep everything that is needed to answer the request later on
+    CommandResponse * command = AllocateCommandResponse(session, request, start_us, BridgePath::kCoapCommand, "coap.command");
+    if (command == nullptr) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE);
+        BridgeLatencyEnd(BridgePath::kCoapCommand, start_us, false);
+        return;
+    }
+    DispatchCommandResponse(command, &data, 1, response);
+}
+
+// Maximum number of resources that are read or written with an object instance
+constexpr size_t kMaxObjectResources = 32;
+// Maximum number of batched reads or writes needed for an object instance
+constexpr size_t kMaxObjectCommands = (kMaxObjectResources + kMaxBatchAttributes - 1) / kMaxBatchAttributes;
+
+// Read of an object instance that is answered once every resource has been read
+struct ObjectRead
+{
+    // Context handed to the completion callback of a single resource
+    struct Slot
+    {
+        ObjectRead * read;
+        size_t index;
+    };
+
+    int object_id;
+    int instance_id;
+    // Local endpoint whose bindings serve the object instance
+    EndpointId endpoint_id;
+    size_t resource_count = 0;
+    int resource_ids[kMaxObjectResources];
+    std::optional<TlvValue> values[kMaxObjectResources];
+    Slot slots[kMaxObjectResources];
+    // Resources that have not been read, the CoAP handler holds one more until it has dispatched every read
+    std::atomic<size_t> pending{ 1 };
+    // The response is sent separately unless every value is known once the reads have been dispatched
+    DeferredResponse response;
+};
+
+// Reads of object instances are kept in a pool, so their contexts do not fragment the heap
+static ObjectPool<ObjectRead, CONFIG_BRIDGE_OBJECT_READ_POOL_SIZE> object_read_pool("object_read");
+
+#if !CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+// Reads of object instances that have been completed on the Matter event loop and are answered by the CoAP server task
+static SpscRing<ObjectRead *, CompletedCommandsCapacity(CONFIG_BRIDGE_OBJECT_READ_POOL_SIZE)> completed_object_reads;
+#endif
+
+/**
+ * Function used to add an attribute value to a SenML record
+ * Numbers are added as "v", booleans as "vb" and strings as "vs", byte strings are hex encoded
+ */
+static bool AddSenmlValue(nlohmann::json & record, const TlvValue & value)
+{
+    chip::TLV::TLVReader reader;
+    nlohmann::json json;
+    VerifyOrReturnValue(value.GetReader(reader) == CHIP_NO_ERROR && TlvToJson(reader, json) == CHIP_NO_ERROR, false);
+    if (json.is_number()) {
+        record["v"] = json;
+    } else if (json.is_boolean()) {
+        record["vb"] = json;
+    } else if (json.is_string()) {
+        record["vs"] = json;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Function used to encode the values of an object instance as SenML JSON
+ * Resources that could not be read are left out
+ */
+static std::string EncodeObjectValues(const ObjectRead & read)
+{
+    nlohmann::json records = nlohmann::json::array();
+    for (size_t i = 0; i < read.resource_count; i++) {
+        if (!read.values[i].has_value()) {
+            continue;
+        }
+        nlohmann::json record;
+        if (!AddSenmlValue(record, *read.values[i])) {
+            continue;
+        }
+        if (records.empty()) {
+            record["bn"] = "/" + std::to_string(read.object_id) + "/" + std::to_string(read.instance_id) + "/";
+        }
+        record["n"] = std::to_string(read.resource_ids[i]);
+        records.push_back(record);
+    }
+    return records.empty() ? std::string() : records.dump();
+}
+
+/**
+ * Function used to fill the response to the read of an object instance
+ */
+static void AddObjectValues(coap_pdu_t * pdu, const ObjectRead & read)
+{
+    std::string payload = EncodeObjectValues(read);
+    if (payload.empty()) {
+        SetErrorResponse(pdu, COAP_RESPONSE_CODE_BAD_GATEWAY);
+        return;
+    }
+
+    unsigned char opt[4];
+    coap_pdu_set_code(pdu, COAP_RESPONSE_CODE_CONTENT);
+    coap_add_option(pdu, COAP_OPTION_CONTENT_FORMAT, coap_encode_var_safe(opt, sizeof(opt), COAP_MEDIATYPE_APPLICATION_SENML_JSON), opt);
+    coap_add_option(pdu, COAP_OPTION_MAXAGE, coap_encode_var_safe(opt, sizeof(opt), 0x01), opt);
+    coap_add_data(pdu, payload.size(), reinterpret_cast<const uint8_t *>(payload.data()));
+}
+
+/**
+ * Function used to release the read of an object instance once it has been answered
+ */
+static void FinishObjectRead(ObjectRead * read, bool success)
+{
+    DeferredResponse & deferred = read->response;
+    BridgeLatencyEnd(BridgePath::kCoapRead, deferred.start_us, success);
+    BridgeTraceSpan(deferred.trace_id, "coap.object_read", deferred.start_us);
+    ReleaseDeferredResponse(deferred);
+    object_read_pool.Release(read);
+}
+
+/**
+ * Function used to send the separate response to the read of an object instance
+ * Must be called from the task that processes the CoAP I/O
+ */
+static void SendObjectReadResponse(ObjectRead * read)
+{
+    DeferredResponse & deferred = read->response;
+    bool success = false;
+    coap_pdu_t * pdu = coap_pdu_init(deferred.type, COAP_RESPONSE_CODE_CONTENT, coap_new_message_id(deferred.session),
+                                     coap_session_max_pdu_size(deferred.session));
+    if (pdu) {
+        coap_add_token(pdu, deferred.token->length, deferred.token->s);
+        AddObjectValues(pdu, *read);
+        success = coap_pdu_get_code(pdu) == COAP_RESPONSE_CODE_CONTENT;
+        if (coap_send(deferred.session, pdu) == COAP_INVALID_MID) {
+            ChipLogError(DeviceLayer, "CoAP Server: Cannot send separate response");
+        }
+    } else {
+        ChipLogError(DeviceLayer, "CoAP Server: Cannot create separate response PDU");
+    }
+    FinishObjectRead(read, success);
+}
+
+#if !CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+/**
+ * Function used to answer every command, write and read that has been completed on the Matter event loop
+ */
+static void SendCompletedResponses()
+{
+    while (CommandResponse ** command = completed_commands.Front()) {
+        SendCommandResponse(*command);
+        completed_commands.Pop();
+    }
+    while (AttributeRead ** read = completed_attribute_reads.Front()) {
+        SendAttributeReadResponse(*read);
+        completed_attribute_reads.Pop();
+    }
+    while (ObjectRead ** read = completed_object_reads.Front()) {
+        SendObjectReadResponse(*read);
+        completed_object_reads.Pop();
+    }
+}
+#endif
+
+/**
+ * Function used to collect the result of a single resource of an object instance read
+ * Called on the Matter event loop, the value is a nullptr if the read interaction failed
+ */
+static void CompleteObjectReadResource(void * context, const TlvValue * value)
+{
+    ObjectRead::Slot * slot = static_cast<ObjectRead::Slot *>(context);
+    ObjectRead * read = slot->read;
+    if (value) {
+        read->values[slot->index] = *value;
+    }
+    VerifyOrReturn(read->pending.fetch_sub(1) == 1);
 
-    // Schedule sending of the command
-    chip::DeviceLayer::PlatformMgr().ScheduleWork(SwitchWorkerFunction, reinterpret_cast<intptr_t>(data));
+#if CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+    SendObjectReadResponse(read);
+#else
+    // The ring holds at least as many entries as the pool, so it cannot be full
+    ObjectRead ** completed = completed_object_reads.Acquire();
+    VerifyOrDie(completed != nullptr);
+    *completed = read;
+    completed_object_reads.Commit();
+#endif
+}
+
+/**
+ * Function used to read every resource of an object instance
+ * Shadowed values are taken directly, the remaining attributes are read with a single batched interaction per
+ * kMaxBatchAttributes resources. Returns true if every read has completed once they have been dispatched,
+ * otherwise the last completion answers the request.
+ */
+static bool DispatchObjectRead(ObjectRead * read, const std::vector<int> & resources)
+{
+    int cluster_id = coap_mapping.cluster_object_map.get_matter_id(read->object_id);
+    BindingCommandData commands[kMaxObjectCommands];
+    size_t command_count = 0;
+
+    if (resources.size() > kMaxObjectResources) {
+        ChipLogError(DeviceLayer, "CoAP Server: Only the first %u resources of object %d are read",
+                     static_cast<unsigned>(kMaxObjectResources), read->object_id);
+    }
+    read->resource_count = std::min(resources.size(), kMaxObjectResources);
+    std::copy_n(resources.begin(), read->resource_count, read->resource_ids);
+    for (size_t i = 0; i < read->resource_count; i++) {
+        int attribute_id = coap_mapping.attribute_resource_map.get_matter_id(resources[i]);
+        TlvValue value;
+        if (attribute_id < 0) {
+            continue;
+        }
+        if (GetShadowAttribute(read->endpoint_id, cluster_id, attribute_id, value)) {
+            read->values[i] = value;
+            continue;
+        }
+
+        if (command_count == 0 || commands[command_count - 1].batch.count == kMaxBatchAttributes) {
+            commands[command_count].localEndpointId = read->endpoint_id;
+            commands[command_count].clusterId       = cluster_id;
+            commands[command_count].readAttribute   = true;
+            command_count++;
+        }
+        AttributeBatch & batch = commands[command_count - 1].batch;
+        read->slots[i]                    = { read, i };
+        batch.attributeIds[batch.count]   = attribute_id;
+        batch.onReadComplete[batch.count] = CompleteObjectReadResource;
+        batch.readContexts[batch.count]   = &read->slots[i];
+        batch.count++;
+        read->pending++;
+    }
+
+    // Resources whose read cannot be dispatched are left out of the response
+    size_t failed = 0;
+    for (size_t c = 0; c < command_count; c++) {
+        if (DispatchBindingCommand(commands[c]) != CHIP_NO_ERROR) {
+            failed += commands[c].batch.count;
+        }
+    }
+    return read->pending.fetch_sub(failed + 1) == failed + 1;
+}
+
+/**
+ * Function used to encode the value of a SenML record according to the type of the LwM2M resource
+ */
+static bool EncodeSenmlValue(const std::string & type, const nlohmann::json & record, TlvValue & value)
+{
+    CHIP_ERROR err = CHIP_ERROR_INVALID_ARGUMENT;
+    if (type == "Boolean" && record.contains("vb") && record["vb"].is_boolean()) {
+        err = value.EncodeBoolean(record["vb"].get<bool>());
+    } else if (type == "Unsigned Integer" && record.contains("v") && record["v"].is_number_unsigned()) {
+        err = value.EncodeUnsigned(record["v"].get<uint64_t>());
+    } else if ((type == "Integer" || type == "Time") && record.contains("v") && record["v"].is_number_integer()) {
+        err = value.EncodeSigned(record["v"].get<int64_t>());
+    } else if (type == "Float" && record.contains("v") && record["v"].is_number()) {
+        err = value.EncodeFloat(record["v"].get<float>());
+    } else if (type == "String" && record.contains("vs") && record["vs"].is_string()) {
+        const std::string & str = record["vs"].get_ref<const std::string &>();
+        err = value.EncodeString(str.data(), str.size());
+    }
+    return err == CHIP_NO_ERROR;
+}
+
+/**
+ * Function used to prepare the write of an object instance
+ * The payload contains SenML JSON records, all of them are written with batched write interactions
+ * Returns false if the payload could not be parsed
+ */
+static bool PrepareObjectWrite(const std::string & uri, const uint8_t * payload, size_t size, BindingCommandData * commands,
+                               size_t & command_count)
+{
+    nlohmann::json records = nlohmann::json::parse(payload, payload + size, nullptr, false);
+    if (records.is_discarded() || !records.is_array()) {
+        return false;
+    }
+
+    const ObjectInstanceResources & resources = object_map.at(uri);
+    std::vector<std::string> split_string = SplitString(uri, '/');
+    int object_id = std::stoi(split_string.at(0));
+    int cluster_id = coap_mapping.cluster_object_map.get_matter_id(object_id);
+    EndpointId endpoint_id = GetInstanceEndpoint(split_string);
+    std::string base_name;
+    command_count = 0;
+
+    for (const auto & record : records) {
+        if (!record.is_object()) {
+            return false;
+        }
+        if (record.contains("bn") && record["bn"].is_string()) {
+            base_name = record["bn"].get<std::string>();
+        }
+        std::string name = base_name + record.value("n", std::string());
+        int resource_id = std::atoi(name.substr(name.find_last_of('/') + 1).c_str());
+        int attribute_id = coap_mapping.attribute_resource_map.get_matter_id(resource_id);
+        if (attribute_id < 0 || std::find(resources.writable.begin(), resources.writable.end(), resource_id) == resources.writable.end()) {
+            return false;
+        }
+
+        // The type of the LwM2M resource decides which type the Matter attribute is written with
+        TlvValue value;
+        if (!EncodeSenmlValue(type_map.at(uri + "/" + std::to_string(resource_id)), record, value)) {
+            return false;
+        }
+
+        if (command_count == 0 || commands[command_count - 1].batch.count == kMaxBatchAttributes) {
+            if (command_count == kMaxObjectCommands) {
+                return false;
+            }
+            commands[command_count].localEndpointId = endpoint_id;
+            commands[command_count].clusterId       = cluster_id;
+            commands[command_count].writeAttribute  = true;
+            command_count++;
+        }
+        AttributeBatch & batch = commands[command_count - 1].batch;
+        batch.attributeIds[batch.count] = attribute_id;
+        batch.values[batch.count]       = value;
+        batch.count++;
+    }
+    return command_count > 0;
 }
 
 /**
@@ -173,20 +1060,14 @@ void hnd_attribute_get(coap_resource_t *resource, coap_session_t  *session,
              const coap_pdu_t *request, const coap_string_t *query,
              coap_pdu_t *response) {
 
-    unsigned char buf[40];
-    size_t response_len;
+    BridgeTraceScope trace(GetRequestTraceId(request), "coap.attribute_get");
 
     (void)resource;
-    (void)session;
-    (void)request;
-
-    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
-    coap_add_option(response, COAP_OPTION_CONTENT_FORMAT, coap_encode_var_safe(buf, sizeof(buf), COAP_MEDIATYPE_TEXT_PLAIN), buf);
-    coap_add_option(response, COAP_OPTION_MAXAGE, coap_encode_var_safe(buf, sizeof(buf), 0x01), buf);
-    
-    ForwardAttributeReadMessage(coap_get_uri_path(request), buf, sizeof(buf), response_len);
+    (void)query;
 
-    coap_add_data(response, response_len, buf);
+    // Reads must not block the CoAP I/O, unless the value is shadowed the response code is left
+    // unset so libcoap only acknowledges the request and the response is sent separately
+    ForwardAttributeReadMessage(session, request, response);
 }
 
 /**
@@ -198,45 +1079,343 @@ void hnd_attribute_put(coap_resource_t *resource, coap_session_t  *session,
 
     size_t size;
     const uint8_t *data;
+    int64_t start_us = BridgeLatencyBegin(BridgePath::kCoapWrite);
+    BridgeTraceScope trace(GetRequestTraceId(request), "coap.attribute_put");
 
-    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CHANGED);
-    coap_show_pdu(COAP_LOG_WARN, request);
+    BRIDGE_LOG_PDU("CoAP Server: PUT", request);
 
     if (coap_get_data(request, &size, &data)) {
-        // Copy the payload to a buffer (if needed)
-        char payload[size + 1];
-        memcpy(payload, data, size);
-        payload[size] = '\0';  // Null-terminate the payload for printing
+        BRIDGE_LOG_PAYLOAD("CoAP Server: PUT data", data, size);
+    } else {
+        BRIDGE_LOG_DETAIL("CoAP Server: PUT without data");
+        size = 0;
+        data = nullptr;
+    }
 
-        printf("Received PUT data: %s\n", payload);
-        ForwardAttributeWriteMessage(coap_get_uri_path(request), payload);
+    BindingCommandData command_data;
+    if (!PrepareAttributeWrite(coap_get_uri_path(request), reinterpret_cast<const char*>(data), size, command_data)) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+        BridgeLatencyEnd(BridgePath::kCoapWrite, start_us, false);
+        return;
+    }
+    if (command_data.localEndpointId == kInvalidEndpointId) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_NOT_FOUND);
+        BridgeLatencyEnd(BridgePath::kCoapWrite, start_us, false);
+        return;
+    }
 
-        // Process the payload as needed
-    } else {
-        printf("No data received in PUT request.\n");
-        char payload[0];
-        ForwardAttributeWriteMessage(coap_get_uri_path(request), payload);
+    // The response carries the status of the write interaction, it is sent separately once the interaction has finished
+    CommandResponse * command = AllocateCommandResponse(session, request, start_us, BridgePath::kCoapWrite, "coap.attribute_write");
+    if (command == nullptr) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE);
+        BridgeLatencyEnd(BridgePath::kCoapWrite, start_us, false);
+        return;
     }
-    
-    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CHANGED);
+    DispatchCommandResponse(command, &command_data, 1, response);
 }
 
 /**
  * Handler used for command PUT requests
+ * The Matter status and the command response are returned with a separate response
  */ 
 void hnd_command_put(coap_resource_t *resource, coap_session_t  *session,
              const coap_pdu_t *request, const coap_string_t *query,
              coap_pdu_t *response) {
 
-    (void)resource;
+    (void)query;
+    BridgeTraceScope trace(GetRequestTraceId(request), "coap.command_put");
+
+    ForwardCommandMessage(resource, session, request, response);
+}
+
+/**
+ * Handler used for object instance GET requests
+ * All resources of the object instance are read with as few Matter interactions as possible
+ */
+void hnd_object_get(coap_resource_t *resource, coap_session_t  *session,
+             const coap_pdu_t *request, const coap_string_t *query,
+             coap_pdu_t *response) {
+
+    coap_str_const_t * uri_path = coap_resource_get_uri_path(resource);
+    std::string uri = std::string(reinterpret_cast<const char*>(uri_path->s), uri_path->length);
+    int64_t start_us = BridgeLatencyBegin(BridgePath::kCoapRead);
+    BridgeTraceScope trace(GetRequestTraceId(request), "coap.object_get");
+
+    std::vector<std::string> split_string = SplitString(uri, '/');
+    EndpointId endpoint_id = GetInstanceEndpoint(split_string);
+    if (endpoint_id == kInvalidEndpointId) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_NOT_FOUND);
+        BridgeLatencyEnd(BridgePath::kCoapRead, start_us, false);
+        return;
+    }
+
+    ObjectRead * read = object_read_pool.Allocate();
+    if (read == nullptr) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE);
+        BridgeLatencyEnd(BridgePath::kCoapRead, start_us, false);
+        return;
+    }
+    read->object_id   = std::stoi(split_string.at(0));
+    read->instance_id = std::stoi(split_string.at(1));
+    read->endpoint_id = endpoint_id;
+
+    // Unless every value is known right away the response code is left unset, so libcoap only acknowledges the request
+    // and the response is sent separately. The CoAP I/O is never blocked by the reads.
+    DeferResponse(read->response, session, request, start_us);
+    if (DispatchObjectRead(read, object_map.at(uri).readable)) {
+        AddObjectValues(response, *read);
+        FinishObjectRead(read, coap_pdu_get_code(response) == COAP_RESPONSE_CODE_CONTENT);
+    }
+}
+
+/**
+ * Handler used for object instance PUT requests
+ */
+void hnd_object_put(coap_resource_t *resource, coap_session_t  *session,
+             const coap_pdu_t *request, const coap_string_t *query,
+             coap_pdu_t *response) {
+
+    size_t size;
+    const uint8_t *data;
+    coap_str_const_t * uri_path = coap_resource_get_uri_path(resource);
+    std::string uri = std::string(reinterpret_cast<const char*>(uri_path->s), uri_path->length);
+    int64_t start_us = BridgeLatencyBegin(BridgePath::kCoapWrite);
+    BridgeTraceScope trace(GetRequestTraceId(request), "coap.object_put");
+
+    BindingCommandData commands[kMaxObjectCommands];
+    size_t command_count;
+    if (!coap_get_data(request, &size, &data) || !PrepareObjectWrite(uri, data, size, commands, command_count)) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+        BridgeLatencyEnd(BridgePath::kCoapWrite, start_us, false);
+        return;
+    }
+    if (commands[0].localEndpointId == kInvalidEndpointId) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_NOT_FOUND);
+        BridgeLatencyEnd(BridgePath::kCoapWrite, start_us, false);
+        return;
+    }
+
+    // The response carries the status of the write interactions, it is sent separately once all of them have finished
+    CommandResponse * command = AllocateCommandResponse(session, request, start_us, BridgePath::kCoapWrite, "coap.object_write");
+    if (command == nullptr) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE);
+        BridgeLatencyEnd(BridgePath::kCoapWrite, start_us, false);
+        return;
+    }
+    DispatchCommandResponse(command, commands, command_count, response);
+}
+
+// Size of the buffer the metrics are encoded into
+constexpr size_t kMaxMetricsSize = 4096;
+
+/**
+ * Function used to free a large response once libcoap has sent the last block
+ */
+static void release_large_response(coap_session_t *session, void *app_ptr)
+{
     (void)session;
-    (void)request;
+    free(app_ptr);
+}
+
+/**
+ * Handler used for GET requests of the metrics resource
+ * The metrics are returned as a CBOR map, larger encodings are split into blocks by libcoap
+ */
+void hnd_metrics_get(coap_resource_t *resource, coap_session_t  *session,
+             const coap_pdu_t *request, const coap_string_t *query,
+             coap_pdu_t *response) {
+
+    uint8_t * buffer = static_cast<uint8_t *>(malloc(kMaxMetricsSize));
+    if (buffer == nullptr) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE);
+        return;
+    }
+    size_t length = EncodeBridgeMetrics(buffer, kMaxMetricsSize);
+    if (length == 0) {
+        ChipLogError(DeviceLayer, "CoAP Server: Metrics exceed %u bytes", static_cast<unsigned>(kMaxMetricsSize));
+        free(buffer);
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_INTERNAL_ERROR);
+        return;
+    }
+
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
+    coap_add_data_large_response(resource, session, request, response, query, COAP_MEDIATYPE_APPLICATION_CBOR, 0, 0, length,
+                                 buffer, release_large_response, buffer);
+}
+
+/**
+ * Function used to register the resource that exports the metrics of the bridge
+ */
+static void RegisterMetricsResource()
+{
+    resource = coap_resource_init(coap_make_str_const(".well-known/bridge-metrics"), 0);
 
-    ForwardCommandMessage(coap_get_uri_path(request));
+    coap_register_handler(resource, COAP_REQUEST_GET, hnd_metrics_get);
+    coap_add_attr(resource, coap_make_str_const("ct"), coap_make_str_const("60"), 0);
 
+    coap_add_resource(coap_ctx, resource);
+}
+
+/**
+ * Handler used for GET requests of the log resource
+ * The records of the bridge log are formatted when they are requested, one record per line
+ */
+void hnd_log_get(coap_resource_t *resource, coap_session_t  *session,
+             const coap_pdu_t *request, const coap_string_t *query,
+             coap_pdu_t *response) {
+
+    size_t size = GetBridgeLogExportSize();
+    char * buffer = static_cast<char *>(malloc(size));
+    if (buffer == nullptr) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE);
+        return;
+    }
+    size_t length = ExportBridgeLog(buffer, size);
+    if (length == 0) {
+        free(buffer);
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_INTERNAL_ERROR);
+        return;
+    }
+
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
+    coap_add_data_large_response(resource, session, request, response, query, COAP_MEDIATYPE_TEXT_PLAIN, 0, 0, length,
+                                 reinterpret_cast<const uint8_t *>(buffer), release_large_response, buffer);
+}
+
+/**
+ * Handler used for DELETE requests of the log resource, drops every record
+ */
+void hnd_log_delete(coap_resource_t *resource, coap_session_t  *session,
+             const coap_pdu_t *request, const coap_string_t *query,
+             coap_pdu_t *response) {
+
+    ClearBridgeLog();
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_DELETED);
+}
+
+/**
+ * Function used to register the resource that dumps the bridge log
+ */
+static void RegisterLogResource()
+{
+    resource = coap_resource_init(coap_make_str_const(".well-known/bridge-log"), 0);
+
+    coap_register_handler(resource, COAP_REQUEST_GET, hnd_log_get);
+    coap_register_handler(resource, COAP_REQUEST_DELETE, hnd_log_delete);
+    coap_add_attr(resource, coap_make_str_const("ct"), coap_make_str_const("0"), 0);
+
+    coap_add_resource(coap_ctx, resource);
+}
+
+#if CONFIG_BRIDGE_TRACE
+/**
+ * Handler used for GET requests of the trace resource
+ * The recorded spans are returned as Chrome trace event JSON, which can be opened in Perfetto
+ */
+void hnd_trace_get(coap_resource_t *resource, coap_session_t  *session,
+             const coap_pdu_t *request, const coap_string_t *query,
+             coap_pdu_t *response) {
+
+    size_t size = GetBridgeTraceExportSize();
+    char * buffer = static_cast<char *>(malloc(size));
+    if (buffer == nullptr) {
+        SetErrorResponse(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE);
+        return;
+    }
+    size_t length = ExportBridgeTrace(buffer, size);
+    if (length == 0) {
+        free(buffer);
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_INTERNAL_ERROR);
+        return;
+    }
+
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
+    coap_add_data_large_response(resource, session, request, response, query, COAP_MEDIATYPE_APPLICATION_JSON, 0, 0, length,
+                                 reinterpret_cast<const uint8_t *>(buffer), release_large_response, buffer);
+}
+
+/**
+ * Handler used for DELETE requests of the trace resource, drops every recorded span
+ */
+void hnd_trace_delete(coap_resource_t *resource, coap_session_t  *session,
+             const coap_pdu_t *request, const coap_string_t *query,
+             coap_pdu_t *response) {
+
+    ClearBridgeTrace();
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_DELETED);
+}
+
+/**
+ * Function used to register the resource that dumps the recorded trace spans
+ */
+static void RegisterTraceResource()
+{
+    resource = coap_resource_init(coap_make_str_const(".well-known/bridge-trace"), 0);
+
+    coap_register_handler(resource, COAP_REQUEST_GET, hnd_trace_get);
+    coap_register_handler(resource, COAP_REQUEST_DELETE, hnd_trace_delete);
+    coap_add_attr(resource, coap_make_str_const("ct"), coap_make_str_const("50"), 0);
+
+    coap_add_resource(coap_ctx, resource);
+}
+#endif
+
+/**
+ * Handler used for GET requests of the reload resource, returns the outcome of the last reload
+ */
+void hnd_reload_get(coap_resource_t *resource, coap_session_t  *session,
+             const coap_pdu_t *request, const coap_string_t *query,
+             coap_pdu_t *response) {
+
+    const char * status = GetBridgeReloadStatus();
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
+    coap_add_data(response, strlen(status), reinterpret_cast<const uint8_t *>(status));
+}
+
+/**
+ * Handler used for POST requests of the reload resource
+ * The configuration is reloaded in the background, its outcome can be polled with GET
+ */
+void hnd_reload_post(coap_resource_t *resource, coap_session_t  *session,
+             const coap_pdu_t *request, const coap_string_t *query,
+             coap_pdu_t *response) {
+
+    if (!StartBridgeReload()) {
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE);
+        return;
+    }
+#if !CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+    // The reload finishes with work on this task, the server polls until it has run
+    pending_responses.fetch_add(1);
+#endif
     coap_pdu_set_code(response, COAP_RESPONSE_CODE_CHANGED);
 }
 
+/**
+ * Function used to register the resource that reloads the configuration
+ */
+static void RegisterReloadResource()
+{
+    resource = coap_resource_init(coap_make_str_const(".well-known/bridge-reload"), 0);
+
+    coap_register_handler(resource, COAP_REQUEST_GET, hnd_reload_get);
+    coap_register_handler(resource, COAP_REQUEST_POST, hnd_reload_post);
+    coap_add_attr(resource, coap_make_str_const("ct"), coap_make_str_const("0"), 0);
+
+    coap_add_resource(coap_ctx, resource);
+}
+
+/**
+ * Function used to create a resource for a URI the caller does not keep, e.g. the buffer of a temporary std::string
+ * The resource owns a copy of the URI, libcoap frees it together with the resource
+ */
+static coap_resource_t * NewResource(const char* uri)
+{
+    coap_str_const_t * path = coap_new_str_const(reinterpret_cast<const uint8_t *>(uri), strlen(uri));
+    VerifyOrReturnValue(path != nullptr, nullptr);
+    return coap_resource_init(path, COAP_RESOURCE_FLAGS_RELEASE_URI);
+}
+
 /**
  * Function used to register a c attribute resource that can be read and written 
  */ 
@@ -244,7 +1423,8 @@ int RegisterAttributeRWResource(const char* uri, std::string& type)
 {
     type_map[uri] = type;
     /* Create a resource that the server can respond to with information */
-    resource = coap_resource_init(coap_make_str_const(uri), 0);
+    resource = NewResource(uri);
+    VerifyOrReturnValue(resource != nullptr, -1);
 
     coap_register_handler(resource, COAP_REQUEST_GET, hnd_attribute_get);
     coap_register_handler(resource, COAP_REQUEST_PUT, hnd_attribute_put);
@@ -261,7 +1441,8 @@ int RegisterAttributeResource(const char* uri, coap_request_t method, std::strin
 {
     type_map[uri] = type;
     /* Create a resource that the server can respond to with information */
-    resource = coap_resource_init(coap_make_str_const(uri), 0);
+    resource = NewResource(uri);
+    VerifyOrReturnValue(resource != nullptr, -1);
     if (method == COAP_REQUEST_GET) {
         coap_register_handler(resource, method, hnd_attribute_get);
     }
@@ -280,7 +1461,8 @@ int RegisterAttributeResource(const char* uri, coap_request_t method, std::strin
 int RegisterCommandResource(const char* uri)
 {
     /* Create a resource that the server can respond to with information */
-    resource = coap_resource_init(coap_make_str_const(uri), 0);
+    resource = NewResource(uri);
+    VerifyOrReturnValue(resource != nullptr, -1);
 
     coap_register_handler(resource, COAP_REQUEST_PUT, hnd_command_put);
     
@@ -289,6 +1471,77 @@ int RegisterCommandResource(const char* uri)
     return 0;
 }
 
+/**
+ * Function used to register an object instance ressource
+ */
+int RegisterObjectInstanceResource(const char* uri, std::vector<int>& readable_resources, std::vector<int>& writable_resources)
+{
+    object_map[uri] = { readable_resources, writable_resources };
+    /* Create a resource that the server can respond to with information */
+    resource = NewResource(uri);
+    VerifyOrReturnValue(resource != nullptr, -1);
+
+    if (!readable_resources.empty()) {
+        coap_register_handler(resource, COAP_REQUEST_GET, hnd_object_get);
+    }
+    if (!writable_resources.empty()) {
+        coap_register_handler(resource, COAP_REQUEST_PUT, hnd_object_put);
+    }
+
+    coap_add_resource(coap_ctx, resource);
+
+    return 0;
+}
+
+/**
+ * Function used to remove a ressource, its type and object instance entries are removed as well
+ */
+int UnregisterResource(const char* uri)
+{
+    type_map.erase(uri);
+    object_map.erase(uri);
+    coap_resource_t * existing = coap_get_resource_from_uri_path(coap_ctx, coap_make_str_const(uri));
+    VerifyOrReturnValue(existing != nullptr, -1);
+    coap_delete_resource(coap_ctx, existing);
+
+    return 0;
+}
+
+/**
+ * Function used to assign the local endpoint of a bridged LwM2M device to its object instance
+ */
+void SetCoapInstanceEndpoint(uint16_t instance_id, EndpointId endpoint)
+{
+    VerifyOrReturn(instance_id < CONFIG_BRIDGE_LWM2M_DEVICE_COUNT);
+    instance_endpoints[instance_id].store(endpoint, std::memory_order_relaxed);
+    assigned_instances.fetch_or(1u << instance_id, std::memory_order_release);
+}
+
+/**
+ * Function used to hand work over to the task that processes the CoAP I/O
+ */
+bool ScheduleCoapServerWork(void (*work)(intptr_t), intptr_t context)
+{
+#if CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+    return chip::DeviceLayer::PlatformMgr().ScheduleWork(work, context) == CHIP_NO_ERROR;
+#else
+    VerifyOrReturnValue(server_work.load(std::memory_order_acquire) == nullptr, false);
+    server_work_context = context;
+    server_work.store(work, std::memory_order_release);
+    return true;
+#endif
+}
+
+/**
+ * Function used to stop polling for server work that will never be scheduled
+ */
+void CancelCoapServerPoll()
+{
+#if !CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+    pending_responses.fetch_sub(1);
+#endif
+}
+
 /**
  * Function used to cleanup the CoAP server
  */
@@ -358,12 +1611,72 @@ int init_server(const char* ip_address)
     coap_join_mcast_group_intf(coap_ctx, COAP_LISTEN_MULTICAST_IPV6, NULL);
 #endif /* COAP_LISTEN_MULTICAST_IPV6 */
 
+    RegisterMetricsResource();
+    RegisterLogResource();
+    RegisterReloadResource();
+#if CONFIG_BRIDGE_TRACE
+    RegisterTraceResource();
+#endif
+
     return EXIT_SUCCESS;
 }
 
+#if CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+/**
+ * Function used to process pending libcoap I/O and timers on the Matter event loop
+ * Afterwards the next invocation is scheduled based on the next libcoap timeout
+ */
+static void ProcessCoapIo(chip::System::Layer * layer, void * appState)
+{
+    coap_io_process(coap_ctx, COAP_IO_NO_WAIT);
+
+    unsigned int next_ms = CONFIG_BRIDGE_COAP_POLL_INTERVAL_MS;
+    if (coap_context_get_coap_fd(coap_ctx) >= 0) {
+        // The file descriptor wakes us up on incoming data, the timer is only needed for libcoap timeouts
+        coap_tick_t now;
+        coap_ticks(&now);
+        next_ms = coap_io_prepare_epoll(coap_ctx, now);
+        chip::DeviceLayer::SystemLayerSockets().RequestCallbackOnPendingRead(coap_watch_token);
+        if (next_ms == 0) {
+            return;
+        }
+    }
+    chip::DeviceLayer::SystemLayer().StartTimer(chip::System::Clock::Milliseconds32(next_ms), ProcessCoapIo, nullptr);
+}
+
+/**
+ * Callback invoked by the CHIP system layer if the libcoap file descriptor is readable
+ */
+static void HandleCoapSocketEvent(chip::System::SocketEvents events, intptr_t data)
+{
+    chip::DeviceLayer::SystemLayer().CancelTimer(ProcessCoapIo, nullptr);
+    ProcessCoapIo(&chip::DeviceLayer::SystemLayer(), nullptr);
+}
+
+/**
+ * Function used to register the libcoap context with the Matter event loop
+ * If libcoap provides a single file descriptor (epoll), it is watched by the CHIP system layer
+ * Otherwise the context gets polled from the Matter event loop
+ */
+static void RegisterCoapIo(intptr_t context)
+{
+    int fd = coap_context_get_coap_fd(coap_ctx);
+    if (fd >= 0) {
+        auto & sockets = chip::DeviceLayer::SystemLayerSockets();
+        if (sockets.StartWatchingSocket(fd, &coap_watch_token) != CHIP_NO_ERROR ||
+            sockets.SetCallback(coap_watch_token, HandleCoapSocketEvent, 0) != CHIP_NO_ERROR) {
+            ChipLogError(DeviceLayer, "CoAP Server: Cannot watch the libcoap file descriptor, falling back to polling");
+        }
+    }
+    ProcessCoapIo(&chip::DeviceLayer::SystemLayer(), nullptr);
+    ChipLogProgress(DeviceLayer, "CoAP Server: Processing CoAP I/O on the Matter event loop");
+}
+#endif
+
 /**
  * Function starts the coap server
  * Note that init_server must be called beforehand
+ * If CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP is set, the server is handed over to the Matter event loop and this function returns
 */
 int start_server() 
 {
@@ -373,11 +1686,18 @@ int start_server()
         ChipLogError(DeviceLayer, "CoAP Server: Tried to start the CoAP Server before initializing it");
         return EXIT_FAILURE;
     }
-    
+
+#if CONFIG_BRIDGE_COAP_IO_IN_MATTER_LOOP
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(RegisterCoapIo);
+#else
     /* Handle any libcoap I/O requirements */
     while (true) {
-        coap_io_process(coap_ctx, COAP_IO_WAIT);
+        // Wake up periodically while forwarded commands wait for their separate response
+        coap_io_process(coap_ctx, pending_responses.load() > 0 ? CONFIG_BRIDGE_COAP_RESPONSE_POLL_MS : COAP_IO_WAIT);
+        SendCompletedResponses();
+        RunServerWork();
     }
     ChipLogProgress(DeviceLayer, "CoAP Server: CoAP Server terminated");
+#endif
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,138 @@
+#include "ConfigDiff.h"
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+/**
+ * Function used to find an element of a definition by its id
+ * Returns nullptr if no element has the id
+ */
+template <typename Container, typename Id>
+auto FindById(const Container & elements, Id id) -> decltype(&*elements.begin())
+{
+    for (const auto & element : elements) {
+        if (element.id == id) {
+            return &element;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Function used to collect the Matter ids whose LwM2M id differs between two versions of a map
+ */
+std::vector<int> DiffIds(const BiMap & old_map, const BiMap & new_map)
+{
+    std::vector<int> ids;
+    for (const auto & [matter_id, ipso_id] : new_map.entries()) {
+        auto previous = old_map.entries().find(matter_id);
+        if (previous == old_map.entries().end() || previous->second != ipso_id) {
+            ids.push_back(matter_id);
+        }
+    }
+    for (const auto & entry : old_map.entries()) {
+        if (new_map.entries().count(entry.first) == 0) {
+            ids.push_back(entry.first);
+        }
+    }
+    return ids;
+}
+
+/**
+ * Function used to check if a resource supports an operation, e.g. 'R' for reads
+ */
+bool HasOperation(const ResourceDefinition & resource, char operation)
+{
+    return resource.operations.find(operation) != std::string::npos;
+}
+
+} // namespace
+
+ClusterDelta DiffCluster(const matter::Cluster & old_cluster, const matter::Cluster & new_cluster)
+{
+    ClusterDelta delta;
+    for (const auto & attribute : new_cluster.attributes) {
+        auto previous = FindById(old_cluster.attributes, attribute.id);
+        if (previous == nullptr) {
+            delta.addedAttributes.push_back(static_cast<uint32_t>(attribute.id));
+        } else if (previous->type != attribute.type) {
+            delta.changedAttributes.push_back(static_cast<uint32_t>(attribute.id));
+        }
+    }
+    for (const auto & attribute : old_cluster.attributes) {
+        if (FindById(new_cluster.attributes, attribute.id) == nullptr) {
+            delta.removedAttributes.push_back(static_cast<uint32_t>(attribute.id));
+        }
+    }
+
+    // Only the ids of the commands end up in the accepted command list
+    delta.commandsChanged = old_cluster.client_commands.size() != new_cluster.client_commands.size();
+    for (const auto & command : new_cluster.client_commands) {
+        if (FindById(old_cluster.client_commands, command.id) == nullptr) {
+            delta.commandsChanged = true;
+        }
+    }
+    return delta;
+}
+
+MappingDelta DiffMapping(const MatterIpsoMapping & old_mapping, const MatterIpsoMapping & new_mapping)
+{
+    MappingDelta delta;
+    delta.clusters   = DiffIds(old_mapping.cluster_object_map, new_mapping.cluster_object_map);
+    delta.attributes = DiffIds(old_mapping.attribute_resource_map, new_mapping.attribute_resource_map);
+    delta.commands   = DiffIds(old_mapping.command_resource_map, new_mapping.command_resource_map);
+    delta.events     = DiffIds(old_mapping.event_resource_map, new_mapping.event_resource_map);
+    return delta;
+}
+
+ObjectDelta DiffObjectDefinition(const ObjectDefinition & old_object, const ObjectDefinition & new_object)
+{
+    ObjectDelta delta;
+    for (const auto & resource : new_object.resources) {
+        auto previous = FindById(old_object.resources, resource.id);
+        if (previous == nullptr) {
+            delta.addedResources.push_back(resource.id);
+            delta.instanceChanged |= HasOperation(resource, 'R') || HasOperation(resource, 'W');
+        } else if (previous->operations != resource.operations || previous->type != resource.type) {
+            delta.changedResources.push_back(resource.id);
+            delta.instanceChanged |= HasOperation(*previous, 'R') != HasOperation(resource, 'R') ||
+                HasOperation(*previous, 'W') != HasOperation(resource, 'W');
+        }
+    }
+    for (const auto & resource : old_object.resources) {
+        if (FindById(new_object.resources, resource.id) == nullptr) {
+            delta.removedResources.push_back(resource.id);
+            delta.instanceChanged |= HasOperation(resource, 'R') || HasOperation(resource, 'W');
+        }
+    }
+    return delta;
+}
+
+BridgeConfigDelta DiffBridgeConfig(const BridgeConfig & old_config, const BridgeConfig & new_config)
+{
+    BridgeConfigDelta delta;
+    // The device type, the cluster ids and the object id are part of the endpoint and the CoAP routes of every device
+    if (new_config.clusters.empty()) {
+        delta.restartReason = "no cluster has been converted";
+    } else if (old_config.clusters.empty() || old_config.device.id != new_config.device.id) {
+        delta.restartReason = "the device type has changed";
+    } else if (old_config.clusters.front().id != new_config.clusters.front().id) {
+        delta.restartReason = "the server cluster has changed";
+    } else if (old_config.clientCluster.id != new_config.clientCluster.id) {
+        delta.restartReason = "the client cluster has changed";
+    } else if (old_config.object.id != new_config.object.id) {
+        delta.restartReason = "the LwM2M object has changed";
+    }
+    if (delta.restartReason != nullptr) {
+        return delta;
+    }
+
+    delta.nameChanged   = old_config.device.name != new_config.device.name;
+    delta.server        = DiffCluster(old_config.clusters.front(), new_config.clusters.front());
+    delta.client        = DiffCluster(old_config.clientCluster, new_config.clientCluster);
+    delta.matterMapping = DiffMapping(old_config.matterMapping, new_config.matterMapping);
+    delta.coapMapping   = DiffMapping(old_config.coapMapping, new_config.coapMapping);
+    delta.object        = DiffObjectDefinition(old_config.object, new_config.object);
+    return delta;
+}
@@ -0,0 +1,401 @@
+#include "ConfigMirrors.h"
+#include "nvs.h"
+#include <lib/support/CodeUtils.h>
+#include <support/logging/CHIPLogging.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+// Maximum length of the base URI of a configuration server
+constexpr size_t kMaxMirrorUriLength = 64;
+// Number of recent response times the percentiles are computed from
+constexpr size_t kSampleCount = 8;
+// The budget of a server is only derived from its own samples once it has this many
+constexpr uint32_t kMinBudgetSamples = 3;
+// Requests are never hedged earlier than this, even if a server usually answers faster
+constexpr uint32_t kMinHedgeDelayMs = 100;
+
+constexpr char kNvsNamespace[] = "bridge_cfg";
+// The key changed when the samples were added and again when they became per block, blobs of an old layout are ignored
+constexpr char kNvsMirrorsKey[] = "mirrors_v3";
+
+// Response times of a configuration server that are kept across reboots
+// The samples are kept instead of the percentiles, so the first new sample after a reboot does not discard them
+struct PersistedMirror
+{
+    uint32_t uriHash;
+    uint32_t samples[kSampleCount];
+    uint32_t sampleCount;
+    uint32_t healthy;
+};
+
+// State of a single configuration server
+struct Mirror
+{
+    char uri[kMaxMirrorUriLength];
+    uint32_t samples[kSampleCount];
+    uint32_t sampleCount = 0;
+    uint32_t consecutiveFailures = 0;
+    ConfigMirrorInfo info;
+};
+
+// The servers are used by the configuration task, the counters may be read from any task
+Mirror sMirrors[kMaxConfigMirrors];
+size_t sMirrorCount = 0;
+bool sInitialized   = false;
+PersistedMirror sPersisted[kMaxConfigMirrors];
+size_t sPersistedCount = 0;
+std::mutex sMutex;
+
+/**
+ * Function used to hash the URI of a server, so persisted state is dropped if the list of servers changes
+ */
+uint32_t HashUri(const char * uri)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (; *uri != '\0'; uri++) {
+        hash = (hash ^ static_cast<uint8_t>(*uri)) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Function used to compute a percentile of the recent response times of a server
+ */
+uint32_t Percentile(const Mirror & mirror, uint32_t percentile)
+{
+    size_t count = std::min<size_t>(mirror.sampleCount, kSampleCount);
+    VerifyOrReturnValue(count > 0, 0);
+    uint32_t sorted[kSampleCount];
+    std::copy(mirror.samples, mirror.samples + count, sorted);
+    std::sort(sorted, sorted + count);
+    // Nearest rank
+    size_t rank = (percentile * count + 99) / 100;
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+/**
+ * Function used to update the percentiles of a server from its samples, must be called with the mutex held
+ */
+void UpdatePercentiles(Mirror & mirror)
+{
+    mirror.info.samples = mirror.sampleCount;
+    mirror.info.medianMs = Percentile(mirror, 50);
+    if (mirror.sampleCount >= kMinBudgetSamples) {
+        mirror.info.budgetMs = std::max(Percentile(mirror, CONFIG_BRIDGE_CONFIG_HEDGE_PERCENTILE), kMinHedgeDelayMs);
+    }
+}
+
+/**
+ * Function used to add a response time of a server, must be called with the mutex held
+ */
+void AddSample(Mirror & mirror, uint32_t latency_ms)
+{
+    mirror.samples[mirror.sampleCount % kSampleCount] = std::max<uint32_t>(latency_ms, 1);
+    mirror.sampleCount++;
+    UpdatePercentiles(mirror);
+}
+
+/**
+ * Function used to count an error response or a timeout of a server, must be called with the mutex held
+ */
+void CountFailure(Mirror & mirror)
+{
+    mirror.info.failures++;
+    mirror.consecutiveFailures++;
+    if (mirror.info.healthy && mirror.consecutiveFailures >= CONFIG_BRIDGE_CONFIG_MIRROR_FAILURE_THRESHOLD) {
+        ChipLogError(DeviceLayer, "Config mirrors: %s is unhealthy", mirror.uri);
+        mirror.info.healthy = false;
+    }
+}
+
+/**
+ * Function used to restore the response times of the previous boot
+ */
+void LoadPersistedMirrors()
+{
+    nvs_handle_t handle;
+    VerifyOrReturn(nvs_open(kNvsNamespace, NVS_READONLY, &handle) == ESP_OK);
+    size_t size = sizeof(sPersisted);
+    if (nvs_get_blob(handle, kNvsMirrorsKey, sPersisted, &size) == ESP_OK && size % sizeof(PersistedMirror) == 0) {
+        sPersistedCount = size / sizeof(PersistedMirror);
+    }
+    nvs_close(handle);
+
+    for (size_t i = 0; i < sPersistedCount; i++) {
+        for (size_t m = 0; m < sMirrorCount; m++) {
+            Mirror & mirror = sMirrors[m];
+            if (HashUri(mirror.uri) == sPersisted[i].uriHash) {
+                std::copy(sPersisted[i].samples, sPersisted[i].samples + kSampleCount, mirror.samples);
+                mirror.sampleCount = sPersisted[i].sampleCount;
+                UpdatePercentiles(mirror);
+                mirror.info.healthy = sPersisted[i].healthy != 0;
+                mirror.consecutiveFailures = mirror.info.healthy ? 0 : CONFIG_BRIDGE_CONFIG_MIRROR_FAILURE_THRESHOLD;
+            }
+        }
+    }
+}
+
+/**
+ * Function used to parse the list of servers and restore their state, must be called with the mutex held
+ */
+void EnsureInitialized()
+{
+    VerifyOrReturn(!sInitialized);
+    sInitialized = true;
+
+    const char * list = CONFIG_BRIDGE_CONFIG_MIRRORS;
+    while (*list != '\0' && sMirrorCount < kMaxConfigMirrors) {
+        const char * end = strchr(list, ',');
+        if (end == nullptr) {
+            end = list + strlen(list);
+        }
+        const char * first = list;
+        const char * last  = end;
+        while (first < last && isspace(static_cast<unsigned char>(*first))) {
+            first++;
+        }
+        while (last > first && (isspace(static_cast<unsigned char>(last[-1])) || last[-1] == '/')) {
+            last--;
+        }
+        size_t length = static_cast<size_t>(last - first);
+        if (length >= kMaxMirrorUriLength) {
+            ChipLogError(DeviceLayer, "Config mirrors: Ignoring URI longer than %u characters",
+                         static_cast<unsigned>(kMaxMirrorUriLength - 1));
+        } else if (length > 0) {
+            Mirror & mirror = sMirrors[sMirrorCount++];
+            memcpy(mirror.uri, first, length);
+            mirror.uri[length] = '\0';
+            mirror.info        = { mirror.uri, true, 0, CONFIG_BRIDGE_CONFIG_HEDGE_DELAY_MS, 0, 0, 0, 0 };
+        }
+        list = *end == ',' ? end + 1 : end;
+    }
+    if (sMirrorCount == 0) {
+        ChipLogError(DeviceLayer, "Config mirrors: No configuration server configured");
+    }
+
+    LoadPersistedMirrors();
+}
+
+} // namespace
+
+size_t ConfigMirrorsGetOrder(size_t * order, size_t max_order)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    EnsureInitialized();
+    size_t count = std::min(sMirrorCount, max_order);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    // Servers without any response time keep the configured order behind the measured ones
+    std::stable_sort(order, order + count, [](size_t a, size_t b) {
+        const ConfigMirrorInfo & lhs = sMirrors[a].info;
+        const ConfigMirrorInfo & rhs = sMirrors[b].info;
+        if (lhs.healthy != rhs.healthy) {
+            return lhs.healthy;
+        }
+        if ((lhs.medianMs == 0) != (rhs.medianMs == 0)) {
+            return rhs.medianMs == 0;
+        }
+        return lhs.medianMs < rhs.medianMs;
+    });
+    return count;
+}
+
+const char * ConfigMirrorGetUri(size_t mirror)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    EnsureInitialized();
+    VerifyOrReturnValue(mirror < sMirrorCount, nullptr);
+    return sMirrors[mirror].uri;
+}
+
+uint32_t ConfigMirrorGetHedgeDelay(size_t mirror)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    EnsureInitialized();
+    VerifyOrReturnValue(mirror < sMirrorCount, CONFIG_BRIDGE_CONFIG_HEDGE_DELAY_MS);
+    return sMirrors[mirror].info.budgetMs;
+}
+
+void ConfigMirrorReportSuccess(size_t mirror, uint32_t latency_ms, uint32_t blocks)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    VerifyOrReturn(mirror < sMirrorCount);
+    Mirror & entry = sMirrors[mirror];
+    // A large document takes more round trips, not a slower server
+    AddSample(entry, latency_ms / std::max<uint32_t>(blocks, 1));
+    entry.consecutiveFailures = 0;
+    entry.info.healthy        = true;
+    entry.info.wins++;
+}
+
+void ConfigMirrorReportSlow(size_t mirror, uint32_t elapsed_ms)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    VerifyOrReturn(mirror < sMirrorCount);
+    Mirror & entry = sMirrors[mirror];
+    // Without any answer the elapsed time would rank the server before the untried ones and every hedge would go to it
+    if (entry.sampleCount == 0) {
+        CountFailure(entry);
+        return;
+    }
+    AddSample(entry, elapsed_ms);
+}
+
+void ConfigMirrorReportFailure(size_t mirror)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    VerifyOrReturn(mirror < sMirrorCount);
+    CountFailure(sMirrors[mirror]);
+}
+
+void ConfigMirrorReportHedge(size_t mirror)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    VerifyOrReturn(mirror < sMirrorCount);
+    sMirrors[mirror].info.hedges++;
+}
+
+void ConfigMirrorsPersist()
+{
+    PersistedMirror persisted[kMaxConfigMirrors];
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        EnsureInitialized();
+        count = sMirrorCount;
+        for (size_t i = 0; i < count; i++) {
+            const Mirror & mirror = sMirrors[i];
+            persisted[i] = { HashUri(mirror.uri), {}, mirror.sampleCount, static_cast<uint32_t>(mirror.info.healthy) };
+            std::copy(mirror.samples, mirror.samples + kSampleCount, persisted[i].samples);
+        }
+        VerifyOrReturn(count != sPersistedCount || memcmp(persisted, sPersisted, count * sizeof(PersistedMirror)) != 0);
+        memcpy(sPersisted, persisted, count * sizeof(PersistedMirror));
+        sPersistedCount = count;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(kNvsNamespace, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, kNvsMirrorsKey, persisted, count * sizeof(PersistedMirror));
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ChipLogError(DeviceLayer, "Config mirrors: Failed to store response times: %s", esp_err_to_name(err));
+    }
+}
+
+size_t GetConfigMirrorInfo(ConfigMirrorInfo * infos, size_t max_infos)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    EnsureInitialized();
+    size_t count = std::min(sMirrorCount, max_infos);
+    for (size_t i = 0; i < count; i++) {
+        infos[i] = sMirrors[i].info;
+    }
+    return count;
+}
+
+ConfigFetchPlan::ConfigFetchPlan(bool hedging) :
+    mMirrorCount(ConfigMirrorsGetOrder(mOrder, kMaxConfigMirrors)), mHedging(hedging)
+{}
+
+ConfigFetchPlan::Step ConfigFetchPlan::Next(int64_t now_ms)
+{
+    int64_t wake_ms  = now_ms + 1000;
+    size_t in_flight = 0;
+    for (size_t i = 0; i < mLaunched; i++) {
+        Attempt & attempt = mAttempts[i];
+        if (attempt.finished) {
+            continue;
+        }
+        int64_t deadline_ms = attempt.progressMs + attempt.timeoutMs;
+        if (now_ms >= deadline_ms) {
+            ChipLogError(DeviceLayer, "Config mirrors: No block from %s within %u ms", ConfigMirrorGetUri(attempt.mirror),
+                         static_cast<unsigned>(attempt.timeoutMs));
+            attempt.finished = true;
+            ConfigMirrorReportFailure(attempt.mirror);
+            continue;
+        }
+        in_flight++;
+        wake_ms = std::min(wake_ms, deadline_ms);
+    }
+
+    bool may_hedge = mLaunched < mMirrorCount && in_flight < kMaxRequestsInFlight;
+    may_hedge = may_hedge && (mHedging || in_flight == 0);
+    if (may_hedge && (in_flight == 0 || now_ms >= mHedgeAtMs)) {
+        size_t index      = mLaunched++;
+        Attempt & attempt = mAttempts[index];
+        // The caller reports whether the request has been sent before it asks for the next step
+        attempt = { mOrder[index], now_ms, now_ms, 0, false };
+        if (in_flight > 0) {
+            ConfigMirrorReportHedge(attempt.mirror);
+        }
+        return { Action::kLaunch, index, attempt.mirror, in_flight > 0, now_ms };
+    }
+    if (in_flight == 0) {
+        return { Action::kGiveUp, 0, 0, false, now_ms };
+    }
+    if (may_hedge) {
+        wake_ms = std::min(wake_ms, mHedgeAtMs);
+    }
+    return { Action::kWait, 0, 0, false, wake_ms };
+}
+
+void ConfigFetchPlan::Started(size_t attempt, int64_t now_ms, uint32_t timeout_ms)
+{
+    VerifyOrReturn(attempt < mLaunched);
+    mAttempts[attempt].startMs    = now_ms;
+    mAttempts[attempt].progressMs = now_ms;
+    mAttempts[attempt].timeoutMs  = timeout_ms;
+    if (attempt + 1 == mLaunched) {
+        mHedgeAtMs = now_ms + ConfigMirrorGetHedgeDelay(mAttempts[attempt].mirror);
+    }
+}
+
+void ConfigFetchPlan::Progress(size_t attempt, int64_t now_ms)
+{
+    VerifyOrReturn(attempt < mLaunched && !mAttempts[attempt].finished);
+    mAttempts[attempt].progressMs = now_ms;
+    // A transfer that keeps delivering blocks is not hedged, a new request would start over with the first block
+    if (attempt + 1 == mLaunched) {
+        mHedgeAtMs = now_ms + ConfigMirrorGetHedgeDelay(mAttempts[attempt].mirror);
+    }
+}
+
+bool ConfigFetchPlan::Completed(size_t attempt, int64_t now_ms, uint32_t blocks)
+{
+    VerifyOrReturnValue(attempt < mLaunched && !mAttempts[attempt].finished, false);
+    mAttempts[attempt].finished = true;
+    ConfigMirrorReportSuccess(mAttempts[attempt].mirror, static_cast<uint32_t>(now_ms - mAttempts[attempt].startMs), blocks);
+    bool first = !mHasWinner;
+    mHasWinner = true;
+    return first;
+}
+
+void ConfigFetchPlan::Failed(size_t attempt)
+{
+    VerifyOrReturn(attempt < mLaunched && !mAttempts[attempt].finished);
+    mAttempts[attempt].finished = true;
+    ConfigMirrorReportFailure(mAttempts[attempt].mirror);
+}
+
+void ConfigFetchPlan::Finish(int64_t now_ms)
+{
+    for (size_t i = 0; i < mLaunched; i++) {
+        Attempt & attempt = mAttempts[i];
+        if (!attempt.finished && mHasWinner) {
+            // The request lost against a faster server, which says as much about its response time as a sample
+            ConfigMirrorReportSlow(attempt.mirror, static_cast<uint32_t>(now_ms - attempt.progressMs));
+        }
+        attempt.finished = true;
+    }
+}
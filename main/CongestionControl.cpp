@@ -0,0 +1,209 @@
+#include "CongestionControl.h"
+#include "esp_timer.h"
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+// Number of destinations whose retransmission state is kept, the least recently used one is replaced
+constexpr size_t kMaxDestinations = 8;
+// Initial retransmission timeout of RFC 7252 that is used until the first sample
+constexpr uint32_t kDefaultRtoMs = 2000;
+constexpr uint32_t kMinRtoMs     = 100;
+constexpr uint32_t kMaxRtoMs     = 32000;
+// Samples of requests that needed more retransmissions are ambiguous and are discarded
+constexpr uint8_t kMaxWeakRetransmissions = 2;
+
+// Mean and variation of the round trip time as defined by RFC 6298
+struct RttEstimator
+{
+    uint32_t srttMs   = 0;
+    uint32_t rttVarMs = 0;
+
+    // Feed a sample and get the retransmission timeout for the given variance factor
+    uint32_t Update(uint32_t rtt_ms, uint32_t k)
+    {
+        if (srttMs == 0) {
+            srttMs   = rtt_ms;
+            rttVarMs = rtt_ms / 2;
+        } else {
+            uint32_t delta = srttMs > rtt_ms ? srttMs - rtt_ms : rtt_ms - srttMs;
+            rttVarMs       = (3 * rttVarMs + delta) / 4;
+            srttMs         = (7 * srttMs + rtt_ms) / 8;
+        }
+        return srttMs + k * rttVarMs;
+    }
+};
+
+// CoCoA state of a single destination
+struct Destination
+{
+    bool inUse = false;
+    coap_address_t address;
+    RttEstimator strong;
+    RttEstimator weak;
+    uint32_t rtoMs          = kDefaultRtoMs;
+    uint32_t strongRtoMs    = 0;
+    uint32_t weakRtoMs      = 0;
+    uint32_t strongSamples  = 0;
+    uint32_t weakSamples    = 0;
+    int64_t lastUpdateMs    = 0;
+    int64_t lastUseMs       = 0;
+    uint8_t outstanding     = 0;
+};
+
+// The state is shared by every task that sends CoAP requests
+Destination sDestinations[kMaxDestinations];
+Destination sOverflow;
+std::mutex sMutex;
+
+int64_t NowMs()
+{
+    return esp_timer_get_time() / 1000;
+}
+
+/**
+ * Function used to find or create the state of a destination, must be called with the mutex held
+ */
+Destination & GetDestination(const coap_address_t * dst)
+{
+    Destination * candidate = nullptr;
+    for (auto & entry : sDestinations) {
+        if (entry.inUse && coap_address_equals(&entry.address, dst)) {
+            entry.lastUseMs = NowMs();
+            return entry;
+        }
+        // Destinations with outstanding requests are never replaced, free entries are taken first
+        if (entry.outstanding == 0 &&
+            (candidate == nullptr || (candidate->inUse && (!entry.inUse || entry.lastUseMs < candidate->lastUseMs)))) {
+            candidate = &entry;
+        }
+    }
+    if (candidate == nullptr) {
+        // Every destination has outstanding requests, the remaining ones share a single state
+        return sOverflow;
+    }
+    *candidate         = Destination();
+    candidate->inUse   = true;
+    candidate->address = *dst;
+    candidate->lastUseMs = candidate->lastUpdateMs = NowMs();
+    return *candidate;
+}
+
+/**
+ * Function used to age the retransmission timeout of a destination without recent samples
+ * Small timeouts are doubled, large timeouts are moved back towards the default
+ */
+void AgeRto(Destination & entry)
+{
+    int64_t idle = NowMs() - entry.lastUpdateMs;
+    if (entry.rtoMs < 1000 && idle > 16 * static_cast<int64_t>(entry.rtoMs)) {
+        entry.rtoMs        = std::min<uint32_t>(2 * entry.rtoMs, kDefaultRtoMs);
+        entry.lastUpdateMs = NowMs();
+    } else if (entry.rtoMs > 3000 && idle > 4 * static_cast<int64_t>(entry.rtoMs)) {
+        entry.rtoMs        = (kDefaultRtoMs + entry.rtoMs) / 2;
+        entry.lastUpdateMs = NowMs();
+    }
+}
+
+} // namespace
+
+bool CongestionAcquire(const coap_address_t * dst)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    Destination & entry = GetDestination(dst);
+    if (entry.outstanding >= CONFIG_BRIDGE_COAP_NSTART) {
+        return false;
+    }
+    entry.outstanding++;
+    return true;
+}
+
+void CongestionRelease(const coap_address_t * dst)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    Destination & entry = GetDestination(dst);
+    if (entry.outstanding > 0) {
+        entry.outstanding--;
+    }
+}
+
+uint32_t CongestionGetRto(const coap_address_t * dst)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    Destination & entry = GetDestination(dst);
+    AgeRto(entry);
+    return entry.rtoMs;
+}
+
+unsigned int CongestionGetExchangeLifetime(uint32_t rto_ms)
+{
+    return CongestionGetExchangeLifetime(rto_ms, CONFIG_BRIDGE_COAP_MAX_RETRANSMIT);
+}
+
+unsigned int CongestionGetExchangeLifetime(uint32_t rto_ms, uint8_t max_retransmit)
+{
+    // Sum of the initial timeout and every doubled retransmission timeout including the random factor of 1.5
+    uint32_t transmissions = (1u << (max_retransmit + 1)) - 1;
+    return rto_ms * transmissions * 3 / 2;
+}
+
+uint8_t CongestionGetMaxRetransmitWithin(uint32_t rto_ms, unsigned int budget_ms)
+{
+    uint8_t max_retransmit = 0;
+    while (max_retransmit < CONFIG_BRIDGE_COAP_MAX_RETRANSMIT &&
+           CongestionGetExchangeLifetime(rto_ms, max_retransmit + 1) <= budget_ms) {
+        max_retransmit++;
+    }
+    return max_retransmit;
+}
+
+uint32_t CongestionApplyToSession(coap_session_t * session, const coap_address_t * dst)
+{
+    uint32_t rto_ms = CongestionGetRto(dst);
+    coap_fixed_point_t ack_timeout = { static_cast<uint16_t>(rto_ms / 1000), static_cast<uint16_t>(rto_ms % 1000) };
+    coap_session_set_ack_timeout(session, ack_timeout);
+    coap_session_set_max_retransmit(session, CONFIG_BRIDGE_COAP_MAX_RETRANSMIT);
+    return rto_ms;
+}
+
+void CongestionReportRtt(const coap_address_t * dst, uint32_t rtt_ms, uint32_t initial_rto_ms)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    Destination & entry = GetDestination(dst);
+    rtt_ms              = std::max<uint32_t>(rtt_ms, 1);
+
+    // Retransmissions happen after the initial timeout, which doubles with every retransmission
+    uint8_t retransmissions = 0;
+    for (uint64_t elapsed = initial_rto_ms; rtt_ms > elapsed && retransmissions <= kMaxWeakRetransmissions;
+         elapsed += static_cast<uint64_t>(initial_rto_ms) << retransmissions) {
+        retransmissions++;
+    }
+
+    if (retransmissions == 0) {
+        entry.strongRtoMs = entry.strong.Update(rtt_ms, 4);
+        entry.rtoMs       = (entry.strongRtoMs + entry.rtoMs) / 2;
+        entry.strongSamples++;
+    } else if (retransmissions <= kMaxWeakRetransmissions) {
+        entry.weakRtoMs = entry.weak.Update(rtt_ms, 1);
+        entry.rtoMs     = (entry.weakRtoMs + 3 * entry.rtoMs) / 4;
+        entry.weakSamples++;
+    } else {
+        return;
+    }
+    entry.rtoMs        = std::clamp(entry.rtoMs, kMinRtoMs, kMaxRtoMs);
+    entry.lastUpdateMs = NowMs();
+}
+
+size_t GetCongestionInfo(CongestionInfo * infos, size_t max_infos)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    size_t count = 0;
+    for (const auto & entry : sDestinations) {
+        if (entry.inUse && count < max_infos) {
+            infos[count++] = { entry.address,     entry.rtoMs,         entry.strongRtoMs, entry.weakRtoMs,
+                               entry.outstanding, entry.strongSamples, entry.weakSamples };
+        }
+    }
+    return count;
+}
@@ -0,0 +1,270 @@
+#include "DeviceHealth.h"
+#include "BridgeMemory.h"
+#include "BridgeMetrics.h"
+#include "CoapClient.h"
+#include "Device.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <lib/support/CodeUtils.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+using namespace chip;
+
+namespace {
+
+// Number of LwM2M devices whose health can be tracked, one per dynamic endpoint
+constexpr size_t kMaxTrackedDevices = CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT;
+// Requests never wait shorter than this for a response, even on a fast link
+constexpr uint32_t kMinRequestTimeoutMs = 500;
+// Maximum length of the URI that is used to probe a device
+constexpr size_t kMaxProbeUriLength = 96;
+// Stack size of the task that probes unreachable devices
+constexpr uint32_t kProbeTaskStackSize = 4096;
+
+constexpr uint32_t kProbeMinIntervalMs = CONFIG_BRIDGE_DEVICE_PROBE_MIN_INTERVAL * 1000;
+constexpr uint32_t kProbeMaxIntervalMs = CONFIG_BRIDGE_DEVICE_PROBE_MAX_INTERVAL * 1000;
+
+// Health of a single LwM2M device
+struct TrackedDevice
+{
+    bool inUse = false;
+    coap_address_t address;
+    char uri[kMaxProbeUriLength];
+    Device * device = nullptr;
+    DeviceHealthInfo info;
+    // Time at which the next probe of an unreachable device is allowed
+    int64_t nextProbeMs = 0;
+    bool probeInFlight = false;
+};
+
+// The health is updated by every task that sends CoAP requests
+TrackedDevice sDevices[kMaxTrackedDevices];
+std::mutex sDevicesMutex;
+TaskHandle_t sProbeTask = nullptr;
+
+int64_t NowMs()
+{
+    return esp_timer_get_time() / 1000;
+}
+
+/**
+ * Function used to find the device of a destination, must be called with the mutex held
+ */
+TrackedDevice * FindDevice(const coap_address_t * dst)
+{
+    for (auto & entry : sDevices) {
+        if (entry.inUse && coap_address_equals(&entry.address, dst)) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Job running on the Matter event loop that updates the Reachable attribute of a bridged device
+ */
+void ApplyReachability(intptr_t context)
+{
+    TrackedDevice & entry = sDevices[context];
+    bool reachable;
+    {
+        std::lock_guard<std::mutex> lock(sDevicesMutex);
+        reachable = entry.info.reachable;
+    }
+    entry.device->SetReachable(reachable);
+}
+
+/**
+ * Function used to hand a change of the reachability over to the Matter event loop
+ */
+void ScheduleReachability(const TrackedDevice & entry)
+{
+    DeviceLayer::PlatformMgr().ScheduleWork(ApplyReachability, static_cast<intptr_t>(&entry - sDevices));
+    // Wake up the probe task, so it picks up the new backoff
+    xTaskNotifyGive(sProbeTask);
+}
+
+/**
+ * Task used to probe unreachable devices
+ * Probes are CoAP pings, their result is reported by the CoAP client like the result of any other request
+ * Note that FreeRTOS task are not allowed to terminate
+ */
+void ProbeTask(void * args)
+{
+    BridgeMemoryWatchTask(xTaskGetCurrentTaskHandle(), kProbeTaskStackSize);
+    char uri[kMaxProbeUriLength];
+    while (true) {
+        int64_t now      = NowMs();
+        int64_t next_due = now + kProbeMaxIntervalMs;
+        bool probe       = false;
+        {
+            std::lock_guard<std::mutex> lock(sDevicesMutex);
+            for (const auto & entry : sDevices) {
+                if (!entry.inUse || entry.info.reachable || entry.probeInFlight) {
+                    continue;
+                }
+                if (entry.nextProbeMs <= now && !probe) {
+                    strncpy(uri, entry.uri, sizeof(uri));
+                    probe = true;
+                } else {
+                    next_due = std::min(next_due, entry.nextProbeMs);
+                }
+            }
+        }
+
+        if (probe) {
+            CoapClientPing(uri);
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(std::max<int64_t>(next_due - now, 1)));
+    }
+}
+
+} // namespace
+
+CHIP_ERROR TrackLwm2mDevice(const char * uri, Device * device)
+{
+    VerifyOrReturnError(uri != nullptr && device != nullptr && strlen(uri) < kMaxProbeUriLength, CHIP_ERROR_INVALID_ARGUMENT);
+
+    coap_uri_t parsed;
+    coap_address_t address;
+    VerifyOrReturnError(coap_split_uri(reinterpret_cast<const uint8_t *>(uri), strlen(uri), &parsed) == 0,
+                        CHIP_ERROR_INVALID_ARGUMENT);
+    VerifyOrReturnError(resolve_address(&parsed.host, parsed.port, &address, 1 << parsed.scheme) > 0,
+                        CHIP_ERROR_INVALID_ADDRESS);
+
+    if (sProbeTask == nullptr) {
+        xTaskCreate(&ProbeTask, "bridge_probe", kProbeTaskStackSize, NULL, 5, &sProbeTask);
+        VerifyOrReturnError(sProbeTask != nullptr, CHIP_ERROR_NO_MEMORY);
+    }
+
+    std::lock_guard<std::mutex> lock(sDevicesMutex);
+    VerifyOrReturnError(FindDevice(&address) == nullptr, CHIP_ERROR_DUPLICATE_KEY_ID);
+    for (auto & entry : sDevices) {
+        if (!entry.inUse) {
+            entry.inUse         = true;
+            entry.address       = address;
+            entry.device        = device;
+            entry.info          = { device->IsReachable(), 0, 0, 0, kProbeMinIntervalMs, 0 };
+            entry.nextProbeMs   = NowMs();
+            entry.probeInFlight = false;
+            strncpy(entry.uri, uri, sizeof(entry.uri));
+            return CHIP_NO_ERROR;
+        }
+    }
+    return CHIP_ERROR_NO_MEMORY;
+}
+
+bool Lwm2mDeviceAllowsRequest(const coap_address_t * dst)
+{
+    std::lock_guard<std::mutex> lock(sDevicesMutex);
+    TrackedDevice * entry = FindDevice(dst);
+    if (entry == nullptr || entry->info.reachable) {
+        return true;
+    }
+    // A single request at a time is let through as a probe once the backoff has expired
+    if (!entry->probeInFlight && entry->nextProbeMs <= NowMs()) {
+        entry->probeInFlight = true;
+        return true;
+    }
+    entry->info.rejectedRequests++;
+    BridgeMetricIncrement(BridgeCounter::kCoapClientRejected);
+    return false;
+}
+
+unsigned int Lwm2mDeviceRequestTimeout(const coap_address_t * dst, unsigned int default_ms)
+{
+    std::lock_guard<std::mutex> lock(sDevicesMutex);
+    TrackedDevice * entry = FindDevice(dst);
+    if (entry == nullptr || entry->info.srttMs == 0) {
+        return default_ms;
+    }
+    // Same bound as the retransmission timeout of RFC 6298
+    uint32_t timeout = entry->info.srttMs + 4 * entry->info.rttVarMs;
+    return std::min<unsigned int>(default_ms, std::max(timeout, kMinRequestTimeoutMs));
+}
+
+void Lwm2mDeviceReportSuccess(const coap_address_t * dst, uint32_t rtt_ms)
+{
+    bool changed;
+    TrackedDevice * entry;
+    {
+        std::lock_guard<std::mutex> lock(sDevicesMutex);
+        entry = FindDevice(dst);
+        VerifyOrReturn(entry != nullptr);
+
+        DeviceHealthInfo & info = entry->info;
+        rtt_ms                  = std::max<uint32_t>(rtt_ms, 1);
+        if (info.srttMs == 0) {
+            info.srttMs   = rtt_ms;
+            info.rttVarMs = rtt_ms / 2;
+        } else {
+            uint32_t delta = info.srttMs > rtt_ms ? info.srttMs - rtt_ms : rtt_ms - info.srttMs;
+            info.rttVarMs  = (3 * info.rttVarMs + delta) / 4;
+            info.srttMs    = (7 * info.srttMs + rtt_ms) / 8;
+        }
+
+        changed                  = !info.reachable;
+        info.reachable           = true;
+        info.consecutiveFailures = 0;
+        info.backoffMs           = kProbeMinIntervalMs;
+        entry->probeInFlight     = false;
+    }
+    if (changed) {
+        ChipLogProgress(DeviceLayer, "LwM2M device %s is reachable again", entry->uri);
+        ScheduleReachability(*entry);
+    }
+}
+
+void Lwm2mDeviceReportFailure(const coap_address_t * dst)
+{
+    bool changed = false;
+    TrackedDevice * entry;
+    {
+        std::lock_guard<std::mutex> lock(sDevicesMutex);
+        entry = FindDevice(dst);
+        VerifyOrReturn(entry != nullptr);
+
+        DeviceHealthInfo & info = entry->info;
+        info.consecutiveFailures++;
+        if (info.reachable && info.consecutiveFailures >= CONFIG_BRIDGE_DEVICE_FAILURE_THRESHOLD) {
+            // Trip the breaker, requests fail fast until a probe succeeds
+            info.reachable = false;
+            info.backoffMs = kProbeMinIntervalMs;
+            changed        = true;
+        } else if (!info.reachable && entry->probeInFlight) {
+            // The probe failed, wait longer before the next one
+            info.backoffMs = std::min(info.backoffMs * 2, kProbeMaxIntervalMs);
+        }
+        entry->nextProbeMs   = NowMs() + info.backoffMs;
+        entry->probeInFlight = false;
+    }
+    if (changed) {
+        ChipLogError(DeviceLayer, "LwM2M device %s is unreachable", entry->uri);
+        ScheduleReachability(*entry);
+    }
+}
+
+void Lwm2mDeviceCancelRequest(const coap_address_t * dst)
+{
+    std::lock_guard<std::mutex> lock(sDevicesMutex);
+    TrackedDevice * entry = FindDevice(dst);
+    VerifyOrReturn(entry != nullptr);
+    entry->probeInFlight = false;
+}
+
+bool GetLwm2mDeviceHealth(const Device * device, DeviceHealthInfo & info)
+{
+    std::lock_guard<std::mutex> lock(sDevicesMutex);
+    for (const auto & entry : sDevices) {
+        if (entry.inUse && entry.device == device) {
+            info = entry.info;
+            return true;
+        }
+    }
+    return false;
+}
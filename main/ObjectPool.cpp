@@ -0,0 +1,51 @@
+#include "ObjectPool.h"
+#include "esp_heap_caps.h"
+#include <lib/support/CodeUtils.h>
+#include <platform/CHIPDeviceLayer.h>
+
+using namespace chip;
+
+namespace {
+
+/**
+ * Timer handler used to log the pool counters periodically
+ */
+void StatsTimerHandler(System::Layer * layer, void * context)
+{
+    LogObjectPoolStats();
+    DeviceLayer::SystemLayer().StartTimer(System::Clock::Seconds32(CONFIG_BRIDGE_POOL_STATS_INTERVAL), StatsTimerHandler,
+                                          nullptr);
+}
+
+} // namespace
+
+uint8_t GetHeapFragmentation()
+{
+    size_t free_size = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    VerifyOrReturnValue(free_size > 0, 0);
+    size_t largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    return static_cast<uint8_t>(100 - (largest_block * 100) / free_size);
+}
+
+void LogObjectPoolStats()
+{
+    for (const ObjectPoolBase * pool = ObjectPoolBase::First(); pool != nullptr; pool = pool->Next()) {
+        ObjectPoolStats stats = pool->GetStats();
+        ChipLogProgress(NotSpecified, "Pool %s: %" PRIu32 "/%u in use, high water %" PRIu32 ", %" PRIu32 " allocations, %" PRIu32
+                        " exhausted", stats.name, stats.inUse, static_cast<unsigned>(stats.capacity), stats.highWater,
+                        stats.allocations, stats.failures);
+    }
+    ChipLogProgress(NotSpecified, "Heap: %u free, %u minimum free, %u largest block, %u%% fragmented",
+                    static_cast<unsigned>(heap_caps_get_free_size(MALLOC_CAP_8BIT)),
+                    static_cast<unsigned>(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT)),
+                    static_cast<unsigned>(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT)), GetHeapFragmentation());
+}
+
+/**
+ * Function used to log the pool counters every CONFIG_BRIDGE_POOL_STATS_INTERVAL seconds
+ */
+void StartObjectPoolStats()
+{
+    DeviceLayer::SystemLayer().StartTimer(System::Clock::Seconds32(CONFIG_BRIDGE_POOL_STATS_INTERVAL), StatsTimerHandler,
+                                          nullptr);
+}
@@ -0,0 +1,252 @@
+#include "SessionKeeper.h"
+#include <app-common/zap-generated/ids/Attributes.h>
+#include <app-common/zap-generated/ids/Clusters.h>
+#include <app/InteractionModelEngine.h>
+#include <app/OperationalSessionSetup.h>
+#include <app/ReadClient.h>
+#include <app/server/Server.h>
+#include <app/util/binding-table.h>
+#include <lib/support/CodeUtils.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <system/SystemClock.h>
+#include <optional>
+
+using namespace chip;
+using namespace chip::app;
+
+namespace {
+
+// Number of bound peers whose sessions can be kept at the same time
+constexpr size_t kMaxPeerSessions = 8;
+
+/**
+ * CASE session to a single bound peer
+ * The session is established through the CASE session manager, so the binding manager reuses it later on
+ * A keepalive reads the revision of a bound cluster, so a peer that has dropped the session is noticed before a
+ * forwarded request runs into it
+ */
+class PeerSession : public ReadClient::Callback
+{
+public:
+    PeerSession() : mOnConnected(HandleConnected, this), mOnConnectionFailure(HandleConnectionFailure, this) {}
+
+    bool InUse() const { return mInUse; }
+    bool Matches(const ScopedNodeId & peer) const { return mInUse && mInfo.peer == peer; }
+    const PeerSessionInfo & Info() const { return mInfo; }
+
+    void Assign(const ScopedNodeId & peer, EndpointId endpoint, ClusterId cluster)
+    {
+        mInUse    = true;
+        mInfo     = { peer, PeerSessionState::kIdle, 0, 0, 0 };
+        mEndpoint = endpoint;
+        mCluster  = cluster;
+    }
+
+    void Release()
+    {
+        mOnConnected.Cancel();
+        mOnConnectionFailure.Cancel();
+        mReadClient.reset();
+        mKeepAlivePending = false;
+        mInUse            = false;
+    }
+
+    /**
+     * Function used to send a keepalive over the session to the peer
+     * The session is re-established first if it has been dropped, a keepalive that is still in flight is not repeated
+     */
+    void KeepAlive()
+    {
+        VerifyOrReturn(!mReadClient.has_value());
+        mKeepAlivePending = true;
+        Connect();
+    }
+
+    /**
+     * Function used to make sure that a session to the peer is available
+     * An active session is reused, otherwise a new one is established
+     */
+    void Connect()
+    {
+        VerifyOrReturn(mInfo.state != PeerSessionState::kConnecting);
+        mInfo.state    = PeerSessionState::kConnecting;
+        mConnectStart  = System::SystemClock().GetMonotonicTimestamp();
+        mInConnectCall = true;
+        Server::GetInstance().GetCASESessionManager()->FindOrEstablishSession(mInfo.peer, &mOnConnected, &mOnConnectionFailure);
+        mInConnectCall = false;
+    }
+
+private:
+    static void HandleConnected(void * context, Messaging::ExchangeManager & exchangeMgr, const SessionHandle & sessionHandle)
+    {
+        PeerSession * session = static_cast<PeerSession *>(context);
+        // A session that is reported while the connect call is still running was already available
+        if (!session->mInConnectCall) {
+            session->mInfo.lastHandshakeMs = static_cast<uint32_t>(
+                (System::SystemClock().GetMonotonicTimestamp() - session->mConnectStart).count());
+            session->mInfo.handshakeCount++;
+            ChipLogProgress(NotSpecified, "Session to " ChipLogFormatScopedNodeId " established in %" PRIu32 " ms",
+                            ChipLogValueScopedNodeId(session->mInfo.peer), session->mInfo.lastHandshakeMs);
+        }
+        session->mInfo.state = PeerSessionState::kConnected;
+        if (session->mKeepAlivePending) {
+            session->mKeepAlivePending = false;
+            session->SendKeepAlive(exchangeMgr, sessionHandle);
+        }
+    }
+
+    static void HandleConnectionFailure(void * context, const ScopedNodeId & peerId, CHIP_ERROR error)
+    {
+        PeerSession * session = static_cast<PeerSession *>(context);
+        session->mKeepAlivePending = false;
+        session->Fail(error);
+    }
+
+    /**
+     * Function used to read the cluster revision of the bound cluster, the cheapest read every cluster answers
+     */
+    void SendKeepAlive(Messaging::ExchangeManager & exchangeMgr, const SessionHandle & sessionHandle)
+    {
+        mKeepAlivePath = AttributePathParams(mEndpoint, mCluster, Clusters::Globals::Attributes::ClusterRevision::Id);
+        ReadPrepareParams params(sessionHandle);
+        params.mpAttributePathParamsList    = &mKeepAlivePath;
+        params.mAttributePathParamsListSize = 1;
+
+        mReadClient.emplace(InteractionModelEngine::GetInstance(), &exchangeMgr, *this, ReadClient::InteractionType::Read);
+        CHIP_ERROR err = mReadClient->SendRequest(params);
+        if (err != CHIP_NO_ERROR) {
+            mReadClient.reset();
+            Fail(err);
+        }
+    }
+
+    void OnAttributeData(const ConcreteDataAttributePath & aPath, TLV::TLVReader * apData, const StatusIB & aStatus) override {}
+
+    void OnError(CHIP_ERROR aError) override
+    {
+        // The next check establishes a new session
+        Fail(aError);
+    }
+
+    void OnDone(ReadClient * apReadClient) override { mReadClient.reset(); }
+
+    // The attribute path is owned by this object
+    void OnDeallocatePaths(ReadPrepareParams && aReadPrepareParams) override {}
+
+    void Fail(CHIP_ERROR error)
+    {
+        mInfo.state = PeerSessionState::kFailed;
+        mInfo.failureCount++;
+        ChipLogError(NotSpecified, "Session to " ChipLogFormatScopedNodeId " failed: %" CHIP_ERROR_FORMAT,
+                     ChipLogValueScopedNodeId(mInfo.peer), error.Format());
+    }
+
+    Callback::Callback<OnDeviceConnected> mOnConnected;
+    Callback::Callback<OnDeviceConnectionFailure> mOnConnectionFailure;
+    System::Clock::Timestamp mConnectStart;
+    PeerSessionInfo mInfo;
+    // Remote endpoint and cluster of a binding to the peer, the target of the keepalive
+    EndpointId mEndpoint = kRootEndpointId;
+    ClusterId mCluster   = Clusters::Descriptor::Id;
+    std::optional<ReadClient> mReadClient;
+    AttributePathParams mKeepAlivePath;
+    bool mInUse            = false;
+    bool mInConnectCall    = false;
+    bool mKeepAlivePending = false;
+};
+
+PeerSession sPeerSessions[kMaxPeerSessions];
+
+/**
+ * Function used to check if a peer is the target of a unicast binding
+ */
+bool IsBoundPeer(const ScopedNodeId & peer)
+{
+    for (const auto & entry : BindingTable::GetInstance()) {
+        if (entry.type == EMBER_UNICAST_BINDING && ScopedNodeId(entry.nodeId, entry.fabricIndex) == peer) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Timer handler used to send a keepalive to every bound peer
+ * Sessions that have been dropped are re-established before the keepalive is sent
+ */
+void KeepAliveTimerHandler(System::Layer * layer, void * appState)
+{
+    for (auto & session : sPeerSessions) {
+        if (session.InUse() && session.Info().state != PeerSessionState::kConnecting) {
+            session.KeepAlive();
+        }
+    }
+    DeviceLayer::SystemLayer().StartTimer(System::Clock::Seconds32(CONFIG_BRIDGE_SESSION_KEEPALIVE_INTERVAL),
+                                          KeepAliveTimerHandler, nullptr);
+}
+
+} // namespace
+
+/**
+ * Function used to establish sessions to all unicast binding targets
+ * Peers that are no longer bound are dropped from the session keeper
+ */
+void WarmBoundPeerSessions()
+{
+    for (auto & session : sPeerSessions) {
+        if (session.InUse() && !IsBoundPeer(session.Info().peer)) {
+            session.Release();
+        }
+    }
+
+    for (const auto & entry : BindingTable::GetInstance()) {
+        if (entry.type != EMBER_UNICAST_BINDING) {
+            continue;
+        }
+        ScopedNodeId peer(entry.nodeId, entry.fabricIndex);
+        PeerSession * free_session = nullptr;
+        PeerSession * peer_session = nullptr;
+        for (auto & session : sPeerSessions) {
+            if (session.Matches(peer)) {
+                peer_session = &session;
+                break;
+            }
+            if (!session.InUse() && free_session == nullptr) {
+                free_session = &session;
+            }
+        }
+        if (peer_session == nullptr) {
+            VerifyOrReturn(free_session != nullptr, ChipLogError(NotSpecified, "Session keeper is full"));
+            peer_session = free_session;
+            // Bindings without a cluster are kept alive with the Descriptor cluster every endpoint has
+            peer_session->Assign(peer, entry.remote, entry.clusterId.ValueOr(Clusters::Descriptor::Id));
+        }
+        if (peer_session->Info().state != PeerSessionState::kConnected) {
+            peer_session->Connect();
+        }
+    }
+}
+
+/**
+ * Function used to start the session keeper
+ */
+void StartSessionKeeper()
+{
+    WarmBoundPeerSessions();
+    DeviceLayer::SystemLayer().StartTimer(System::Clock::Seconds32(CONFIG_BRIDGE_SESSION_KEEPALIVE_INTERVAL),
+                                          KeepAliveTimerHandler, nullptr);
+}
+
+/**
+ * Function used to get the state of the sessions to all bound peers
+ */
+size_t GetPeerSessionInfo(PeerSessionInfo * infos, size_t max_infos)
+{
+    size_t count = 0;
+    for (const auto & session : sPeerSessions) {
+        if (session.InUse() && count < max_infos) {
+            infos[count++] = session.Info();
+        }
+    }
+    return count;
+}
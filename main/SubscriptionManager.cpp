@@ -0,0 +1,324 @@
+#include "SubscriptionManager.h"
+#include "BridgeMetrics.h"
+#include <app/InteractionModelEngine.h>
+#include <app/ReadClient.h>
+#include <app/clusters/bindings/BindingManager.h>
+#include <lib/support/CodeUtils.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <mutex>
+#include <optional>
+
+using namespace chip;
+using namespace chip::app;
+
+namespace {
+
+// Number of clusters of bound devices that can be subscribed at the same time
+constexpr size_t kMaxSubscriptions = 4;
+// Number of attribute values that can be kept in the shadow
+constexpr size_t kMaxShadowAttributes = 32;
+
+// Cluster of a bound device, as it is addressed by a unicast binding
+struct ShadowKey
+{
+    FabricIndex fabricIndex = kUndefinedFabricIndex;
+    NodeId nodeId           = kUndefinedNodeId;
+    EndpointId endpointId   = kInvalidEndpointId;
+    ClusterId clusterId     = kInvalidClusterId;
+
+    bool operator==(const ShadowKey & other) const
+    {
+        return fabricIndex == other.fabricIndex && nodeId == other.nodeId && endpointId == other.endpointId &&
+            clusterId == other.clusterId;
+    }
+};
+
+/**
+ * Function used to get the cluster of the bound device a binding addresses
+ */
+ShadowKey GetBindingKey(const EmberBindingTableEntry & binding)
+{
+    return { binding.fabricIndex, binding.nodeId, binding.remote, binding.clusterId.Value() };
+}
+
+// Last reported value of an attribute of a bound device
+struct ShadowAttribute
+{
+    ShadowKey key;
+    AttributeId attributeId;
+    TlvValue value;
+    bool valid = false;
+};
+
+// Unicast binding of a local endpoint, used to find the shadow of the device the endpoint is bound to
+struct ShadowRoute
+{
+    EndpointId localEndpointId = kInvalidEndpointId;
+    ShadowKey key;
+};
+
+// The shadow is written on the Matter event loop and read by the CoAP server
+ShadowAttribute sShadow[kMaxShadowAttributes];
+ShadowRoute sShadowRoutes[EMBER_BINDING_TABLE_SIZE];
+std::mutex sShadowMutex;
+
+/**
+ * Function used to store a reported value in the shadow
+ */
+void UpdateShadowAttribute(const ShadowKey & key, AttributeId attributeId, const TlvValue & value)
+{
+    std::lock_guard<std::mutex> lock(sShadowMutex);
+    ShadowAttribute * free_entry = nullptr;
+    for (auto & entry : sShadow) {
+        if (entry.valid && entry.key == key && entry.attributeId == attributeId) {
+            entry.value = value;
+            return;
+        }
+        if (!entry.valid && free_entry == nullptr) {
+            free_entry = &entry;
+        }
+    }
+    VerifyOrReturn(free_entry != nullptr, ChipLogError(NotSpecified, "Attribute shadow is full"));
+    free_entry->key         = key;
+    free_entry->attributeId = attributeId;
+    free_entry->value       = value;
+    free_entry->valid       = true;
+}
+
+/**
+ * Function used to invalidate every shadowed attribute of a cluster of a bound device
+ * Afterwards reads fall back to a read interaction until the subscription delivers new reports
+ */
+void InvalidateShadowCluster(const ShadowKey & key)
+{
+    std::lock_guard<std::mutex> lock(sShadowMutex);
+    for (auto & entry : sShadow) {
+        if (entry.key == key) {
+            entry.valid = false;
+        }
+    }
+}
+
+/**
+ * Function used to invalidate a single shadowed attribute of a cluster of a bound device
+ */
+void InvalidateShadowEntry(const ShadowKey & key, AttributeId attributeId)
+{
+    std::lock_guard<std::mutex> lock(sShadowMutex);
+    for (auto & entry : sShadow) {
+        if (entry.key == key && entry.attributeId == attributeId) {
+            entry.valid = false;
+        }
+    }
+}
+
+/**
+ * Function used to rebuild the routes from the local endpoints to the shadow from the binding table
+ */
+void RebuildShadowRoutes()
+{
+    std::lock_guard<std::mutex> lock(sShadowMutex);
+    size_t count = 0;
+    for (const auto & entry : BindingTable::GetInstance()) {
+        if (entry.type == EMBER_UNICAST_BINDING && entry.clusterId.HasValue() && count < ArraySize(sShadowRoutes)) {
+            sShadowRoutes[count].localEndpointId = entry.local;
+            sShadowRoutes[count].key             = GetBindingKey(entry);
+            count++;
+        }
+    }
+    for (; count < ArraySize(sShadowRoutes); count++) {
+        sShadowRoutes[count].localEndpointId = kInvalidEndpointId;
+    }
+}
+
+/**
+ * Subscription to all attributes of a single cluster of a bound device
+ * The ReadClient resubscribes on its own, including the establishment of a new CASE session
+ */
+class ClusterSubscription : public ReadClient::Callback
+{
+public:
+    bool InUse() const { return mReadClient.has_value(); }
+
+    bool Matches(const EmberBindingTableEntry & binding) const
+    {
+        return InUse() && binding.type == EMBER_UNICAST_BINDING && binding.clusterId.HasValue() && GetKey() == GetBindingKey(binding);
+    }
+
+    ShadowKey GetKey() const { return { mFabricIndex, mNodeId, mPath.mEndpointId, mPath.mClusterId }; }
+
+    CHIP_ERROR Subscribe(const EmberBindingTableEntry & binding, OperationalDeviceProxy * peer_device)
+    {
+        mFabricIndex = binding.fabricIndex;
+        mNodeId      = binding.nodeId;
+        mPath        = AttributePathParams(binding.remote, binding.clusterId.Value());
+
+        ReadPrepareParams params(peer_device->GetSecureSession().Value());
+        params.mpAttributePathParamsList    = &mPath;
+        params.mAttributePathParamsListSize = 1;
+        params.mMinIntervalFloorSeconds     = CONFIG_BRIDGE_SUBSCRIPTION_MIN_INTERVAL;
+        params.mMaxIntervalCeilingSeconds   = CONFIG_BRIDGE_SUBSCRIPTION_MAX_INTERVAL;
+        params.mKeepSubscriptions           = true;
+
+        // The read client is kept inline, so a subscription does not allocate from the heap
+        mReadClient.emplace(InteractionModelEngine::GetInstance(), peer_device->GetExchangeManager(), *this,
+                            ReadClient::InteractionType::Subscribe);
+
+        CHIP_ERROR err = mReadClient->SendAutoResubscribeRequest(std::move(params));
+        if (err != CHIP_NO_ERROR) {
+            mReadClient.reset();
+        }
+        return err;
+    }
+
+    void OnAttributeData(const ConcreteDataAttributePath & aPath, TLV::TLVReader * apData, const StatusIB & aStatus) override
+    {
+        VerifyOrReturn(apData != nullptr && aStatus.IsSuccess());
+
+        // Values larger than the largest mapped attribute are not kept in the shadow
+        TlvValue value;
+        VerifyOrReturn(DecodeAttributeValue(*apData, value) == CHIP_NO_ERROR);
+        UpdateShadowAttribute(ShadowKey{ mFabricIndex, mNodeId, aPath.mEndpointId, aPath.mClusterId }, aPath.mAttributeId, value);
+    }
+
+    void OnSubscriptionEstablished(SubscriptionId aSubscriptionId) override
+    {
+        ChipLogProgress(NotSpecified, "Subscription 0x%" PRIx32 " to cluster 0x%" PRIx32 " established", aSubscriptionId,
+                        mPath.mClusterId);
+    }
+
+    CHIP_ERROR OnResubscriptionNeeded(ReadClient * apReadClient, CHIP_ERROR aTerminationCause) override
+    {
+        ChipLogError(NotSpecified, "Subscription to cluster 0x%" PRIx32 " lost: %" CHIP_ERROR_FORMAT, mPath.mClusterId,
+                     aTerminationCause.Format());
+        // The shadow can no longer be trusted until the subscription has been re-established
+        InvalidateShadowCluster(GetKey());
+        return ReadClient::Callback::OnResubscriptionNeeded(apReadClient, aTerminationCause);
+    }
+
+    void OnError(CHIP_ERROR aError) override
+    {
+        ChipLogError(NotSpecified, "Subscription to cluster 0x%" PRIx32 " failed: %" CHIP_ERROR_FORMAT, mPath.mClusterId,
+                     aError.Format());
+    }
+
+    void OnDone(ReadClient * apReadClient) override
+    {
+        InvalidateShadowCluster(GetKey());
+        mReadClient.reset();
+    }
+
+    /**
+     * Function used to end the subscription, e.g. because its binding has been removed
+     */
+    void Shutdown()
+    {
+        ChipLogProgress(NotSpecified, "Subscription to cluster 0x%" PRIx32 " ended", mPath.mClusterId);
+        // Destroying the read client ends the subscription without calling OnDone
+        mReadClient.reset();
+        InvalidateShadowCluster(GetKey());
+    }
+
+    // The attribute path is owned by this object
+    void OnDeallocatePaths(ReadPrepareParams && aReadPrepareParams) override {}
+
+private:
+    std::optional<ReadClient> mReadClient;
+    FabricIndex mFabricIndex = kUndefinedFabricIndex;
+    NodeId mNodeId           = kUndefinedNodeId;
+    AttributePathParams mPath;
+};
+
+ClusterSubscription sSubscriptions[kMaxSubscriptions];
+
+} // namespace
+
+/**
+ * Function used to subscribe to all attributes of a cluster of a bound device
+ */
+CHIP_ERROR SubscribeBoundCluster(const EmberBindingTableEntry & binding, OperationalDeviceProxy * peer_device)
+{
+    VerifyOrReturnError(binding.type == EMBER_UNICAST_BINDING && binding.clusterId.HasValue(), CHIP_ERROR_INVALID_ARGUMENT);
+    VerifyOrReturnError(peer_device != nullptr && peer_device->ConnectionReady(), CHIP_ERROR_INCORRECT_STATE);
+
+    ClusterSubscription * free_subscription = nullptr;
+    for (auto & subscription : sSubscriptions) {
+        if (subscription.Matches(binding)) {
+            return CHIP_NO_ERROR;
+        }
+        if (!subscription.InUse() && free_subscription == nullptr) {
+            free_subscription = &subscription;
+        }
+    }
+    VerifyOrReturnError(free_subscription != nullptr, CHIP_ERROR_NO_MEMORY,
+                        ChipLogError(NotSpecified, "No free subscription for cluster 0x%" PRIx32, binding.clusterId.Value()));
+    return free_subscription->Subscribe(binding, peer_device);
+}
+
+/**
+ * Function used to subscribe to every cluster in the binding table
+ */
+void SubscribeBoundClusters()
+{
+    RebuildShadowRoutes();
+    for (const auto & entry : BindingTable::GetInstance()) {
+        if (entry.type == EMBER_UNICAST_BINDING && entry.clusterId.HasValue()) {
+            BindingCommandData data;
+            data.localEndpointId     = entry.local;
+            data.clusterId           = entry.clusterId.Value();
+            data.subscribeAttributes = true;
+            ProcessBindingCommand(data);
+        }
+    }
+}
+
+/**
+ * Function used to end every subscription whose binding is no longer in the binding table
+ */
+void UnsubscribeRemovedBindings()
+{
+    for (auto & subscription : sSubscriptions) {
+        if (!subscription.InUse()) {
+            continue;
+        }
+        bool bound = false;
+        for (const auto & entry : BindingTable::GetInstance()) {
+            bound = bound || subscription.Matches(entry);
+        }
+        if (!bound) {
+            subscription.Shutdown();
+        }
+    }
+    RebuildShadowRoutes();
+}
+
+/**
+ * Function used to drop the shadowed value of an attribute the bridge writes to a bound device
+ */
+void InvalidateShadowAttribute(FabricIndex fabricIndex, NodeId nodeId, EndpointId endpointId, ClusterId clusterId,
+                               AttributeId attributeId)
+{
+    InvalidateShadowEntry(ShadowKey{ fabricIndex, nodeId, endpointId, clusterId }, attributeId);
+}
+
+/**
+ * Function used to get the last reported value of an attribute of the device a local endpoint is bound to
+ */
+bool GetShadowAttribute(EndpointId endpoint, ClusterId clusterId, AttributeId attributeId, TlvValue & value)
+{
+    std::lock_guard<std::mutex> lock(sShadowMutex);
+    for (const auto & route : sShadowRoutes) {
+        if (endpoint == kInvalidEndpointId || route.localEndpointId != endpoint || route.key.clusterId != clusterId) {
+            continue;
+        }
+        for (const auto & entry : sShadow) {
+            if (entry.valid && entry.key == route.key && entry.attributeId == attributeId) {
+                value = entry.value;
+                BridgeMetricIncrement(BridgeCounter::kShadowHits);
+                return true;
+            }
+        }
+    }
+    BridgeMetricIncrement(BridgeCounter::kShadowMisses);
+    return false;
+}
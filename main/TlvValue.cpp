@@ -0,0 +1,120 @@
+#include "TlvValue.h"
+#include <lib/core/TLVWriter.h>
+#include <lib/support/CodeUtils.h>
+#include <cerrno>
+#include <cstdlib>
+
+using namespace chip;
+
+namespace {
+
+/**
+ * Function used to encode a single anonymous element into the buffer of the value
+ */
+template <typename T>
+CHIP_ERROR EncodeElement(TlvValue & value, T element)
+{
+    TLV::TLVWriter writer;
+    writer.Init(value.buffer, sizeof(value.buffer));
+    value.length = 0;
+    ReturnErrorOnFailure(writer.Put(TLV::AnonymousTag(), element));
+    ReturnErrorOnFailure(writer.Finalize());
+    value.length = static_cast<uint8_t>(writer.GetLengthWritten());
+    return CHIP_NO_ERROR;
+}
+
+} // namespace
+
+CHIP_ERROR TlvValue::EncodeBoolean(bool value)
+{
+    return EncodeElement(*this, value);
+}
+
+CHIP_ERROR TlvValue::EncodeUnsigned(uint64_t value)
+{
+    return EncodeElement(*this, value);
+}
+
+CHIP_ERROR TlvValue::EncodeSigned(int64_t value)
+{
+    return EncodeElement(*this, value);
+}
+
+CHIP_ERROR TlvValue::EncodeFloat(float value)
+{
+    return EncodeElement(*this, value);
+}
+
+CHIP_ERROR TlvValue::EncodeString(const char * value, size_t len)
+{
+    TLV::TLVWriter writer;
+    writer.Init(buffer, sizeof(buffer));
+    length = 0;
+    ReturnErrorOnFailure(writer.PutString(TLV::AnonymousTag(), CharSpan(value, len)));
+    ReturnErrorOnFailure(writer.Finalize());
+    length = static_cast<uint8_t>(writer.GetLengthWritten());
+    return CHIP_NO_ERROR;
+}
+
+CHIP_ERROR TlvValue::EncodeEmptyStructure()
+{
+    TLV::TLVWriter writer;
+    TLV::TLVType container;
+    writer.Init(buffer, sizeof(buffer));
+    length = 0;
+    ReturnErrorOnFailure(writer.StartContainer(TLV::AnonymousTag(), TLV::kTLVType_Structure, container));
+    ReturnErrorOnFailure(writer.EndContainer(container));
+    ReturnErrorOnFailure(writer.Finalize());
+    length = static_cast<uint8_t>(writer.GetLengthWritten());
+    return CHIP_NO_ERROR;
+}
+
+CHIP_ERROR TlvValue::EncodeLwm2mText(const std::string & type, const char * text, size_t len)
+{
+    // The numeric conversions need a null-terminated string
+    std::string str(text, len);
+    char * end = nullptr;
+    errno = 0;
+
+    if (type == "Boolean") {
+        VerifyOrReturnError(str == "0" || str == "1" || str == "false" || str == "true", CHIP_ERROR_INVALID_ARGUMENT);
+        return EncodeBoolean(str == "1" || str == "true");
+    }
+    if (type == "Unsigned Integer") {
+        unsigned long long number = strtoull(str.c_str(), &end, 10);
+        VerifyOrReturnError(!str.empty() && *end == '\0' && errno == 0 && str[0] != '-', CHIP_ERROR_INVALID_ARGUMENT);
+        return EncodeUnsigned(number);
+    }
+    if (type == "Integer" || type == "Time") {
+        long long number = strtoll(str.c_str(), &end, 10);
+        VerifyOrReturnError(!str.empty() && *end == '\0' && errno == 0, CHIP_ERROR_INVALID_ARGUMENT);
+        return EncodeSigned(number);
+    }
+    if (type == "Float") {
+        float number = strtof(str.c_str(), &end);
+        VerifyOrReturnError(!str.empty() && *end == '\0' && errno == 0, CHIP_ERROR_INVALID_ARGUMENT);
+        return EncodeFloat(number);
+    }
+    if (type == "String") {
+        return EncodeString(text, len);
+    }
+    return CHIP_ERROR_INVALID_ARGUMENT;
+}
+
+CHIP_ERROR TlvValue::CopyElement(TLV::TLVReader & reader)
+{
+    TLV::TLVWriter writer;
+    writer.Init(buffer, sizeof(buffer));
+    length = 0;
+    ReturnErrorOnFailure(writer.CopyElement(TLV::AnonymousTag(), reader));
+    ReturnErrorOnFailure(writer.Finalize());
+    length = static_cast<uint8_t>(writer.GetLengthWritten());
+    return CHIP_NO_ERROR;
+}
+
+CHIP_ERROR TlvValue::GetReader(TLV::TLVReader & reader) const
+{
+    VerifyOrReturnError(length > 0, CHIP_ERROR_INCORRECT_STATE);
+    reader.Init(buffer, length);
+    return reader.Next();
+}
@@ -21,28 +21,96 @@
 #include "app-common/zap-generated/ids/Clusters.h"
 #include "app-common/zap-generated/ids/Commands.h"
 #include "lib/core/CHIPError.h"
-#include <variant>
-#include <memory>
+#include "lib/core/DataModelTypes.h"
+#include "lib/core/TLVReader.h"
+#include "protocols/interaction_model/StatusCode.h"
+#include "BridgeTrace.h"
+#include "TlvValue.h"
+
+struct EmberBindingTableEntry;
 
 CHIP_ERROR InitBindingHandler();
-void SwitchWorkerFunction(intptr_t context);
 void BindingWorkerFunction(intptr_t context);
+CHIP_ERROR ScheduleBindingEntry(const EmberBindingTableEntry & entry);
+
+// Callback used to hand the TLV encoded result of a read interaction back to the requester
+// The value is a nullptr if the read interaction failed
+typedef void (*ReadCompleteCallback)(void * context, const TlvValue * value);
 
-// Global pointer that contains the result of a read interaction
-extern std::unique_ptr<std::variant<uint16_t, bool>> result_ptr;
+// Callback used to hand the result of a write or an invoke interaction back to the requester
+// The response is a nullptr if the command failed or has no response fields, it is always a nullptr for writes
+typedef void (*CommandCompleteCallback)(void * context, chip::Protocols::InteractionModel::Status status,
+                                        chip::TLV::TLVReader * response);
 
-// Type definition for data that can be given to a write interaction
-typedef std::variant<uint16_t, bool> Data;
+// Maximum number of attributes that are read or written within a single interaction
+constexpr uint8_t kMaxBatchAttributes = 8;
+
+// Attributes of a single cluster that are read or written within one interaction
+// The result of every attribute of a batched read is handed to its own completion callback
+struct AttributeBatch
+{
+    uint8_t count = 0;
+    chip::AttributeId attributeIds[kMaxBatchAttributes];
+    // TLV encoded values of a batched write interaction
+    TlvValue values[kMaxBatchAttributes];
+    // If a callback is not set, the result is dropped
+    ReadCompleteCallback onReadComplete[kMaxBatchAttributes] = {};
+    void * readContexts[kMaxBatchAttributes] = {};
+};
 
 // Struct that is used as the data in combination with bindings
 struct BindingCommandData
 {
-    chip::EndpointId localEndpointId = 2;
+    // Local endpoint whose bindings are used, commands for kInvalidEndpointId are failed without being routed
+    chip::EndpointId localEndpointId = chip::kInvalidEndpointId;
     chip::CommandId commandId;
     chip::AttributeId attributeId;
     chip::ClusterId clusterId;
-    Data data;
+    // TLV encoded value of a write interaction or fields of an invoke interaction
+    // Commands without fields are sent with an empty structure
+    TlvValue value;
     bool readAttribute = false;
     bool writeAttribute = false;
     bool isGroup = false;
+    // Subscribe to all attributes of the cluster instead of sending an interaction
+    bool subscribeAttributes = false;
+    // If set, the result of a read interaction is handed to this callback, otherwise it is dropped
+    ReadCompleteCallback onReadComplete = nullptr;
+    void * readContext = nullptr;
+    // If set, the status of a write interaction or the status and the response of an invoke interaction are handed to this callback
+    CommandCompleteCallback onCommandComplete = nullptr;
+    void * commandContext = nullptr;
+    // If the batch is not empty, the read or write interaction covers its attributes instead of attributeId
+    AttributeBatch batch;
+    // Trace the command belongs to, by default the trace of the task that creates the data
+    uint32_t traceId = BridgeTraceCurrent();
+    // Time the command was posted to a command ring, used to trace the time it waits for the Matter event loop
+    int64_t postedUs = 0;
+};
+
+// Tasks that hand BindingCommandData over to the Matter event loop
+// Every producer has its own single-producer ring
+enum class CommandProducer : uint8_t
+{
+    kCoapServer = 0,
+    kAppTask,
+    kCount,
 };
+
+/**
+ * Function used to send a read, write or invoke interaction to a cluster from a task other than the Matter event loop
+ * The data is copied into a preallocated ring slot, a whole burst of commands is processed by a single Matter work item
+ */
+CHIP_ERROR PostBindingCommand(CommandProducer producer, const BindingCommandData & data);
+
+/**
+ * Function used to copy the TLV representation of a reported attribute value
+ * Fails if the value is larger than the largest attribute the bridge maps
+ */
+CHIP_ERROR DecodeAttributeValue(chip::TLV::TLVReader & reader, TlvValue & value);
+
+/**
+ * Function used to send a read, write or invoke interaction to a cluster
+ * Must only be called from the Matter event loop
+ */
+void ProcessBindingCommand(const BindingCommandData & data);
@@ -0,0 +1,80 @@
+#ifndef BINDING_INDEX_H
+#define BINDING_INDEX_H
+
+#include <app/util/binding-table.h>
+#include <lib/core/DataModelTypes.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Function used to get the smallest power of two that is not below the given value
+ */
+constexpr size_t BindingIndexNextPowerOfTwo(size_t value, size_t power = 1)
+{
+    return power >= value ? power : BindingIndexNextPowerOfTwo(value, power * 2);
+}
+
+/**
+ * Index of the binding table keyed by (local endpoint, cluster)
+ * A lookup only visits the bindings that match, independent of the size of the binding table
+ * The index has to be rebuilt whenever the binding table changes, it must only be used from the Matter event loop
+ */
+class BindingIndex
+{
+public:
+    static constexpr uint8_t kNoBinding = UINT8_MAX;
+
+    /**
+     * Function used to rebuild the index from the binding table
+     */
+    void Rebuild();
+
+    /**
+     * Function used to call the given function with the binding table index of every matching binding
+     * Bindings without a cluster match every cluster
+     * No binding is visited if the endpoint is kInvalidEndpointId, a lookup never fans out to every local endpoint
+     */
+    template <typename Function>
+    void ForEach(chip::EndpointId endpoint, chip::ClusterId cluster, Function && function) const
+    {
+        if (endpoint == chip::kInvalidEndpointId) {
+            return;
+        }
+        for (chip::ClusterId key_cluster : { cluster, chip::kInvalidClusterId }) {
+            for (uint8_t index = Find(endpoint, key_cluster); index != kNoBinding; index = mNext[index]) {
+                function(index);
+            }
+            if (cluster == chip::kInvalidClusterId) {
+                break;
+            }
+        }
+    }
+
+private:
+    static constexpr size_t kTableSize = EMBER_BINDING_TABLE_SIZE;
+
+    // Every binding occupies at most one bucket, the load factor is kept below one half
+    static constexpr size_t kBucketCount = BindingIndexNextPowerOfTwo(2 * kTableSize);
+
+    struct Bucket
+    {
+        chip::EndpointId endpoint;
+        chip::ClusterId cluster;
+        uint8_t head = kNoBinding;
+    };
+
+    static size_t Hash(chip::EndpointId endpoint, chip::ClusterId cluster)
+    {
+        uint32_t hash = (cluster ^ (static_cast<uint32_t>(endpoint) << 16)) * 2654435761u;
+        return hash & (kBucketCount - 1);
+    }
+
+    uint8_t Find(chip::EndpointId endpoint, chip::ClusterId cluster) const;
+    void Insert(chip::EndpointId endpoint, chip::ClusterId cluster, uint8_t index);
+
+    Bucket mBuckets[kBucketCount];
+    // Next binding with the same key, every binding is linked into the chain of its local endpoint and cluster
+    uint8_t mNext[kTableSize];
+};
+
+#endif //BINDING_INDEX_H
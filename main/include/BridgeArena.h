@@ -0,0 +1,152 @@
+#ifndef BRIDGE_ARENA_H
+#define BRIDGE_ARENA_H
+
+#include "sdkconfig.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if CONFIG_BRIDGE_CONFIG_ARENA
+
+/**
+ * Bump allocator for objects that share a lifetime, e.g. everything the configuration documents are parsed into
+ * Freeing a single object does nothing, the memory of every object is released at once by Release
+ * Only a single arena can hold memory at a time
+ */
+class BridgeArena
+{
+public:
+    BridgeArena() = default;
+    ~BridgeArena() { Release(); }
+
+    BridgeArena(const BridgeArena &)             = delete;
+    BridgeArena & operator=(const BridgeArena &) = delete;
+
+    /**
+     * Function used to allocate memory from the arena, must only be called by the task the arena is active for
+     * Returns nullptr if no chunk could be allocated
+     */
+    void * Allocate(size_t size);
+
+    /**
+     * Function used to check if memory has been allocated from the arena
+     */
+    bool Owns(const void * ptr) const;
+
+    /**
+     * Function used to release every chunk of the arena
+     * Objects that were allocated from the arena must have been destroyed beforehand
+     */
+    void Release();
+
+    size_t Used() const { return mUsed; }
+    size_t Reserved() const { return mReserved; }
+
+private:
+    struct Chunk;
+
+    Chunk * AddChunk(size_t size);
+
+    std::atomic<Chunk *> mChunks{ nullptr };
+    size_t mUsed     = 0;
+    size_t mReserved = 0;
+};
+
+/**
+ * Function used to allocate memory from the arena that is active for the calling task
+ * Used by pugixml and operator new, returns nullptr if no arena is active or the arena is suspended
+ */
+void * BridgeArenaAllocate(size_t size);
+
+/**
+ * Function used to check if memory has been allocated from the arena that holds memory
+ * Freeing such memory is a no-op. Memory outside of the address range of the arena is rejected without a lock,
+ * so operator delete on the other tasks does not contend with the configuration task
+ */
+bool BridgeArenaOwns(const void * ptr);
+
+/**
+ * Function used to route the allocations of the calling task to an arena, nullptr routes them back to the heap
+ */
+void BridgeArenaActivate(BridgeArena * arena);
+
+/**
+ * Function used to route the allocations of the calling task back to the heap while the arena stays active
+ * Returns whether the arena was suspended before, so scopes can restore it
+ */
+bool BridgeArenaSetSuspended(bool suspended);
+
+#else
+
+class BridgeArena
+{
+public:
+    void Release() {}
+    size_t Used() const { return 0; }
+    size_t Reserved() const { return 0; }
+};
+
+inline void * BridgeArenaAllocate(size_t size)
+{
+    return nullptr;
+}
+inline bool BridgeArenaOwns(const void * ptr)
+{
+    return false;
+}
+inline void BridgeArenaActivate(BridgeArena * arena) {}
+inline bool BridgeArenaSetSuspended(bool suspended)
+{
+    return false;
+}
+
+#endif // CONFIG_BRIDGE_CONFIG_ARENA
+
+/**
+ * Scope in which the allocations of the calling task are made from an arena
+ * This covers pugixml as well as everything allocated with operator new, e.g. nlohmann::json and the SDF converter
+ */
+class BridgeArenaScope
+{
+public:
+    explicit BridgeArenaScope(BridgeArena & arena) { BridgeArenaActivate(&arena); }
+    ~BridgeArenaScope() { BridgeArenaActivate(nullptr); }
+
+    BridgeArenaScope(const BridgeArenaScope &)             = delete;
+    BridgeArenaScope & operator=(const BridgeArenaScope &) = delete;
+};
+
+/**
+ * Scope in which the allocations of the calling task are made from the heap, although an arena is active
+ * Results that outlive the arena are copied to the heap in this scope
+ */
+class BridgeArenaSuspendScope
+{
+public:
+    BridgeArenaSuspendScope() : mWasSuspended(BridgeArenaSetSuspended(true)) {}
+    ~BridgeArenaSuspendScope() { BridgeArenaSetSuspended(mWasSuspended); }
+
+    BridgeArenaSuspendScope(const BridgeArenaSuspendScope &)             = delete;
+    BridgeArenaSuspendScope & operator=(const BridgeArenaSuspendScope &) = delete;
+
+private:
+    bool mWasSuspended;
+};
+
+/**
+ * Scope in which a suspended arena is used again, e.g. for the document that is parsed while it is fetched
+ */
+class BridgeArenaResumeScope
+{
+public:
+    BridgeArenaResumeScope() : mWasSuspended(BridgeArenaSetSuspended(false)) {}
+    ~BridgeArenaResumeScope() { BridgeArenaSetSuspended(mWasSuspended); }
+
+    BridgeArenaResumeScope(const BridgeArenaResumeScope &)             = delete;
+    BridgeArenaResumeScope & operator=(const BridgeArenaResumeScope &) = delete;
+
+private:
+    bool mWasSuspended;
+};
+
+#endif //BRIDGE_ARENA_H
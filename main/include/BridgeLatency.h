@@ -0,0 +1,99 @@
+#ifndef BRIDGE_LATENCY_H
+#define BRIDGE_LATENCY_H
+
+#include "LatencyHistogram.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Round trips through the bridge whose latency is measured
+ */
+enum class BridgePath : uint8_t
+{
+    // Matter read, emberAfExternalAttributeReadCallback, CoAP GET to the LwM2M device
+    kMatterRead = 0,
+    // Matter write, emberAfExternalAttributeWriteCallback, CoAP PUT to the LwM2M device
+    kMatterWrite,
+    // Matter invoke, CoAP PUT to the LwM2M device, invoke response
+    kMatterCommand,
+    // CoAP GET on the CoAP server, BindingHandler, Matter read of the bound device
+    kCoapRead,
+    // CoAP PUT on the CoAP server, BindingHandler, Matter write of the bound device
+    kCoapWrite,
+    // CoAP PUT on a command resource, BindingHandler, Matter invoke of the bound device
+    kCoapCommand,
+    kCount
+};
+
+/**
+ * Latency and throughput of a bridge path since the last reset
+ */
+struct BridgePathStats
+{
+    const char * name;
+    uint32_t count;
+    uint32_t failures;
+    uint32_t p50Us;
+    uint32_t p99Us;
+    uint32_t p999Us;
+    uint32_t maxUs;
+    // Completed round trips per second, in thousandths
+    uint32_t throughputMilli;
+    // Highest number of round trips that were in flight at the same time
+    uint32_t maxInFlight;
+};
+
+/**
+ * Function used to mark the start of a round trip, returns the start time that is passed to BridgeLatencyEnd
+ */
+int64_t BridgeLatencyBegin(BridgePath path);
+
+/**
+ * Function used to record the end of a round trip that was started with BridgeLatencyBegin
+ * Can be called from any task
+ */
+void BridgeLatencyEnd(BridgePath path, int64_t start_us, bool success);
+
+/**
+ * Function used to get the latency and throughput of a bridge path
+ */
+BridgePathStats GetBridgePathStats(BridgePath path);
+
+/**
+ * Function used to log the statistics of every bridge path as one JSON object per line
+ * The lines are prefixed with "bridge-latency:" so they can be collected from the console for regression tracking
+ */
+void LogBridgeLatencies();
+
+/**
+ * Function used to clear the statistics of every bridge path, e.g. before a benchmark run
+ */
+void ResetBridgeLatencies();
+
+/**
+ * Function used to log the statistics every CONFIG_BRIDGE_LATENCY_REPORT_INTERVAL seconds
+ * Has to be called from the Matter event loop
+ */
+void StartBridgeLatencyReport();
+
+/**
+ * Scope that measures a round trip which completes within a single function
+ */
+class BridgeLatencyScope
+{
+public:
+    explicit BridgeLatencyScope(BridgePath path) : mPath(path), mStartUs(BridgeLatencyBegin(path)) {}
+    ~BridgeLatencyScope() { BridgeLatencyEnd(mPath, mStartUs, mSuccess); }
+
+    BridgeLatencyScope(const BridgeLatencyScope &)             = delete;
+    BridgeLatencyScope & operator=(const BridgeLatencyScope &) = delete;
+
+    void SetSuccess(bool success) { mSuccess = success; }
+
+private:
+    BridgePath mPath;
+    int64_t mStartUs;
+    bool mSuccess = true;
+};
+
+#endif //BRIDGE_LATENCY_H
@@ -0,0 +1,115 @@
+#ifndef BRIDGE_LOG_H
+#define BRIDGE_LOG_H
+
+#include "sdkconfig.h"
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Levels of the bridge log, a record is compiled in if its level is at most CONFIG_BRIDGE_LOG_LEVEL
+ */
+enum class BridgeLogLevel : uint8_t
+{
+    kError = 0,
+    kInfo,
+    kDetail,
+    kDebug,
+};
+
+// Number of integer arguments a record can carry
+constexpr size_t kMaxBridgeLogArgs = 4;
+
+/**
+ * Function used to write a record into the log ring, can be called from any task
+ * The format is only referenced and has to be a string literal that consumes 32-bit integers only
+ */
+void BridgeLogWrite(BridgeLogLevel level, const char * format, const uint32_t * args, size_t arg_count);
+
+/**
+ * Function used to format the records in the log ring as text, one record per line, oldest first
+ * Returns the length of the text or 0 if the buffer is too small
+ */
+size_t ExportBridgeLog(char * buffer, size_t size);
+
+/**
+ * Function used to get the size of the buffer ExportBridgeLog needs for the records that are kept
+ */
+size_t GetBridgeLogExportSize();
+
+/**
+ * Function used to drop every record in the log ring
+ */
+void ClearBridgeLog();
+
+/**
+ * Function used to count records that were suppressed by the rate limit
+ */
+void BridgeLogCountSuppressed();
+
+/**
+ * Rate limit of a single log statement
+ * At most CONFIG_BRIDGE_LOG_RATE_LIMIT records per second are written, the rest is only counted
+ */
+class BridgeLogSampler
+{
+public:
+    bool Allow();
+
+private:
+    std::atomic<uint32_t> mWindow{ 0 };
+    std::atomic<uint32_t> mCount{ 0 };
+};
+
+template <typename... Args>
+inline void BridgeLogRecord(BridgeLogLevel level, const char * format, Args... args)
+{
+    static_assert(sizeof...(Args) <= kMaxBridgeLogArgs, "Too many arguments for a bridge log record");
+    static_assert(((std::is_integral<Args>::value || std::is_enum<Args>::value) && ...),
+                  "Bridge log records only carry integers, the format is expanded when the log is exported");
+    uint32_t values[kMaxBridgeLogArgs] = { static_cast<uint32_t>(args)... };
+    BridgeLogWrite(level, format, values, sizeof...(Args));
+}
+
+// Statements above CONFIG_BRIDGE_LOG_LEVEL are removed at compile time, their arguments are not evaluated
+#define BRIDGE_LOG(level, format, ...)                                                                                         \
+    do {                                                                                                                       \
+        if constexpr (static_cast<int>(level) <= CONFIG_BRIDGE_LOG_LEVEL) {                                                    \
+            static BridgeLogSampler _bridgeLogSampler;                                                                         \
+            if (_bridgeLogSampler.Allow()) {                                                                                   \
+                BridgeLogRecord(level, format, ##__VA_ARGS__);                                                                 \
+            }                                                                                                                  \
+        }                                                                                                                      \
+    } while (0)
+
+#define BRIDGE_LOG_ERROR(format, ...) BRIDGE_LOG(BridgeLogLevel::kError, format, ##__VA_ARGS__)
+#define BRIDGE_LOG_INFO(format, ...) BRIDGE_LOG(BridgeLogLevel::kInfo, format, ##__VA_ARGS__)
+#define BRIDGE_LOG_DETAIL(format, ...) BRIDGE_LOG(BridgeLogLevel::kDetail, format, ##__VA_ARGS__)
+#define BRIDGE_LOG_DEBUG(format, ...) BRIDGE_LOG(BridgeLogLevel::kDebug, format, ##__VA_ARGS__)
+
+/**
+ * Function used to pack the first bytes of a payload into an integer argument, so the kind of document
+ * can be recognized in the log without copying the payload
+ */
+inline uint32_t BridgeLogPayloadPrefix(const uint8_t * data, size_t length, size_t offset)
+{
+    uint32_t prefix = 0;
+    for (size_t i = offset; i < offset + 4; i++) {
+        prefix = prefix << 8 | (data != nullptr && i < length ? data[i] : 0);
+    }
+    return prefix;
+}
+
+// Debug record of a payload with its length and its first eight bytes
+#define BRIDGE_LOG_PAYLOAD(label, data, length)                                                                                \
+    BRIDGE_LOG_DEBUG(label ": %" PRIu32 " bytes, starts with %08" PRIx32 "%08" PRIx32, static_cast<uint32_t>(length),          \
+                     BridgeLogPayloadPrefix(data, length, 0), BridgeLogPayloadPrefix(data, length, 4))
+
+// Debug record of the header of a CoAP PDU, replaces dumping every PDU with coap_show_pdu
+#define BRIDGE_LOG_PDU(label, pdu)                                                                                             \
+    BRIDGE_LOG_DEBUG(label ": type %" PRIu32 ", code %" PRIu32 ".%02" PRIu32 ", mid %" PRIu32, coap_pdu_get_type(pdu),         \
+                     COAP_RESPONSE_CLASS(coap_pdu_get_code(pdu)), coap_pdu_get_code(pdu) & 0x1f, coap_pdu_get_mid(pdu))
+
+#endif //BRIDGE_LOG_H
@@ -0,0 +1,118 @@
+#ifndef BRIDGE_MEMORY_H
+#define BRIDGE_MEMORY_H
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Phases of the bridge whose heap usage is recorded separately
+ * The configuration is fetched and parsed, converted to the Matter and CoAP data models and deployed,
+ * afterwards the bridge stays in the steady state
+ */
+enum class BridgePhase : uint8_t
+{
+    kFetch = 0,
+    kParse,
+    kConvert,
+    kDeploy,
+    kSteady,
+    kCount,
+};
+
+/**
+ * Heap usage of a phase
+ * Phases of different tasks overlap, an allocation counts for every phase that is active at the time
+ */
+struct BridgePhaseStats
+{
+    const char * name;
+    // Free heap when the phase was entered for the first time and the lowest free heap seen while it was active
+    uint32_t heapFreeStart;
+    uint32_t heapFreeMin;
+    // Peak of the bytes held through the tracking allocator and the number of allocations made through it
+    uint32_t trackedPeak;
+    uint32_t trackedAllocations;
+    // Time during which at least one task was in the phase
+    uint32_t durationMs;
+};
+
+/**
+ * Stack usage of a watched task
+ */
+struct BridgeTaskStackStats
+{
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t stackSize;
+    // Lowest number of bytes that were left on the stack
+    uint32_t minFree;
+    // The task has been deleted, its last high-water mark is kept
+    bool exited;
+};
+
+/**
+ * Function used to hook the tracking allocator into pugixml
+ * Must be called before the first document is parsed
+ */
+void InitBridgeMemory();
+
+/**
+ * Function used to mark the calling task as being in a phase until BridgeMemoryLeavePhase is called
+ */
+void BridgeMemoryEnterPhase(BridgePhase phase);
+void BridgeMemoryLeavePhase(BridgePhase phase);
+
+/**
+ * Function used to get the heap usage of a phase
+ */
+BridgePhaseStats GetBridgePhaseStats(BridgePhase phase);
+
+/**
+ * Function used to watch the stack of a task, e.g. xTaskGetCurrentTaskHandle() at the start of a task
+ * The stack size is the one the task has been created with
+ */
+void BridgeMemoryWatchTask(TaskHandle_t task, uint32_t stack_size);
+
+/**
+ * Function used to record the final high-water mark of the calling task before it deletes itself
+ */
+void BridgeMemoryTaskExiting();
+
+/**
+ * Function used to sample the stacks of the watched tasks
+ * Returns the number of entries written
+ */
+size_t GetBridgeTaskStackStats(BridgeTaskStackStats * stats, size_t max_stats);
+
+/**
+ * Function used to log the stack and heap budget of the bridge
+ */
+void LogBridgeMemoryBudget();
+
+/**
+ * Function used to allocate and free memory through the tracking allocator
+ * Used by pugixml and, if CONFIG_BRIDGE_MEMORY_TRACKING is set, by operator new and thereby nlohmann::json
+ * Allocations of a task with an active BridgeArenaScope are made from the arena
+ */
+void * BridgeTrackedAllocate(size_t size);
+void BridgeTrackedFree(void * ptr);
+
+/**
+ * Scope of a phase, phases nest, e.g. parsing a document while it is fetched
+ */
+class BridgePhaseScope
+{
+public:
+    explicit BridgePhaseScope(BridgePhase phase) : mPhase(phase) { BridgeMemoryEnterPhase(phase); }
+    ~BridgePhaseScope() { BridgeMemoryLeavePhase(mPhase); }
+
+    BridgePhaseScope(const BridgePhaseScope &)             = delete;
+    BridgePhaseScope & operator=(const BridgePhaseScope &) = delete;
+
+private:
+    BridgePhase mPhase;
+};
+
+#endif //BRIDGE_MEMORY_H
@@ -0,0 +1,77 @@
+#ifndef BRIDGE_METRICS_H
+#define BRIDGE_METRICS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Counters of the bridge that are exported as metrics
+ */
+enum class BridgeCounter : uint8_t
+{
+    // Requests sent to bridged LwM2M devices and the responses received in time
+    kCoapClientRequests = 0,
+    kCoapClientResponses,
+    kCoapClientTimeouts,
+    // Requests that failed fast because the LwM2M device is unreachable
+    kCoapClientRejected,
+    // Requests that were not sent because CONFIG_BRIDGE_COAP_NSTART requests to the destination are outstanding
+    kCoapClientCongested,
+    // Requests from the Matter event loop that gave up waiting once the budget of their caller was spent
+    kCoapClientBudgetExpired,
+    // Reasons libcoap gave for a lost message
+    kCoapClientNackTooManyRetries,
+    kCoapClientNackNotDeliverable,
+    kCoapClientNackRst,
+    kCoapClientNackIcmp,
+    kCoapClientNackOther,
+    // Error responses of the CoAP server
+    kCoapServerBadRequests,
+    kCoapServerBadGateway,
+    kCoapServerUnavailable,
+    // Commands routed to bound devices, commands that found no free context or ring slot
+    // and completions that were failed without an answer of a bound device
+    kBindingCommands,
+    kBindingNoContext,
+    kBindingRingFull,
+    kBindingFailedCompletions,
+    // Lookups in the attribute shadow of the bound devices
+    kShadowHits,
+    kShadowMisses,
+    kCount
+};
+
+/**
+ * Histograms of the bridge that are exported as metrics
+ */
+enum class BridgeHistogram : uint8_t
+{
+    // Round trip time of the requests to bridged LwM2M devices
+    kCoapClientRtt = 0,
+    kCount
+};
+
+/**
+ * Function used to add to a counter, can be called from any task
+ */
+void BridgeMetricIncrement(BridgeCounter counter, uint32_t value = 1);
+
+/**
+ * Function used to add a sample in microseconds to a histogram, can be called from any task
+ */
+void BridgeMetricRecord(BridgeHistogram histogram, uint32_t value_us);
+
+/**
+ * Function used to get the current value of a counter
+ */
+uint32_t BridgeMetricGet(BridgeCounter counter);
+
+/**
+ * Function used to encode every metric of the bridge as a CBOR map
+ * Besides the counters and histograms the map holds the bridge path latencies, the object pools,
+ * the request coalescing of the CoAP client and the heap
+ * Returns the length of the encoding or 0 if the buffer is too small
+ */
+size_t EncodeBridgeMetrics(uint8_t * buffer, size_t size);
+
+#endif //BRIDGE_METRICS_H
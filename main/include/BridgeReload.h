@@ -0,0 +1,16 @@
+#ifndef BRIDGE_RELOAD_H
+#define BRIDGE_RELOAD_H
+
+/**
+ * Function used to reload the configuration in the background
+ * Only the difference to the running configuration is applied, unaffected endpoints and subscriptions are kept
+ * Returns false if the bridge has not been configured yet or a reload is still in progress
+ */
+bool StartBridgeReload();
+
+/**
+ * Function used to get the outcome of the last reload as text
+ */
+const char * GetBridgeReloadStatus();
+
+#endif //BRIDGE_RELOAD_H
@@ -0,0 +1,127 @@
+#ifndef BRIDGE_TRACE_H
+#define BRIDGE_TRACE_H
+
+#include "sdkconfig.h"
+#include <cstddef>
+#include <cstdint>
+
+// A trace ID of zero means that the work is not traced
+constexpr uint32_t kNoTraceId = 0;
+
+#if CONFIG_BRIDGE_TRACE
+
+/**
+ * Function used to start a new trace, e.g. for a Matter interaction that is forwarded to a LwM2M device
+ */
+uint32_t BridgeTraceNewId();
+
+/**
+ * Function used to derive the trace ID of a CoAP request from its token
+ * Requests with an empty token get a new trace ID
+ */
+uint32_t BridgeTraceIdFromToken(const uint8_t * token, size_t length);
+
+/**
+ * Function used to get the trace ID of the work that is currently done by the calling task
+ */
+uint32_t BridgeTraceCurrent();
+
+/**
+ * Function used to set the trace ID of the work that is currently done by the calling task
+ * Returns the previous trace ID
+ */
+uint32_t BridgeTraceSetCurrent(uint32_t trace_id);
+
+/**
+ * Function used to record a span that started at start_us and ends now
+ * Spans are written into a ring buffer without a lock, the oldest spans are overwritten
+ */
+void BridgeTraceSpan(uint32_t trace_id, const char * name, int64_t start_us);
+
+/**
+ * Function used to get the current time in microseconds, which is the start of a span
+ */
+int64_t BridgeTraceNow();
+
+/**
+ * Function used to export the recorded spans as Chrome trace event JSON, which is loaded by Perfetto
+ * Returns the length of the JSON or 0 if the buffer is too small
+ */
+size_t ExportBridgeTrace(char * buffer, size_t size);
+
+/**
+ * Function used to get the size of the buffer ExportBridgeTrace needs for the spans that are recorded
+ */
+size_t GetBridgeTraceExportSize();
+
+/**
+ * Function used to drop every recorded span
+ */
+void ClearBridgeTrace();
+
+#else
+
+inline uint32_t BridgeTraceNewId()
+{
+    return kNoTraceId;
+}
+inline uint32_t BridgeTraceIdFromToken(const uint8_t * token, size_t length)
+{
+    return kNoTraceId;
+}
+inline uint32_t BridgeTraceCurrent()
+{
+    return kNoTraceId;
+}
+inline uint32_t BridgeTraceSetCurrent(uint32_t trace_id)
+{
+    return kNoTraceId;
+}
+inline void BridgeTraceSpan(uint32_t trace_id, const char * name, int64_t start_us) {}
+inline int64_t BridgeTraceNow()
+{
+    return 0;
+}
+
+#endif // CONFIG_BRIDGE_TRACE
+
+/**
+ * Scope that makes a trace ID the current one of the calling task
+ * Work that is handed over to another task carries the trace ID along, e.g. in BindingCommandData
+ */
+class BridgeTraceContext
+{
+public:
+    explicit BridgeTraceContext(uint32_t trace_id) : mPrevious(BridgeTraceSetCurrent(trace_id)) {}
+    ~BridgeTraceContext() { BridgeTraceSetCurrent(mPrevious); }
+
+    BridgeTraceContext(const BridgeTraceContext &)             = delete;
+    BridgeTraceContext & operator=(const BridgeTraceContext &) = delete;
+
+private:
+    uint32_t mPrevious;
+};
+
+/**
+ * Scope that records a span of the given trace and makes the trace the current one of the calling task
+ * The name has to be a string literal, only the pointer is recorded
+ */
+class BridgeTraceScope
+{
+public:
+    BridgeTraceScope(uint32_t trace_id, const char * name) :
+        mContext(trace_id), mTraceId(trace_id), mName(name), mStartUs(BridgeTraceNow())
+    {}
+    ~BridgeTraceScope() { BridgeTraceSpan(mTraceId, mName, mStartUs); }
+
+    BridgeTraceScope(const BridgeTraceScope &)             = delete;
+    BridgeTraceScope & operator=(const BridgeTraceScope &) = delete;
+
+private:
+    BridgeTraceContext mContext;
+    uint32_t mTraceId;
+    const char * mName;
+    int64_t mStartUs;
+};
+
+#endif //BRIDGE_TRACE_H
@@ -14,6 +14,8 @@
 #include <lib/support/CHIPMem.h>
 #include <lib/support/CHIPMemString.h>
 #include <lib/support/ZclString.h>
+#include <protocols/interaction_model/StatusCode.h>
+#include <coap3/coap.h>
 
 std::string Ip6ToStr(esp_ip6_addr_t &ip6addr);
 
@@ -50,6 +52,11 @@ public:
         return -1;
     }
 
+    // Get every Matter ID together with its LwM2M ID
+    const std::unordered_map<int, int>& entries() const {
+        return left_map;
+    }
+
 private:
     std::unordered_map<int, int> left_map;
     std::unordered_map<int, int> right_map;
@@ -145,4 +152,14 @@ inline std::string ExtractBetweenSlashes(const std::string& str)
     return str.substr(prevBackslashPos + 1, lastBackslashPos - prevBackslashPos - 1);
 }
 
+/**
+ * Function used to map the status of a Matter interaction onto a CoAP response code
+ */
+coap_pdu_code_t ImStatusToCoapCode(chip::Protocols::InteractionModel::Status status);
+
+/**
+ * Function used to map a CoAP response code onto the status of a Matter interaction
+ */
+chip::Protocols::InteractionModel::Status CoapCodeToImStatus(coap_pdu_code_t code);
+
 #endif //BRIDGE_UTILS_H
\ No newline at end of file
@@ -9,8 +9,6 @@
 
 #define BUFSIZE 100
 
-inline int have_response = 0;
-
 // Global variables containing the loaded definitions
 inline nlohmann::ordered_json sdf_model_file;
 inline nlohmann::ordered_json sdf_mapping_lwm2m_file;
@@ -38,29 +36,66 @@ static inline int resolve_address(coap_str_const_t *host, uint16_t port, coap_ad
 }
 
 /**
- * Function used to load the Cluster xml from the CoAP server
+ * Function used to parse a configuration document, called with the complete body of the first successful response
  */
-int LoadClusterXmlFile(const char* client_uri);
+typedef void (*ConfigDocumentParser)(const uint8_t *data, size_t len);
 
 /**
- * Function used to load the sdf-model from the CoAP server
+ * Function used to load a configuration document from the configuration servers listed in CONFIG_BRIDGE_CONFIG_MIRRORS
+ * The path, e.g. /sdf/sdf-model, is requested from the fastest healthy server first. If it does not send a block within
+ * its hedging budget, the next server is asked as well and the first complete document wins, see ConfigFetchPlan.
+ * Returns EXIT_SUCCESS if the document has been received
  */
-int LoadSdfModelFile(const char* client_uri);
+int LoadConfigDocument(const char* path, ConfigDocumentParser parser);
 
 /**
- * Function used to load the LwM2M to Matter merged mapping from the CoAP server
+ * Timing of a configuration document transfer
  */
-int LoadSdfMappingLwm2mFile(const char* client_uri);
+struct ConfigTransferStats
+{
+    char path[40];
+    // Index of the server in CONFIG_BRIDGE_CONFIG_MIRRORS that delivered the document
+    size_t mirror;
+    size_t length;
+    // Block size the server answered with, the number of blocks is derived from it
+    uint16_t block_size;
+    uint32_t blocks;
+    // Time from the request to the last block
+    uint32_t duration_ms;
+    // Requests sent for the document, including hedged and failed ones
+    uint8_t requests;
+};
 
 /**
- * Function used to load the Matter to LwM2M merged mapping from the CoAP server
+ * Function used to get the timing of the most recent configuration document transfers, oldest first
+ * Returns the number of entries written
  */
-int LoadSdfMappingMatterFile(const char* client_uri);
+size_t GetConfigTransferStats(ConfigTransferStats* stats, size_t max_stats);
 
 /**
- * Function used to load the converted LwM2M definition from the CoAP server
+ * Function used to load the Cluster xml from the configuration servers
  */
-int LoadLwm2mFile(const char* client_uri);
+int LoadClusterXmlFile(const char* path);
+
+/**
+ * Function used to load the sdf-model from the configuration servers
+ */
+int LoadSdfModelFile(const char* path);
+
+/**
+ * Function used to load the LwM2M to Matter merged mapping from the configuration servers
+ */
+int LoadSdfMappingLwm2mFile(const char* path);
+
+/**
+ * Function used to load the Matter to LwM2M merged mapping from the configuration servers
+ */
+int LoadSdfMappingMatterFile(const char* path);
+
+/**
+ * Function used to load the converted LwM2M definition from the configuration servers
+ */
+int LoadLwm2mFile(const char* path);
 
 /**
  * Function used to send a simple CoAP GET request without a payload
@@ -74,12 +109,81 @@ int CoapClientPut(const char* client_uri);
 
 /**
  * Function used to send a simple CoAP GET request with a payload
+ * Concurrent requests for the same URI share a single request to the server, a PUT to the URI ends the sharing
+ * Callers in a CoapClientWaitBudgetScope never wait for the request of another caller
  */
 int CoapClientGet(const char* client_uri, char* answer, size_t answer_size);
 
+/**
+ * Counters of the GET requests that have been shared between callers
+ */
+struct CoapClientCoalescingStats
+{
+    uint32_t requests = 0;
+    // Callers that joined a request that was in flight
+    uint32_t in_flight_hits = 0;
+    // Callers with a wait budget that sent their own request instead of joining one in flight
+    uint32_t in_flight_bypasses = 0;
+    // Callers that got the answer of a request that had just completed
+    uint32_t window_hits = 0;
+};
+
+/**
+ * Function used to get the counters of the shared GET requests
+ */
+CoapClientCoalescingStats GetCoapClientCoalescingStats();
+
 /**
  * Function used to send a simple CoAP PUT request with a payload
  */
 int CoapClientPut(const char* client_uri, char* data, size_t data_size);
 
+/**
+ * Response of a CoAP request that waits for the answer of the server
+ * The payload is written into the buffer provided by the caller
+ */
+struct CoapClientResponse
+{
+    bool received = false;
+    // Set if the request is known to be lost before the timeout expired
+    bool failed = false;
+    coap_pdu_code_t code = COAP_EMPTY_CODE;
+    uint8_t* payload = nullptr;
+    size_t payload_size = 0;
+    size_t length = 0;
+};
+
+/**
+ * Function used to send a CoAP PUT request with a payload and wait for the response
+ * The request uses its own libcoap context, so it can be sent from any task
+ * Returns EXIT_SUCCESS if a response was received before the timeout
+ */
+int CoapClientPutWithResponse(const char* client_uri, const uint8_t* data, size_t data_size, CoapClientResponse& response);
+
+/**
+ * Scope that bounds the time the requests of the calling task wait for their response
+ * Used by callers on the Matter event loop, which must not block for the whole lifetime of an exchange
+ * A request cut short by the budget fails like a timeout, but only counts against the device if the budget was long
+ * enough for a healthy device to answer
+ */
+class CoapClientWaitBudgetScope
+{
+public:
+    explicit CoapClientWaitBudgetScope(unsigned int budget_ms);
+    ~CoapClientWaitBudgetScope();
+
+    CoapClientWaitBudgetScope(const CoapClientWaitBudgetScope &)             = delete;
+    CoapClientWaitBudgetScope & operator=(const CoapClientWaitBudgetScope &) = delete;
+
+private:
+    unsigned int mPreviousBudgetMs;
+};
+
+/**
+ * Function used to check whether a CoAP endpoint is alive with a CoAP ping
+ * The request uses its own libcoap context, so it can be sent from any task
+ * Returns EXIT_SUCCESS if the endpoint answered before the timeout
+ */
+int CoapClientPing(const char* client_uri);
+
 #endif //COAP_CLIENT_H
@@ -3,6 +3,9 @@
 
 #include <coap3/coap.h>
 #include "BridgeUtils.h"
+#include <lib/core/DataModelTypes.h>
+#include <cstdint>
+#include <vector>
 
 // Global variable containing the LwM2M to Matter mapping
 inline MatterIpsoMapping coap_mapping;
@@ -38,4 +41,35 @@ int RegisterAttributeRWResource(const char* uri, std::string& type);
  */
 int RegisterCommandResource(const char* uri);
 
+/**
+ * Function used to register a LwM2M ressource for an object instance
+ * Reads and writes of the object instance are forwarded with batched Matter interactions
+ * The parameters are the readable and writable resources of the object instance
+ */
+int RegisterObjectInstanceResource(const char* uri, std::vector<int>& readable_resources, std::vector<int>& writable_resources);
+
+/**
+ * Function used to remove a ressource that has been registered by one of the functions above
+ * Must be called from the CoAP I/O, e.g. with ScheduleCoapServerWork
+ */
+int UnregisterResource(const char* uri);
+
+/**
+ * Function used to assign the local endpoint of a bridged LwM2M device to its object instance
+ * Requests on the resources of the instance are routed through the bindings of the endpoint
+ * Until an endpoint has been assigned, requests on the instance are rejected
+ */
+void SetCoapInstanceEndpoint(uint16_t instance_id, chip::EndpointId endpoint);
+
+/**
+ * Function used to run work where the CoAP I/O is processed, which is the only place the ressources may be changed
+ * At most one work item is pending at a time, returns false if the previous one has not run yet
+ */
+bool ScheduleCoapServerWork(void (*work)(intptr_t), intptr_t context);
+
+/**
+ * Function used to end the polling a reload has started in hnd_reload_post, if its work cannot be scheduled any more
+ */
+void CancelCoapServerPoll();
+
 #endif //COAP_SERVER_H
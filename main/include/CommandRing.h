@@ -0,0 +1,142 @@
+#ifndef COMMAND_RING_H
+#define COMMAND_RING_H
+
+#include <atomic>
+#include <cstddef>
+
+// Alignment used to keep the indices of the producer and the consumer on separate cache lines
+constexpr size_t kCacheLineSize = 64;
+
+/**
+ * Fixed capacity single-producer/single-consumer ring of preallocated slots
+ * The producer fills the slot returned by Acquire and publishes it with Commit
+ * The consumer reads the slot returned by Front and frees it with Pop
+ */
+template <typename T, size_t N>
+class SpscRing
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "The capacity of the ring has to be a power of two");
+
+public:
+    // Get the next free slot, returns nullptr if the ring is full
+    // Must only be called by the producer
+    T * Acquire()
+    {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) == N) {
+            return nullptr;
+        }
+        return &mSlots[tail & (N - 1)];
+    }
+
+    // Publish the slot returned by Acquire to the consumer
+    // Must only be called by the producer
+    void Commit()
+    {
+        mTail.store(mTail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Get the oldest published slot, returns nullptr if the ring is empty
+    // Must only be called by the consumer
+    T * Front()
+    {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &mSlots[head & (N - 1)];
+    }
+
+    // Free the slot returned by Front
+    // Must only be called by the consumer
+    void Pop()
+    {
+        mHead.store(mHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Get the number of published slots
+    size_t Size() const
+    {
+        return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(kCacheLineSize) std::atomic<size_t> mHead{ 0 };
+    alignas(kCacheLineSize) std::atomic<size_t> mTail{ 0 };
+    alignas(kCacheLineSize) T mSlots[N];
+};
+
+/**
+ * Rings of several producer tasks that are drained by work items on the consumer's event loop
+ * A drain work item is only scheduled for the first command of a burst, later commands are picked up by the same drain
+ */
+template <typename T, size_t N, size_t Producers>
+class CommandChannel
+{
+public:
+    enum class PostResult : uint8_t
+    {
+        kPosted = 0,
+        // The ring of the producer is full, the command has not been posted
+        kFull,
+        // The command has been posted but no drain could be scheduled
+        // It is drained together with the next command whose drain can be scheduled
+        kNotScheduled,
+    };
+
+    /**
+     * Function used to copy a command into a slot of the producer's ring with fill(T & slot)
+     * If no drain is pending, schedule() is called to schedule one and returns false if it cannot
+     * Must only be called by the producer that owns the ring
+     */
+    template <typename Fill, typename Schedule>
+    PostResult Post(size_t producer, Fill fill, Schedule schedule)
+    {
+        SpscRing<T, N> & ring = mRings[producer];
+        T * slot              = ring.Acquire();
+        if (slot == nullptr) {
+            return PostResult::kFull;
+        }
+        fill(*slot);
+        ring.Commit();
+
+        if (!mDrainScheduled.exchange(true) && !schedule()) {
+            // Clear the flag again, otherwise no drain would ever be scheduled and the rings would fill up
+            mDrainScheduled.store(false);
+            return PostResult::kNotScheduled;
+        }
+        return PostResult::kPosted;
+    }
+
+    /**
+     * Function used to process every posted command with process(T & command), called by the drain work item
+     * merge(T & command, const T & next) may fold the next command of the same ring into the command, it returns true
+     * if it has done so
+     */
+    template <typename Merge, typename Process>
+    void Drain(Merge merge, Process process)
+    {
+        // Clear the flag first so that commands posted while draining schedule a new work item
+        mDrainScheduled.store(false);
+
+        for (auto & ring : mRings) {
+            while (T * data = ring.Front()) {
+                T command = *data;
+                ring.Pop();
+                while ((data = ring.Front()) != nullptr && merge(command, *data)) {
+                    ring.Pop();
+                }
+                process(command);
+            }
+        }
+    }
+
+    // True while a drain work item is pending
+    bool DrainScheduled() const { return mDrainScheduled.load(); }
+
+private:
+    SpscRing<T, N> mRings[Producers];
+    std::atomic<bool> mDrainScheduled{ false };
+};
+
+#endif //COMMAND_RING_H
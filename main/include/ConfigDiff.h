@@ -0,0 +1,123 @@
+#ifndef CONFIG_DIFF_H
+#define CONFIG_DIFF_H
+
+#include "BridgeUtils.h"
+#include "LwM2MObject.hpp"
+#include "matter.h"
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <vector>
+
+/**
+ * Everything the bridge is configured with
+ * The sdf-model and the sdf-mappings are only kept in their converted form
+ */
+struct BridgeConfig
+{
+    matter::Device device;
+    std::list<matter::Cluster> clusters;
+    matter::Cluster clientCluster;
+    // Mapping used by the Matter callbacks and mapping used by the CoAP server
+    MatterIpsoMapping matterMapping;
+    MatterIpsoMapping coapMapping;
+    ObjectDefinition object{};
+};
+
+/**
+ * Difference between two versions of a converted cluster
+ * Attributes are compared by their id and type, which is everything the endpoint metadata is built from
+ */
+struct ClusterDelta
+{
+    std::vector<uint32_t> addedAttributes;
+    std::vector<uint32_t> removedAttributes;
+    std::vector<uint32_t> changedAttributes;
+    // Set if a command has been added or removed, the accepted command list is replaced as a whole
+    bool commandsChanged = false;
+
+    bool AttributeListChanged() const { return !addedAttributes.empty() || !removedAttributes.empty(); }
+    bool Empty() const { return !AttributeListChanged() && changedAttributes.empty() && !commandsChanged; }
+};
+
+/**
+ * Difference between two versions of a Matter <-> LwM2M mapping
+ * Every list contains the Matter ids whose LwM2M id has been added, removed or changed
+ */
+struct MappingDelta
+{
+    std::vector<int> clusters;
+    std::vector<int> attributes;
+    std::vector<int> commands;
+    std::vector<int> events;
+
+    bool Empty() const { return clusters.empty() && attributes.empty() && commands.empty() && events.empty(); }
+};
+
+/**
+ * Difference between two versions of a LwM2M object definition
+ * Resources are compared by their id, a resource whose operations or type differ is registered again
+ */
+struct ObjectDelta
+{
+    std::vector<int> addedResources;
+    std::vector<int> removedResources;
+    std::vector<int> changedResources;
+    // Set if the readable or writable resources of the object instance differ
+    bool instanceChanged = false;
+
+    bool Empty() const { return addedResources.empty() && removedResources.empty() && changedResources.empty() && !instanceChanged; }
+};
+
+/**
+ * Difference between the configuration the bridge runs with and a reloaded one
+ */
+struct BridgeConfigDelta
+{
+    // Set if the difference cannot be applied to the running bridge, e.g. because the device type changed
+    const char * restartReason = nullptr;
+    bool nameChanged           = false;
+    ClusterDelta server;
+    ClusterDelta client;
+    MappingDelta matterMapping;
+    MappingDelta coapMapping;
+    ObjectDelta object;
+
+    bool Empty() const
+    {
+        return restartReason == nullptr && !nameChanged && server.Empty() && client.Empty() && matterMapping.Empty() &&
+            coapMapping.Empty() && object.Empty();
+    }
+};
+
+/**
+ * Function used to check if a delta lists an id
+ */
+template <typename Id, typename Other>
+inline bool DeltaContains(const std::vector<Id> & ids, Other id)
+{
+    return std::find(ids.begin(), ids.end(), static_cast<Id>(id)) != ids.end();
+}
+
+/**
+ * Function used to compare two versions of a converted cluster
+ */
+ClusterDelta DiffCluster(const matter::Cluster & old_cluster, const matter::Cluster & new_cluster);
+
+/**
+ * Function used to compare two versions of a Matter <-> LwM2M mapping
+ */
+MappingDelta DiffMapping(const MatterIpsoMapping & old_mapping, const MatterIpsoMapping & new_mapping);
+
+/**
+ * Function used to compare two versions of a LwM2M object definition
+ */
+ObjectDelta DiffObjectDefinition(const ObjectDefinition & old_object, const ObjectDefinition & new_object);
+
+/**
+ * Function used to compare the configuration the bridge runs with to a reloaded one
+ * Only the first converted cluster is compared, as it is the only one that is deployed
+ */
+BridgeConfigDelta DiffBridgeConfig(const BridgeConfig & old_config, const BridgeConfig & new_config);
+
+#endif //CONFIG_DIFF_H
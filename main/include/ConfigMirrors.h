@@ -0,0 +1,173 @@
+#ifndef CONFIG_MIRRORS_H
+#define CONFIG_MIRRORS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Maximum number of configuration servers that can be listed in CONFIG_BRIDGE_CONFIG_MIRRORS
+constexpr size_t kMaxConfigMirrors = 4;
+
+// Response times of a configuration server as seen by the CoAP client
+// The response times are per block, so documents of different sizes give comparable samples
+struct ConfigMirrorInfo
+{
+    const char * uri;
+    bool healthy;
+    // Median response time per block and the percentile that is used as the hedging budget, zero while unknown
+    uint32_t medianMs;
+    uint32_t budgetMs;
+    uint32_t samples;
+    uint32_t wins;
+    uint32_t hedges;
+    uint32_t failures;
+};
+
+/**
+ * Function used to get the configuration servers in the order they are tried
+ * Healthy servers come first, ordered by their median response time, which is restored from NVS at boot
+ * Returns the number of indices written
+ */
+size_t ConfigMirrorsGetOrder(size_t * order, size_t max_order);
+
+/**
+ * Function used to get the base URI of a configuration server, e.g. coap://[fd00::1]:5683
+ */
+const char * ConfigMirrorGetUri(size_t mirror);
+
+/**
+ * Function used to get the time without a block after which a request to a configuration server is hedged with a
+ * request to the next one
+ * This is the CONFIG_BRIDGE_CONFIG_HEDGE_PERCENTILE of the recent response times per block of the server
+ */
+uint32_t ConfigMirrorGetHedgeDelay(size_t mirror);
+
+/**
+ * Function used to report a document received from a configuration server together with its transfer time
+ * The transfer time is divided by the number of blocks of the document before it is recorded
+ */
+void ConfigMirrorReportSuccess(size_t mirror, uint32_t latency_ms, uint32_t blocks);
+
+/**
+ * Function used to report a request that was still in flight when another server answered
+ * The time since its last block is a lower bound of the response time per block and is recorded as such
+ * For a server that has never answered, the request is counted as a failure instead
+ */
+void ConfigMirrorReportSlow(size_t mirror, uint32_t elapsed_ms);
+
+/**
+ * Function used to report an error response or a timeout of a configuration server
+ */
+void ConfigMirrorReportFailure(size_t mirror);
+
+/**
+ * Function used to report that a request to a configuration server has been sent as a hedge
+ */
+void ConfigMirrorReportHedge(size_t mirror);
+
+/**
+ * Function used to store the response times in NVS, so the fastest server is used first on the next boot
+ * NVS is only written if the stored state changed
+ */
+void ConfigMirrorsPersist();
+
+/**
+ * Function used to get the response times of every configuration server
+ * Returns the number of entries written
+ */
+size_t GetConfigMirrorInfo(ConfigMirrorInfo * infos, size_t max_infos);
+
+/**
+ * Decisions of a fetch of a configuration document from the configuration servers
+ * The servers are asked in the order of ConfigMirrorsGetOrder. The next one is asked if every request failed, or as a
+ * hedge if the last request did not receive a block within the hedge delay of its server. A request fails once it
+ * did not receive a block within its timeout, so a large document may take much longer in total.
+ * The outcome of every request is reported to the servers. The transport is up to the caller, LoadConfigDocument uses
+ * libcoap and config_mirror_harness plain UDP datagrams.
+ */
+class ConfigFetchPlan
+{
+public:
+    // Number of requests for a document in flight at the same time, including the hedged one
+    static constexpr size_t kMaxRequestsInFlight = 2;
+
+    enum class Action
+    {
+        // Send the request of the attempt to its server
+        kLaunch,
+        // Wait for responses until the given time at most
+        kWait,
+        // Every server failed
+        kGiveUp,
+    };
+
+    struct Step
+    {
+        Action action;
+        size_t attempt;
+        size_t mirror;
+        // Set if the request is sent while another one is still in flight
+        bool hedge;
+        int64_t wakeMs;
+    };
+
+    /**
+     * Without hedging the next server is only asked once every request failed
+     */
+    explicit ConfigFetchPlan(bool hedging = true);
+
+    /**
+     * Function used to decide what to do next, requests that made no progress within their timeout fail
+     */
+    Step Next(int64_t now_ms);
+
+    /**
+     * Function used to report that the request of an attempt has been sent
+     */
+    void Started(size_t attempt, int64_t now_ms, uint32_t timeout_ms);
+
+    /**
+     * Function used to report that a block of the document has been received for an attempt
+     */
+    void Progress(size_t attempt, int64_t now_ms);
+
+    /**
+     * Function used to report that an attempt received the whole document in the given number of blocks
+     * Returns true if the attempt is the first one that did
+     */
+    bool Completed(size_t attempt, int64_t now_ms, uint32_t blocks);
+
+    /**
+     * Function used to report that a request could not be sent or was answered with an error
+     */
+    void Failed(size_t attempt);
+
+    /**
+     * Function used to end the fetch, requests that are still in flight lost against the winner
+     */
+    void Finish(int64_t now_ms);
+
+    bool Finished(size_t attempt) const { return mAttempts[attempt].finished; }
+    bool HasWinner() const { return mHasWinner; }
+    size_t Launched() const { return mLaunched; }
+
+private:
+    struct Attempt
+    {
+        size_t mirror;
+        int64_t startMs;
+        // Time of the request or of the last block
+        int64_t progressMs;
+        uint32_t timeoutMs;
+        bool finished;
+    };
+
+    Attempt mAttempts[kMaxConfigMirrors];
+    size_t mOrder[kMaxConfigMirrors];
+    size_t mMirrorCount;
+    bool mHedging;
+    size_t mLaunched   = 0;
+    int64_t mHedgeAtMs = 0;
+    bool mHasWinner    = false;
+};
+
+#endif //CONFIG_MIRRORS_H
@@ -0,0 +1,74 @@
+#ifndef CONGESTION_CONTROL_H
+#define CONGESTION_CONTROL_H
+
+#include <coap3/coap.h>
+#include <cstddef>
+#include <cstdint>
+
+// Retransmission state of a CoAP destination
+struct CongestionInfo
+{
+    coap_address_t address;
+    // Overall retransmission timeout that is used for the next confirmable request
+    uint32_t rtoMs;
+    // Retransmission timeouts of the strong and the weak estimator, zero until their first sample
+    uint32_t strongRtoMs;
+    uint32_t weakRtoMs;
+    uint8_t outstanding;
+    uint32_t strongSamples;
+    uint32_t weakSamples;
+};
+
+/**
+ * Function used to check whether another request to a destination may be sent
+ * At most CONFIG_BRIDGE_COAP_NSTART requests are outstanding per destination
+ * Never waits, since it is called from the Matter event loop. Returns false if the limit has been reached
+ */
+bool CongestionAcquire(const coap_address_t * dst);
+
+/**
+ * Function used to mark a request acquired with CongestionAcquire as finished
+ */
+void CongestionRelease(const coap_address_t * dst);
+
+/**
+ * Function used to get the initial retransmission timeout of the next confirmable request to a destination
+ * The timeout is estimated as defined by CoCoA, unknown destinations start with the CoAP default of two seconds
+ */
+uint32_t CongestionGetRto(const coap_address_t * dst);
+
+/**
+ * Function used to get the time a confirmable request waits for its response, including all retransmissions
+ */
+unsigned int CongestionGetExchangeLifetime(uint32_t rto_ms);
+
+/**
+ * Function used to get the time a confirmable request waits for its response with the given number of retransmissions
+ */
+unsigned int CongestionGetExchangeLifetime(uint32_t rto_ms, uint8_t max_retransmit);
+
+/**
+ * Function used to get the number of retransmissions of a confirmable request whose exchange ends within a budget
+ * At most CONFIG_BRIDGE_COAP_MAX_RETRANSMIT, zero if not even the first transmission fits
+ */
+uint8_t CongestionGetMaxRetransmitWithin(uint32_t rto_ms, unsigned int budget_ms);
+
+/**
+ * Function used to apply the retransmission parameters of a destination to a client session
+ * Returns the retransmission timeout that has been applied
+ */
+uint32_t CongestionApplyToSession(coap_session_t * session, const coap_address_t * dst);
+
+/**
+ * Function used to report the round trip time of a request
+ * The time is measured from the first transmission, the request was retransmitted if it exceeds the initial timeout
+ */
+void CongestionReportRtt(const coap_address_t * dst, uint32_t rtt_ms, uint32_t initial_rto_ms);
+
+/**
+ * Function used to get the retransmission state of every known destination
+ * Returns the number of entries written
+ */
+size_t GetCongestionInfo(CongestionInfo * infos, size_t max_infos);
+
+#endif //CONGESTION_CONTROL_H
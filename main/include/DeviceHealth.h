@@ -0,0 +1,67 @@
+#ifndef DEVICE_HEALTH_H
+#define DEVICE_HEALTH_H
+
+#include <coap3/coap.h>
+#include <lib/core/CHIPError.h>
+#include <cstddef>
+#include <cstdint>
+
+class Device;
+
+// Health of a bridged LwM2M device as seen by the CoAP client
+struct DeviceHealthInfo
+{
+    bool reachable;
+    uint32_t consecutiveFailures;
+    // Smoothed round trip time and its variation, zero until the first response has been received
+    uint32_t srttMs;
+    uint32_t rttVarMs;
+    // Time until the next probe while the device is unreachable
+    uint32_t backoffMs;
+    uint32_t rejectedRequests;
+};
+
+/**
+ * Function used to track the health of the LwM2M device behind a CoAP URI
+ * The Reachable attribute of the bridged device follows the health of the LwM2M device
+ * Unreachable devices are probed with an exponential backoff until they answer again
+ * Must be called from the Matter event loop
+ */
+CHIP_ERROR TrackLwm2mDevice(const char * uri, Device * device);
+
+/**
+ * Function used to decide whether a request to a destination is sent
+ * Requests to an unreachable device fail fast, unless the next probe is due
+ * Destinations that are not tracked are always allowed
+ */
+bool Lwm2mDeviceAllowsRequest(const coap_address_t * dst);
+
+/**
+ * Function used to get the time a request waits for the response of a destination
+ * The time is derived from the measured round trip time, the default is used until the first response
+ */
+unsigned int Lwm2mDeviceRequestTimeout(const coap_address_t * dst, unsigned int default_ms);
+
+/**
+ * Function used to report a response of a destination together with its round trip time
+ */
+void Lwm2mDeviceReportSuccess(const coap_address_t * dst, uint32_t rtt_ms);
+
+/**
+ * Function used to report a NACK or a timeout of a destination
+ */
+void Lwm2mDeviceReportFailure(const coap_address_t * dst);
+
+/**
+ * Function used to report that a request let through by Lwm2mDeviceAllowsRequest was not sent for a local reason
+ * The health of the destination is left unchanged, a probe that was not sent can be retried at once
+ */
+void Lwm2mDeviceCancelRequest(const coap_address_t * dst);
+
+/**
+ * Function used to get the health of the LwM2M device that is bridged as the given device
+ * Returns false if the device is not tracked
+ */
+bool GetLwm2mDeviceHealth(const Device * device, DeviceHealthInfo & info);
+
+#endif //DEVICE_HEALTH_H
@@ -0,0 +1,99 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fixed-bucket histogram of durations in microseconds
+ * Every power of two is split into four buckets, so a percentile is off by at most 25 %
+ * Samples are recorded with relaxed atomics and may be added from any task without a lock
+ */
+class LatencyHistogram
+{
+public:
+    // Durations of 2^kMaxExponent microseconds (about 67 s) and above share the last bucket
+    static constexpr unsigned kSubBuckets  = 4;
+    static constexpr unsigned kMaxExponent = 26;
+    static constexpr size_t kBucketCount   = kSubBuckets + (kMaxExponent - 2) * kSubBuckets;
+
+    void Record(uint32_t value_us)
+    {
+        mBuckets[BucketIndex(value_us)].fetch_add(1, std::memory_order_relaxed);
+        mCount.fetch_add(1, std::memory_order_relaxed);
+        mSum.fetch_add(value_us, std::memory_order_relaxed);
+        uint32_t max = mMax.load(std::memory_order_relaxed);
+        while (value_us > max && !mMax.compare_exchange_weak(max, value_us, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint32_t Count() const { return mCount.load(std::memory_order_relaxed); }
+    uint32_t Max() const { return mMax.load(std::memory_order_relaxed); }
+
+    uint32_t Mean() const
+    {
+        uint32_t count = Count();
+        return count > 0 ? static_cast<uint32_t>(mSum.load(std::memory_order_relaxed) / count) : 0;
+    }
+
+    // Upper bound of the bucket holding the given percentile, in tenths of a percent (999 is p99.9)
+    uint32_t Percentile(uint32_t per_mille) const
+    {
+        uint32_t count = Count();
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t rank = (static_cast<uint64_t>(count) * per_mille + 999) / 1000;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; i++) {
+            seen += mBuckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank && seen > 0) {
+                uint32_t upper = BucketUpperBound(i);
+                return upper < Max() ? upper : Max();
+            }
+        }
+        return Max();
+    }
+
+    void Reset()
+    {
+        for (auto & bucket : mBuckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        mCount.store(0, std::memory_order_relaxed);
+        mSum.store(0, std::memory_order_relaxed);
+        mMax.store(0, std::memory_order_relaxed);
+    }
+
+    static constexpr size_t BucketIndex(uint32_t value_us)
+    {
+        if (value_us < kSubBuckets) {
+            return value_us;
+        }
+        unsigned exponent = 31u - static_cast<unsigned>(__builtin_clz(value_us));
+        if (exponent >= kMaxExponent) {
+            return kBucketCount - 1;
+        }
+        size_t sub = (value_us >> (exponent - 2)) & (kSubBuckets - 1);
+        return kSubBuckets + (exponent - 2) * kSubBuckets + sub;
+    }
+
+    static constexpr uint32_t BucketUpperBound(size_t index)
+    {
+        if (index < kSubBuckets) {
+            return static_cast<uint32_t>(index);
+        }
+        unsigned exponent = static_cast<unsigned>((index - kSubBuckets) / kSubBuckets) + 2;
+        uint32_t sub      = static_cast<uint32_t>((index - kSubBuckets) % kSubBuckets);
+        return ((kSubBuckets + sub + 1) << (exponent - 2)) - 1;
+    }
+
+private:
+    std::atomic<uint32_t> mBuckets[kBucketCount] = {};
+    std::atomic<uint32_t> mCount{ 0 };
+    std::atomic<uint64_t> mSum{ 0 };
+    std::atomic<uint32_t> mMax{ 0 };
+};
+
+#endif //LATENCY_HISTOGRAM_H
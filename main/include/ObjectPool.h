@@ -0,0 +1,150 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+/**
+ * Counters of an object pool
+ */
+struct ObjectPoolStats
+{
+    const char * name;
+    size_t capacity;
+    uint32_t allocations;
+    uint32_t failures;
+    uint32_t inUse;
+    uint32_t highWater;
+};
+
+/**
+ * Type independent part of an object pool
+ * Every pool adds itself to a list at static initialization, so the counters of all pools can be logged
+ */
+class ObjectPoolBase
+{
+public:
+    ObjectPoolBase(const char * name, size_t capacity) : mName(name), mCapacity(capacity), mNext(sFirst) { sFirst = this; }
+
+    ObjectPoolStats GetStats() const
+    {
+        return ObjectPoolStats{ mName,
+                                mCapacity,
+                                mAllocations.load(std::memory_order_relaxed),
+                                mFailures.load(std::memory_order_relaxed),
+                                mInUse.load(std::memory_order_relaxed),
+                                mHighWater.load(std::memory_order_relaxed) };
+    }
+
+    static const ObjectPoolBase * First() { return sFirst; }
+    const ObjectPoolBase * Next() const { return mNext; }
+
+protected:
+    void CountAllocation()
+    {
+        mAllocations.fetch_add(1, std::memory_order_relaxed);
+        uint32_t in_use = mInUse.fetch_add(1, std::memory_order_relaxed) + 1;
+        uint32_t high_water = mHighWater.load(std::memory_order_relaxed);
+        while (in_use > high_water && !mHighWater.compare_exchange_weak(high_water, in_use, std::memory_order_relaxed)) {
+        }
+    }
+    void CountFailure() { mFailures.fetch_add(1, std::memory_order_relaxed); }
+    void CountRelease() { mInUse.fetch_sub(1, std::memory_order_relaxed); }
+
+private:
+    // The head of the list is constant initialized, so it is valid before any pool is constructed
+    static inline ObjectPoolBase * sFirst = nullptr;
+
+    const char * mName;
+    size_t mCapacity;
+    ObjectPoolBase * mNext;
+    std::atomic<uint32_t> mAllocations{ 0 };
+    std::atomic<uint32_t> mFailures{ 0 };
+    std::atomic<uint32_t> mInUse{ 0 };
+    std::atomic<uint32_t> mHighWater{ 0 };
+};
+
+/**
+ * Fixed capacity pool of objects that never touches the heap
+ * Slots are claimed with a compare-and-swap on an occupancy bitmap, so objects can be allocated
+ * and released from any task without a lock
+ */
+template <typename T, size_t N>
+class ObjectPool : public ObjectPoolBase
+{
+    static_assert(N > 0, "An object pool needs at least one slot");
+
+public:
+    explicit ObjectPool(const char * name) : ObjectPoolBase(name, N) {}
+
+    // Construct an object in a free slot, returns nullptr if the pool is exhausted
+    template <typename... Args>
+    T * Allocate(Args &&... args)
+    {
+        for (size_t word = 0; word < kWordCount; word++) {
+            uint32_t occupied = mOccupied[word].load(std::memory_order_relaxed);
+            while (true) {
+                uint32_t free_bits = ~occupied & WordMask(word);
+                if (free_bits == 0) {
+                    break;
+                }
+                uint32_t bit = free_bits & (~free_bits + 1);
+                if (mOccupied[word].compare_exchange_weak(occupied, occupied | bit, std::memory_order_acquire,
+                                                          std::memory_order_relaxed)) {
+                    CountAllocation();
+                    return new (&mSlots[word * 32 + static_cast<size_t>(__builtin_ctz(bit))]) T(std::forward<Args>(args)...);
+                }
+            }
+        }
+        CountFailure();
+        return nullptr;
+    }
+
+    // Destroy an object returned by Allocate and free its slot
+    void Release(T * object)
+    {
+        size_t index = static_cast<size_t>(reinterpret_cast<Slot *>(object) - mSlots);
+        object->~T();
+        CountRelease();
+        mOccupied[index / 32].fetch_and(~(1u << (index % 32)), std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t kWordCount = (N + 31) / 32;
+
+    // Only the bits of existing slots can be claimed in the last word
+    static constexpr uint32_t WordMask(size_t word)
+    {
+        return (word + 1) * 32 <= N ? UINT32_MAX : (1u << (N % 32)) - 1;
+    }
+
+    struct Slot
+    {
+        alignas(T) uint8_t storage[sizeof(T)];
+    };
+
+    Slot mSlots[N];
+    std::atomic<uint32_t> mOccupied[kWordCount] = {};
+};
+
+/**
+ * Function used to log the counters of every object pool together with the state of the heap
+ */
+void LogObjectPoolStats();
+
+/**
+ * Function used to get the fragmentation of the heap in percent
+ * This is the share of the free heap that is not part of the largest free block
+ */
+uint8_t GetHeapFragmentation();
+
+/**
+ * Function used to start logging the counters periodically
+ * Has to be called from the Matter event loop
+ */
+void StartObjectPoolStats();
+
+#endif //OBJECT_POOL_H
@@ -0,0 +1,49 @@
+#ifndef SESSION_KEEPER_H
+#define SESSION_KEEPER_H
+
+#include <lib/core/CHIPError.h>
+#include <lib/core/ScopedNodeId.h>
+#include <cstddef>
+#include <cstdint>
+
+// State of the CASE session to a bound peer
+enum class PeerSessionState : uint8_t
+{
+    kIdle = 0,
+    kConnecting,
+    kConnected,
+    kFailed,
+};
+
+// Snapshot of the CASE session to a bound peer
+struct PeerSessionInfo
+{
+    chip::ScopedNodeId peer;
+    PeerSessionState state;
+    // Duration of the last successful session establishment, zero if the session was already available
+    uint32_t lastHandshakeMs;
+    uint32_t handshakeCount;
+    uint32_t failureCount;
+};
+
+/**
+ * Function used to start the session keeper
+ * Sessions to all unicast binding targets are established right away, afterwards a keepalive read is sent
+ * periodically and sessions that have been dropped are re-established
+ * Must be called from the Matter event loop after the binding manager has been initialized
+ */
+void StartSessionKeeper();
+
+/**
+ * Function used to establish sessions to all unicast binding targets that are not connected yet
+ * Should be called whenever the binding table has changed, must be called from the Matter event loop
+ */
+void WarmBoundPeerSessions();
+
+/**
+ * Function used to get the state of the sessions to all bound peers
+ * Returns the number of entries written, must be called from the Matter event loop
+ */
+size_t GetPeerSessionInfo(PeerSessionInfo * infos, size_t max_infos);
+
+#endif //SESSION_KEEPER_H
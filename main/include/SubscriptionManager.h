@@ -0,0 +1,41 @@
+#ifndef SUBSCRIPTION_MANAGER_H
+#define SUBSCRIPTION_MANAGER_H
+
+#include "BindingHandler.h"
+#include <app/OperationalSessionSetup.h>
+#include <app/util/binding-table.h>
+
+/**
+ * Function used to subscribe to all attributes of a cluster of a bound device
+ * Reports are kept in the attribute shadow, an existing subscription for the same device and cluster is reused
+ * Must be called from the Matter event loop with a connected peer device
+ */
+CHIP_ERROR SubscribeBoundCluster(const EmberBindingTableEntry & binding, chip::OperationalDeviceProxy * peer_device);
+
+/**
+ * Function used to subscribe to every cluster in the binding table
+ * Must be called from the Matter event loop
+ */
+void SubscribeBoundClusters();
+
+/**
+ * Function used to end every subscription whose binding has been removed from the binding table
+ * The shadowed attributes of the ended subscriptions are invalidated, must be called from the Matter event loop
+ */
+void UnsubscribeRemovedBindings();
+
+/**
+ * Function used to drop the shadowed value of an attribute the bridge writes to a bound device
+ * Reads fall back to a read interaction until the subscription reports the attribute again, so a read right after a
+ * write never returns the value from before the write, can be called from any task
+ */
+void InvalidateShadowAttribute(chip::FabricIndex fabricIndex, chip::NodeId nodeId, chip::EndpointId endpointId,
+                               chip::ClusterId clusterId, chip::AttributeId attributeId);
+
+/**
+ * Function used to get the last reported value of an attribute of the device a local endpoint is bound to
+ * Returns false if no valid value is available or the endpoint is kInvalidEndpointId, can be called from any task
+ */
+bool GetShadowAttribute(chip::EndpointId endpoint, chip::ClusterId clusterId, chip::AttributeId attributeId, TlvValue & value);
+
+#endif //SUBSCRIPTION_MANAGER_H
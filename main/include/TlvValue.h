@@ -0,0 +1,57 @@
+#ifndef TLV_VALUE_H
+#define TLV_VALUE_H
+
+#include "sdkconfig.h"
+#include <lib/core/CHIPError.h>
+#include <lib/core/TLVReader.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Bytes a single anonymous element needs besides its value: the control byte and the length of a string
+constexpr size_t kTlvElementOverhead = 2;
+// Largest value of a mapped attribute, integers and floats need up to 8 bytes
+constexpr size_t kMaxAttributeValueSize = std::max<size_t>(CONFIG_BRIDGE_MAX_ATTRIBUTE_SIZE, sizeof(uint64_t));
+// Maximum length of a TLV encoded attribute value or of the fields of a command
+constexpr size_t kMaxTlvValueLength = kMaxAttributeValueSize + kTlvElementOverhead;
+static_assert(kMaxTlvValueLength <= UINT8_MAX, "The length of a TlvValue is stored in a single byte");
+
+/**
+ * Attribute value or command fields encoded as a single anonymous Matter TLV element
+ * The element is stored inline, so it can be handed between tasks without any heap allocation
+ * An empty value is used as an empty structure for the fields of a command
+ */
+struct TlvValue
+{
+    uint8_t buffer[kMaxTlvValueLength];
+    uint8_t length = 0;
+
+    bool IsEmpty() const { return length == 0; }
+
+    CHIP_ERROR EncodeBoolean(bool value);
+    CHIP_ERROR EncodeUnsigned(uint64_t value);
+    CHIP_ERROR EncodeSigned(int64_t value);
+    CHIP_ERROR EncodeFloat(float value);
+    CHIP_ERROR EncodeString(const char * value, size_t len);
+    CHIP_ERROR EncodeEmptyStructure();
+
+    /**
+     * Function used to encode the text representation of a LwM2M resource
+     * The type of the LwM2M resource decides which TLV type is used
+     */
+    CHIP_ERROR EncodeLwm2mText(const std::string & type, const char * text, size_t len);
+
+    /**
+     * Function used to copy the element a reader is positioned on, e.g. a reported attribute value
+     * Fails with CHIP_ERROR_BUFFER_TOO_SMALL if the element is larger than kMaxTlvValueLength
+     */
+    CHIP_ERROR CopyElement(chip::TLV::TLVReader & reader);
+
+    /**
+     * Function used to get a reader that is positioned on the encoded element
+     */
+    CHIP_ERROR GetReader(chip::TLV::TLVReader & reader) const;
+};
+
+#endif //TLV_VALUE_H
@@ -35,10 +35,14 @@
 #include <lib/support/ZclString.h>
 #include <platform/ESP32/ESP32Utils.h>
 #include <common/Esp32ThreadInit.h>
+#include <app/CommandHandler.h>
 #include <app/InteractionModelEngine.h>
 #include <lib/core/ErrorStr.h>
 #include <app/server/Server.h>
 #include "LwM2MObject.hpp"
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <list>
 #include <optional>
 #include "matter.h"
@@ -49,9 +53,21 @@
 
 #include "esp_netif.h"
 #include "esp_pthread.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "BridgeArena.h"
+#include "BridgeLatency.h"
+#include "BridgeMemory.h"
+#include "BridgeMetrics.h"
+#include "BridgeReload.h"
+#include "BridgeTrace.h"
 #include "BridgeUtils.h"
 #include "CoapServer.h"
 #include "CoapClient.h"
+#include "ConfigDiff.h"
+#include "ConfigMirrors.h"
+#include "DeviceHealth.h"
+#include "ObjectPool.h"
 #include <coap3/coap.h>
 #include <nlohmann/json.hpp>
 #include <pugixml.hpp>
@@ -107,6 +123,8 @@ static Device gLight1("Light 1", "Office");
 // Mapping between Matter and LwM2M
 static MatterIpsoMapping matter_mapping;
 
+void HandleDeviceStatusChanged(Device * dev, Device::Changed_t itemChangedMask);
+
 // (taken from chip-devices.xml)
 #define DEVICE_TYPE_BRIDGED_NODE 0x0013
 // (taken from lo-devices.xml)
@@ -120,6 +138,57 @@ static MatterIpsoMapping matter_mapping;
 // Device Version for dynamic endpoints:
 #define DEVICE_VERSION_DEFAULT 1
 
+// Stack size of the task that loads the configuration and afterwards runs the CoAP server
+#define BRIDGE_CONFIG_TASK_STACK_SIZE 8192
+// Time the configuration task waits before a configuration that could not be loaded or converted is loaded again
+#define BRIDGE_CONFIG_RETRY_DELAY_MS 10000
+// Stack size of the task that forwards invoked commands to the LwM2M device
+#define BRIDGE_COMMAND_TASK_STACK_SIZE 4096
+// Stack size of the task that reloads the configuration, it converts the configuration like the configuration task
+#define BRIDGE_RELOAD_TASK_STACK_SIZE BRIDGE_CONFIG_TASK_STACK_SIZE
+// Attempts to hand a step of a reload over to the next task and the time between them, the CoAP server has a single
+// work slot that is busy until its task has run the previous work
+#define BRIDGE_RELOAD_HANDOFF_ATTEMPTS 50
+#define BRIDGE_RELOAD_HANDOFF_RETRY_MS 20
+// Time the attribute callbacks on the Matter event loop wait at most for the answer of a LwM2M device
+#define BRIDGE_MATTER_LOOP_WAIT_MS 1000
+// Size of the arguments of a LwM2M execute operation
+#define BRIDGE_EXECUTE_PAYLOAD_SIZE 32
+// Size of the URI of a LwM2M resource on the bridged device
+#define BRIDGE_TARGET_URI_SIZE 96
+// Size of the URI of a bridged LwM2M device without the path of a resource
+#define BRIDGE_DEVICE_URI_SIZE 64
+
+// URI of the LwM2M device that is bridged on a dynamic endpoint, indexed like gDevices
+static char gLwm2mDeviceUris[CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT][BRIDGE_DEVICE_URI_SIZE];
+
+/**
+ * Function used to get the URI of the LwM2M device that is bridged on a dynamic endpoint
+ * Returns nullptr if no LwM2M device is bridged on the endpoint
+ */
+static const char * GetLwm2mDeviceUri(uint16_t endpointIndex)
+{
+    if (endpointIndex >= CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT || gLwm2mDeviceUris[endpointIndex][0] == '\0') {
+        return nullptr;
+    }
+    return gLwm2mDeviceUris[endpointIndex];
+}
+
+/**
+ * Function used to check whether the LwM2M device bridged as a device is known to be unreachable
+ * The attribute callbacks fail at once instead of blocking the Matter event loop, the probes of the device health
+ * tracking find out when it answers again
+ */
+static bool IsLwm2mDeviceUnreachable(const Device * device)
+{
+    DeviceHealthInfo health;
+    if (device == nullptr || !GetLwm2mDeviceHealth(device, health) || health.reachable) {
+        return false;
+    }
+    BridgeMetricIncrement(BridgeCounter::kCoapClientRejected);
+    return true;
+}
+
 /**
  * This code is left to showcase the original intended use of the bridge in comparison 
  * to the newly added dynamic generation of an endpoint based on an converted sdf-model
@@ -249,82 +318,124 @@ CHIP_ERROR RemoveDeviceEndpoint(Device * dev)
  */
 matter::Cluster LoadClusterDefinition()
 {
-    const char* cluster_xml_uri = "coap://[2a02:8109:c40:7cc6:8150:45c1:c796:5026]:5683/xml/cluster-xml";
-    LoadClusterXmlFile(cluster_xml_uri);
+    LoadClusterXmlFile("/xml/cluster-xml");
     // Parse the cluster xml into a cluster object
     matter::Cluster cluster = matter::ParseCluster(cluster_xml.document_element());
     cluster_xml.reset();
     return cluster;
 }
 
+// Positions of the converted clusters in the cluster list of the custom endpoint
+constexpr uint8_t kCustomServerClusterIndex = 0;
+constexpr uint8_t kCustomClientClusterIndex = 1;
+// Converted server and client cluster, Descriptor, Bridged Device Basic Information and Binding
+constexpr uint8_t kCustomClusterCount = 5;
+
+// Metadata of the converted clusters, the dynamic endpoints keep referencing it
+// Only changed on the Matter event loop, a reload replaces it together with the entries of the cluster lists
+static std::vector<EmberAfAttributeMetadata> gCustomServerAttributes;
+static std::vector<CommandId> gCustomServerCommands;
+static std::vector<EmberAfAttributeMetadata> gCustomClientAttributes;
+static std::vector<CommandId> gCustomClientCommands;
+// Cluster lists, endpoint types and device types of the bridged LwM2M devices, the dynamic endpoints keep referencing them
+// Every device has its own copy, so no endpoint aliases the storage of another one
+static EmberAfCluster gCustomClusters[CONFIG_BRIDGE_LWM2M_DEVICE_COUNT][kCustomClusterCount];
+static EmberAfEndpointType gCustomEndpoints[CONFIG_BRIDGE_LWM2M_DEVICE_COUNT];
+static EmberAfDeviceType gCustomDeviceTypes[CONFIG_BRIDGE_LWM2M_DEVICE_COUNT][2];
+static DataVersion gCustomDataVersions[CONFIG_BRIDGE_LWM2M_DEVICE_COUNT][kCustomClusterCount];
+// Bridged LwM2M devices, one per dynamic endpoint
+static std::list<Device> gBridgedCustomDevices;
+
 /**
- * Function used to generate a custom bridged device based on the given device type and list of clusters
+ * Function used to build the attribute metadata of a converted cluster
  */
-int CreateCustomDevice(matter::Device& device, std::list<matter::Cluster>& clusters) {   
-    ChipLogError(DeviceLayer, "Creating a custom endpoint");
-
-    // Set the device type for the bridged endpoint
-    const EmberAfDeviceType gBridgedCustomDeviceTypes[] = { { static_cast<chip::DeviceTypeId>(device.id), DEVICE_VERSION_DEFAULT },
-                                                    { DEVICE_TYPE_BRIDGED_NODE, DEVICE_VERSION_DEFAULT } };
-    // We limit this to the first cluster for this poc as the device type definition only contains two clusters
-    matter::Cluster cluster;
-    if (!clusters.empty()) {
-        cluster = clusters.front();
-    } else {
-        return -1;
-    }
-    
-    // Create everything neccessary for the server Cluster
-    // Create the list of attributes
-    std::vector<EmberAfAttributeMetadata> cluster_attributes;
+static std::vector<EmberAfAttributeMetadata> BuildAttributeMetadata(const matter::Cluster & cluster)
+{
+    std::vector<EmberAfAttributeMetadata> attributes;
     for (const auto& attribute : cluster.attributes) {
         // Just for demonstrating purposes
         // In a fully featured version, there would exist a mapper from the type to its ZAP_TYPE
+        EmberAfAttributeMetadata metadata;
         if (attribute.type == "bool") {
-            cluster_attributes.push_back(DECLARE_DYNAMIC_ATTRIBUTE(attribute.id, BOOLEAN, 1, 0));
+            metadata = DECLARE_DYNAMIC_ATTRIBUTE(attribute.id, BOOLEAN, 1, 0);
         } else if (attribute.type == "uint16") {
-            cluster_attributes.push_back(DECLARE_DYNAMIC_ATTRIBUTE(attribute.id, INT16U, 16, 0));
+            metadata = DECLARE_DYNAMIC_ATTRIBUTE(attribute.id, INT16U, 16, 0);
+        } else {
+            continue;
         }
+        // Values are handed between the tasks in inline buffers, larger attributes cannot be forwarded
+        if (metadata.size > kMaxAttributeValueSize) {
+            ChipLogError(DeviceLayer, "Attribute 0x%" PRIx32 " exceeds the maximum attribute size of %u bytes",
+                         static_cast<uint32_t>(attribute.id), static_cast<unsigned>(kMaxAttributeValueSize));
+            continue;
+        }
+        attributes.push_back(metadata);
     }
-    cluster_attributes.push_back({ZAP_EMPTY_DEFAULT(), 0xFFFD, 2, ZAP_TYPE(INT16U), ZAP_ATTRIBUTE_MASK(EXTERNAL_STORAGE)}); // Cluster Revision
+    attributes.push_back({ZAP_EMPTY_DEFAULT(), 0xFFFD, 2, ZAP_TYPE(INT16U), ZAP_ATTRIBUTE_MASK(EXTERNAL_STORAGE)}); // Cluster Revision
+    return attributes;
+}
 
-    // Create the list of commands
-    std::vector<CommandId> cluster_incomming_commands;
+/**
+ * Function used to build the list of commands a converted cluster accepts
+ */
+static std::vector<CommandId> BuildAcceptedCommands(const matter::Cluster & cluster)
+{
+    std::vector<CommandId> commands;
     for (const auto& command : cluster.client_commands) {
-        cluster_incomming_commands.push_back(command.id);
+        commands.push_back(command.id);
     }
     // Invalid command id
-    cluster_incomming_commands.push_back(kInvalidCommandId);
-    
-    // Client cluster loaded from the definition of the Matter device
-    // This is part of the PoC as normally this information would also be available if a LwM2M converter would be usable on the bridge
-    // This object has to be static to ensure its lifetime beyond this function
-    static matter::Cluster client_cluster = LoadClusterDefinition();
-    
-    // Create everything neccessary for the client Cluster
-    // Create the list of attributes
-    std::vector<EmberAfAttributeMetadata> client_cluster_attributes;
-    for (const auto& attribute : client_cluster.attributes) {
-        // Just for demonstrating purposes
-        // In a fully featured version, there would exist a mapper from the type to its ZAP_TYPE
-        if (attribute.type == "bool") {
-            client_cluster_attributes.push_back(DECLARE_DYNAMIC_ATTRIBUTE(attribute.id, BOOLEAN, 1, 0));
-        } else if (attribute.type == "uint16") {
-            client_cluster_attributes.push_back(DECLARE_DYNAMIC_ATTRIBUTE(attribute.id, INT16U, 16, 0));
-        }
+    commands.push_back(kInvalidCommandId);
+    return commands;
+}
+
+/**
+ * Function used to point an entry of the custom cluster list to the given metadata
+ */
+static void SetCustomClusterMetadata(EmberAfCluster & cluster, const std::vector<EmberAfAttributeMetadata> & attributes,
+                                     const std::vector<CommandId> & commands)
+{
+    cluster.attributes          = attributes.data();
+    cluster.attributeCount      = static_cast<uint16_t>(attributes.size());
+    cluster.acceptedCommandList = commands.data();
+}
+
+/**
+ * Function used to format the name of the bridged LwM2M device with the given index
+ */
+static void FormatBridgedDeviceName(char * name, size_t size, const matter::Device & device, uint16_t index)
+{
+    if (CONFIG_BRIDGE_LWM2M_DEVICE_COUNT > 1) {
+        snprintf(name, size, "%s %u", device.name.c_str(), index + 1);
+    } else {
+        snprintf(name, size, "%s", device.name.c_str());
     }
-    client_cluster_attributes.push_back({ZAP_EMPTY_DEFAULT(), 0xFFFD, 2, ZAP_TYPE(INT16U), ZAP_ATTRIBUTE_MASK(EXTERNAL_STORAGE)}); // Cluster Revision
+}
+
+/**
+ * Function used to generate a custom bridged device based on the given device type and list of clusters
+ */
+int CreateCustomDevice(matter::Device& device, std::list<matter::Cluster>& clusters, matter::Cluster& client_cluster) {   
+    ChipLogError(DeviceLayer, "Creating a custom endpoint");
 
-    // Create the list of commands
-    std::vector<CommandId> client_cluster_incomming_commands;
-    for (const auto& command : client_cluster.client_commands) {
-        client_cluster_incomming_commands.push_back(command.id);
+    // Note that the attribute lists below are static as the dynamic endpoints keep referencing them after this function returns
+    // They are never changed, so every endpoint can use them
+    // We limit this to the first cluster for this poc as the device type definition only contains two clusters
+    matter::Cluster cluster;
+    if (!clusters.empty()) {
+        cluster = clusters.front();
+    } else {
+        return -1;
     }
-    // Invalid command id
-    client_cluster_incomming_commands.push_back(kInvalidCommandId);
+    
+    // Create the lists of attributes and commands of the server and the client cluster
+    gCustomServerAttributes = BuildAttributeMetadata(cluster);
+    gCustomServerCommands   = BuildAcceptedCommands(cluster);
+    gCustomClientAttributes = BuildAttributeMetadata(client_cluster);
+    gCustomClientCommands   = BuildAcceptedCommands(client_cluster);
 
     // Declare the Descriptor cluster attributes
-    DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(descriptorCustomAttrs)
+    static DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(descriptorCustomAttrs)
         DECLARE_DYNAMIC_ATTRIBUTE(Descriptor::Attributes::DeviceTypeList::Id, ARRAY, kDescriptorAttributeArraySize, 0), // device list
         DECLARE_DYNAMIC_ATTRIBUTE(Descriptor::Attributes::ServerList::Id, ARRAY, kDescriptorAttributeArraySize, 0),     // server list
         DECLARE_DYNAMIC_ATTRIBUTE(Descriptor::Attributes::ClientList::Id, ARRAY, kDescriptorAttributeArraySize, 0),     // client list
@@ -332,38 +443,65 @@ int CreateCustomDevice(matter::Device& device, std::list<matter::Cluster>& clust
     DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
 
     // Declare the Bridged Device Basic Information cluster attributes
-    DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(bridgedCustomDeviceBasicAttrs)
+    static DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(bridgedCustomDeviceBasicAttrs)
         DECLARE_DYNAMIC_ATTRIBUTE(BridgedDeviceBasicInformation::Attributes::NodeLabel::Id, CHAR_STRING, kNodeLabelSize, 0), // NodeLabel
         DECLARE_DYNAMIC_ATTRIBUTE(BridgedDeviceBasicInformation::Attributes::Reachable::Id, BOOLEAN, 1, 0),                  // Reachable
     DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
 
     // Declare the Binding cluster attribute
-    DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(bridgedBindingClusterAttributes)
+    static DECLARE_DYNAMIC_ATTRIBUTE_LIST_BEGIN(bridgedBindingClusterAttributes)
         DECLARE_DYNAMIC_ATTRIBUTE(Binding::Attributes::Binding::Id, ARRAY, kBindingAttributeArraySize, 1), // Binding
     DECLARE_DYNAMIC_ATTRIBUTE_LIST_END();
 
     // Were adding the generated cluster in combination with other utility clusters
     // Keep in mind that this demonstration only supports a single cluster
-    DECLARE_DYNAMIC_CLUSTER_LIST_BEGIN(BridgedCustomClusters)
-        DECLARE_DYNAMIC_CUSTOM_CLUSTER(cluster.id, cluster_attributes.data(), static_cast<uint16_t>(cluster_attributes.size()), cluster_incomming_commands.data(), nullptr), // Custom Server Cluster
-        DECLARE_DYNAMIC_CUSTOM_CLUSTER(client_cluster.id, client_cluster_attributes.data(), static_cast<uint16_t>(client_cluster_attributes.size()), client_cluster_incomming_commands.data(), nullptr), // Custom Client Cluster
+    // The list is a template that is copied for every device, a reload replaces the metadata of the converted clusters in the copies
+    DECLARE_DYNAMIC_CUSTOM_CLUSTER_LIST_BEGIN(BridgedCustomClusters)
+        DECLARE_DYNAMIC_CUSTOM_CLUSTER(cluster.id, gCustomServerAttributes.data(), static_cast<uint16_t>(gCustomServerAttributes.size()), gCustomServerCommands.data(), nullptr), // Custom Server Cluster
+        DECLARE_DYNAMIC_CUSTOM_CLUSTER(client_cluster.id, gCustomClientAttributes.data(), static_cast<uint16_t>(gCustomClientAttributes.size()), gCustomClientCommands.data(), nullptr), // Custom Client Cluster
         DECLARE_DYNAMIC_CLUSTER(Descriptor::Id, descriptorCustomAttrs, nullptr, nullptr),                      // Descriptor Cluster
         DECLARE_DYNAMIC_CLUSTER(BridgedDeviceBasicInformation::Id, bridgedCustomDeviceBasicAttrs, nullptr, nullptr), // Bridged Device Basic Information Cluster
         DECLARE_DYNAMIC_CLUSTER(Binding::Id, bridgedBindingClusterAttributes, nullptr, nullptr) // Binding Cluster
-    DECLARE_DYNAMIC_CLUSTER_LIST_END;
-
-    // Declare the dynamic endpoint
-    DECLARE_DYNAMIC_ENDPOINT(BridgedCustomEndpoint, BridgedCustomClusters);
-    
-    DataVersion gCustomDataVersions[ArraySize(BridgedCustomClusters)];
-    
-    // Add the endpoint to the node of the bridge
-    static Device bridged_custom_device(device.name.c_str(), "No Location");
-    AddDeviceEndpoint(&bridged_custom_device, &BridgedCustomEndpoint, Span<const EmberAfDeviceType>(gBridgedCustomDeviceTypes),
-                      Span<DataVersion>(gCustomDataVersions), 1);
-    
-    // Set the device as reachable
-    bridged_custom_device.SetReachable(true);
+    DECLARE_DYNAMIC_CUSTOM_CLUSTER_LIST_END;
+    static_assert(ArraySize(BridgedCustomClusters) == kCustomClusterCount, "The cluster list does not match its storage");
+
+    // Every LwM2M device gets its own endpoint with its own cluster list and device types
+    // Device i listens on the configured port + i, like a fleet of simulated devices
+    for (uint16_t i = 0; i < CONFIG_BRIDGE_LWM2M_DEVICE_COUNT; i++) {
+        char name[Device::kDeviceNameSize];
+        char uri[BRIDGE_DEVICE_URI_SIZE];
+        FormatBridgedDeviceName(name, sizeof(name), device, i);
+        snprintf(uri, sizeof(uri), "%s:%u", CONFIG_BRIDGE_LWM2M_DEVICE_HOST, CONFIG_BRIDGE_LWM2M_DEVICE_PORT + i);
+
+        // Declare the dynamic endpoint and set the device type for it
+        std::copy(std::begin(BridgedCustomClusters), std::end(BridgedCustomClusters), gCustomClusters[i]);
+        gCustomEndpoints[i]      = { gCustomClusters[i], kCustomClusterCount, 0 };
+        gCustomDeviceTypes[i][0] = { static_cast<chip::DeviceTypeId>(device.id), DEVICE_VERSION_DEFAULT };
+        gCustomDeviceTypes[i][1] = { DEVICE_TYPE_BRIDGED_NODE, DEVICE_VERSION_DEFAULT };
+
+        // Add the endpoint to the node of the bridge
+        Device & bridged_custom_device = gBridgedCustomDevices.emplace_back(name, "No Location");
+        bridged_custom_device.SetChangeCallback(&HandleDeviceStatusChanged);
+        int index = AddDeviceEndpoint(&bridged_custom_device, &gCustomEndpoints[i],
+                                      Span<const EmberAfDeviceType>(gCustomDeviceTypes[i]),
+                                      Span<DataVersion>(gCustomDataVersions[i]), 1);
+        if (index < 0) {
+            ChipLogError(DeviceLayer, "Cannot bridge the LwM2M device %s", uri);
+            gBridgedCustomDevices.pop_back();
+            return -1;
+        }
+        strncpy(gLwm2mDeviceUris[index], uri, sizeof(gLwm2mDeviceUris[index]) - 1);
+        // Requests on the object instance of the device are routed through the bindings of its endpoint
+        SetCoapInstanceEndpoint(i, bridged_custom_device.GetEndpointId());
+
+        // Set the device as reachable
+        // Afterwards the reachability follows the health of the LwM2M device
+        bridged_custom_device.SetReachable(true);
+        CHIP_ERROR err = TrackLwm2mDevice(uri, &bridged_custom_device);
+        if (err != CHIP_NO_ERROR) {
+            ChipLogError(DeviceLayer, "Cannot track the health of the LwM2M device %s: %" CHIP_ERROR_FORMAT, uri, err.Format());
+        }
+    }
 
     return 0;
 }
@@ -377,20 +515,35 @@ Protocols::InteractionModel::Status emberAfExternalAttributeReadCallback(Endpoin
                                                                          uint8_t * buffer, uint16_t maxReadLength)
 {
     uint16_t endpointIndex = emberAfGetDynamicIndexFromEndpoint(endpoint);
+    const char * device_uri = GetLwm2mDeviceUri(endpointIndex);
 
-    if ((endpointIndex < CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT) && (gDevices[endpointIndex] != NULL))
+    if ((device_uri != nullptr) && (gDevices[endpointIndex] != NULL))
     {
         AttributeId attribute_id = attributeMetadata->attributeId;
         // Translate the cluster and attribute id into a object and a resource id
         int ipso_object_id = matter_mapping.cluster_object_map.get_ipso_id(clusterId);
         int ipso_resource_id = matter_mapping.attribute_resource_map.get_ipso_id(attribute_id);
-        std::string target = "coap://[fd73:13f6:c3ed:1:d8bd:9673:d9cd:a562]:5184/";
-        // Build the target uri basd on the translated ids
-        target.append(std::to_string(ipso_object_id));
-        target.append("/0/");
-        target.append(std::to_string(ipso_resource_id));
+        BridgeLatencyScope latency(BridgePath::kMatterRead);
+        BridgeTraceScope trace(BridgeTraceNewId(), "matter.read_callback");
+        // Build the target uri based on the translated ids
+        char target[BRIDGE_TARGET_URI_SIZE];
+        int target_len = snprintf(target, sizeof(target), "%s/%d/0/%d", device_uri, ipso_object_id, ipso_resource_id);
+        if (target_len < 0 || static_cast<size_t>(target_len) >= sizeof(target)) {
+            latency.SetSuccess(false);
+            return Protocols::InteractionModel::Status::Failure;
+        }
         // Send the CoAP GET request
-        CoapClientGet(target.c_str(), reinterpret_cast<char*>(buffer), maxReadLength);
+        // Fails right away while the LwM2M device is unreachable, the wait for the answer blocks the Matter event loop
+        // and is bounded
+        if (IsLwm2mDeviceUnreachable(gDevices[endpointIndex])) {
+            latency.SetSuccess(false);
+            return Protocols::InteractionModel::Status::Failure;
+        }
+        CoapClientWaitBudgetScope budget(BRIDGE_MATTER_LOOP_WAIT_MS);
+        if (CoapClientGet(target, reinterpret_cast<char*>(buffer), maxReadLength) != EXIT_SUCCESS) {
+            latency.SetSuccess(false);
+            return Protocols::InteractionModel::Status::Failure;
+        }
         return Protocols::InteractionModel::Status::Success;
     }
 
@@ -406,20 +559,35 @@ Protocols::InteractionModel::Status emberAfExternalAttributeWriteCallback(Endpoi
                                                                           uint8_t * buffer)
 {
     uint16_t endpointIndex = emberAfGetDynamicIndexFromEndpoint(endpoint);
+    const char * device_uri = GetLwm2mDeviceUri(endpointIndex);
 
-    if (endpointIndex < CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT)
+    if (device_uri != nullptr)
     {
         AttributeId attribute_id = attributeMetadata->attributeId;
         // Translate the cluster and attribute id into a object and a resource id
         int ipso_object_id = matter_mapping.cluster_object_map.get_ipso_id(clusterId);
         int ipso_resource_id = matter_mapping.attribute_resource_map.get_ipso_id(attribute_id);
-        std::string target = "coap://[fd73:13f6:c3ed:1:d8bd:9673:d9cd:a562]:5184/";
-        // Build the target uri basd on the translated ids
-        target.append(std::to_string(ipso_object_id));
-        target.append("/0/");
-        target.append(std::to_string(ipso_resource_id));
+        BridgeLatencyScope latency(BridgePath::kMatterWrite);
+        BridgeTraceScope trace(BridgeTraceNewId(), "matter.write_callback");
+        // Build the target uri based on the translated ids
+        char target[BRIDGE_TARGET_URI_SIZE];
+        int target_len = snprintf(target, sizeof(target), "%s/%d/0/%d", device_uri, ipso_object_id, ipso_resource_id);
+        if (target_len < 0 || static_cast<size_t>(target_len) >= sizeof(target)) {
+            latency.SetSuccess(false);
+            return Protocols::InteractionModel::Status::Failure;
+        }
         // Send the CoAP PUT request
-        CoapClientPut(target.c_str(), reinterpret_cast<char*>(buffer), attributeMetadata->size);
+        // Fails right away while the LwM2M device is unreachable, the wait for the answer blocks the Matter event loop
+        // and is bounded
+        if (IsLwm2mDeviceUnreachable(gDevices[endpointIndex])) {
+            latency.SetSuccess(false);
+            return Protocols::InteractionModel::Status::Failure;
+        }
+        CoapClientWaitBudgetScope budget(BRIDGE_MATTER_LOOP_WAIT_MS);
+        if (CoapClientPut(target, reinterpret_cast<char*>(buffer), attributeMetadata->size) != EXIT_SUCCESS) {
+            latency.SetSuccess(false);
+            return Protocols::InteractionModel::Status::Failure;
+        }
         return Protocols::InteractionModel::Status::Success;
     }
 
@@ -427,21 +595,150 @@ Protocols::InteractionModel::Status emberAfExternalAttributeWriteCallback(Endpoi
 }
 
 /**
- * These are functions leftover from the original implementation
- * These are left to showcase the original function of the bridge
+ * Attribute reporting for the bridged endpoints
+ * Changed attributes are collected in a dirty bitmap per dynamic endpoint and reported by a single scheduled job
  */
 namespace {
+// Number of dirty bits per dynamic endpoint, the last bit marks the whole endpoint as dirty
+constexpr uint8_t kDirtyBitCount    = 32;
+constexpr uint8_t kDirtyEndpointBit = kDirtyBitCount - 1;
+
+// Attributes reported by HandleDeviceStatusChanged, they have fixed bits ahead of the flat indices
+// Otherwise a reachability change of an endpoint with many converted attributes would mark the whole endpoint dirty
+struct ReservedDirtyAttribute
+{
+    ClusterId cluster;
+    AttributeId attribute;
+};
+constexpr ReservedDirtyAttribute kReservedDirtyAttributes[] = {
+    { BridgedDeviceBasicInformation::Id, BridgedDeviceBasicInformation::Attributes::Reachable::Id },
+    { BridgedDeviceBasicInformation::Id, BridgedDeviceBasicInformation::Attributes::NodeLabel::Id },
+    { OnOff::Id, OnOff::Attributes::OnOff::Id },
+};
+constexpr uint8_t kReservedDirtyBitCount = sizeof(kReservedDirtyAttributes) / sizeof(kReservedDirtyAttributes[0]);
+
+// Dirty bitmap per dynamic endpoint index
+// The reserved attributes come first, the bit of any other attribute is its flat index in the endpoint type after them
+std::atomic<uint32_t> gDirtyAttributes[CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT];
+// Set while a drain job is pending on the Matter event loop
+std::atomic<bool> gReportingScheduled{ false };
+
+/**
+ * Function used to get the bit of an attribute in the dirty bitmap of an endpoint
+ * Returns kDirtyEndpointBit if the attribute cannot be represented in the bitmap
+ */
+uint8_t GetDirtyBit(EndpointId endpoint, ClusterId cluster, AttributeId attribute)
+{
+    for (uint8_t i = 0; i < kReservedDirtyBitCount; i++)
+    {
+        if (kReservedDirtyAttributes[i].cluster == cluster && kReservedDirtyAttributes[i].attribute == attribute)
+        {
+            return i;
+        }
+    }
+
+    const EmberAfEndpointType * endpointType = emberAfFindEndpointType(endpoint);
+    if (endpointType == nullptr)
+    {
+        return kDirtyEndpointBit;
+    }
+
+    uint16_t offset = kReservedDirtyBitCount;
+    for (uint8_t i = 0; i < endpointType->clusterCount; i++)
+    {
+        const EmberAfCluster & endpointCluster = endpointType->cluster[i];
+        if (endpointCluster.clusterId == cluster)
+        {
+            for (uint16_t j = 0; j < endpointCluster.attributeCount; j++)
+            {
+                if (endpointCluster.attributes[j].attributeId == attribute)
+                {
+                    return (offset + j < kDirtyEndpointBit) ? static_cast<uint8_t>(offset + j) : kDirtyEndpointBit;
+                }
+            }
+        }
+        offset = static_cast<uint16_t>(offset + endpointCluster.attributeCount);
+    }
+    return kDirtyEndpointBit;
+}
+
+/**
+ * Function used to report every attribute that is marked in the given dirty bitmap of an endpoint
+ */
+void ReportDirtyAttributes(EndpointId endpoint, uint32_t dirty)
+{
+    if (dirty & (1u << kDirtyEndpointBit))
+    {
+        MatterReportingAttributeChangeCallback(endpoint);
+        return;
+    }
+
+    for (uint8_t i = 0; i < kReservedDirtyBitCount; i++)
+    {
+        const ReservedDirtyAttribute & reserved = kReservedDirtyAttributes[i];
+        // Not every bridged endpoint has every reserved attribute
+        if ((dirty & (1u << i)) && emberAfLocateAttributeMetadata(endpoint, reserved.cluster, reserved.attribute) != nullptr)
+        {
+            MatterReportingAttributeChangeCallback(endpoint, reserved.cluster, reserved.attribute);
+        }
+    }
+
+    const EmberAfEndpointType * endpointType = emberAfFindEndpointType(endpoint);
+    VerifyOrReturn(endpointType != nullptr);
+
+    uint16_t offset = kReservedDirtyBitCount;
+    for (uint8_t i = 0; i < endpointType->clusterCount && offset < kDirtyEndpointBit; i++)
+    {
+        const EmberAfCluster & endpointCluster = endpointType->cluster[i];
+        for (uint16_t j = 0; j < endpointCluster.attributeCount && offset + j < kDirtyEndpointBit; j++)
+        {
+            if (dirty & (1u << (offset + j)))
+            {
+                MatterReportingAttributeChangeCallback(endpoint, endpointCluster.clusterId, endpointCluster.attributes[j].attributeId);
+            }
+        }
+        offset = static_cast<uint16_t>(offset + endpointCluster.attributeCount);
+    }
+}
+
+/**
+ * Job running on the Matter event loop that drains the dirty bitmaps of all dynamic endpoints
+ */
 void CallReportingCallback(intptr_t closure)
 {
-    auto path = reinterpret_cast<app::ConcreteAttributePath *>(closure);
-    MatterReportingAttributeChangeCallback(*path);
-    Platform::Delete(path);
+    // Clear the flag first so that changes made while draining schedule a new job
+    gReportingScheduled.store(false);
+
+    for (uint16_t index = 0; index < CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT; index++)
+    {
+        uint32_t dirty = gDirtyAttributes[index].exchange(0);
+        if (dirty != 0 && gDevices[index] != NULL)
+        {
+            ReportDirtyAttributes(gDevices[index]->GetEndpointId(), dirty);
+        }
+    }
 }
 
+/**
+ * Function used to mark an attribute of a bridged device as changed
+ * Can be called from any task, at most one drain job is pending at a time
+ */
 void ScheduleReportingCallback(Device * dev, ClusterId cluster, AttributeId attribute)
 {
-    auto * path = Platform::New<app::ConcreteAttributePath>(dev->GetEndpointId(), cluster, attribute);
-    DeviceLayer::PlatformMgr().ScheduleWork(CallReportingCallback, reinterpret_cast<intptr_t>(path));
+    uint16_t index = emberAfGetDynamicIndexFromEndpoint(dev->GetEndpointId());
+    VerifyOrReturn(index < CHIP_DEVICE_CONFIG_DYNAMIC_ENDPOINT_COUNT);
+
+    gDirtyAttributes[index].fetch_or(1u << GetDirtyBit(dev->GetEndpointId(), cluster, attribute));
+
+    if (!gReportingScheduled.exchange(true))
+    {
+        // The dirty bits are kept, the next change schedules the drain job again
+        if (DeviceLayer::PlatformMgr().ScheduleWork(CallReportingCallback) != CHIP_NO_ERROR)
+        {
+            ChipLogError(DeviceLayer, "Cannot schedule the reporting of endpoint %d", dev->GetEndpointId());
+            gReportingScheduled.store(false);
+        }
+    }
 }
 } // anonymous namespace
 
@@ -463,9 +760,83 @@ void HandleDeviceStatusChanged(Device * dev, Device::Changed_t itemChangedMask)
     }
 }
 
+/**
+ * Command invoked on a bridged device that waits for the response of the LwM2M device
+ * The handle keeps the invoke interaction open until the status has been added
+ */
+struct ForwardedInvoke
+{
+    ForwardedInvoke(app::CommandHandler * commandObj, const app::ConcreteCommandPath & commandPath) :
+        handle(commandObj), path(commandPath), start_us(BridgeLatencyBegin(BridgePath::kMatterCommand)),
+        trace_id(BridgeTraceNewId())
+    {}
+
+    app::CommandHandler::Handle handle;
+    app::ConcreteCommandPath path;
+    char target[BRIDGE_TARGET_URI_SIZE];
+    char payload[BRIDGE_EXECUTE_PAYLOAD_SIZE];
+    size_t payload_length = 0;
+    Protocols::InteractionModel::Status status = Protocols::InteractionModel::Status::Failure;
+    // Time the command was invoked, the round trip ends with the invoke response
+    int64_t start_us;
+    // Trace of the command, carried along to the command task
+    uint32_t trace_id;
+};
+
+// Queue of invoked commands that are sent to the LwM2M device by the command task
+static QueueHandle_t gForwardedInvokeQueue;
+// Invoked commands are kept in a pool, the queue can hold every command of the pool
+static ObjectPool<ForwardedInvoke, CONFIG_BRIDGE_FORWARDED_INVOKE_POOL_SIZE> gForwardedInvokePool("forwarded_invoke");
+
+/**
+ * Function used to add the status of a forwarded command to the invoke response
+ * Runs on the Matter event loop, which is the only place the command handler may be used
+ */
+static void CompleteForwardedInvoke(intptr_t context)
+{
+    ForwardedInvoke * invoke = reinterpret_cast<ForwardedInvoke *>(context);
+    app::CommandHandler * commandObj = invoke->handle.Get();
+    if (commandObj != nullptr) {
+        commandObj->AddStatus(invoke->path, invoke->status);
+    }
+    BridgeLatencyEnd(BridgePath::kMatterCommand, invoke->start_us, invoke->status == Protocols::InteractionModel::Status::Success);
+    BridgeTraceSpan(invoke->trace_id, "matter.invoke_callback", invoke->start_us);
+    // Releasing the handle sends the invoke response
+    gForwardedInvokePool.Release(invoke);
+}
+
+/**
+ * Task used to send invoked commands to the LwM2M device and wait for the response
+ * The blocking CoAP exchange is kept off the Matter event loop
+ * Note that FreeRTOS task are not allowed to terminate
+ */
+static void CommandForwardingTask(void * args)
+{
+    BridgeMemoryWatchTask(xTaskGetCurrentTaskHandle(), BRIDGE_COMMAND_TASK_STACK_SIZE);
+    ForwardedInvoke * invoke;
+    while (true) {
+        if (xQueueReceive(gForwardedInvokeQueue, &invoke, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        BridgeTraceScope trace(invoke->trace_id, "command_task.forward");
+        CoapClientResponse response;
+        if (CoapClientPutWithResponse(invoke->target, reinterpret_cast<const uint8_t *>(invoke->payload),
+                                      invoke->payload_length, response) == EXIT_SUCCESS) {
+            // The CoAP response code of the LwM2M device is returned as the Matter status
+            invoke->status = CoapCodeToImStatus(response.code);
+        } else {
+            invoke->status = Protocols::InteractionModel::Status::Timeout;
+        }
+
+        DeviceLayer::PlatformMgr().ScheduleWork(CompleteForwardedInvoke, reinterpret_cast<intptr_t>(invoke));
+    }
+}
+
 /**
  * Callback function that is invoked if a device tries to invoke a command of a device that is bridged
  * The function will translate the invoke interaction into a CoAP PUT request
+ * The status is added once the LwM2M device has answered, so the Matter event loop is never blocked
  */ 
 bool emberAfActionsClusterInstantActionCallback(app::CommandHandler * commandObj, const app::ConcreteCommandPath & commandPath,
                                                 const Actions::Commands::InstantAction::DecodableType & commandData)
@@ -476,18 +847,39 @@ bool emberAfActionsClusterInstantActionCallback(app::CommandHandler * commandObj
     // Translate the cluster and attribute id into a object and a resource id
     int ipso_object_id = matter_mapping.cluster_object_map.get_ipso_id(cluster_id);
     int ipso_resource_id = matter_mapping.command_resource_map.get_ipso_id(command_id);
-    std::string target = "coap://[fd73:13f6:c3ed:1:d8bd:9673:d9cd:a562]:5184/";
+    // The command is sent to the LwM2M device that is bridged on the endpoint
+    const char * device_uri = GetLwm2mDeviceUri(emberAfGetDynamicIndexFromEndpoint(commandPath.mEndpointId));
+    if (device_uri == nullptr) {
+        commandObj->AddStatus(commandPath, Protocols::InteractionModel::Status::UnsupportedEndpoint);
+        return true;
+    }
+
+    ForwardedInvoke * invoke = gForwardedInvokePool.Allocate(commandObj, commandPath);
+    if (invoke == nullptr) {
+        commandObj->AddStatus(commandPath, Protocols::InteractionModel::Status::Busy);
+        return true;
+    }
+
     // Build the target uri basd on the translated ids
-    target.append(std::to_string(ipso_object_id));
-    target.append("/0/");
-    target.append(std::to_string(ipso_resource_id));
-    // commandData contains the data of the command
-    // For this PoC we limited the PUT request to a request without a payload
-    // Send the CoAP PUT request
-    CoapClientPut(target.c_str());
-
-    // Return the status success
-    commandObj->AddStatus(commandPath, Protocols::InteractionModel::Status::Success);
+    snprintf(invoke->target, sizeof(invoke->target), "%s/%d/0/%d", device_uri,
+             ipso_object_id, ipso_resource_id);
+
+    // The fields of the command are passed as the arguments of the LwM2M execute operation
+    int len;
+    if (commandData.invokeID.HasValue()) {
+        len = snprintf(invoke->payload, sizeof(invoke->payload), "0='%u',1='%" PRIu32 "'", commandData.actionID,
+                       commandData.invokeID.Value());
+    } else {
+        len = snprintf(invoke->payload, sizeof(invoke->payload), "0='%u'", commandData.actionID);
+    }
+    invoke->payload_length = len > 0 ? std::min(static_cast<size_t>(len), sizeof(invoke->payload) - 1) : 0;
+
+    // Hand the request to the command task, the status is added by CompleteForwardedInvoke
+    if (xQueueSend(gForwardedInvokeQueue, &invoke, 0) != pdTRUE) {
+        BridgeLatencyEnd(BridgePath::kMatterCommand, invoke->start_us, false);
+        gForwardedInvokePool.Release(invoke);
+        commandObj->AddStatus(commandPath, Protocols::InteractionModel::Status::Busy);
+    }
     return true;
 }
 
@@ -533,13 +925,33 @@ MatterIpsoMapping GenerateMatterIpsoMapping(const json& json)
 }
  
 /**
- * Function used to generate CoAP resources based on an LwM2M object definition
- */ 
-void GenerateCoapResource(ObjectDefinition& object_definition)
+ * Function used to get the URI of a resource of the format /<OBJECT_ID>/<INSTANCE_ID>/<RESOURCE_ID>
+ * Every bridged LwM2M device has its own object instance, the instance id is the index of the device
+ */
+static std::string GetResourceUri(int object_id, uint16_t instance_id, int resource_id)
 {
-    // Register a CoAP resource for every resource defined in the object
-    for (auto& resource : object_definition.resources) {
-        // Create a URI of the format /<OBJECT_ID>/0/<RESOURCE_ID>
+    std::string uri_str;
+    uri_str.append(std::to_string(object_id)).append("/").append(std::to_string(instance_id)).append("/").append(std::to_string(resource_id));
+    return uri_str;
+}
+
+/**
+ * Function used to get the URI of an object instance of the format /<OBJECT_ID>/<INSTANCE_ID>
+ */
+static std::string GetObjectInstanceUri(int object_id, uint16_t instance_id)
+{
+    return std::to_string(object_id).append("/").append(std::to_string(instance_id));
+}
+
+/**
+ * Function used to register the CoAP resources of a resource defined in an LwM2M object, one per object instance
+ */
+static void GenerateResourceRoute(int object_id, ResourceDefinition& resource)
+{
+    for (uint16_t instance_id = 0; instance_id < CONFIG_BRIDGE_LWM2M_DEVICE_COUNT; instance_id++)
+    {
+        std::string uri_str = GetResourceUri(object_id, instance_id, resource.id);
+
         // Depending on the operations, we register different coap ressources
         // Register a read ressource
         if (resource.operations.find('R') != std::string::npos)
@@ -547,14 +959,10 @@ void GenerateCoapResource(ObjectDefinition& object_definition)
             // Register a read write resource
             if (resource.operations.find('W') != std::string::npos)
             {
-                std::string uri_str;
-                uri_str.append(std::to_string(object_definition.id)).append("/0/").append(std::to_string(resource.id));
                 RegisterAttributeRWResource(uri_str.c_str(), resource.type);
             } 
             // register a read resource
             else {
-                std::string uri_str;
-                uri_str.append(std::to_string(object_definition.id)).append("/0/").append(std::to_string(resource.id));
                 RegisterAttributeResource(uri_str.c_str(), COAP_REQUEST_GET, resource.type);
             }
         }
@@ -562,21 +970,105 @@ void GenerateCoapResource(ObjectDefinition& object_definition)
         // Register a read write resource
         else if (resource.operations.find('W') != std::string::npos)
         {
-            std::string uri_str;
-            uri_str.append(std::to_string(object_definition.id)).append("/0/").append(std::to_string(resource.id));
             RegisterAttributeResource(uri_str.c_str(), COAP_REQUEST_PUT, resource.type);
         }
 
         // Register a execute resource
         if (resource.operations.find('E') != std::string::npos)
         {
-            std::string uri_str;
-            uri_str.append(std::to_string(object_definition.id)).append("/0/").append(std::to_string(resource.id));
             RegisterCommandResource(uri_str.c_str());
         }
     }
 }
 
+/**
+ * Function used to remove the CoAP resources of a resource defined in an LwM2M object from every object instance
+ */
+static void RemoveResourceRoute(int object_id, int resource_id)
+{
+    for (uint16_t instance_id = 0; instance_id < CONFIG_BRIDGE_LWM2M_DEVICE_COUNT; instance_id++) {
+        UnregisterResource(GetResourceUri(object_id, instance_id, resource_id).c_str());
+    }
+}
+
+/**
+ * Function used to register the CoAP resources of the object instances of an LwM2M object
+ */
+static void GenerateObjectInstanceRoute(ObjectDefinition& object_definition)
+{
+    // Resources that can be read or written through the object instance
+    std::vector<int> readable_resources;
+    std::vector<int> writable_resources;
+    for (auto& resource : object_definition.resources) {
+        if (resource.operations.find('R') != std::string::npos) {
+            readable_resources.push_back(resource.id);
+        }
+        if (resource.operations.find('W') != std::string::npos) {
+            writable_resources.push_back(resource.id);
+        }
+    }
+
+    // Register a resource of the format /<OBJECT_ID>/<INSTANCE_ID> for every object instance
+    for (uint16_t instance_id = 0; instance_id < CONFIG_BRIDGE_LWM2M_DEVICE_COUNT; instance_id++) {
+        RegisterObjectInstanceResource(GetObjectInstanceUri(object_definition.id, instance_id).c_str(), readable_resources,
+                                       writable_resources);
+    }
+}
+
+/**
+ * Function used to remove the CoAP resources of the object instances of an LwM2M object
+ */
+static void RemoveObjectInstanceRoute(int object_id)
+{
+    for (uint16_t instance_id = 0; instance_id < CONFIG_BRIDGE_LWM2M_DEVICE_COUNT; instance_id++) {
+        UnregisterResource(GetObjectInstanceUri(object_id, instance_id).c_str());
+    }
+}
+
+/**
+ * Function used to generate CoAP resources based on an LwM2M object definition
+ */ 
+void GenerateCoapResource(ObjectDefinition& object_definition)
+{
+    // Register a CoAP resource for every resource defined in the object
+    for (auto& resource : object_definition.resources) {
+        GenerateResourceRoute(object_definition.id, resource);
+    }
+    GenerateObjectInstanceRoute(object_definition);
+}
+
+// The configuration documents and everything they are parsed and converted into are allocated from this arena
+// Results that outlive the configuration are copied to the heap, the arena is released before the CoAP server starts
+static BridgeArena gConfigArena;
+
+// Configuration the bridge runs with, a reload is diffed against it
+// Filled by the configuration task, afterwards only changed while a reload is applied
+static BridgeConfig gBridgeConfig;
+// Set once the bridge runs with the complete configuration, reloads are rejected before
+static std::atomic<bool> gBridgeConfigured{ false };
+
+/**
+ * Function used to load the LwM2M object definition the CoAP resources are generated from
+ */
+static int LoadObjectDefinition(ObjectDefinition & object_definition)
+{
+    BridgeArenaScope arena(gConfigArena);
+    // Load the LwM2M configuration via CoAP
+    if (LoadLwm2mFile("/xml/lwm2m-xml") != EXIT_SUCCESS) {
+        ChipLogError(DeviceLayer, "CoAP Client: Cannot load the LwM2M object definition");
+        return EXIT_FAILURE;
+    }
+
+    // Parse the loaded xml file into an object, which is used by the CoAP resources
+    BridgePhaseScope phase(BridgePhase::kConvert);
+    {
+        BridgeArenaSuspendScope suspend;
+        object_definition = ParseObjectDefinition(lwm2m_xml_file);
+    }
+    lwm2m_xml_file.reset();
+    return EXIT_SUCCESS;
+}
+
 /**
  * Function used to completely initialize and start the CoAP server
  * This includes the generation of the CoAP resources based on the LwM2M object definition
@@ -601,24 +1093,32 @@ static void InitCoapServer(void *args)
                     ChipLogProgress(DeviceLayer, "CoAP Client: Loading LwM2M configuration file as well as the SDF-Mapping");
                     vTaskDelay(1000);
 
-                    // Load the LwM2M configuration via CoAP
-                    const char* lwm2m_xml_uri = "coap://[2a02:8109:c40:7cc6:8150:45c1:c796:5026]:5683/xml/lwm2m-xml";
-                    LoadLwm2mFile(lwm2m_xml_uri);
-
-                    // Parse the loaded xml file into an object
-                    ObjectDefinition object_definition;
-                    object_definition = ParseObjectDefinition(lwm2m_xml_file);
-                    lwm2m_xml_file.reset();
+                    // The CoAP resources cannot be generated without the object definition, it is loaded again
+                    if (LoadObjectDefinition(gBridgeConfig.object) != EXIT_SUCCESS) {
+                        gConfigArena.Release();
+                        vTaskDelay(pdMS_TO_TICKS(BRIDGE_CONFIG_RETRY_DELAY_MS));
+                        continue;
+                    }
+                    // Every configuration document has been loaded, the fastest mirror is used first on the next boot
+                    ConfigMirrorsPersist();
 
                     // Initialize the CoAP Server
                     ChipLogProgress(DeviceLayer, "CoAP Server: Starting CoAP Server!");
                     ChipLogProgress(DeviceLayer, "CoAP Server: Using Address: %s", Ip6ToStr(ip6_addr[2]).c_str());
+                    BridgeMemoryEnterPhase(BridgePhase::kDeploy);
                     init_server(Ip6ToStr(ip6_addr[2]).c_str());
 
                     // Generate the custom ressources based on the parsed LwM2M object definition
                     ChipLogProgress(DeviceLayer, "Generating Custom Resources");
-                    GenerateCoapResource(object_definition);
+                    GenerateCoapResource(gBridgeConfig.object);
                     ChipLogProgress(DeviceLayer, "Generated Custom Resources");
+                    BridgeMemoryLeavePhase(BridgePhase::kDeploy);
+
+                    // The configuration is complete, everything it allocated is released at once
+                    gConfigArena.Release();
+                    BridgeMemoryEnterPhase(BridgePhase::kSteady);
+                    LogBridgeMemoryBudget();
+                    gBridgeConfigured.store(true);
 
                     start_server();
                     break;
@@ -641,40 +1141,397 @@ static void InitCoapServer(void *args)
 
 /**
  * Function used to convert a sdf-model and sdf-mapping to the Matter data model
- * The function also creates a dynamic endpoint based on these converted definitions
+ * Runs on the configuration task and on the reload task, the resulting endpoint is deployed by DeployMatter
  */
-int ConvertAndDeployMatter()
+int ConvertMatter(BridgeConfig & config)
 {
+    BridgeArenaScope arena(gConfigArena);
     ChipLogProgress(DeviceLayer, "CoAP Client: Loading SDF configuration files");
     vTaskDelay(1000);
 
     // Load the sdf-model
-    const char* sdf_model_uri = "coap://[2a02:8109:c40:7cc6:8150:45c1:c796:5026]:5683/sdf/sdf-model";
-    LoadSdfModelFile(sdf_model_uri);
+    if (LoadSdfModelFile("/sdf/sdf-model") != EXIT_SUCCESS) {
+        ChipLogError(DeviceLayer, "CoAP Client: Cannot load the sdf-model");
+        return EXIT_FAILURE;
+    }
     vTaskDelay(1000);
 
     // Load the Matter specific sdf-mapping
-    const char* sdf_mapping_uri = "coap://[2a02:8109:c40:7cc6:8150:45c1:c796:5026]:5683/sdf/sdf-mapping";
-    LoadSdfMappingMatterFile(sdf_mapping_uri);
+    if (LoadSdfMappingMatterFile("/sdf/sdf-mapping") != EXIT_SUCCESS) {
+        ChipLogError(DeviceLayer, "CoAP Client: Cannot load the sdf-mapping");
+        // The document has been parsed into the arena, it must not outlive it
+        sdf_model_file = nullptr;
+        return EXIT_FAILURE;
+    }
 
     ChipLogProgress(DeviceLayer, "CoAP Client: Finished loading configuration files");
 
     // Convert the sdf-model and the sdf-mapping to a device type definition and a list of cluster definitions
     ChipLogProgress(DeviceLayer, "SDF-Matter-Converter: Converting SDF to Matter");
-    static matter::Device converted_device;
-    static std::list<matter::Cluster> clusters;
-    ConvertSdfToMatter(sdf_model_file, sdf_mapping_matter_file, converted_device, clusters);
-    sdf_model_file.clear();
-    sdf_mapping_matter_file.clear();
-    ChipLogProgress(DeviceLayer, "SDF-Matter-Converter: Converted Device: %s", converted_device.name.c_str());
+    BridgePhaseScope phase(BridgePhase::kConvert);
+    matter::Device device;
+    std::list<matter::Cluster> clusters;
+    ConvertSdfToMatter(sdf_model_file, sdf_mapping_matter_file, device, clusters);
+    // The documents are destroyed rather than cleared, clear() keeps their storage in the arena
+    sdf_model_file = nullptr;
+    sdf_mapping_matter_file = nullptr;
+    if (clusters.empty()) {
+        ChipLogError(DeviceLayer, "SDF-Matter-Converter: The sdf-model has not been converted to a cluster");
+        return EXIT_FAILURE;
+    }
+    ChipLogProgress(DeviceLayer, "SDF-Matter-Converter: Converted Device: %s", device.name.c_str());
     ChipLogProgress(DeviceLayer, "SDF-Matter-Converter: Converted SDF to Matter!");
 
+    // Client cluster loaded from the definition of the Matter device
+    // This is part of the PoC as normally this information would also be available if a LwM2M converter would be usable on the bridge
+    matter::Cluster client_cluster = LoadClusterDefinition();
+
+    // The converted device is deployed after the arena has been released
+    BridgeArenaSuspendScope suspend;
+    config.device = device;
+    config.clusters = clusters;
+    config.clientCluster = client_cluster;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Function used to generate the link between LwM2M and Matter data model elements by utilizing the combined sdf-mappings
+ * The mappings are parsed into the arena, the generated mappers are kept on the heap
+ */
+static int GenerateMappings(BridgeConfig & config)
+{
+    BridgeArenaScope arena(gConfigArena);
+    // Load the LwM2M specific mapping
+    if (LoadSdfMappingMatterFile("/sdf/sdf-lwm2m-to-matter-merged") != EXIT_SUCCESS) {
+        ChipLogError(DeviceLayer, "CoAP Client: Cannot load the LwM2M to Matter mapping");
+        return EXIT_FAILURE;
+    }
+    BridgeMemoryEnterPhase(BridgePhase::kConvert);
+    {
+        BridgeArenaSuspendScope suspend;
+        config.coapMapping = GenerateMatterIpsoMapping(sdf_mapping_matter_file);
+    }
+    sdf_mapping_matter_file = nullptr;
+    BridgeMemoryLeavePhase(BridgePhase::kConvert);
+
+    // Load the Matter specific mapping
+    if (LoadSdfMappingLwm2mFile("/sdf/sdf-matter-to-lwm2m-merged") != EXIT_SUCCESS) {
+        ChipLogError(DeviceLayer, "CoAP Client: Cannot load the Matter to LwM2M mapping");
+        return EXIT_FAILURE;
+    }
+    BridgeMemoryEnterPhase(BridgePhase::kConvert);
+    {
+        BridgeArenaSuspendScope suspend;
+        config.matterMapping = GenerateMatterIpsoMapping(sdf_mapping_lwm2m_file);
+    }
+    sdf_mapping_lwm2m_file = nullptr;
+    BridgeMemoryLeavePhase(BridgePhase::kConvert);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Function used to deploy the converted Matter device as a dynamic endpoint
+ * Runs on the Matter event loop once the configuration task has finished converting
+ */
+static void DeployMatter(intptr_t context)
+{
     // Create a dynamic endpoint based on the converted device type definition and the list of cluster definitions
     ChipLogProgress(DeviceLayer, "Generating and deploying converted Matter device");
-    CreateCustomDevice(converted_device, clusters);
+    BridgePhaseScope phase(BridgePhase::kDeploy);
+    CreateCustomDevice(gBridgeConfig.device, gBridgeConfig.clusters, gBridgeConfig.clientCluster);
     ChipLogProgress(DeviceLayer, "Deployed converted Matter device");
 
-    return 0;
+    // The mapping is used by the attribute callbacks which run on the Matter event loop
+    matter_mapping = gBridgeConfig.matterMapping;
+}
+
+/**
+ * Task used to load and convert the bridge configuration without blocking the Matter event loop
+ * Afterwards the task continues as the CoAP server task
+ * Note that FreeRTOS task are not allowed to terminate
+ */
+static void ConfigurationTask(void *args)
+{
+    BridgeMemoryWatchTask(xTaskGetCurrentTaskHandle(), BRIDGE_CONFIG_TASK_STACK_SIZE);
+
+    // Convert SDF to Matter and generate the link between LwM2M and Matter data model elements by utilizing the combined sdf-mappings
+    // The bridge is only deployed with a completely converted configuration, otherwise the configuration is loaded again
+    while (true) {
+        if (ConvertMatter(gBridgeConfig) == EXIT_SUCCESS) {
+            ChipLogProgress(DeviceLayer, "Generating the mappers");
+            if (GenerateMappings(gBridgeConfig) == EXIT_SUCCESS) {
+                break;
+            }
+        }
+        ChipLogError(DeviceLayer, "Cannot convert the configuration, retrying in %d ms", BRIDGE_CONFIG_RETRY_DELAY_MS);
+        // Every document of the failed attempt has been destroyed, so the arena can be released
+        gConfigArena.Release();
+        vTaskDelay(pdMS_TO_TICKS(BRIDGE_CONFIG_RETRY_DELAY_MS));
+    }
+    // The CoAP mapping is only used by the CoAP server which is started from this task
+    coap_mapping = gBridgeConfig.coapMapping;
+    ChipLogProgress(DeviceLayer, "Generated the mappers!");
+
+    // Only the endpoint deployment itself runs on the Matter event loop
+    DeviceLayer::PlatformMgr().ScheduleWork(DeployMatter);
+
+    // Create the CoAP Server
+    // Unless the CoAP I/O is handed over to the Matter event loop, this does not return
+    ChipLogProgress(DeviceLayer, "Starting Server");
+    InitCoapServer(args);
+
+    // The task is no longer needed, its stack is released
+    BridgeMemoryTaskExiting();
+    vTaskDelete(NULL);
+}
+
+/**
+ * Reload of the configuration
+ * The configuration is loaded and converted like on boot, afterwards only its difference to the running configuration
+ * is applied: the Matter side on the Matter event loop and the CoAP side where the CoAP I/O is processed
+ */
+namespace {
+// Set while a reload is in progress, the reload is finished where the CoAP I/O is processed
+std::atomic<bool> gReloadInProgress{ false };
+// Outcome of the last reload, only used where the CoAP I/O is processed
+char gReloadStatus[96] = "idle";
+// Reloaded configuration and its difference to the running configuration
+// They are handed from the reload task to the Matter event loop and from there to the CoAP I/O
+BridgeConfig gReloadedConfig;
+BridgeConfigDelta gReloadDelta;
+
+/**
+ * Function used to finish a reload, the context is the outcome of the reload
+ * Runs where the CoAP I/O is processed, which is where the status is read
+ */
+void FinishReload(intptr_t context)
+{
+    const char * outcome = reinterpret_cast<const char *>(context);
+    if (gReloadDelta.restartReason != nullptr) {
+        snprintf(gReloadStatus, sizeof(gReloadStatus), "%s: %s", outcome, gReloadDelta.restartReason);
+    } else {
+        snprintf(gReloadStatus, sizeof(gReloadStatus), "%s", outcome);
+    }
+
+    // The running configuration has taken over everything it needs
+    gReloadedConfig = BridgeConfig();
+    gReloadDelta    = BridgeConfigDelta();
+    gReloadInProgress.store(false);
+}
+
+/**
+ * Function used to give up a reload whose next step cannot be handed over to the task that has to run it
+ * Clears the reload state and stops the CoAP server from polling for the work that will never run
+ */
+void AbortReload(const char * reason)
+{
+    ChipLogError(DeviceLayer, "Bridge-Reload: %s", reason);
+    snprintf(gReloadStatus, sizeof(gReloadStatus), "failed: %s", reason);
+    gReloadedConfig = BridgeConfig();
+    gReloadDelta    = BridgeConfigDelta();
+    CancelCoapServerPoll();
+    gReloadInProgress.store(false);
+}
+
+/**
+ * Function used to apply the CoAP side of a reload
+ * Only the routes of resources that have been added, removed or changed are touched
+ */
+void ApplyCoapReload(intptr_t context)
+{
+    ObjectDefinition & object_definition = gReloadedConfig.object;
+    const ObjectDelta & delta            = gReloadDelta.object;
+
+    // Changed resources are registered again with their new operations and type
+    for (int resource_id : delta.removedResources) {
+        RemoveResourceRoute(object_definition.id, resource_id);
+    }
+    for (auto & resource : object_definition.resources) {
+        if (DeltaContains(delta.changedResources, resource.id)) {
+            RemoveResourceRoute(object_definition.id, resource.id);
+            GenerateResourceRoute(object_definition.id, resource);
+        } else if (DeltaContains(delta.addedResources, resource.id)) {
+            GenerateResourceRoute(object_definition.id, resource);
+        }
+    }
+    if (delta.instanceChanged) {
+        RemoveObjectInstanceRoute(object_definition.id);
+        GenerateObjectInstanceRoute(object_definition);
+    }
+
+    // The CoAP handlers run here, so the mapping is swapped between two requests
+    coap_mapping = gReloadedConfig.coapMapping;
+    gBridgeConfig.coapMapping = std::move(gReloadedConfig.coapMapping);
+    gBridgeConfig.object      = std::move(gReloadedConfig.object);
+
+    ChipLogProgress(DeviceLayer, "Bridge-Reload: Added %u, removed %u and changed %u LwM2M resources",
+                    static_cast<unsigned>(delta.addedResources.size()), static_cast<unsigned>(delta.removedResources.size()),
+                    static_cast<unsigned>(delta.changedResources.size()));
+    FinishReload(reinterpret_cast<intptr_t>("applied"));
+}
+
+/**
+ * Function used to report the attributes of a converted cluster that are affected by a reload
+ * Reporting bumps the data version of this cluster only, the subscriptions to the endpoint stay intact
+ */
+void ReportReloadedCluster(EndpointId endpoint, const matter::Cluster & cluster, const ClusterDelta & delta,
+                           const MappingDelta & mapping)
+{
+    // The attributes of a cluster that is mapped to another object are read from other resources from now on
+    bool remapped = DeltaContains(mapping.clusters, cluster.id);
+    for (const auto & attribute : cluster.attributes) {
+        bool affected = remapped || DeltaContains(delta.addedAttributes, attribute.id) ||
+            DeltaContains(delta.changedAttributes, attribute.id) || DeltaContains(mapping.attributes, attribute.id);
+        // Attributes of a type the endpoint cannot represent have no metadata
+        if (affected && emberAfLocateAttributeMetadata(endpoint, cluster.id, attribute.id) != nullptr) {
+            MatterReportingAttributeChangeCallback(endpoint, cluster.id, attribute.id);
+        }
+    }
+
+    if (delta.AttributeListChanged()) {
+        MatterReportingAttributeChangeCallback(endpoint, cluster.id, Globals::Attributes::AttributeList::Id);
+    }
+    if (delta.commandsChanged) {
+        MatterReportingAttributeChangeCallback(endpoint, cluster.id, Globals::Attributes::AcceptedCommandList::Id);
+    }
+}
+
+/**
+ * Timer handler used to hand the CoAP side of a reload over to the CoAP I/O, the context is the number of attempts left
+ * Runs on the Matter event loop, which must not wait for the work slot of the CoAP server
+ */
+void ScheduleCoapReload(System::Layer * layer, void * context)
+{
+    uintptr_t attempts = reinterpret_cast<uintptr_t>(context);
+    if (ScheduleCoapServerWork(ApplyCoapReload, 0)) {
+        return;
+    }
+    if (attempts <= 1 ||
+        layer->StartTimer(System::Clock::Milliseconds32(BRIDGE_RELOAD_HANDOFF_RETRY_MS), ScheduleCoapReload,
+                          reinterpret_cast<void *>(attempts - 1)) != CHIP_NO_ERROR) {
+        // The Matter side has already been applied, only a restart brings both sides together again
+        AbortReload("cannot apply the CoAP side, restart required");
+    }
+}
+
+/**
+ * Function used to apply the Matter side of a reload
+ * The metadata of the converted clusters is replaced in place, the endpoints keep their ids and data versions
+ */
+void ApplyMatterReload(intptr_t context)
+{
+    const BridgeConfigDelta & delta        = gReloadDelta;
+    const matter::Cluster & server_cluster = gReloadedConfig.clusters.front();
+    const matter::Cluster & client_cluster = gReloadedConfig.clientCluster;
+
+    if (!delta.server.Empty()) {
+        gCustomServerAttributes = BuildAttributeMetadata(server_cluster);
+        gCustomServerCommands   = BuildAcceptedCommands(server_cluster);
+        for (auto & clusters : gCustomClusters) {
+            SetCustomClusterMetadata(clusters[kCustomServerClusterIndex], gCustomServerAttributes, gCustomServerCommands);
+        }
+    }
+    if (!delta.client.Empty()) {
+        gCustomClientAttributes = BuildAttributeMetadata(client_cluster);
+        gCustomClientCommands   = BuildAcceptedCommands(client_cluster);
+        for (auto & clusters : gCustomClusters) {
+            SetCustomClusterMetadata(clusters[kCustomClientClusterIndex], gCustomClientAttributes, gCustomClientCommands);
+        }
+    }
+
+    // The attribute callbacks run on the Matter event loop, so the mapping is swapped between two interactions
+    matter_mapping = gReloadedConfig.matterMapping;
+
+    uint16_t index = 0;
+    for (Device & device : gBridgedCustomDevices) {
+        ReportReloadedCluster(device.GetEndpointId(), server_cluster, delta.server, delta.matterMapping);
+        ReportReloadedCluster(device.GetEndpointId(), client_cluster, delta.client, delta.matterMapping);
+        if (delta.nameChanged) {
+            // The node label is reported by HandleDeviceStatusChanged
+            char name[Device::kDeviceNameSize];
+            FormatBridgedDeviceName(name, sizeof(name), gReloadedConfig.device, index);
+            device.SetName(name);
+        }
+        index++;
+    }
+
+    ChipLogProgress(DeviceLayer, "Bridge-Reload: Added %u, removed %u and changed %u attributes",
+                    static_cast<unsigned>(delta.server.addedAttributes.size() + delta.client.addedAttributes.size()),
+                    static_cast<unsigned>(delta.server.removedAttributes.size() + delta.client.removedAttributes.size()),
+                    static_cast<unsigned>(delta.server.changedAttributes.size() + delta.client.changedAttributes.size()));
+
+    gBridgeConfig.device        = std::move(gReloadedConfig.device);
+    gBridgeConfig.clusters      = std::move(gReloadedConfig.clusters);
+    gBridgeConfig.clientCluster = std::move(gReloadedConfig.clientCluster);
+    gBridgeConfig.matterMapping = std::move(gReloadedConfig.matterMapping);
+
+    ScheduleCoapReload(&DeviceLayer::SystemLayer(), reinterpret_cast<void *>(BRIDGE_RELOAD_HANDOFF_ATTEMPTS));
+}
+
+/**
+ * Task used to load and convert the configuration again and to compute its difference to the running configuration
+ */
+void ReloadTask(void * args)
+{
+    ChipLogProgress(DeviceLayer, "Bridge-Reload: Reloading the configuration");
+    const char * outcome = nullptr;
+    if (ConvertMatter(gReloadedConfig) != EXIT_SUCCESS || GenerateMappings(gReloadedConfig) != EXIT_SUCCESS ||
+        LoadObjectDefinition(gReloadedConfig.object) != EXIT_SUCCESS) {
+        outcome = "failed";
+    }
+    // Everything the documents have been parsed into is released, the reloaded configuration lives on the heap
+    gConfigArena.Release();
+
+    if (outcome == nullptr) {
+        gReloadDelta = DiffBridgeConfig(gBridgeConfig, gReloadedConfig);
+        if (gReloadDelta.restartReason != nullptr) {
+            ChipLogError(DeviceLayer, "Bridge-Reload: Cannot apply the configuration, %s", gReloadDelta.restartReason);
+            outcome = "restart required";
+        } else if (gReloadDelta.Empty()) {
+            outcome = "unchanged";
+        }
+    }
+
+    if (outcome != nullptr) {
+        ChipLogProgress(DeviceLayer, "Bridge-Reload: Nothing to apply, %s", outcome);
+    }
+    // The next step of the reload runs on another task, a failed hand-off would leave the reload in progress forever
+    bool handed_over = false;
+    for (int attempt = 0; attempt < BRIDGE_RELOAD_HANDOFF_ATTEMPTS && !handed_over; attempt++) {
+        if (attempt > 0) {
+            vTaskDelay(pdMS_TO_TICKS(BRIDGE_RELOAD_HANDOFF_RETRY_MS));
+        }
+        handed_over = outcome != nullptr ? ScheduleCoapServerWork(FinishReload, reinterpret_cast<intptr_t>(outcome))
+                                         : DeviceLayer::PlatformMgr().ScheduleWork(ApplyMatterReload) == CHIP_NO_ERROR;
+    }
+    if (!handed_over) {
+        AbortReload(outcome != nullptr ? "cannot report the outcome" : "cannot apply the Matter side");
+    }
+
+    vTaskDelete(NULL);
+}
+} // anonymous namespace
+
+bool StartBridgeReload()
+{
+    VerifyOrReturnValue(gBridgeConfigured.load(), false);
+    VerifyOrReturnValue(!gReloadInProgress.exchange(true), false);
+
+    snprintf(gReloadStatus, sizeof(gReloadStatus), "in progress");
+    if (xTaskCreate(&ReloadTask, "bridge_reload", BRIDGE_RELOAD_TASK_STACK_SIZE, NULL, 5, NULL) != pdPASS) {
+        ChipLogError(DeviceLayer, "Bridge-Reload: Cannot create the reload task");
+        snprintf(gReloadStatus, sizeof(gReloadStatus), "failed");
+        gReloadInProgress.store(false);
+        return false;
+    }
+    return true;
+}
+
+const char * GetBridgeReloadStatus()
+{
+    return gReloadStatus;
 }
 
 /**
@@ -684,6 +1541,9 @@ static void InitServer(intptr_t context)
 {
     PrintOnboardingCodes(chip::RendezvousInformationFlags(CONFIG_RENDEZVOUS_MODE));
 
+    // The Matter event loop runs the attribute callbacks and the endpoint deployment
+    BridgeMemoryWatchTask(xTaskGetCurrentTaskHandle(), CONFIG_CHIP_TASK_STACK_SIZE);
+
     Esp32AppServer::Init(); // Init ZCL Data Model and CHIP App Server AND Initialize device attestation config
 
     // Initialize the Binding Handler
@@ -705,31 +1565,19 @@ static void InitServer(intptr_t context)
 
     // Add lights 1
     // Still remaining as part of the original bridge to showcase the original usecase
+    gLight1.SetChangeCallback(&HandleDeviceStatusChanged);
     AddDeviceEndpoint(&gLight1, &bridgedLightEndpoint, Span<const EmberAfDeviceType>(gBridgedOnOffDeviceTypes),
                       Span<DataVersion>(gLight1DataVersions), 1);
     
-    // Convert SDF to Matter and generate a endpoint based on the given information
-    ConvertAndDeployMatter();
-
-    // Generate the link between LwM2M and Matter data model elements by utilizing the combined sdf-mappings
-    ChipLogProgress(DeviceLayer, "Generating the mappers");
-    sdf_mapping_matter_file.clear();
-    // Load the LwM2M specific mapping
-    const char* sdf_mapping_uri = "coap://[2a02:8109:c40:7cc6:8150:45c1:c796:5026]:5683/sdf/sdf-lwm2m-to-matter-merged";
-    LoadSdfMappingMatterFile(sdf_mapping_uri);
-    coap_mapping = GenerateMatterIpsoMapping(sdf_mapping_matter_file);
-    ChipLogProgress(DeviceLayer, "Generated the mappers!");
-
-    // Load the Matter specific mapping
-    const char* sdf_mapping_lwm2m_uri = "coap://[2a02:8109:c40:7cc6:8150:45c1:c796:5026]:5683/sdf/sdf-matter-to-lwm2m-merged";
-    LoadSdfMappingLwm2mFile(sdf_mapping_lwm2m_uri);
-    matter_mapping = GenerateMatterIpsoMapping(sdf_mapping_lwm2m_file);
-
-    // Create the CoAP Server
+    // Load and convert the configuration in the background, the bridge stays responsive in the meantime
     // Note that FreeRTOS task are not allowed to terminate
     // They have to be explicitly terminated with vTaskDelete
-    ChipLogProgress(DeviceLayer, "Starting Server");
-    xTaskCreate(&InitCoapServer, "coap_server", 4096, NULL, 5, NULL);
+    ChipLogProgress(DeviceLayer, "Starting configuration task");
+    xTaskCreate(&ConfigurationTask, "bridge_config", BRIDGE_CONFIG_TASK_STACK_SIZE, NULL, 5, NULL);
+
+    // Invoked commands wait for the LwM2M device in their own task
+    gForwardedInvokeQueue = xQueueCreate(CONFIG_BRIDGE_FORWARDED_INVOKE_POOL_SIZE, sizeof(ForwardedInvoke *));
+    xTaskCreate(&CommandForwardingTask, "bridge_cmd", BRIDGE_COMMAND_TASK_STACK_SIZE, NULL, 5, NULL);
 
     // Check if the Device is reachable
     if (DeviceLayer::Internal::ESP32Utils::IsInterfaceUp("ot1"))
@@ -744,6 +1592,9 @@ static void InitServer(intptr_t context)
 
 extern "C" void app_main()
 {
+    // The tracking allocator has to be in place before pugixml allocates
+    InitBridgeMemory();
+
     // Initialize the ESP NVS layer.
     esp_err_t err = nvs_flash_init();
     if (err != ESP_OK)